@@ -1,9 +1,12 @@
 #include "./controller/controller_blender.h"
 
+#include <algorithm>
+
 #include "./core/scene.h"
 #include "./graphics/camera.h"
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
+#include "./utils/log.h"
 
 using namespace std;
 
@@ -44,8 +47,8 @@ void Blender::update()
             for (auto& linked : cameraLinks)
             {
                 auto object = dynamic_pointer_cast<Object>(getObject(linked));
-                if (object)
-                    objLinkedToCameras.push_back(getObject(linked));
+                if (object && find(objLinkedToCameras.begin(), objLinkedToCameras.end(), object) == objLinkedToCameras.end())
+                    objLinkedToCameras.push_back(object);
             }
         }
 
@@ -54,63 +57,30 @@ void Blender::update()
 
     if (_computeBlending && (!_blendingComputed || _continuousBlending))
     {
+        // A new computation, as opposed to a continuous update, starts from scratch
+        bool firstComputation = !_blendingComputed;
+        if (firstComputation)
+        {
+            _cameraStates.clear();
+            _objectStates.clear();
+            _objectCameras.clear();
+        }
+
         _blendingComputed = true;
 
         // Only the master scene computes the blending
         if (isMaster)
         {
-            auto cameras = getObjectsOfType("camera");
-            auto objects = getObjLinkedToCameras();
-
-            if (cameras.size() != 0)
-            {
-                for (auto& it : objects)
-                    dynamic_pointer_cast<Object>(it)->resetTessellation();
-
-                // Tessellate
-                for (auto& it : cameras)
-                {
-                    auto camera = dynamic_pointer_cast<Camera>(it);
-                    camera->computeVertexVisibility();
-                    camera->blendingTessellateForCurrentCamera();
-                }
-
-                for (auto& it : objects)
-                    dynamic_pointer_cast<Object>(it)->resetBlendingAttribute();
-
-                // Compute each camera contribution
-                for (auto& it : cameras)
-                {
-                    auto camera = dynamic_pointer_cast<Camera>(it);
-                    camera->computeVertexVisibility();
-                    camera->computeBlendingContribution();
-                }
-            }
-            else
-            {
+            if (!computeBlending())
                 return;
-            }
-
-            for (auto& object : objects)
-                object->setAttribute("activateVertexBlending", {1});
-
-            // If there are some other scenes, send them the blending
-            auto geometries = getObjectsOfType("geometry");
-            for (auto& geometry : geometries)
-            {
-                auto serializedGeometry = dynamic_pointer_cast<Geometry>(geometry)->serialize();
-                sendBuffer(geometry->getName(), std::move(serializedGeometry));
-            }
-
-            setObjectAttribute(_name, "blendingUpdated", {});
         }
         // The non-master scenes only need to activate blending
         else
         {
             // Wait for the master scene to notify us that the blending was updated
-            // Note that we do not wait more that 2 seconds
+            // Note that we do not wait more that 2 seconds. In continuous mode, later updates are only applied when they arrive
             unique_lock<mutex> updateBlendingLock(_vertexBlendingMutex);
-            int maxSecElapsed = 2;
+            int maxSecElapsed = firstComputation ? 2 : 0;
             while (!_vertexBlendingReceptionStatus && maxSecElapsed)
             {
                 _vertexBlendingCondition.wait_for(updateBlendingLock, chrono::seconds(1));
@@ -149,6 +119,140 @@ void Blender::update()
     }
 }
 
+/*************/
+bool Blender::computeBlending()
+{
+    auto cameraObjects = getObjectsOfType("camera");
+    if (cameraObjects.empty())
+        return false;
+
+    auto links = getObjectLinks();
+
+    // Find the cameras which changed, and the cameras seeing each object
+    unordered_map<string, vector<double>> cameraStates;
+    unordered_map<string, bool> cameraChanged;
+    unordered_map<string, vector<string>> objectCameras;
+    vector<string> objectNames;
+    for (auto& it : cameraObjects)
+    {
+        auto camera = dynamic_pointer_cast<Camera>(it);
+        auto cameraName = camera->getName();
+        auto state = camera->getBlendingState();
+        auto stateIt = _cameraStates.find(cameraName);
+        cameraChanged[cameraName] = stateIt == _cameraStates.end() || stateIt->second != state;
+        cameraStates[cameraName] = std::move(state);
+
+        for (auto& linked : links[cameraName])
+        {
+            if (!dynamic_pointer_cast<Object>(getObject(linked)))
+                continue;
+            if (objectCameras.find(linked) == objectCameras.end())
+                objectNames.push_back(linked);
+            objectCameras[linked].push_back(cameraName);
+        }
+    }
+
+    // Find the objects which changed, or whose cameras were linked or unlinked
+    unordered_map<string, vector<double>> objectStates;
+    unordered_map<string, bool> objectChanged;
+    for (auto& objectName : objectNames)
+    {
+        auto object = dynamic_pointer_cast<Object>(getObject(objectName));
+        auto state = object->getBlendingState();
+
+        auto stateIt = _objectStates.find(objectName);
+        auto camerasIt = _objectCameras.find(objectName);
+        objectChanged[objectName] = stateIt == _objectStates.end() || stateIt->second != state || camerasIt == _objectCameras.end() || camerasIt->second != objectCameras[objectName];
+        objectStates[objectName] = std::move(state);
+    }
+
+    // Visibility depends on occlusion: when anything seen by a camera changes, all the objects it sees have to be updated.
+    // This includes the objects which it does not see anymore
+    auto cameraDirty = cameraChanged;
+    for (auto& objectName : objectNames)
+        if (objectChanged[objectName])
+            for (auto& cameraName : objectCameras[objectName])
+                cameraDirty[cameraName] = true;
+    for (auto& previous : _objectCameras)
+    {
+        auto camerasIt = objectCameras.find(previous.first);
+        for (auto& cameraName : previous.second)
+            if (camerasIt == objectCameras.end() || find(camerasIt->second.begin(), camerasIt->second.end(), cameraName) == camerasIt->second.end())
+                cameraDirty[cameraName] = true;
+    }
+
+    vector<shared_ptr<Object>> objects;
+    vector<shared_ptr<Camera>> cameras;
+    for (auto& objectName : objectNames)
+    {
+        const auto& linkedCameras = objectCameras[objectName];
+        if (none_of(linkedCameras.begin(), linkedCameras.end(), [&](const string& cameraName) { return cameraDirty[cameraName]; }))
+            continue;
+
+        objects.push_back(dynamic_pointer_cast<Object>(getObject(objectName)));
+        for (auto& cameraName : linkedCameras)
+        {
+            auto camera = dynamic_pointer_cast<Camera>(getObject(cameraName));
+            if (find(cameras.begin(), cameras.end(), camera) == cameras.end())
+                cameras.push_back(camera);
+        }
+    }
+
+    _cameraStates = std::move(cameraStates);
+    _objectStates = std::move(objectStates);
+    _objectCameras = std::move(objectCameras);
+    _updatedObjectCount = objects.size();
+
+    if (objects.empty())
+        return true;
+
+#ifdef DEBUG
+    Log::get() << Log::DEBUGGING << "Blender::" << __FUNCTION__ << " - Updating the blending of " << objects.size() << " objects, seen by " << cameras.size() << " cameras"
+               << Log::endl;
+#endif
+
+    // Objects which are not updated are still rendered by the visibility passes, as they may hide the others
+    for (auto& object : objects)
+        object->resetTessellation();
+
+    // Tessellate
+    for (auto& camera : cameras)
+    {
+        camera->computeVertexVisibility();
+        camera->blendingTessellateForCurrentCamera(objects);
+    }
+
+    for (auto& object : objects)
+        object->resetBlendingAttribute();
+
+    // Compute each camera contribution
+    for (auto& camera : cameras)
+    {
+        camera->computeVertexVisibility();
+        camera->computeBlendingContribution(objects);
+    }
+
+    for (auto& object : objects)
+        object->setAttribute("activateVertexBlending", {1});
+
+    // If there are some other scenes, send them the geometries which were updated
+    for (auto& object : objects)
+    {
+        for (auto& linked : links[object->getName()])
+        {
+            auto geometry = dynamic_pointer_cast<Geometry>(getObject(linked));
+            if (!geometry)
+                continue;
+            auto serializedGeometry = geometry->serialize();
+            sendBuffer(geometry->getName(), std::move(serializedGeometry));
+        }
+    }
+
+    setObjectAttribute(_name, "blendingUpdated", {});
+
+    return true;
+}
+
 /*************/
 void Blender::registerAttributes()
 {
@@ -192,6 +296,9 @@ void Blender::registerAttributes()
     });
     setAttributeDescription("blendingUpdated", "Message sent by the master Scene to notify that a new blending has been computed");
     setAttributeSyncMethod("blendingUpdated", Attribute::Sync::force_sync);
+
+    addAttribute("updatedObjects", nullptr, [&]() -> Values { return {_updatedObjectCount}; }, {});
+    setAttributeDescription("updatedObjects", "Number of objects whose blending was computed by the last update, the others being unchanged");
 }
 
 } // end of namespace
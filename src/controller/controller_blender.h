@@ -26,6 +26,8 @@
 #define SPLASH_CONTROLLER_BLENDER_H
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "./controller.h"
 
@@ -62,12 +64,24 @@ class Blender : public ControllerObject
     bool _computeBlending{false};      //!< If true, compute blending in the next render
     bool _continuousBlending{false};   //!< If true, render does not reset _computeBlending
     bool _blendingComputed{false};     //!< True if the blending has been computed
+    uint32_t _updatedObjectCount{0};   //!< Number of objects updated by the last blending computation
+
+    // State of the cameras and objects when their blending was last computed, to only update what changed
+    std::unordered_map<std::string, std::vector<double>> _cameraStates{};
+    std::unordered_map<std::string, std::vector<double>> _objectStates{};
+    std::unordered_map<std::string, std::vector<std::string>> _objectCameras{};
 
     // Vertex blending variables
     std::mutex _vertexBlendingMutex;
     std::condition_variable _vertexBlendingCondition;
     std::atomic_bool _vertexBlendingReceptionStatus{false};
 
+    /**
+     * \brief Compute the blending of the objects whose cameras or own parameters changed since the last computation
+     * \return Return false if there is no camera
+     */
+    bool computeBlending();
+
     /**
      * \brief Register new functors to modify attributes
      */
@@ -1153,6 +1153,12 @@ void Gui::initImWidgets()
         stream << "  GUI rendering: " << setprecision(4) << gui << " ms\n";
         stream << "  Windows rendering: " << setprecision(4) << win << " ms\n";
         stream << "  Swapping and events: " << setprecision(4) << buf << " ms\n";
+        stream << "Statistics since start (median / 99th percentile / max):\n";
+        for (const auto& timer : {"loop_world", "loop_scene", "textureUpload", "swap"})
+        {
+            auto statistics = Timer::get().getStatistics(timer);
+            stream << "  " << timer << ": " << setprecision(4) << statistics.p50 * 0.001 << " / " << statistics.p99 * 0.001 << " / " << statistics.max * 0.001 << " ms\n";
+        }
 
         return stream.str();
     });
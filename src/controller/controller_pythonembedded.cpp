@@ -86,23 +86,53 @@ PyObject* PythonEmbedded::pythonGetLogs(PyObject* /*self*/, PyObject* /*args*/)
 PyDoc_STRVAR(pythonGetTimings_doc__,
     "Get the timings from Splash\n"
     "\n"
-    "splash.get_timings()\n"
+    "splash.get_timings(statistics=False)\n"
+    "\n"
+    "Args:\n"
+    "  statistics (bool): if True, returns the statistics of each timer since start instead of its last value\n"
     "\n"
     "Returns:\n"
-    "  The timers as a dict\n"
+    "  The timers as a dict, in us. Statistics are given as a dict holding the count, p50, p99 and max of each timer\n"
     "\n"
     "Raises:\n"
     "  splash.error: if Splash instance is not available");
 
-PyObject* PythonEmbedded::pythonGetTimings(PyObject* /*self*/, PyObject* /*args*/)
+PyObject* PythonEmbedded::pythonGetTimings(PyObject* /*self*/, PyObject* args, PyObject* kwds)
 {
-    auto& timings = Timer::get().getDurationMap();
+    int statistics = 0;
+    static const char* kwlist[] = {"statistics", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|p", const_cast<char**>(kwlist), &statistics))
+    {
+        PyErr_Warn(PyExc_Warning, "Wrong argument type or number");
+        return PyDict_New();
+    }
+
     PyObject* pythonTimerDict = PyDict_New();
-    for (auto& t : timings)
+    if (statistics)
     {
-        PyObject* val = Py_BuildValue("K", static_cast<uint64_t>(t.second));
-        PyDict_SetItemString(pythonTimerDict, t.first.c_str(), val);
-        Py_DECREF(val);
+        for (auto& t : Timer::get().getStatistics())
+        {
+            PyObject* val = Py_BuildValue("{s:K,s:K,s:K,s:K}",
+                "count",
+                static_cast<unsigned long long>(t.second.count),
+                "p50",
+                static_cast<unsigned long long>(t.second.p50),
+                "p99",
+                static_cast<unsigned long long>(t.second.p99),
+                "max",
+                static_cast<unsigned long long>(t.second.max));
+            PyDict_SetItemString(pythonTimerDict, t.first.c_str(), val);
+            Py_DECREF(val);
+        }
+    }
+    else
+    {
+        for (auto& t : Timer::get().getDurationMap())
+        {
+            PyObject* val = Py_BuildValue("K", static_cast<uint64_t>(t.second));
+            PyDict_SetItemString(pythonTimerDict, t.first.c_str(), val);
+            Py_DECREF(val);
+        }
     }
 
     return pythonTimerDict;
@@ -1076,7 +1106,7 @@ PyMethodDef PythonEmbedded::SplashMethods[] = {
     {(const char*)"get_object_links", (PyCFunction)PythonEmbedded::pythonGetObjectLinks, METH_VARARGS | METH_KEYWORDS, pythonGetObjectLinks_doc__},
     {(const char*)"get_object_reversed_links", (PyCFunction)PythonEmbedded::pythonGetObjectReversedLinks, METH_VARARGS | METH_KEYWORDS, pythonGetObjectReversedLinks_doc__},
     {(const char*)"get_types_from_category", (PyCFunction)PythonEmbedded::pythonGetTypesFromCategory, METH_VARARGS | METH_KEYWORDS, pythonGetTypesFromCategory_doc__},
-    {(const char*)"get_timings", (PyCFunction)PythonEmbedded::pythonGetTimings, METH_VARARGS, pythonGetTimings_doc__},
+    {(const char*)"get_timings", (PyCFunction)PythonEmbedded::pythonGetTimings, METH_VARARGS | METH_KEYWORDS, pythonGetTimings_doc__},
     {(const char*)"register_attribute_callback", (PyCFunction)PythonEmbedded::pythonRegisterAttributeCallback, METH_VARARGS | METH_KEYWORDS, pythonRegisterAttributeCallback_doc__},
     {(const char*)"set_world_attribute", (PyCFunction)PythonEmbedded::pythonSetGlobal, METH_VARARGS | METH_KEYWORDS, pythonSetGlobal_doc__},
     {(const char*)"set_object_attribute", (PyCFunction)PythonEmbedded::pythonSetObject, METH_VARARGS | METH_KEYWORDS, pythonSetObject_doc__},
@@ -1119,6 +1149,14 @@ PyObject* PythonEmbedded::pythonInitSplash()
     Py_INCREF(&PythonSink::pythonSinkType);
     PyModule_AddObject(module, "Sink", (PyObject*)&PythonSink::pythonSinkType);
 
+    if (PyType_Ready(&PythonSink::pythonSinkFrameType) < 0)
+    {
+        Log::get() << Log::WARNING << "PythonEmbedded::" << __FUNCTION__ << " - SinkFrame type is not ready" << Log::endl;
+        return nullptr;
+    }
+    Py_INCREF(&PythonSink::pythonSinkFrameType);
+    PyModule_AddObject(module, "SinkFrame", (PyObject*)&PythonSink::pythonSinkFrameType);
+
     SplashError = PyErr_NewException((const char*)"splash.error", PyExc_Exception, nullptr);
     if (SplashError)
     {
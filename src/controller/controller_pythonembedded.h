@@ -141,7 +141,7 @@ class PythonEmbedded : public ControllerObject
     static PyObject* pythonInitSplash();
     static PyObject* pythonGetInterpreterName(PyObject* self, PyObject* args);
     static PyObject* pythonGetLogs(PyObject* self, PyObject* args);
-    static PyObject* pythonGetTimings(PyObject* self, PyObject* args);
+    static PyObject* pythonGetTimings(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetMasterClock(PyObject* self, PyObject* args);
     static PyObject* pythonGetObjectAlias(PyObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonGetObjectAliases(PyObject* self, PyObject* args);
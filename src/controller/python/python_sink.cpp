@@ -30,7 +30,6 @@ void PythonSink::pythonSinkDealloc(PythonSinkObject* self)
         that->setInScene("deleteObject", {self->filterName});
     }
 
-    Py_XDECREF(self->lastBuffer);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -262,17 +261,21 @@ PyObject* PythonSink::pythonSinkUnlink(PythonSinkObject* self)
 
 /*************/
 PyDoc_STRVAR(pythonSinkGrab_doc__,
-    "Grab the latest image from the sink\n"
+    "Grab the next image from the sink, waiting for it if needed\n"
     "\n"
-    "splash.grab()\n"
+    "splash.grab(timeout=1.0)\n"
+    "\n"
+    "Args:\n"
+    "  timeout (float): Maximum waiting time, in seconds\n"
     "\n"
     "Returns:\n"
-    "  The grabbed image as a bytes object\n"
+    "  The grabbed image as a splash.SinkFrame, which exposes the pixels through the buffer protocol without copying them,\n"
+    "  as well as its width, height, channels, sequence number and timestamp. None if no image arrived before the timeout\n"
     "\n"
     "Raises:\n"
     "  splash.error: if Splash instance is not available");
 
-PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
+PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self, PyObject* args, PyObject* kwds)
 {
     auto that = PythonEmbedded::getInstance();
     if (!that)
@@ -288,53 +291,52 @@ PyObject* PythonSink::pythonSinkGrab(PythonSinkObject* self)
     if (!self->opened)
         return Py_BuildValue("");
 
-    // The Sink wrapper can be opened although its Splash counterpart has not
-    // received the order yet. We wait for that
-    Values opened({false});
-    while (!opened[0].as<bool>())
-    {
-        self->sink->getAttribute("opened", opened);
-        this_thread::sleep_for(chrono::milliseconds(5));
-    }
+    double timeout = 1.0;
+    static char* kwlist[] = {(char*)"timeout", nullptr};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d", kwlist, &timeout))
+        return nullptr;
 
-    // Due to the asynchronicity of passing messages to Splash, the frame may still
-    // be at a wrong resolution if set_size was called. We test for this case.
-    PyObject* buffer = nullptr;
-    int triesLeft = SPLASH_PYTHON_MAX_TRIES;
-    while (triesLeft)
+    // The Sink wrapper can be opened although its Splash counterpart has not received the order yet,
+    // and due to the asynchronicity of passing messages to Splash, the frame may still be at a wrong resolution
+    // if set_size was called. In both cases we wait for the next frames, with the GIL released
+    auto deadline = chrono::steady_clock::now() + chrono::microseconds(static_cast<int64_t>(max(timeout, 0.0) * 1e6));
+    shared_ptr<const Sink::Frame> frame{nullptr};
+    while (true)
     {
-        auto frame = self->sink->getBuffer();
-        if (frame.size() != self->width * self->height * 4 /* RGBA*/)
+        auto remaining = chrono::duration_cast<chrono::microseconds>(deadline - chrono::steady_clock::now());
+        if (remaining.count() < 0)
+            break;
+
+        auto threadState = PyEval_SaveThread();
+        frame = self->sink->waitForFrame(self->lastSequence, remaining);
+        PyEval_RestoreThread(threadState);
+
+        if (!frame)
+            break;
+        self->lastSequence = frame->sequence;
+
+        // Keeping the ratio may also have had some effects
+        if (self->keepRatio)
         {
-            --triesLeft;
-            this_thread::sleep_for(chrono::milliseconds(5));
-            // Keeping the ratio may also have had some effects
-            if (self->keepRatio)
-            {
-                auto realSize = that->getObjectAttribute(self->filterName, "sizeOverride");
-                self->width = realSize[0].as<int>();
-                self->height = realSize[1].as<int>();
-            }
+            auto realSize = that->getObjectAttribute(self->filterName, "sizeOverride");
+            self->width = realSize[0].as<int>();
+            self->height = realSize[1].as<int>();
         }
-        else
-        {
-            buffer = PyByteArray_FromStringAndSize(reinterpret_cast<char*>(frame.data()), frame.size());
+
+        if (frame->spec.width == self->width && frame->spec.height == self->height)
             break;
-        }
+        frame.reset();
     }
 
-    if (!buffer)
+    if (!frame)
         return Py_BuildValue("");
 
-    PyObject* tmp = nullptr;
-    if (self->lastBuffer != nullptr)
-        tmp = self->lastBuffer;
-    self->lastBuffer = buffer;
-    if (tmp != nullptr)
-        Py_XDECREF(tmp);
+    auto frameObject = reinterpret_cast<PythonSinkFrameObject*>(pythonSinkFrameType.tp_alloc(&pythonSinkFrameType, 0));
+    if (!frameObject)
+        return nullptr;
+    new (&frameObject->frame) shared_ptr<const Sink::Frame>(frame);
 
-    Py_INCREF(self->lastBuffer);
-    return self->lastBuffer;
+    return reinterpret_cast<PyObject*>(frameObject);
 }
 
 /*************/
@@ -516,6 +518,10 @@ PyObject* PythonSink::pythonSinkOpen(PythonSinkObject* self)
         return Py_False;
     }
 
+    // Only the frames rendered after opening are grabbed
+    auto lastFrame = self->sink ? self->sink->getLastFrame() : nullptr;
+    self->lastSequence = lastFrame ? lastFrame->sequence : 0;
+
     that->setObjectAttribute(self->sinkName, "opened", {1});
     self->opened = true;
 
@@ -554,13 +560,6 @@ PyObject* PythonSink::pythonSinkClose(PythonSinkObject* self)
     that->setObjectAttribute(self->sinkName, "opened", {0});
     self->opened = false;
 
-    PyObject* tmp = nullptr;
-    if (self->lastBuffer != nullptr)
-        tmp = self->lastBuffer;
-    self->lastBuffer = nullptr;
-    if (tmp != nullptr)
-        Py_XDECREF(tmp);
-
     Py_INCREF(Py_True);
     return Py_True;
 }
@@ -597,10 +596,63 @@ PyObject* PythonSink::pythonSinkGetCaps(PythonSinkObject* self)
     return Py_BuildValue("s", caps.c_str());
 }
 
+/****************************/
+// Sink frame Python wrapper //
+/****************************/
+void PythonSink::pythonSinkFrameDealloc(PythonSinkFrameObject* self)
+{
+    self->frame.~shared_ptr<const Sink::Frame>();
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+/*************/
+int PythonSink::pythonSinkFrameGetBuffer(PythonSinkFrameObject* self, Py_buffer* view, int flags)
+{
+    // The pixels are exposed as read-only bytes, the frame being shared with the sink and the other readers
+    auto& pixels = self->frame->pixels;
+    return PyBuffer_FillInfo(view, reinterpret_cast<PyObject*>(self), const_cast<uint8_t*>(pixels.data()), pixels.size(), 1, flags);
+}
+
+/*************/
+Py_ssize_t PythonSink::pythonSinkFrameLength(PythonSinkFrameObject* self)
+{
+    return self->frame->pixels.size();
+}
+
+/*************/
+PyObject* PythonSink::pythonSinkFrameGetWidth(PythonSinkFrameObject* self, void* /*closure*/)
+{
+    return Py_BuildValue("I", self->frame->spec.width);
+}
+
+/*************/
+PyObject* PythonSink::pythonSinkFrameGetHeight(PythonSinkFrameObject* self, void* /*closure*/)
+{
+    return Py_BuildValue("I", self->frame->spec.height);
+}
+
+/*************/
+PyObject* PythonSink::pythonSinkFrameGetChannels(PythonSinkFrameObject* self, void* /*closure*/)
+{
+    return Py_BuildValue("I", self->frame->spec.channels);
+}
+
+/*************/
+PyObject* PythonSink::pythonSinkFrameGetSequence(PythonSinkFrameObject* self, void* /*closure*/)
+{
+    return Py_BuildValue("K", static_cast<unsigned long long>(self->frame->sequence));
+}
+
+/*************/
+PyObject* PythonSink::pythonSinkFrameGetTimestamp(PythonSinkFrameObject* self, void* /*closure*/)
+{
+    return Py_BuildValue("L", static_cast<long long>(self->frame->timestamp));
+}
+
 // clang-format off
 /*************/
 PyMethodDef PythonSink::SinkMethods[] = {
-    {(const char*)"grab", (PyCFunction)PythonSink::pythonSinkGrab, METH_NOARGS, pythonSinkGrab_doc__},
+    {(const char*)"grab", (PyCFunction)PythonSink::pythonSinkGrab, METH_VARARGS | METH_KEYWORDS, pythonSinkGrab_doc__},
     {(const char*)"set_size", (PyCFunction)PythonSink::pythonSinkSetSize, METH_VARARGS | METH_KEYWORDS, pythonSinkSetSize_doc__},
     {(const char*)"get_size", (PyCFunction)PythonSink::pythonSinkGetSize, METH_VARARGS | METH_KEYWORDS, pythonSinkGetSize_doc__},
     {(const char*)"set_framerate", (PyCFunction)PythonSink::pythonSinkSetFramerate, METH_VARARGS | METH_KEYWORDS, pythonSinkSetFramerate_doc__},
@@ -654,6 +706,61 @@ PyTypeObject PythonSink::pythonSinkType = {
     0,                                                   /* tp_alloc */
     PythonSink::pythonSinkNew                            /* tp_new */
 };
+
+/*************/
+PyBufferProcs PythonSink::SinkFrameBufferProcs = {
+    (getbufferproc)PythonSink::pythonSinkFrameGetBuffer, /* bf_getbuffer */
+    nullptr                                              /* bf_releasebuffer */
+};
+
+/*************/
+PySequenceMethods PythonSink::SinkFrameSequenceMethods = {
+    (lenfunc)PythonSink::pythonSinkFrameLength,          /* sq_length */
+};
+
+/*************/
+PyGetSetDef PythonSink::SinkFrameGetSetters[] = {
+    {(char*)"width", (getter)PythonSink::pythonSinkFrameGetWidth, nullptr, (char*)"Frame width", nullptr},
+    {(char*)"height", (getter)PythonSink::pythonSinkFrameGetHeight, nullptr, (char*)"Frame height", nullptr},
+    {(char*)"channels", (getter)PythonSink::pythonSinkFrameGetChannels, nullptr, (char*)"Channel count", nullptr},
+    {(char*)"sequence", (getter)PythonSink::pythonSinkFrameGetSequence, nullptr, (char*)"Sequence number of the frame in the sink, starting at 1", nullptr},
+    {(char*)"timestamp", (getter)PythonSink::pythonSinkFrameGetTimestamp, nullptr, (char*)"Time at which the frame was read from the GPU, in microseconds", nullptr},
+    {nullptr}
+};
+
+/*************/
+PyTypeObject PythonSink::pythonSinkFrameType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    (const char*) "splash.SinkFrame",                    /* tp_name */
+    sizeof(PythonSinkFrameObject),                       /* tp_basicsize */
+    0,                                                   /* tp_itemsize */
+    (destructor)PythonSink::pythonSinkFrameDealloc,      /* tp_dealloc */
+    0,                                                   /* tp_print */
+    0,                                                   /* tp_getattr */
+    0,                                                   /* tp_setattr */
+    0,                                                   /* tp_reserved */
+    0,                                                   /* tp_repr */
+    0,                                                   /* tp_as_number */
+    &PythonSink::SinkFrameSequenceMethods,               /* tp_as_sequence */
+    0,                                                   /* tp_as_mapping */
+    0,                                                   /* tp_hash  */
+    0,                                                   /* tp_call */
+    0,                                                   /* tp_str */
+    0,                                                   /* tp_getattro */
+    0,                                                   /* tp_setattro */
+    &PythonSink::SinkFrameBufferProcs,                   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                                  /* tp_flags */
+    (const char*)"Frame grabbed from a Splash Sink, exposing its pixels through the buffer protocol", /* tp_doc */
+    0,                                                   /* tp_traverse */
+    0,                                                   /* tp_clear */
+    0,                                                   /* tp_richcompare */
+    0,                                                   /* tp_weaklistoffset */
+    0,                                                   /* tp_iter */
+    0,                                                   /* tp_iternext */
+    0,                                                   /* tp_methods */
+    0,                                                   /* tp_members */
+    PythonSink::SinkFrameGetSetters,                     /* tp_getset */
+};
 // clang-format on
 
 } // namespace Splash
@@ -52,17 +52,23 @@ class PythonSink
         std::shared_ptr<Splash::Sink> sink{nullptr};
         bool linked{false};
         bool opened{false};
-        PyObject* lastBuffer{nullptr};
+        uint64_t lastSequence{0}; //!< Sequence number of the last grabbed frame
     };
     PythonSinkObject pythonSinkObject;
 
+    // Frame returned by grab, giving access to the sink frame through the buffer protocol
+    struct PythonSinkFrameObject
+    {
+        PyObject_HEAD std::shared_ptr<const Sink::Frame> frame;
+    };
+
     // Sink wrapper methods. They are in this class to be able to access the Splash capsule
     static void pythonSinkDealloc(PythonSinkObject* self);
     static PyObject* pythonSinkNew(PyTypeObject* type, PyObject* args, PyObject* kwds);
     static int pythonSinkInit(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkLink(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkUnlink(PythonSinkObject* self);
-    static PyObject* pythonSinkGrab(PythonSinkObject* self);
+    static PyObject* pythonSinkGrab(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkSetSize(PythonSinkObject* self, PyObject* args, PyObject* kwds);
     static PyObject* pythonSinkGetSize(PythonSinkObject* self);
     static PyObject* pythonSinkKeepRatio(PythonSinkObject* self, PyObject* args, PyObject* kwds);
@@ -73,6 +79,21 @@ class PythonSink
 
     static PyMethodDef SinkMethods[];
     static PyTypeObject pythonSinkType;
+
+    // Sink frame methods
+    static void pythonSinkFrameDealloc(PythonSinkFrameObject* self);
+    static int pythonSinkFrameGetBuffer(PythonSinkFrameObject* self, Py_buffer* view, int flags);
+    static Py_ssize_t pythonSinkFrameLength(PythonSinkFrameObject* self);
+    static PyObject* pythonSinkFrameGetWidth(PythonSinkFrameObject* self, void* closure);
+    static PyObject* pythonSinkFrameGetHeight(PythonSinkFrameObject* self, void* closure);
+    static PyObject* pythonSinkFrameGetChannels(PythonSinkFrameObject* self, void* closure);
+    static PyObject* pythonSinkFrameGetSequence(PythonSinkFrameObject* self, void* closure);
+    static PyObject* pythonSinkFrameGetTimestamp(PythonSinkFrameObject* self, void* closure);
+
+    static PyBufferProcs SinkFrameBufferProcs;
+    static PySequenceMethods SinkFrameSequenceMethods;
+    static PyGetSetDef SinkFrameGetSetters[];
+    static PyTypeObject pythonSinkFrameType;
 };
 
 }
@@ -12,7 +12,7 @@ void GuiGraph::render()
 {
     if (ImGui::CollapsingHeader(_name.c_str()))
     {
-        auto& durationMap = Timer::get().getDurationMap();
+        auto durationMap = Timer::get().getDurationMap();
 
         for (auto& t : durationMap)
         {
@@ -43,6 +43,7 @@ Attribute& Attribute::operator=(Attribute&& a)
         _defaultSetAndGet = a._defaultSetAndGet;
         _doUpdateDistant = a._doUpdateDistant;
         _savable = a._savable;
+        _version = a._version.load();
     }
 
     return *this;
@@ -70,6 +71,7 @@ bool Attribute::operator()(const Values& args)
         for (const auto& a : args)
             _valuesTypes.push_back(a.getTypeAsChar());
 
+        ++_version;
         return true;
     }
     else if (!_setFunc)
@@ -98,7 +100,11 @@ bool Attribute::operator()(const Values& args)
         }
     }
 
-    return _setFunc(forward<const Values&>(args));
+    if (!_setFunc(forward<const Values&>(args)))
+        return false;
+
+    ++_version;
+    return true;
 }
 
 /*************/
@@ -227,6 +227,12 @@ class Attribute
      */
     void setSyncMethod(const Sync& method) { _syncMethod = method; }
 
+    /**
+     * \brief Get the version of the attribute, incremented each time it is successfully set
+     * \return Return the version
+     */
+    uint64_t getVersion() const { return _version; }
+
   private:
     mutable std::mutex _defaultFuncMutex{};
     std::string _name{}; // Name of the attribute
@@ -248,6 +254,7 @@ class Attribute
     std::map<uint32_t, Callback> _callbacks{};
 
     bool _isLocked{false};
+    std::atomic<uint64_t> _version{0}; //!< Incremented by each successful call to the setter
 };
 
 } // end of namespace
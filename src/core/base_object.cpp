@@ -35,6 +35,10 @@ bool BaseObject::setAttribute(const string& attrib, const Values& args)
         _updatedParams = true;
     bool attribResult = attribFunction->second(forward<const Values&>(args));
 
+    // Bumped once the value is set, so that a render reading the new version also sees the new value
+    if (attribResult && !attribFunction->second.isDefault())
+        ++_attributesVersion;
+
     return attribResult && attribNotPresent;
 }
 
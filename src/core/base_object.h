@@ -75,6 +75,12 @@ class BaseObject
      */
     bool setAttribute(const std::string& attrib, const Values& args = {});
 
+    /**
+     * \brief Get a counter incremented each time an attribute of this object is set
+     * \return Return the counter value
+     */
+    uint64_t getAttributesVersion() const { return _attributesVersion; }
+
     /**
      * \brief Get the specified attribute
      * \param attrib Attribute name
@@ -135,6 +141,7 @@ class BaseObject
     std::string _name{""};                                              //!< Object name
     std::unordered_map<std::string, Attribute> _attribFunctions; //!< Map of all attributes
     bool _updatedParams{true};                                          //!< True if the parameters have been updated and the object needs to reflect these changes
+    std::atomic<uint64_t> _attributesVersion{0};                        //!< Incremented each time an attribute is set
 
     std::future<void> _asyncTask{};
     std::mutex _asyncTaskMutex{};
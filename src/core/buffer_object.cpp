@@ -22,6 +22,8 @@ bool BufferObject::deserialize()
 
     bool returnValue = deserialize(_serializedObject);
     _newSerializedObject = false;
+    // The serialized object may hold a shared memory slot, which is handed back to the sender once released
+    _serializedObject.reset();
 
     return returnValue;
 }
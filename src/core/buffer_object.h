@@ -135,6 +135,12 @@ class BufferObject : public GraphObject
      */
     void updateTimestamp();
 
+    /**
+     * \brief Get the version of the content of the object, which is the buffer timestamp
+     * \return Return the version
+     */
+    uint64_t getContentVersion() const override { return _timestamp; }
+
     /**
      * \brief Register new attributes
      */
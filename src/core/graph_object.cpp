@@ -7,6 +7,15 @@ using namespace std;
 namespace Splash
 {
 
+namespace
+{
+/*************/
+inline void combineVersion(uint64_t& seed, uint64_t value)
+{
+    seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+} // end of anonymous namespace
+
 /*************/
 Attribute& GraphObject::operator[](const string& attr)
 {
@@ -111,7 +120,7 @@ Json::Value GraphObject::getConfigurationAsJson() const
 }
 
 /*************/
-unordered_map<string, Values> GraphObject::getDistantAttributes() const
+unordered_map<string, Values> GraphObject::getUpdatedDistantAttributes()
 {
     unordered_map<string, Values> attribs;
     for (auto& attr : _attribFunctions)
@@ -119,11 +128,23 @@ unordered_map<string, Values> GraphObject::getDistantAttributes() const
         if (!attr.second.doUpdateDistant())
             continue;
 
+        auto version = attr.second.getVersion();
+        auto stateIt = _distantAttributesState.find(attr.first);
+        bool wasSet = stateIt == _distantAttributesState.end() || stateIt->second.version != version;
+
+        // Attributes using the default getter can only change through their setter
+        if (!wasSet && attr.second.isDefault())
+            continue;
+
         Values values;
         if (getAttribute(attr.first, values, false, true) == false || values.size() == 0)
             continue;
 
+        if (!wasSet && stateIt->second.values == values)
+            continue;
+
         attribs[attr.first] = values;
+        _distantAttributesState[attr.first] = {version, values};
     }
 
     return attribs;
@@ -217,4 +238,41 @@ void GraphObject::registerAttributes()
         {'s'});
 }
 
+/*************/
+bool GraphObject::needsRender(bool force)
+{
+    auto inputsVersion = computeGraphVersion(0, false);
+    if (!force && _renderedOnce && inputsVersion == _renderedInputsVersion)
+    {
+        _renderSkipped = true;
+        return false;
+    }
+
+    _renderedInputsVersion = inputsVersion;
+    _renderedOnce = true;
+    _renderSkipped = false;
+    return true;
+}
+
+/*************/
+uint64_t GraphObject::computeGraphVersion(uint32_t depth, bool withContent) const
+{
+    uint64_t version = _attributesVersion;
+    if (withContent)
+        combineVersion(version, getContentVersion());
+
+    if (depth >= SPLASH_GRAPH_VERSION_MAX_DEPTH)
+        return version;
+
+    for (const auto& weakObject : _linkedObjects)
+    {
+        auto object = weakObject.lock();
+        if (object)
+            combineVersion(version, object->computeGraphVersion(depth + 1, true));
+    }
+    combineVersion(version, _linkedObjects.size());
+
+    return version;
+}
+
 } // namespace Splash
@@ -27,6 +27,8 @@
 
 #include "./core/base_object.h"
 
+#define SPLASH_GRAPH_VERSION_MAX_DEPTH 16 // Depth at which the objects linked to an object are not checked anymore, for cyclic graphs
+
 namespace Splash
 {
 
@@ -151,11 +153,12 @@ class GraphObject : public BaseObject, public std::enable_shared_from_this<Graph
     virtual void unlinkFrom(const std::shared_ptr<GraphObject>& obj);
 
     /**
-     * \brief Get the map of the attributes which should be updated from World to Scene
+     * \brief Get the map of the attributes which should be updated from World to Scene, and which changed since the last call
      * \brief This is the case when the distant object is different from the World one
-     * \return Returns a map of the distant attributes
+     * \brief An attribute is considered changed if it was set, even to the same value, or if its getter returns a different value
+     * \return Returns a map of the updated distant attributes
      */
-    std::unordered_map<std::string, Values> getDistantAttributes() const;
+    std::unordered_map<std::string, Values> getUpdatedDistantAttributes();
 
     /**
      * \brief Return a vector of the linked objects
@@ -163,6 +166,19 @@ class GraphObject : public BaseObject, public std::enable_shared_from_this<Graph
      */
     const std::vector<std::shared_ptr<GraphObject>> getLinkedObjects();
 
+    /**
+     * \brief Get a version of everything this object is rendered from. It changes whenever the attributes or the content of this object change,
+     * \brief or those of the objects linked to it, recursively
+     * \return Return the version
+     */
+    uint64_t getGraphVersion() const { return computeGraphVersion(0, true); }
+
+    /**
+     * \brief Check whether the last call to render() was skipped, as nothing the object is rendered from changed
+     * \return Return true if the render was skipped
+     */
+    bool isRenderSkipped() const { return _renderSkipped; }
+
     /**
      * \brief Get the savability for this object
      * \return Returns true if the object should be saved
@@ -283,9 +299,19 @@ class GraphObject : public BaseObject, public std::enable_shared_from_this<Graph
 
     bool _isConnectedToRemote{false}; //!< True if the object gets data from a World object
 
+    std::atomic<uint64_t> _contentVersion{0}; //!< Incremented when the content of the object changes, other than through its attributes
+    bool _renderSkipped{false};               //!< True if the last render was skipped
+
     RootObject* _root;                                      //!< Root object, Scene or World
     std::vector<std::weak_ptr<GraphObject>> _linkedObjects; //!< Children of this object
 
+    struct DistantAttributeState
+    {
+        uint64_t version{0};
+        Values values{};
+    };
+    std::unordered_map<std::string, DistantAttributeState> _distantAttributesState{}; //!< Last state of the distant attributes sent to the Scenes
+
     /**
      * Inform that the given object is a parent
      * \param obj Parent object
@@ -302,6 +328,31 @@ class GraphObject : public BaseObject, public std::enable_shared_from_this<Graph
      * \brief Register new attributes
      */
     void registerAttributes();
+
+    /**
+     * \brief Get the version of the content of the object, for the changes which do not go through its attributes
+     * \return Return the version
+     */
+    virtual uint64_t getContentVersion() const { return _contentVersion; }
+
+    /**
+     * \brief Check whether the object has to be rendered, which is the case if its attributes or the objects linked to it changed since the last render
+     * \param force If true, the object is rendered whether something changed or not
+     * \return Return true if the object has to be rendered
+     */
+    bool needsRender(bool force = false);
+
+  private:
+    uint64_t _renderedInputsVersion{0};
+    bool _renderedOnce{false};
+
+    /**
+     * \brief Compute the version of the object and of the objects linked to it
+     * \param depth Current recursion depth, to stop on cyclic links
+     * \param withContent If true, include the content version of this object. It is left out when checking whether the object itself has to be rendered
+     * \return Return the version
+     */
+    uint64_t computeGraphVersion(uint32_t depth, bool withContent) const;
 };
 
 } // namespace Splash
@@ -106,6 +106,13 @@ ImageBuffer::ImageBuffer(const ImageBufferSpec& spec)
     init(spec);
 }
 
+/*************/
+ImageBuffer::ImageBuffer(const ImageBufferSpec& spec, ResizableArray<char>&& buffer)
+    : _spec(spec)
+    , _buffer(std::move(buffer))
+{
+}
+
 /*************/
 ImageBuffer::~ImageBuffer()
 {
@@ -140,10 +140,10 @@ class ImageBufferSpec
     int pixelBytes() const { return bpp / 8; }
 
     /**
-     * \brief Get image size in bytes
+     * \brief Get image size in bytes, computed from the bits per pixel to handle chroma subsampled formats
      * \return Return image size
      */
-    int rawSize() const { return pixelBytes() * width * height; }
+    int rawSize() const { return static_cast<int>(static_cast<int64_t>(width) * height * bpp / 8); }
 };
 
 /*************/
@@ -161,6 +161,13 @@ class ImageBuffer
      */
     ImageBuffer(const ImageBufferSpec& spec);
 
+    /**
+     * \brief Constructor using an existing buffer, whose size must match the spec
+     * \param spec Image spec
+     * \param buffer Buffer to use as inner buffer
+     */
+    ImageBuffer(const ImageBufferSpec& spec, ResizableArray<char>&& buffer);
+
     /**
      * \brief Destructor
      */
@@ -189,6 +196,12 @@ class ImageBuffer
      */
     size_t getSize() const { return _buffer.size(); }
 
+    /**
+     * \brief Check whether the pixels are borrowed from an external buffer, for example a shared memory slot
+     * \return Return true if the buffer is external
+     */
+    bool isExternal() const { return _buffer.isExternal(); }
+
     /**
      * \brief Fill all channels with the given value
      * \param value Value to fill the image with
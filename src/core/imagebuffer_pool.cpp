@@ -0,0 +1,94 @@
+#include "./core/imagebuffer_pool.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+ImageBufferPool::ImageBufferPool(int64_t maximumSize)
+    : _maximumSize(maximumSize)
+{
+}
+
+/*************/
+ImageBufferPool::~ImageBufferPool()
+{
+    clear();
+}
+
+/*************/
+unique_ptr<ImageBuffer> ImageBufferPool::acquire(const ImageBufferSpec& spec)
+{
+    size_t size = spec.rawSize();
+    char* buffer = nullptr;
+
+    {
+        lock_guard<mutex> lock(_mutex);
+        auto bufferIt = _freeBuffers.find(size);
+        if (bufferIt != _freeBuffers.end())
+        {
+            buffer = bufferIt->second;
+            _freeBuffers.erase(bufferIt);
+            _freeSize -= size;
+            ++_hitCount;
+        }
+        else
+        {
+            ++_missCount;
+        }
+
+        _usedSize += size;
+        _highWaterMark = max<int64_t>(_highWaterMark, _usedSize + _freeSize);
+    }
+
+    if (!buffer)
+        buffer = new char[size];
+
+    // The pool may be gone when the buffer is released, in which case the memory is simply freed
+    weak_ptr<ImageBufferPool> weakPool = shared_from_this();
+    auto release = [weakPool, size](char* ptr) {
+        auto pool = weakPool.lock();
+        if (pool)
+            pool->recycle(ptr, size);
+        else
+            delete[] ptr;
+    };
+
+    return unique_ptr<ImageBuffer>(new ImageBuffer(spec, ResizableArray<char>(buffer, buffer + size, release)));
+}
+
+/*************/
+void ImageBufferPool::clear()
+{
+    lock_guard<mutex> lock(_mutex);
+    for (auto& buffer : _freeBuffers)
+        delete[] buffer.second;
+    _freeBuffers.clear();
+    _freeSize = 0;
+}
+
+/*************/
+void ImageBufferPool::setMaximumSize(int64_t size)
+{
+    lock_guard<mutex> lock(_mutex);
+    _maximumSize = size;
+}
+
+/*************/
+void ImageBufferPool::recycle(char* buffer, size_t size)
+{
+    lock_guard<mutex> lock(_mutex);
+    _usedSize -= size;
+
+    if (_usedSize + _freeSize + static_cast<int64_t>(size) > _maximumSize)
+    {
+        delete[] buffer;
+        return;
+    }
+
+    _freeBuffers.emplace(size, buffer);
+    _freeSize += size;
+}
+
+} // end of namespace
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @imagebuffer_pool.h
+ * Pool of image buffers, recycling their memory once they are destroyed
+ */
+
+#ifndef SPLASH_IMAGEBUFFER_POOL_H
+#define SPLASH_IMAGEBUFFER_POOL_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "./core/imagebuffer.h"
+
+namespace Splash
+{
+
+/*************/
+class ImageBufferPool : public std::enable_shared_from_this<ImageBufferPool>
+{
+  public:
+    /**
+     * \brief Constructor. The pool must be held by a shared_ptr
+     * \param maximumSize Maximum memory allocated by the pool, buffers in use included, above which released buffers are freed
+     */
+    explicit ImageBufferPool(int64_t maximumSize);
+
+    /**
+     * \brief Destructor. Buffers still in use are freed once released
+     */
+    ~ImageBufferPool();
+
+    ImageBufferPool(const ImageBufferPool&) = delete;
+    ImageBufferPool& operator=(const ImageBufferPool&) = delete;
+
+    /**
+     * \brief Get a buffer for the given spec, reusing a released one if possible
+     * Its memory goes back to the pool when the buffer is destroyed, wherever that happens
+     * \param spec Image spec
+     * \return Return an image buffer, whose content is undefined
+     */
+    std::unique_ptr<ImageBuffer> acquire(const ImageBufferSpec& spec);
+
+    /**
+     * \brief Free all the buffers not currently in use
+     */
+    void clear();
+
+    /**
+     * \brief Set the maximum memory allocated by the pool
+     * \param size Maximum size in bytes
+     */
+    void setMaximumSize(int64_t size);
+
+    /**
+     * \brief Get the number of acquisitions served by a released buffer
+     * \return Return the hit count
+     */
+    uint64_t getHitCount() const { return _hitCount; }
+
+    /**
+     * \brief Get the number of acquisitions which needed an allocation
+     * \return Return the miss count
+     */
+    uint64_t getMissCount() const { return _missCount; }
+
+    /**
+     * \brief Get the size of the buffers currently in use
+     * \return Return the size in bytes
+     */
+    int64_t getUsedSize() const { return _usedSize; }
+
+    /**
+     * \brief Get the maximum memory allocated at once by the pool, buffers in use included
+     * \return Return the size in bytes
+     */
+    int64_t getHighWaterMark() const { return _highWaterMark; }
+
+  private:
+    mutable std::mutex _mutex{};
+    std::multimap<size_t, char*> _freeBuffers{}; //!< Released buffers, sorted by size
+    int64_t _maximumSize{0};
+    int64_t _freeSize{0};
+    std::atomic<int64_t> _usedSize{0};
+    std::atomic<int64_t> _highWaterMark{0};
+    std::atomic<uint64_t> _hitCount{0};
+    std::atomic<uint64_t> _missCount{0};
+
+    /**
+     * \brief Take back a buffer which is not in use anymore
+     * \param buffer Buffer
+     * \param size Buffer size
+     */
+    void recycle(char* buffer, size_t size);
+};
+
+} // end of namespace
+
+#endif // SPLASH_IMAGEBUFFER_POOL_H
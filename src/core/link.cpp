@@ -38,6 +38,10 @@ Link::Link(RootObject* root, const string& name)
     if (!socketPrefix.empty())
         _basePath += socketPrefix + string("_");
 
+    _shmBasePath = "/splash_";
+    if (!socketPrefix.empty())
+        _shmBasePath += socketPrefix + string("_");
+
     _bufferInThread = thread([&]() { handleInputBuffers(); });
     _messageInThread = thread([&]() { handleInputMessages(); });
 }
@@ -79,6 +83,11 @@ void Link::connectTo(const string& name)
         _socketMessageOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
         _socketBufferOut->setsockopt(ZMQ_SNDHWM, &hwm, sizeof(hwm));
 
+        // Peers are often connected to while they are still starting, so they are retried often
+        int reconnectInterval = SPLASH_LINK_RECONNECT_INTERVAL;
+        _socketMessageOut->setsockopt(ZMQ_RECONNECT_IVL, &reconnectInterval, sizeof(reconnectInterval));
+        _socketBufferOut->setsockopt(ZMQ_RECONNECT_IVL, &reconnectInterval, sizeof(reconnectInterval));
+
         // TODO: for now, all connections are through IPC.
         _socketMessageOut->connect((_basePath + "msg_" + name).c_str());
         _socketBufferOut->connect((_basePath + "buf_" + name).c_str());
@@ -89,8 +98,16 @@ void Link::connectTo(const string& name)
             Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
     }
 
-    // Wait a bit for the connection to be up
-    this_thread::sleep_for(chrono::milliseconds(100));
+#if HAVE_LINUX
+    {
+        lock_guard<mutex> lock(_shmMutex);
+        auto slotCount = max<uint32_t>(SPLASH_SHM_RING_DEFAULT_SLOTS, SPLASH_SHM_RING_SLOTS_PER_BUFFER * _shmBufferNames.size());
+        _shmOutputs[name] = make_shared<SharedMemoryRing>(_shmBasePath + _name + "_to_" + name, true, slotCount);
+    }
+#endif
+
+    // The connection is established asynchronously, and messages sent before it is up are lost.
+    // Peers which need their first messages to go through have to handshake, see World::waitForNextScene
     _connectedToOuter = true;
 }
 
@@ -106,8 +123,6 @@ void Link::connectTo(const std::string& name, RootObject* peer)
     else
         return;
 
-    // Wait a bit for the connection to be up
-    this_thread::sleep_for(chrono::milliseconds(100));
     _connectedToInner = true;
 }
 
@@ -135,6 +150,9 @@ void Link::disconnectFrom(const std::string& name)
                 Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception while disconnecting from " << name << ": " << e.what() << Log::endl;
         }
     }
+
+    lock_guard<mutex> lock(_shmMutex);
+    _shmOutputs.erase(name);
 }
 
 /*************/
@@ -176,6 +194,7 @@ bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer)
             {
                 auto copiedBuffer = make_shared<SerializedObject>();
                 *copiedBuffer = *buffer;
+                _copiedBytes.fetch_add(buffer->size(), std::memory_order_relaxed);
                 rootObject->setFromSerializedObject(name, copiedBuffer);
             }
             else if (rootObject)
@@ -187,6 +206,9 @@ bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer)
 
     if (_connectedToOuter)
     {
+        if (name != SPLASH_LINK_HANDSHAKE_BUFFER && sendBufferThroughSharedMemory(name, buffer))
+            return true;
+
         try
         {
             lock_guard<Spinlock> lock(_bufferSendMutex);
@@ -204,6 +226,9 @@ bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer)
 
             msg.rebuild(bufferPtr->data(), bufferPtr->size(), Link::freeOlderBuffer, this);
             _socketBufferOut->send(msg);
+
+            // The buffer goes through the socket, then is copied again by each receiver
+            _copiedBytes.fetch_add(2 * bufferPtr->size() * _connectedTargets.size(), std::memory_order_relaxed);
         }
         catch (const zmq::error_t& e)
         {
@@ -215,6 +240,61 @@ bool Link::sendBuffer(const string& name, shared_ptr<SerializedObject> buffer)
     return true;
 }
 
+/*************/
+bool Link::sendBufferThroughSharedMemory(const string& name, const shared_ptr<SerializedObject>& buffer)
+{
+#if HAVE_LINUX
+    lock_guard<mutex> lock(_shmMutex);
+    if (_shmOutputs.empty())
+        return false;
+
+    // Each buffer object may have a slot in flight while its next version is written
+    if (_shmBufferNames.insert(name).second)
+    {
+        auto slotCount = max<uint32_t>(SPLASH_SHM_RING_DEFAULT_SLOTS, SPLASH_SHM_RING_SLOTS_PER_BUFFER * _shmBufferNames.size());
+        for (auto& output : _shmOutputs)
+            output.second->setSlotCount(slotCount);
+    }
+
+    // A slot is needed for every peer, otherwise the buffer is sent through the socket to all of them
+    vector<pair<string, SharedMemoryRing::SlotDescription>> descriptions;
+    for (auto& output : _shmOutputs)
+    {
+        SharedMemoryRing::SlotDescription description;
+        auto slotData = output.second->acquireSlot(buffer->size(), description);
+        if (!slotData)
+        {
+            for (auto& acquired : descriptions)
+                _shmOutputs[acquired.first]->cancelSlot(acquired.second.index);
+            return false;
+        }
+
+        memcpy(slotData, buffer->data(), buffer->size());
+        _copiedBytes.fetch_add(buffer->size(), std::memory_order_relaxed);
+        descriptions.push_back(make_pair(output.first, description));
+    }
+
+    for (auto& description : descriptions)
+    {
+        auto& slot = description.second;
+        sendMessageToOuter(description.first,
+            SPLASH_LINK_SHM_BUFFER,
+            {_name,
+                name,
+                static_cast<int64_t>(slot.index),
+                static_cast<int64_t>(slot.generation),
+                static_cast<int64_t>(slot.size),
+                static_cast<int64_t>(slot.capacity)});
+    }
+
+    return true;
+#else
+    (void)name;
+    (void)buffer;
+    return false;
+#endif
+}
+
 /*************/
 bool Link::sendBuffer(const string& name, const shared_ptr<BufferObject>& object)
 {
@@ -236,74 +316,7 @@ bool Link::sendMessage(const string& name, const string& attribute, const Values
     }
 
     if (_connectedToOuter)
-    {
-        try
-        {
-            lock_guard<Spinlock> lock(_msgSendMutex);
-
-            // First we send the name of the target
-            zmq::message_t msg(name.size() + 1);
-            memcpy(msg.data(), (void*)name.c_str(), name.size() + 1);
-            _socketMessageOut->send(msg, ZMQ_SNDMORE);
-
-            // And the target's attribute
-            msg.rebuild(attribute.size() + 1);
-            memcpy(msg.data(), (void*)attribute.c_str(), attribute.size() + 1);
-            _socketMessageOut->send(msg, ZMQ_SNDMORE);
-
-            // Helper function to send messages
-            std::function<void(const Values& message)> sendMessage;
-            sendMessage = [&](const Values& message) {
-                // Size of the message
-                int size = message.size();
-                msg.rebuild(sizeof(size));
-                memcpy(msg.data(), (void*)&size, sizeof(size));
-
-                if (message.size() == 0)
-                    _socketMessageOut->send(msg);
-                else
-                    _socketMessageOut->send(msg, ZMQ_SNDMORE);
-
-                for (uint32_t i = 0; i < message.size(); ++i)
-                {
-                    auto v = message[i];
-                    Value::Type valueType = v.getType();
-
-                    msg.rebuild(sizeof(valueType));
-                    memcpy(msg.data(), (void*)&valueType, sizeof(valueType));
-                    _socketMessageOut->send(msg, ZMQ_SNDMORE);
-
-                    std::string valueName = v.getName();
-                    msg.rebuild(sizeof(valueName) + 1);
-                    memcpy(msg.data(), valueName.c_str(), sizeof(valueName) + 1);
-                    _socketMessageOut->send(msg, ZMQ_SNDMORE);
-
-                    if (valueType == Value::Type::v)
-                        sendMessage(v.as<Values>());
-                    else
-                    {
-                        int valueSize = (valueType == Value::Type::s) ? v.size() + 1 : v.size();
-                        void* value = v.data();
-                        msg.rebuild(valueSize);
-                        memcpy(msg.data(), value, valueSize);
-
-                        if (i != message.size() - 1)
-                            _socketMessageOut->send(msg, ZMQ_SNDMORE);
-                        else
-                            _socketMessageOut->send(msg);
-                    }
-                }
-            };
-
-            // Send the message
-            sendMessage(message);
-        }
-        catch (const zmq::error_t& e)
-        {
-            if (errno != ETERM)
-                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
-        }
-    }
+        sendMessageToOuter(name, attribute, message);
 
 // We don't display broadcast messages, for visibility
 #ifdef DEBUG
@@ -314,6 +327,57 @@ bool Link::sendMessage(const string& name, const string& attribute, const Values
     return true;
 }
 
+/*************/
+void Link::beginMessageBatch()
+{
+    lock_guard<Spinlock> lock(_msgSendMutex);
+    _batchingMessages = true;
+    _batchingThread = this_thread::get_id();
+}
+
+/*************/
+void Link::endMessageBatch()
+{
+    lock_guard<Spinlock> lock(_msgSendMutex);
+    _batchingMessages = false;
+    sendEncodedMessages();
+}
+
+/*************/
+void Link::sendMessageToOuter(const string& name, const string& attribute, const Values& message)
+{
+    lock_guard<Spinlock> lock(_msgSendMutex);
+    _messageEncoder.add(name, attribute, message);
+
+    // Messages from other threads are sent right away, along with the batched ones to keep the ordering
+    if (_batchingMessages && this_thread::get_id() == _batchingThread)
+        return;
+
+    sendEncodedMessages();
+}
+
+/*************/
+void Link::sendEncodedMessages()
+{
+    if (_messageEncoder.getMessageCount() == 0)
+        return;
+
+    try
+    {
+        auto frame = _messageEncoder.encode();
+        _messageEncoder.clear();
+
+        zmq::message_t msg(frame.size());
+        memcpy(msg.data(), frame.data(), frame.size());
+        _socketMessageOut->send(msg);
+    }
+    catch (const zmq::error_t& e)
+    {
+        if (errno != ETERM)
+            Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Exception: " << e.what() << Log::endl;
+    }
+}
+
 /*************/
 void Link::freeOlderBuffer(void* data, void* hint)
 {
@@ -345,60 +409,41 @@ void Link::handleInputMessages()
         _socketMessageIn->bind((_basePath + "msg_" + _name).c_str());
         _socketMessageIn->setsockopt(ZMQ_SUBSCRIBE, NULL, 0); // We subscribe to all incoming messages
 
-        // Helper function to receive messages
         zmq::message_t msg;
-        std::function<Values(void)> recvMessage;
-        recvMessage = [&]() -> Values {
-            _socketMessageIn->recv(&msg); // size of the message
-            int size = *(int*)msg.data();
+        vector<MessageCodec::Message> messages;
+        while (true)
+        {
+            _socketMessageIn->recv(&msg);
 
-            Values values;
-            for (int i = 0; i < size; ++i)
+            messages.clear();
+            if (!MessageCodec::decode(static_cast<char*>(msg.data()), msg.size(), messages))
             {
-                _socketMessageIn->recv(&msg);
-                Value::Type valueType = *(Value::Type*)msg.data();
+                Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Received a malformed message frame, or from another version of Splash" << Log::endl;
+                continue;
+            }
 
-                _socketMessageIn->recv(&msg);
-                string valueName(static_cast<char*>(msg.data()));
+            for (auto& message : messages)
+            {
+                const auto& name = message.target;
+                const auto& attribute = message.attribute;
 
-                if (valueType == Value::Type::v)
+                // Buffers sent through shared memory are only announced on the message socket
+                if (attribute == SPLASH_LINK_SHM_BUFFER)
                 {
-                    values.push_back(recvMessage());
+                    if (name == _name)
+                        handleSharedMemoryBuffer(message.values);
+                    continue;
                 }
-                else
-                {
-                    _socketMessageIn->recv(&msg);
-                    if (valueType == Value::Type::i)
-                        values.push_back(*(int64_t*)msg.data());
-                    else if (valueType == Value::Type::f)
-                        values.push_back(*(double*)msg.data());
-                    else if (valueType == Value::Type::s)
-                        values.push_back(string((char*)msg.data()));
-                }
-
-                if (!valueName.empty())
-                    values.back().setName(valueName);
-            }
-            return values;
-        };
-
-        while (true)
-        {
-            _socketMessageIn->recv(&msg); // name of the target
-            string name((char*)msg.data());
-            _socketMessageIn->recv(&msg); // target's attribute
-            string attribute((char*)msg.data());
 
-            Values values = recvMessage();
-
-            if (_rootObject)
-                _rootObject->set(name, attribute, values);
+                if (_rootObject)
+                    _rootObject->set(name, attribute, message.values);
 // We don't display broadcast messages, for visibility
 #ifdef DEBUG
-            if (name != SPLASH_ALL_PEERS)
-                Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " (" << root->getName() << ")"
-                           << " - Receiving message for " << name << "::" << attribute << Log::endl;
+                if (name != SPLASH_ALL_PEERS)
+                    Log::get() << Log::DEBUGGING << "Link::" << __FUNCTION__ << " (" << _rootObject->getName() << ")"
+                               << " - Receiving message for " << name << "::" << attribute << Log::endl;
 #endif
+            }
         }
     }
     catch (const zmq::error_t& e)
@@ -445,4 +490,43 @@ void Link::handleInputBuffers()
     _socketBufferIn.reset();
 }
 
+/*************/
+void Link::handleSharedMemoryBuffer(const Values& description)
+{
+#if HAVE_LINUX
+    if (description.size() != 6)
+        return;
+
+    auto source = description[0].as<string>();
+    auto name = description[1].as<string>();
+
+    SharedMemoryRing::SlotDescription slot;
+    slot.index = description[2].as<uint32_t>();
+    slot.generation = description[3].as<uint32_t>();
+    slot.size = description[4].as<uint64_t>();
+    slot.capacity = description[5].as<uint64_t>();
+
+    shared_ptr<SharedMemoryRing> ring;
+    {
+        lock_guard<mutex> lock(_shmMutex);
+        auto ringIt = _shmInputs.find(source);
+        if (ringIt == _shmInputs.end())
+            ringIt = _shmInputs.emplace(source, make_shared<SharedMemoryRing>(_shmBasePath + source + "_to_" + _name, false)).first;
+        ring = ringIt->second;
+    }
+
+    auto buffer = ring->readSlot(slot);
+    if (!buffer)
+    {
+        Log::get() << Log::WARNING << "Link::" << __FUNCTION__ << " - Unable to read buffer " << name << " sent by " << source << " through shared memory" << Log::endl;
+        return;
+    }
+
+    if (_rootObject)
+        _rootObject->setFromSerializedObject(name, std::move(buffer));
+#else
+    (void)description;
+#endif
+}
+
 } // end of namespace
@@ -30,6 +30,7 @@
 #include <deque>
 #include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -37,6 +38,12 @@
 
 #include "./config.h"
 #include "./core/coretypes.h"
+#include "./core/message_codec.h"
+#include "./core/shared_memory_ring.h"
+
+#define SPLASH_LINK_SHM_BUFFER "__shmBuffer"
+#define SPLASH_LINK_HANDSHAKE_BUFFER "__handshakeBuffer" // Buffer sent to check that the buffer socket is connected, never through shared memory
+#define SPLASH_LINK_RECONNECT_INTERVAL 10 // Interval between connection attempts to a peer which is not listening yet, in milliseconds
 
 namespace Splash
 {
@@ -112,6 +119,17 @@ class Link
     template <typename T>
     bool sendMessage(const std::string& name, const std::string& attribute, const std::vector<T>& message);
 
+    /**
+     * \brief Coalesce the messages sent to outer peers from the calling thread, until endMessageBatch is called
+     * No message expecting an answer should be sent from this thread in the meantime
+     */
+    void beginMessageBatch();
+
+    /**
+     * \brief Send the messages coalesced since beginMessageBatch, as a single frame
+     */
+    void endMessageBatch();
+
     /**
      * \brief Check that all buffers were sent to the client
      * \param maximumWait Maximum waiting time
@@ -119,6 +137,12 @@ class Link
      */
     bool waitForBufferSending(std::chrono::milliseconds maximumWait);
 
+    /**
+     * \brief Get the amount of data copied while sending buffers since the last call
+     * \return Return the number of bytes
+     */
+    uint64_t getCopiedBytes() { return _copiedBytes.exchange(0); }
+
   private:
     RootObject* _rootObject;
     std::string _basePath{""};
@@ -127,6 +151,10 @@ class Link
     Spinlock _msgSendMutex;
     Spinlock _bufferSendMutex;
 
+    MessageCodec _messageEncoder{};     //!< Messages waiting to be sent to the outer peers
+    bool _batchingMessages{false};      //!< If true, messages from _batchingThread are coalesced
+    std::thread::id _batchingThread{}; //!< Thread which started the current batch
+
     std::vector<std::string> _connectedTargets;
     std::map<std::string, RootObject*> _connectedTargetPointers;
 
@@ -145,6 +173,35 @@ class Link
     std::thread _bufferInThread;
     std::thread _messageInThread;
 
+    // Shared memory transport for buffers, ZMQ sockets being used as a fallback
+    std::string _shmBasePath{""};
+    std::mutex _shmMutex{};
+    std::map<std::string, std::shared_ptr<SharedMemoryRing>> _shmOutputs{}; //!< Rings written to, one per outer peer
+    std::map<std::string, std::shared_ptr<SharedMemoryRing>> _shmInputs{};  //!< Rings read from, one per sending peer
+    std::set<std::string> _shmBufferNames{};                                //!< Buffers sent through shared memory, the rings are sized from their count
+    std::atomic_ullong _copiedBytes{0};                                     //!< Bytes copied while sending buffers
+
+    /**
+     * \brief Send a buffer to the outer peers through shared memory
+     * \param name Buffer name
+     * \param buffer Serialized buffer
+     * \return Return false if a peer had no slot available, in which case nothing is sent
+     */
+    bool sendBufferThroughSharedMemory(const std::string& name, const std::shared_ptr<SerializedObject>& buffer);
+
+    /**
+     * \brief Send a message to the outer peers only
+     * \param name Destination object name
+     * \param attribute Attribute
+     * \param message Message
+     */
+    void sendMessageToOuter(const std::string& name, const std::string& attribute, const Values& message);
+
+    /**
+     * \brief Send the encoded messages as a single frame. _msgSendMutex must be locked
+     */
+    void sendEncodedMessages();
+
     /**
      * \brief Callback to remove the shared_ptr to a sent buffer
      * \param data Pointer to sent data
@@ -161,6 +218,12 @@ class Link
      * \brief Buffer input thread function
      */
     void handleInputBuffers();
+
+    /**
+     * \brief Handle a buffer received through shared memory
+     * \param description Slot description, as sent by the peer
+     */
+    void handleSharedMemoryBuffer(const Values& description);
 };
 
 /*************/
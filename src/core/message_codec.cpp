@@ -0,0 +1,274 @@
+#include "./core/message_codec.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+
+/*************/
+void writeVarint(vector<char>& buffer, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        buffer.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+/*************/
+template <typename T>
+void writeRaw(vector<char>& buffer, const T& value)
+{
+    auto position = buffer.size();
+    buffer.resize(position + sizeof(T));
+    memcpy(buffer.data() + position, &value, sizeof(T));
+}
+
+/*************/
+// Bounds-checked reader over an encoded frame
+struct Reader
+{
+    const char* current;
+    const char* end;
+
+    bool readVarint(uint64_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            if (current >= end)
+                return false;
+            auto byte = static_cast<uint8_t>(*current++);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    bool readRaw(T& value)
+    {
+        if (static_cast<size_t>(end - current) < sizeof(T))
+            return false;
+        memcpy(&value, current, sizeof(T));
+        current += sizeof(T);
+        return true;
+    }
+
+    bool readString(string& value)
+    {
+        uint64_t length;
+        if (!readVarint(length) || static_cast<uint64_t>(end - current) < length)
+            return false;
+        value.assign(current, length);
+        current += length;
+        return true;
+    }
+};
+
+/*************/
+bool decodeValues(Reader& reader, const vector<string>& strings, Values& values, uint32_t depth)
+{
+    // Protects against malformed frames nesting values endlessly
+    if (depth > 64)
+        return false;
+
+    uint64_t count;
+    if (!reader.readVarint(count))
+        return false;
+
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        uint8_t type;
+        uint64_t nameIndex;
+        if (!reader.readRaw(type) || !reader.readVarint(nameIndex) || nameIndex >= strings.size())
+            return false;
+
+        switch (type)
+        {
+        default:
+            return false;
+        case Value::Type::i:
+        {
+            int64_t value;
+            if (!reader.readRaw(value))
+                return false;
+            values.push_back(value);
+            break;
+        }
+        case Value::Type::f:
+        {
+            double value;
+            if (!reader.readRaw(value))
+                return false;
+            values.push_back(value);
+            break;
+        }
+        case Value::Type::s:
+        {
+            string value;
+            if (!reader.readString(value))
+                return false;
+            values.push_back(value);
+            break;
+        }
+        case Value::Type::v:
+        {
+            Values value;
+            if (!decodeValues(reader, strings, value, depth + 1))
+                return false;
+            values.push_back(value);
+            break;
+        }
+        }
+
+        if (nameIndex != 0)
+            values.back().setName(strings[nameIndex]);
+    }
+
+    return true;
+}
+
+} // end of anonymous namespace
+
+/*************/
+void MessageCodec::add(const string& target, const string& attribute, const Values& values)
+{
+    writeVarint(_body, intern(target));
+    writeVarint(_body, intern(attribute));
+    encodeValues(values);
+    ++_messageCount;
+}
+
+/*************/
+vector<char> MessageCodec::encode() const
+{
+    vector<char> frame;
+    frame.reserve(16 + _strings.size() + _body.size());
+
+    writeRaw(frame, static_cast<uint32_t>(SPLASH_MESSAGE_CODEC_MAGIC));
+    writeRaw(frame, static_cast<uint16_t>(SPLASH_MESSAGE_CODEC_VERSION));
+    writeRaw(frame, static_cast<uint16_t>(0));
+
+    writeVarint(frame, _stringIndices.size());
+    frame.insert(frame.end(), _strings.begin(), _strings.end());
+
+    writeVarint(frame, _messageCount);
+    frame.insert(frame.end(), _body.begin(), _body.end());
+
+    return frame;
+}
+
+/*************/
+void MessageCodec::clear()
+{
+    _stringIndices.clear();
+    _strings.clear();
+    _body.clear();
+    _messageCount = 0;
+
+    // The empty string is always at index 0
+    intern("");
+}
+
+/*************/
+bool MessageCodec::decode(const char* data, size_t size, vector<Message>& messages)
+{
+    Reader reader{data, data + size};
+
+    uint32_t magic;
+    uint16_t version, reserved;
+    if (!reader.readRaw(magic) || !reader.readRaw(version) || !reader.readRaw(reserved))
+        return false;
+    if (magic != SPLASH_MESSAGE_CODEC_MAGIC || version != SPLASH_MESSAGE_CODEC_VERSION)
+        return false;
+
+    uint64_t stringCount;
+    if (!reader.readVarint(stringCount) || stringCount == 0 || stringCount > size)
+        return false;
+
+    vector<string> strings(stringCount);
+    for (auto& str : strings)
+        if (!reader.readString(str))
+            return false;
+
+    uint64_t messageCount;
+    if (!reader.readVarint(messageCount) || messageCount > size)
+        return false;
+
+    messages.reserve(messages.size() + messageCount);
+    for (uint64_t i = 0; i < messageCount; ++i)
+    {
+        uint64_t targetIndex, attributeIndex;
+        if (!reader.readVarint(targetIndex) || !reader.readVarint(attributeIndex))
+            return false;
+        if (targetIndex >= stringCount || attributeIndex >= stringCount)
+            return false;
+
+        Message message;
+        message.target = strings[targetIndex];
+        message.attribute = strings[attributeIndex];
+        if (!decodeValues(reader, strings, message.values, 0))
+            return false;
+
+        messages.push_back(std::move(message));
+    }
+
+    return true;
+}
+
+/*************/
+uint32_t MessageCodec::intern(const string& str)
+{
+    auto stringIt = _stringIndices.find(str);
+    if (stringIt != _stringIndices.end())
+        return stringIt->second;
+
+    uint32_t index = _stringIndices.size();
+    _stringIndices.emplace(str, index);
+    writeVarint(_strings, str.size());
+    _strings.insert(_strings.end(), str.begin(), str.end());
+
+    return index;
+}
+
+/*************/
+void MessageCodec::encodeValues(const Values& values)
+{
+    writeVarint(_body, values.size());
+    for (const auto& value : values)
+    {
+        auto type = value.getType();
+        writeRaw(_body, static_cast<uint8_t>(type));
+        writeVarint(_body, value.isNamed() ? intern(value.getName()) : 0);
+
+        switch (type)
+        {
+        case Value::Type::i:
+            writeRaw(_body, value.as<int64_t>());
+            break;
+        case Value::Type::f:
+            writeRaw(_body, value.as<double>());
+            break;
+        case Value::Type::s:
+        {
+            auto str = value.as<string>();
+            writeVarint(_body, str.size());
+            _body.insert(_body.end(), str.begin(), str.end());
+            break;
+        }
+        case Value::Type::v:
+            encodeValues(value.as<Values>());
+            break;
+        }
+    }
+}
+
+} // end of namespace
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @message_codec.h
+ * Binary encoding of the messages sent between processes by the Link
+ */
+
+#ifndef SPLASH_MESSAGE_CODEC_H
+#define SPLASH_MESSAGE_CODEC_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./core/value.h"
+
+#define SPLASH_MESSAGE_CODEC_MAGIC 0x4d4c5053 // "SPLM"
+#define SPLASH_MESSAGE_CODEC_VERSION 1
+
+namespace Splash
+{
+
+/*************/
+/**
+ * A frame holds one or more messages and is laid out as follows, fixed size numbers
+ * being in host byte order and counts, lengths and indices being LEB128 varints:
+ * - magic (uint32), version (uint16), reserved (uint16)
+ * - string count, then each string as its length followed by its characters
+ * - message count, then each message as target index, attribute index and values
+ * - values are a count followed by, for each value, its type (uint8), its name
+ *   index and its payload: int64 or double, string length and characters, or nested values
+ * Strings are interned per frame, index 0 being the empty string.
+ */
+class MessageCodec
+{
+  public:
+    struct Message
+    {
+        std::string target{""};
+        std::string attribute{""};
+        Values values{};
+    };
+
+    /**
+     * \brief Constructor
+     */
+    MessageCodec() { clear(); }
+
+    /**
+     * \brief Add a message to the current frame
+     * \param target Target object name
+     * \param attribute Target attribute
+     * \param values Attribute values
+     */
+    void add(const std::string& target, const std::string& attribute, const Values& values);
+
+    /**
+     * \brief Get the number of messages in the current frame
+     * \return Return the message count
+     */
+    uint32_t getMessageCount() const { return _messageCount; }
+
+    /**
+     * \brief Get the current frame, ready to be sent
+     * \return Return the encoded frame
+     */
+    std::vector<char> encode() const;
+
+    /**
+     * \brief Start a new frame
+     */
+    void clear();
+
+    /**
+     * \brief Decode a frame
+     * \param data Pointer to the frame
+     * \param size Frame size
+     * \param messages Decoded messages are appended to this vector
+     * \return Return false if the frame is malformed or from another version
+     */
+    static bool decode(const char* data, size_t size, std::vector<Message>& messages);
+
+  private:
+    std::unordered_map<std::string, uint32_t> _stringIndices{};
+    std::vector<char> _strings{};
+    std::vector<char> _body{};
+    uint32_t _messageCount{0};
+
+    /**
+     * \brief Get the index of a string in the frame string table, adding it if needed
+     * \param str String
+     * \return Return the index
+     */
+    uint32_t intern(const std::string& str);
+
+    /**
+     * \brief Encode values at the end of the body
+     * \param values Values to encode
+     */
+    void encodeValues(const Values& values);
+};
+
+} // end of namespace
+
+#endif // SPLASH_MESSAGE_CODEC_H
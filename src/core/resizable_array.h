@@ -26,6 +26,7 @@
 #define SPLASH_RESIZABLE_ARRAY_H
 
 #include <cstring>
+#include <functional>
 #include <memory>
 
 namespace Splash
@@ -36,6 +37,8 @@ template <typename T>
 class ResizableArray
 {
   public:
+    using ReleaseFunc = std::function<void(T*)>;
+
     /**
      * \brief Constructor with an initial size
      * \param size Initial array size
@@ -60,10 +63,35 @@ class ResizableArray
 
         _size = static_cast<size_t>(end - start);
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
+        _buffer = allocate(_size);
         memcpy(_buffer.get(), start, _size * sizeof(T));
     }
 
+    /**
+     * \brief Constructor wrapping an external buffer, without copying it
+     * The release function is called once the buffer is not used anymore by this array.
+     * \param start Begin iterator
+     * \param end End iterator
+     * \param release Function called with start as parameter when releasing the buffer
+     */
+    ResizableArray(T* start, T* end, const ReleaseFunc& release)
+    {
+        if (end <= start)
+        {
+            _size = 0;
+            _shift = 0;
+            _buffer.reset();
+            if (release)
+                release(start);
+
+            return;
+        }
+
+        _size = static_cast<size_t>(end - start);
+        _shift = 0;
+        _buffer = std::unique_ptr<T[], Deleter>(start, Deleter(release));
+    }
+
     /**
      * \brief Copy constructor
      * \param a ResizableArray to copy
@@ -72,7 +100,7 @@ class ResizableArray
     {
         _size = a.size();
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
+        _buffer = allocate(_size);
         memcpy(data(), a.data(), _size);
     }
 
@@ -98,7 +126,7 @@ class ResizableArray
 
         _size = a.size();
         _shift = 0;
-        _buffer = std::unique_ptr<T[]>(new T[_size]);
+        _buffer = allocate(_size);
         memcpy(data(), a.data(), _size);
 
         return *this;
@@ -152,6 +180,12 @@ class ResizableArray
      */
     inline size_t size() const { return _size; }
 
+    /**
+     * \brief Check whether the buffer is an external one, which is handed back to its owner when released
+     * \return Return true if the buffer is external
+     */
+    inline bool isExternal() const { return static_cast<bool>(_buffer.get_deleter().release); }
+
     /**
      * \brief Resize the buffer
      * \param size New size
@@ -165,7 +199,7 @@ class ResizableArray
             _buffer.reset(nullptr);
         }
 
-        auto newBuffer = std::unique_ptr<T[]>(new T[size]);
+        auto newBuffer = allocate(size);
         if (size >= _size)
             memcpy(newBuffer.get(), _buffer.get(), _size);
         else
@@ -177,9 +211,38 @@ class ResizableArray
     }
 
   private:
-    size_t _size{0};                       //!< Buffer size
-    size_t _shift{0};                      //!< Buffer shift
-    std::unique_ptr<T[]> _buffer{nullptr}; //!< Pointer to the buffer data
+    /**
+     * Deleter for the inner buffer, which either frees it or hands it back to its owner
+     */
+    struct Deleter
+    {
+        Deleter() = default;
+        explicit Deleter(const ReleaseFunc& func)
+            : release(func)
+        {
+        }
+
+        void operator()(T* ptr) const
+        {
+            if (release)
+                release(ptr);
+            else
+                delete[] ptr;
+        }
+
+        ReleaseFunc release{};
+    };
+
+    size_t _size{0};                                //!< Buffer size
+    size_t _shift{0};                               //!< Buffer shift
+    std::unique_ptr<T[], Deleter> _buffer{nullptr}; //!< Pointer to the buffer data
+
+    /**
+     * \brief Allocate a buffer owned by the array
+     * \param size Buffer size
+     * \return Return the newly allocated buffer
+     */
+    static std::unique_ptr<T[], Deleter> allocate(size_t size) { return std::unique_ptr<T[], Deleter>(new T[size]); }
 };
 
 } // end of namespace
@@ -10,6 +10,7 @@
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
 #include "./graphics/profiler_gl.h"
+#include "./graphics/program_cache.h"
 #include "./graphics/texture.h"
 #include "./graphics/texture_image.h"
 #include "./graphics/warp.h"
@@ -342,6 +343,7 @@ void Scene::render()
         bool firstTextureSync = true; // Sync with the texture upload the first time we need textures
         bool firstWindowSync = true;  // Sync with the texture upload the last time we need textures
         auto textureLock = unique_lock<Spinlock>(_textureMutex, defer_lock);
+        uint64_t skippedPasses = 0;  // Passes skipped as their inputs did not change
         for (auto& objPriority : objectList)
         {
             // If the objects needs some Textures, we need to sync
@@ -384,6 +386,8 @@ void Scene::render()
                         obj->setNotUpdated();
 
                 obj->render();
+                if (obj->isRenderSkipped())
+                    ++skippedPasses;
             }
 
             if (objPriority.second.size() != 0)
@@ -402,17 +406,19 @@ void Scene::render()
                 firstWindowSync = false;
             }
         }
+        Timer::get().setDuration("skipped_passes", skippedPasses);
 
         {
 #ifdef PROFILE
             PROFILEGL("swap buffers");
 #endif
             // Swap all buffers at once
-            Timer::get() << "swap";
+            static const auto swapTimerId = Timer::get().getId("swap");
+            Timer::get() << swapTimerId;
             for (auto& obj : _objects)
                 if (obj.second->getType() == "window")
                     dynamic_pointer_cast<Window>(obj.second)->swapBuffers();
-            Timer::get() >> "swap";
+            Timer::get() >> swapTimerId;
         }
     }
 
@@ -427,6 +433,9 @@ void Scene::run()
     _textureUploadFuture = async(std::launch::async, [&]() { textureUploadRun(); });
 
     _mainWindow->setAsCurrentContext();
+    auto loopSceneTimerId = Timer::get().getId("loop_scene");
+    auto runStartTime = Timer::getTime();
+    bool firstFrameRendered = false;
     while (_isRunning)
     {
         // This gets the whole loop duration
@@ -437,15 +446,16 @@ void Scene::run()
             Timer::get() << "swap_sync";
         }
 
-        Timer::get() >> "loop_scene";
-        Timer::get() << "loop_scene";
+        Timer::get() >> loopSceneTimerId;
+        Timer::get() << loopSceneTimerId;
 
         // Execute waiting tasks
         runTasks();
 
+        // Tasks are run often while waiting for the start, as objects are created through them
         if (!_started)
         {
-            this_thread::sleep_for(chrono::milliseconds(50));
+            this_thread::sleep_for(chrono::milliseconds(5));
             continue;
         }
 
@@ -453,6 +463,17 @@ void Scene::run()
         render();
         Timer::get() >> "rendering";
 
+        // Report the startup time, which mostly depends on building the shader programs
+        if (!firstFrameRendered)
+        {
+            firstFrameRendered = true;
+            auto programStats = ProgramCache::get().getStats();
+            Log::get() << Log::MESSAGE << "Scene::" << __FUNCTION__ << " - First frame rendered " << (Timer::getTime() - runStartTime) / 1000 << "ms after start, shader programs: "
+                       << programStats.compiled << " compiled, " << programStats.loaded << " loaded from cache, " << programStats.shared << " shared, built in "
+                       << programStats.duration / 1000 << "ms" << Log::endl;
+            sendMessageToWorld("firstFrameRendered", {_name});
+        }
+
         Timer::get() << "inputsUpdate";
         updateInputs();
         Timer::get() >> "inputsUpdate";
@@ -490,12 +511,14 @@ void Scene::updateInputs()
 void Scene::textureUploadRun()
 {
     _textureUploadWindow->setAsCurrentContext();
+    auto textureUploadTimerId = Timer::get().getId("textureUpload");
 
     while (_isRunning)
     {
+        // Tasks are run often while waiting for the start, as objects are created through them
         if (!_started)
         {
-            this_thread::sleep_for(chrono::milliseconds(50));
+            this_thread::sleep_for(chrono::milliseconds(5));
             continue;
         }
 
@@ -522,7 +545,7 @@ void Scene::textureUploadRun()
                 glDeleteSync(_cameraDrawnFence);
             }
 
-            Timer::get() << "textureUpload";
+            Timer::get() << textureUploadTimerId;
 
             vector<shared_ptr<Texture>> textures;
             bool expectedAtomicValue = false;
@@ -560,7 +583,7 @@ void Scene::textureUploadRun()
                     texImage->flushPbo();
             }
 
-            Timer::get() >> "textureUpload";
+            Timer::get() >> textureUploadTimerId;
         }
 
 #ifdef PROFILE
@@ -632,6 +655,13 @@ Values Scene::sendMessageToWorldWithAnswer(const string& message, const Values&
     return sendMessageWithAnswer("world", message, value, timeout);
 }
 
+/*************/
+void Scene::handleSerializedObject(const string& name, shared_ptr<SerializedObject> /*obj*/)
+{
+    if (name == SPLASH_LINK_HANDSHAKE_BUFFER)
+        _bufferHandshakeReceived = true;
+}
+
 /*************/
 shared_ptr<GlWindow> Scene::getNewSharedWindow(const string& name)
 {
@@ -818,7 +848,6 @@ void Scene::init(const string& name)
     // Create the link and connect to the World
     _link = make_shared<Link>(this, name);
     _link->connectTo("world");
-    sendMessageToWorld("sceneLaunched", {});
 }
 
 /*************/
@@ -967,11 +996,28 @@ void Scene::registerAttributes()
 
     addAttribute("duration",
         [&](const Values& args) {
-            Timer::get().setDuration(args[0].as<string>(), args[1].as<int>());
+            for (uint32_t i = 0; i + 1 < args.size(); i += 2)
+                Timer::get().setDuration(args[i].as<string>(), args[i + 1].as<int>());
             return true;
         },
         {'s', 'n'});
-    setAttributeDescription("duration", "Set the duration of the given timer");
+    setAttributeDescription("duration", "Set the duration of the given timers, given as pairs of name and duration");
+
+    addAttribute("durationStatistics",
+        [&](const Values& args) {
+            for (uint32_t i = 0; i + 4 < args.size(); i += 5)
+            {
+                Timer::Statistics statistics;
+                statistics.count = args[i + 1].as<uint64_t>();
+                statistics.p50 = args[i + 2].as<uint64_t>();
+                statistics.p99 = args[i + 3].as<uint64_t>();
+                statistics.max = args[i + 4].as<uint64_t>();
+                Timer::get().setStatistics(args[i].as<string>(), statistics);
+            }
+            return true;
+        },
+        {'s', 'n', 'n', 'n', 'n'});
+    setAttributeDescription("durationStatistics", "Set the statistics of the given timers, given as name, count, median, 99th percentile and maximum");
 
     addAttribute("masterClock",
         [&](const Values& args) {
@@ -1018,11 +1064,12 @@ void Scene::registerAttributes()
 
     addAttribute("log",
         [&](const Values& args) {
-            Log::get().setLog(args[0].as<string>(), (Log::Priority)args[1].as<int>());
+            for (uint32_t i = 0; i + 1 < args.size(); i += 2)
+                Log::get().setLog(args[i].as<string>(), (Log::Priority)args[i + 1].as<int>());
             return true;
         },
         {'s', 'n'});
-    setAttributeDescription("log", "Add an entry to the logs, given its message and priority");
+    setAttributeDescription("log", "Add entries to the logs, given as pairs of message and priority");
 
     addAttribute("logToFile",
         [&](const Values& args) {
@@ -1032,6 +1079,14 @@ void Scene::registerAttributes()
         {'n'});
     setAttributeDescription("logToFile", "If set to 1, the process holding the Scene will try to write log to file");
 
+    addAttribute("handshake", [&](const Values&) {
+        // Buffers go through their own socket, which has to be up too before answering
+        if (_bufferHandshakeReceived)
+            sendMessageToWorld("sceneLaunched", {_name});
+        return true;
+    });
+    setAttributeDescription("handshake", "Message sent by the World until the Scene answers, to make sure that messages and buffers go through in both directions");
+
     addAttribute("ping", [&](const Values&) {
         signalBufferObjectUpdated();
         sendMessageToWorld("pong", {_name});
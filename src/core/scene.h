@@ -242,6 +242,7 @@ class Scene : public RootObject
     bool _started{false};
 
     bool _isMaster{false}; //!< Set to true if this is the master Scene of the current config
+    std::atomic_bool _bufferHandshakeReceived{false}; //!< Set to true once a buffer went through from the World
     bool _isInitialized{false};
     bool _status{false};                        //!< Set to true if an error occured during rendering
     int _swapInterval{1};                       //!< Global value for the swap interval, default for all windows
@@ -295,6 +296,13 @@ class Scene : public RootObject
     static void glMsgCallback(GLenum, GLenum, GLuint, GLenum, GLsizei, const GLchar*, void*);
 #endif
 
+    /**
+     * \brief Redefinition of a method from RootObject, to receive the buffer handshake of the World
+     * \param name Buffer name
+     * \param obj Serialized object
+     */
+    void handleSerializedObject(const std::string& name, std::shared_ptr<SerializedObject> obj) final;
+
     /**
      * \brief Texture update loop
      */
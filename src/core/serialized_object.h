@@ -54,6 +54,17 @@ struct SerializedObject
     {
     }
 
+    /**
+     * \brief Constructor wrapping an external buffer, which is not copied
+     * \param start Begin iterator
+     * \param end End iterator
+     * \param release Function called when the buffer is not used anymore
+     */
+    SerializedObject(char* start, char* end, const ResizableArray<char>::ReleaseFunc& release)
+        : _data(ResizableArray<char>(start, end, release))
+    {
+    }
+
     /**
      * \brief Get the pointer to the data
      * \return Return a pointer to the data
@@ -72,6 +83,12 @@ struct SerializedObject
      */
     std::size_t size() { return _data.size(); }
 
+    /**
+     * \brief Check whether the data is borrowed from an external buffer, which should then be released as soon as possible
+     * \return Return true if the data is borrowed
+     */
+    bool isBorrowed() const { return _data.isExternal(); }
+
     /**
      * \brief Modify the size of the data
      * \param s New size
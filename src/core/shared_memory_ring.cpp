@@ -0,0 +1,246 @@
+#include "./core/shared_memory_ring.h"
+
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./utils/log.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+const uint64_t SharedMemoryRing::_headerSize{64};
+
+/*************/
+SharedMemoryRing::Mapping::~Mapping()
+{
+    if (address != nullptr)
+        munmap(address, length);
+}
+
+/*************/
+SharedMemoryRing::SharedMemoryRing(const string& path, bool owner, uint32_t slotCount, uint32_t slotTimeout)
+    : _path(path)
+    , _owner(owner)
+    , _slotTimeout(slotTimeout)
+{
+    _slots.resize(max(1u, slotCount));
+}
+
+/*************/
+SharedMemoryRing::~SharedMemoryRing()
+{
+    if (!_owner)
+        return;
+
+    // The readers may still have the segments mapped, unlinking only removes their names
+    lock_guard<mutex> lock(_slotsMutex);
+    for (uint32_t i = 0; i < _slots.size(); ++i)
+        if (_slots[i])
+            shm_unlink(getSlotPath(i).c_str());
+}
+
+/*************/
+uint32_t SharedMemoryRing::getSlotCount()
+{
+    lock_guard<mutex> lock(_slotsMutex);
+    return _slots.size();
+}
+
+/*************/
+void SharedMemoryRing::setSlotCount(uint32_t slotCount)
+{
+    lock_guard<mutex> lock(_slotsMutex);
+    if (slotCount > _slots.size())
+        _slots.resize(slotCount);
+}
+
+/*************/
+char* SharedMemoryRing::acquireSlot(uint64_t size, SlotDescription& description)
+{
+    if (!_owner)
+        return nullptr;
+
+    lock_guard<mutex> lock(_slotsMutex);
+    auto now = chrono::steady_clock::now();
+    for (uint32_t i = 0; i < _slots.size(); ++i)
+    {
+        auto index = (_nextSlot + i) % _slots.size();
+        auto& slot = _slots[index];
+
+        if (slot)
+        {
+            auto expected = static_cast<uint32_t>(SlotState::FREE);
+            if (!slot->header()->state.compare_exchange_strong(expected, static_cast<uint32_t>(SlotState::BUSY), memory_order_acquire))
+            {
+                // The reader did not hand the slot back in time: either the announcement was lost, or the reader could not map it.
+                // The segment is replaced by a new one, so that a reader still using it keeps reading consistent data
+                if (now - slot->acquiredAt < _slotTimeout)
+                    continue;
+
+                Log::get() << Log::DEBUGGING << "SharedMemoryRing::" << __FUNCTION__ << " - Reclaiming slot " << index << " of " << _path << Log::endl;
+                if (!createSlot(index, max(slot->length - _headerSize, size + size / 4)))
+                    return nullptr;
+            }
+            // The slot is free but too small, it is replaced by a larger one
+            else if (slot->length - _headerSize < size)
+            {
+                // Some margin is kept to prevent reallocating for small size variations
+                if (!createSlot(index, size + size / 4))
+                    return nullptr;
+            }
+        }
+        else
+        {
+            if (!createSlot(index, size + size / 4))
+                return nullptr;
+        }
+
+        auto header = slot->header();
+        header->size = size;
+        slot->acquiredAt = now;
+
+        description.index = index;
+        description.generation = slot->generation;
+        description.size = size;
+        description.capacity = slot->length - _headerSize;
+
+        _nextSlot = (index + 1) % _slots.size();
+        return slot->data();
+    }
+
+    return nullptr;
+}
+
+/*************/
+void SharedMemoryRing::cancelSlot(uint32_t index)
+{
+    lock_guard<mutex> lock(_slotsMutex);
+    if (index >= _slots.size() || !_slots[index])
+        return;
+    _slots[index]->header()->state.store(static_cast<uint32_t>(SlotState::FREE), memory_order_release);
+}
+
+/*************/
+shared_ptr<SerializedObject> SharedMemoryRing::readSlot(const SlotDescription& description)
+{
+    if (_owner)
+        return {nullptr};
+
+    shared_ptr<Mapping> mapping;
+    {
+        lock_guard<mutex> lock(_slotsMutex);
+        // The writer may have grown its ring since the last buffer
+        if (description.index >= _slots.size())
+            _slots.resize(description.index + 1);
+
+        auto& slot = _slots[description.index];
+        if (!slot || slot->generation != description.generation || slot->length - _headerSize < description.size)
+            if (!mapSlot(description))
+                return {nullptr};
+
+        mapping = slot;
+    }
+
+    // The mapping is kept alive by the release function as long as the data is in use
+    auto data = mapping->data();
+    return make_shared<SerializedObject>(
+        data, data + description.size, [mapping](char*) { mapping->header()->state.store(static_cast<uint32_t>(SlotState::FREE), memory_order_release); });
+}
+
+/*************/
+bool SharedMemoryRing::createSlot(uint32_t index, uint64_t capacity)
+{
+    auto slotPath = getSlotPath(index);
+
+    // The previous segment is unlinked, readers still using it keep their own mapping
+    shm_unlink(slotPath.c_str());
+    _slots[index].reset();
+
+    int fd = shm_open(slotPath.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryRing::" << __FUNCTION__ << " - Unable to create shared memory segment " << slotPath << Log::endl;
+        return false;
+    }
+
+    auto length = _headerSize + capacity;
+    if (ftruncate(fd, length) == -1)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryRing::" << __FUNCTION__ << " - Unable to resize shared memory segment " << slotPath << Log::endl;
+        close(fd);
+        shm_unlink(slotPath.c_str());
+        return false;
+    }
+
+    auto address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryRing::" << __FUNCTION__ << " - Unable to map shared memory segment " << slotPath << Log::endl;
+        shm_unlink(slotPath.c_str());
+        return false;
+    }
+
+    auto mapping = make_shared<Mapping>();
+    mapping->address = address;
+    mapping->length = length;
+    mapping->generation = ++_generation;
+
+    auto header = new (address) SlotHeader();
+    header->state.store(static_cast<uint32_t>(SlotState::BUSY), memory_order_release);
+    header->generation = mapping->generation;
+    header->size = 0;
+
+    _slots[index] = mapping;
+    return true;
+}
+
+/*************/
+bool SharedMemoryRing::mapSlot(const SlotDescription& description)
+{
+    auto slotPath = getSlotPath(description.index);
+    _slots[description.index].reset();
+
+    int fd = shm_open(slotPath.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryRing::" << __FUNCTION__ << " - Unable to open shared memory segment " << slotPath << Log::endl;
+        return false;
+    }
+
+    // A segment replaced by a smaller one would raise SIGBUS when read past its end
+    auto length = _headerSize + description.capacity;
+    struct stat segmentStat;
+    if (fstat(fd, &segmentStat) == -1 || static_cast<uint64_t>(segmentStat.st_size) < static_cast<uint64_t>(length))
+    {
+        close(fd);
+        return false;
+    }
+
+    auto address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED)
+    {
+        Log::get() << Log::WARNING << "SharedMemoryRing::" << __FUNCTION__ << " - Unable to map shared memory segment " << slotPath << Log::endl;
+        return false;
+    }
+
+    auto mapping = make_shared<Mapping>();
+    mapping->address = address;
+    mapping->length = length;
+    mapping->generation = mapping->header()->generation;
+
+    // The segment may have been replaced since the description was sent
+    if (mapping->generation != description.generation)
+        return false;
+
+    _slots[description.index] = mapping;
+    return true;
+}
+
+} // end of namespace
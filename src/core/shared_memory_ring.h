@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @shared_memory_ring.h
+ * Ring of shared memory slots, used by the Link to send buffers between processes without copying them through sockets
+ */
+
+#ifndef SPLASH_SHARED_MEMORY_RING_H
+#define SPLASH_SHARED_MEMORY_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./core/serialized_object.h"
+
+#define SPLASH_SHM_RING_DEFAULT_SLOTS 4
+#define SPLASH_SHM_RING_SLOTS_PER_BUFFER 3 // Slots kept per buffer sent: the one displayed by the Scene, the one waiting to be displayed, and the one being written
+#define SPLASH_SHM_RING_SLOT_TIMEOUT 1000 // Delay after which a slot not handed back is replaced by a new segment, in milliseconds
+
+namespace Splash
+{
+
+/*************/
+class SharedMemoryRing
+{
+  public:
+    /**
+     * Description of a filled slot, sent to the reader alongside the buffer name
+     */
+    struct SlotDescription
+    {
+        uint32_t index{0};
+        uint32_t generation{0};
+        uint64_t size{0};
+        uint64_t capacity{0};
+    };
+
+    /**
+     * \brief Constructor
+     * \param path Base path for the shared memory segments, must start with a slash and contain no other
+     * \param owner If true, this side creates and writes into the segments. Otherwise it maps them to read from
+     * \param slotCount Number of slots in the ring
+     * \param slotTimeout Delay after which a slot which was not handed back by the reader is reclaimed, in milliseconds
+     */
+    SharedMemoryRing(const std::string& path, bool owner, uint32_t slotCount = SPLASH_SHM_RING_DEFAULT_SLOTS, uint32_t slotTimeout = SPLASH_SHM_RING_SLOT_TIMEOUT);
+
+    /**
+     * \brief Destructor
+     */
+    ~SharedMemoryRing();
+
+    SharedMemoryRing(const SharedMemoryRing&) = delete;
+    SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+
+    /**
+     * \brief Get the number of slots in the ring
+     * \return Return the slot count
+     */
+    uint32_t getSlotCount();
+
+    /**
+     * \brief Grow the ring to the given number of slots. Rings never shrink, as the reader may still use any slot
+     * \param slotCount New slot count
+     */
+    void setSlotCount(uint32_t slotCount);
+
+    /**
+     * \brief Acquire a free slot large enough to hold the given size. Writer side only
+     * Slots which were not handed back after the timeout, for example because their announcement was lost, are replaced by new segments
+     * \param size Size of the data to write
+     * \param description Description of the acquired slot, to send to the reader
+     * \return Return a pointer to the slot data, or nullptr if no slot is available
+     */
+    char* acquireSlot(uint64_t size, SlotDescription& description);
+
+    /**
+     * \brief Set back a slot as free, if it could not be sent. Writer side only
+     * \param index Slot index
+     */
+    void cancelSlot(uint32_t index);
+
+    /**
+     * \brief Get a serialized object pointing directly to the slot memory. Reader side only
+     * The slot is handed back to the writer once the returned object, or any buffer grabbed from it, is destroyed.
+     * The data should be copied out of it, or released, as soon as it is deserialized
+     * \param description Slot description, as sent by the writer
+     * \return Return a serialized object, or nullptr if the slot could not be mapped
+     */
+    std::shared_ptr<SerializedObject> readSlot(const SlotDescription& description);
+
+  private:
+    /**
+     * Header placed at the beginning of every slot segment
+     */
+    struct SlotHeader
+    {
+        std::atomic_uint state;
+        uint32_t generation;
+        uint64_t size;
+    };
+
+    /**
+     * Memory mapping of a single slot
+     */
+    struct Mapping
+    {
+        ~Mapping();
+
+        void* address{nullptr};
+        uint64_t length{0};
+        uint32_t generation{0};
+        std::chrono::steady_clock::time_point acquiredAt{}; //!< Time at which the writer acquired the slot
+
+        SlotHeader* header() const { return reinterpret_cast<SlotHeader*>(address); }
+        char* data() const { return reinterpret_cast<char*>(address) + _headerSize; }
+    };
+
+    enum class SlotState : uint32_t
+    {
+        FREE = 0,
+        BUSY = 1
+    };
+
+    static const uint64_t _headerSize; //!< Offset of the data in a slot, keeps the data aligned
+
+    std::string _path{""};
+    bool _owner{false};
+    std::chrono::milliseconds _slotTimeout{SPLASH_SHM_RING_SLOT_TIMEOUT};
+    std::mutex _slotsMutex{};
+    std::vector<std::shared_ptr<Mapping>> _slots{};
+    uint32_t _nextSlot{0};
+    uint32_t _generation{0};
+
+    /**
+     * \brief Get the shared memory name for the given slot
+     * \param index Slot index
+     * \return Return the segment name
+     */
+    std::string getSlotPath(uint32_t index) const { return _path + "_" + std::to_string(index); }
+
+    /**
+     * \brief Create a new segment for the given slot. Writer side only
+     * \param index Slot index
+     * \param capacity Capacity for the data
+     * \return Return true if all went well
+     */
+    bool createSlot(uint32_t index, uint64_t capacity);
+
+    /**
+     * \brief Map the segment of a given slot. Reader side only
+     * \param description Slot description
+     * \return Return true if all went well
+     */
+    bool mapSlot(const SlotDescription& description);
+};
+
+} // end of namespace
+
+#endif // SPLASH_SHARED_MEMORY_RING_H
@@ -0,0 +1,193 @@
+#include "./core/thread_pool.h"
+
+#include <algorithm>
+
+#include "./utils/osutils.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+thread_local int ThreadPool::_workerIndex{-1};
+
+/*************/
+ThreadPool::ThreadPool()
+{
+    // At least two workers, as tasks can wait for one another
+    auto workerCount = max(2, Utils::getCoreCount());
+    for (int i = 0; i < workerCount; ++i)
+        _workers.emplace_back(new Worker());
+
+    for (int i = 0; i < workerCount; ++i)
+        _workers[i]->thread = thread([=]() { work(i); });
+}
+
+/*************/
+future<void> ThreadPool::enqueue(const function<void()>& task)
+{
+    Task newTask;
+    newTask.function = packaged_task<void()>(task);
+    newTask.queuedAt = chrono::steady_clock::now();
+    auto result = newTask.function.get_future();
+
+    auto index = _workerIndex >= 0 ? _workerIndex : _nextWorker.fetch_add(1, memory_order_relaxed) % _workers.size();
+    auto& worker = _workers[index];
+    {
+        // The counter is increased first, so that it never goes below zero when the task is taken
+        _queuedTasks.fetch_add(1, memory_order_release);
+        lock_guard<Spinlock> lock(worker->queueMutex);
+        worker->queue.push_back(move(newTask));
+    }
+
+    {
+        lock_guard<mutex> lock(_wakeMutex);
+    }
+    _wakeCondition.notify_one();
+
+    return result;
+}
+
+/*************/
+void ThreadPool::waitAll(vector<future<void>>& futures)
+{
+    for (auto& f : futures)
+    {
+        if (!f.valid())
+            continue;
+
+        // Threads outside of the pool only wait: running any queued task on them could execute
+        // unrelated jobs on the render or world threads, with whatever locks their caller holds
+        if (_workerIndex < 0)
+        {
+            f.get();
+            continue;
+        }
+
+        while (f.wait_for(chrono::seconds(0)) != future_status::ready)
+        {
+            Task task;
+            if (popTask(_workerIndex, task))
+                runTask(task);
+            else
+                f.wait_for(chrono::microseconds(100));
+        }
+        f.get();
+    }
+}
+
+/*************/
+void ThreadPool::setAffinity(const vector<int>& cores)
+{
+    {
+        lock_guard<mutex> lock(_affinityMutex);
+        _affinity = cores;
+        _affinityVersion.fetch_add(1, memory_order_release);
+    }
+
+    // Wake up the workers so that they apply the new affinity
+    {
+        lock_guard<mutex> lock(_wakeMutex);
+    }
+    _wakeCondition.notify_all();
+}
+
+/*************/
+uint64_t ThreadPool::getTaskLatency()
+{
+    auto count = _latencyCount.exchange(0);
+    auto sum = _latencySum.exchange(0);
+    if (count == 0)
+        return 0;
+    return sum / count;
+}
+
+/*************/
+void ThreadPool::work(int index)
+{
+    _workerIndex = index;
+    uint32_t affinityVersion = 0;
+
+    while (true)
+    {
+        auto currentAffinityVersion = _affinityVersion.load(memory_order_acquire);
+        if (currentAffinityVersion != affinityVersion)
+        {
+            vector<int> cores;
+            {
+                lock_guard<mutex> lock(_affinityMutex);
+                cores = _affinity;
+            }
+
+            if (cores.empty())
+                for (int i = 0; i < Utils::getCoreCount(); ++i)
+                    cores.push_back(i);
+            Utils::setAffinity(cores);
+            affinityVersion = currentAffinityVersion;
+        }
+
+        Task task;
+        if (popTask(index, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        unique_lock<mutex> lock(_wakeMutex);
+        _wakeCondition.wait(lock, [&]() { return _queuedTasks.load(memory_order_acquire) != 0 || _affinityVersion.load(memory_order_acquire) != affinityVersion; });
+    }
+}
+
+/*************/
+bool ThreadPool::popTask(int index, Task& task)
+{
+    if (_queuedTasks.load(memory_order_acquire) == 0)
+        return false;
+
+    // Own queue first, newest task first as its data is more likely to be in cache
+    if (index >= 0)
+    {
+        auto& worker = _workers[index];
+        lock_guard<Spinlock> lock(worker->queueMutex);
+        if (!worker->queue.empty())
+        {
+            task = move(worker->queue.back());
+            worker->queue.pop_back();
+            _queuedTasks.fetch_sub(1, memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from the other workers
+    auto workerCount = static_cast<int>(_workers.size());
+    for (int i = 1; i <= workerCount; ++i)
+    {
+        auto victimIndex = (max(index, 0) + i) % workerCount;
+        if (victimIndex == index)
+            continue;
+
+        auto& worker = _workers[victimIndex];
+        lock_guard<Spinlock> lock(worker->queueMutex);
+        if (!worker->queue.empty())
+        {
+            task = move(worker->queue.front());
+            worker->queue.pop_front();
+            _queuedTasks.fetch_sub(1, memory_order_acq_rel);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*************/
+void ThreadPool::runTask(Task& task)
+{
+    auto latency = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - task.queuedAt).count();
+    _latencySum.fetch_add(latency, memory_order_relaxed);
+    _latencyCount.fetch_add(1, memory_order_relaxed);
+
+    task.function();
+}
+
+} // end of namespace
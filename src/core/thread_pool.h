@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @thread_pool.h
+ * Persistent work-stealing thread pool, shared by all the objects of a process
+ */
+
+#ifndef SPLASH_THREAD_POOL_H
+#define SPLASH_THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./config.h"
+#include "./core/spinlock.h"
+
+namespace Splash
+{
+
+/*************/
+class ThreadPool
+{
+  public:
+    /**
+     * \brief Get the process-wide pool, which is created on first call
+     * \return Return a reference to the pool
+     */
+    static ThreadPool& get()
+    {
+        static auto instance = new ThreadPool;
+        return *instance;
+    }
+
+    /**
+     * \brief Add a task to the pool
+     * Tasks added from a worker go to this worker's queue, other workers steal from it when idle
+     * \param task Task to run
+     * \return Return a future which becomes ready when the task has run. Its destructor does not wait for the task
+     */
+    std::future<void> enqueue(const std::function<void()>& task);
+
+    /**
+     * \brief Wait for the given tasks to finish
+     * When called from a worker, queued tasks are run in the meantime. This must be used instead of waiting on the futures
+     * directly from inside a task, to prevent starving the pool. Other threads only block until the tasks are done
+     * \param futures Futures returned by enqueue
+     */
+    void waitAll(std::vector<std::future<void>>& futures);
+
+    /**
+     * \brief Set the cores the workers are allowed to run on
+     * \param cores Core indices. If empty, all cores are allowed
+     */
+    void setAffinity(const std::vector<int>& cores);
+
+    /**
+     * \brief Get the number of workers
+     * \return Return the worker count
+     */
+    uint32_t getWorkerCount() const { return _workers.size(); }
+
+    /**
+     * \brief Get the number of tasks waiting to be run
+     * \return Return the queue depth
+     */
+    uint32_t getQueueDepth() const { return _queuedTasks.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Get the mean delay between adding a task and running it, since the last call
+     * \return Return the latency in microseconds
+     */
+    uint64_t getTaskLatency();
+
+  private:
+    ThreadPool();
+    ~ThreadPool() = default;
+    ThreadPool(const ThreadPool&) = delete;
+    const ThreadPool& operator=(const ThreadPool&) = delete;
+
+    struct Task
+    {
+        std::packaged_task<void()> function;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct Worker
+    {
+        Spinlock queueMutex{};
+        std::deque<Task> queue{};
+        std::thread thread{};
+    };
+
+    static thread_local int _workerIndex; //!< Index of the worker running on the current thread, -1 if none
+
+    std::vector<std::unique_ptr<Worker>> _workers{};
+    std::atomic_uint _nextWorker{0};
+    std::atomic_uint _queuedTasks{0};
+
+    std::mutex _wakeMutex{};
+    std::condition_variable _wakeCondition{};
+
+    std::mutex _affinityMutex{};
+    std::vector<int> _affinity{};
+    std::atomic_uint _affinityVersion{0};
+
+    std::atomic_ullong _latencySum{0};
+    std::atomic_ullong _latencyCount{0};
+
+    /**
+     * \brief Worker loop
+     * \param index Worker index
+     */
+    void work(int index);
+
+    /**
+     * \brief Take a task, from the given worker queue first and then from the other ones
+     * \param index Worker index
+     * \param task Task taken
+     * \return Return true if a task was found
+     */
+    bool popTask(int index, Task& task);
+
+    /**
+     * \brief Run a task and update the latency counters
+     * \param task Task to run
+     */
+    void runTask(Task& task);
+};
+
+} // end of namespace
+
+#endif // SPLASH_THREAD_POOL_H
@@ -27,7 +27,9 @@
 
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
 namespace Splash
 {
@@ -36,6 +38,25 @@ struct Value;
 typedef std::deque<Value> Values;
 
 /*************/
+/**
+ * \brief Get a persistent instance of the given name, shared by all the Values with this name
+ * \brief Values only store a pointer to their name, which is cheap to copy and to compare. Interned names are never freed.
+ * \param name Name to intern
+ * \return Return a pointer to the interned name, or nullptr if the name is empty
+ */
+inline const std::string* internValueName(const std::string& name)
+{
+    if (name.empty())
+        return nullptr;
+
+    static std::mutex namesMutex;
+    static std::unordered_set<std::string> names;
+    std::lock_guard<std::mutex> lock(namesMutex);
+    return &(*names.insert(name).first);
+}
+
+/*************/
+// Scalars and strings are stored inline, only nested Values are allocated
 struct Value
 {
   public:
@@ -50,69 +71,66 @@ struct Value
     Value() {}
 
     template <class T, typename std::enable_if<std::is_integral<T>::value>::type* = nullptr>
-    Value(T v, std::string name = "")
+    Value(T v, const std::string& name = "")
         : _i(v)
         , _type(Type::i)
-        , _name(name)
+        , _name(internValueName(name))
     {
     }
 
     template <class T, typename std::enable_if<std::is_floating_point<T>::value>::type* = nullptr>
-    Value(T v, std::string name = "")
+    Value(T v, const std::string& name = "")
         : _f(v)
         , _type(Type::f)
-        , _name(name)
+        , _name(internValueName(name))
     {
     }
 
     template <class T, typename std::enable_if<std::is_same<T, std::string>::value>::type* = nullptr>
-    Value(T v, std::string name = "")
-        : _s(v)
-        , _type(Type::s)
-        , _name(name)
+    Value(T v, const std::string& name = "")
+        : _type(Type::s)
+        , _name(internValueName(name))
     {
+        new (&_s) std::string(std::move(v));
     }
 
     template <class T, typename std::enable_if<std::is_same<T, const char*>::value>::type* = nullptr>
-    Value(T c, std::string name = "")
-        : _s(std::string(c))
-        , _type(Type::s)
-        , _name(name)
+    Value(T c, const std::string& name = "")
+        : _type(Type::s)
+        , _name(internValueName(name))
     {
+        new (&_s) std::string(c);
     }
 
     template <class T, typename std::enable_if<std::is_same<T, Values>::value>::type* = nullptr>
-    Value(T v, std::string name = "")
-        : _v(std::unique_ptr<Values>(new Values(v)))
+    Value(T v, const std::string& name = "")
+        : _v(new Values(std::move(v)))
         , _type(Type::v)
-        , _name(name)
+        , _name(internValueName(name))
     {
     }
 
-    Value(const Value& v) { operator=(v); }
+    Value(const Value& v) { copyFrom(v); }
+    Value(Value&& v) noexcept { moveFrom(v); }
+    ~Value() { reset(); }
 
     Value& operator=(const Value& v)
     {
         if (this != &v)
         {
-            _type = v._type;
-            switch (_type)
-            {
-            case Type::i:
-                _i = v._i;
-                break;
-            case Type::f:
-                _f = v._f;
-                break;
-            case Type::s:
-            case Type::v:
-                break;
-            }
-            _name = v._name;
-            _s = v._s;
-            _v = std::unique_ptr<Values>(new Values());
-            if (v._v)
-                *_v = *(v._v);
+            reset();
+            copyFrom(v);
+        }
+
+        return *this;
+    }
+
+    Value& operator=(Value&& v) noexcept
+    {
+        if (this != &v)
+        {
+            reset();
+            moveFrom(v);
         }
 
         return *this;
@@ -120,13 +138,13 @@ struct Value
 
     Value& operator[](const std::string& name)
     {
-        _name = name;
+        setName(name);
         return *this;
     }
 
     template <class InputIt>
     Value(InputIt first, InputIt last)
-        : _v(std::unique_ptr<Values>(new Values()))
+        : _v(new Values())
         , _type(Type::v)
     {
         auto it = first;
@@ -142,6 +160,7 @@ struct Value
         if (_type != v._type)
             return false;
 
+        // Names are interned, so comparing the pointers is enough
         if (_name != v._name)
             return false;
 
@@ -247,9 +266,9 @@ struct Value
         }
     }
 
-    std::string getName() const { return _name; }
-    void setName(const std::string& name) { _name = name; }
-    bool isNamed() const { return !_name.empty(); }
+    std::string getName() const { return _name ? *_name : std::string(); }
+    void setName(const std::string& name) { _name = internValueName(name); }
+    bool isNamed() const { return _name != nullptr; }
 
     Type getType() const { return _type; }
     char getTypeAsChar() const
@@ -290,11 +309,80 @@ struct Value
     union {
         int64_t _i{0};
         double _f;
+        std::string _s; // Constructed only when _type is Type::s
+        Values* _v;     // Owned, only when _type is Type::v
     };
-    std::string _s{""};
-    std::unique_ptr<Values> _v{nullptr};
     Type _type{Type::i};
-    std::string _name{""};
+    const std::string* _name{nullptr}; //!< Interned name
+
+    /**
+     * \brief Destroy the stored payload, leaving an integer
+     */
+    void reset()
+    {
+        if (_type == Type::s)
+            _s.~basic_string();
+        else if (_type == Type::v)
+            delete _v;
+
+        _type = Type::i;
+        _i = 0;
+    }
+
+    /**
+     * \brief Copy the payload and name of another value, this value being reset
+     * \param v Value to copy
+     */
+    void copyFrom(const Value& v)
+    {
+        switch (v._type)
+        {
+        case Type::i:
+            _i = v._i;
+            break;
+        case Type::f:
+            _f = v._f;
+            break;
+        case Type::s:
+            new (&_s) std::string(v._s);
+            break;
+        case Type::v:
+            _v = new Values(*v._v);
+            break;
+        }
+        _type = v._type;
+        _name = v._name;
+    }
+
+    /**
+     * \brief Move the payload and name of another value, this value being reset
+     * \param v Value to move, which is left as an unnamed integer
+     */
+    void moveFrom(Value& v) noexcept
+    {
+        switch (v._type)
+        {
+        case Type::i:
+            _i = v._i;
+            break;
+        case Type::f:
+            _f = v._f;
+            break;
+        case Type::s:
+            new (&_s) std::string(std::move(v._s));
+            v._s.~basic_string();
+            break;
+        case Type::v:
+            _v = v._v;
+            break;
+        }
+        _type = v._type;
+        _name = v._name;
+
+        v._type = Type::i;
+        v._i = 0;
+        v._name = nullptr;
+    }
 };
 
 } // end of namespace
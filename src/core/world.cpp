@@ -14,6 +14,7 @@
 #include "./core/buffer_object.h"
 #include "./core/link.h"
 #include "./core/scene.h"
+#include "./core/thread_pool.h"
 #include "./image/image.h"
 #include "./image/queue.h"
 #include "./mesh/mesh.h"
@@ -67,23 +68,31 @@ void World::run()
 
     applyConfig();
 
+    auto loopWorldTimerId = Timer::get().getId("loop_world");
+    auto loopWorldInnerTimerId = Timer::get().getId("loop_world_inner");
+    auto serializeTimerId = Timer::get().getId("serialize");
+    auto uploadTimerId = Timer::get().getId("upload");
+
     while (true)
     {
-        Timer::get() << "loop_world";
-        Timer::get() << "loop_world_inner";
+        Timer::get() << loopWorldTimerId;
+        Timer::get() << loopWorldInnerTimerId;
         lock_guard<mutex> lockConfiguration(_configurationMutex);
 
         // Execute waiting tasks
         runTasks();
 
+        // All messages sent by this loop are coalesced into a single frame
+        _link->beginMessageBatch();
+
         {
             lock_guard<recursive_mutex> lockObjects(_objectsMutex);
 
             // Read and serialize new buffers
-            Timer::get() << "serialize";
+            Timer::get() << serializeTimerId;
             unordered_map<string, shared_ptr<SerializedObject>> serializedObjects;
             {
-                vector<future<void>> threads;
+                vector<future<void>> tasks;
                 for (auto& o : _objects)
                 {
                     // Run object tasks
@@ -95,7 +104,8 @@ void World::run()
                     if (!serializedObjectIt.second)
                         continue; // Error while inserting the object in the map
 
-                    threads.push_back(async(launch::async, [=, &o]() {
+                    auto objectSerializeTimerId = Timer::get().getId("serialize_" + serializedObjectIt.first->first);
+                    tasks.push_back(ThreadPool::get().enqueue([=, &o]() {
                         // Update the local objects
                         o.second->update();
 
@@ -104,7 +114,9 @@ void World::run()
                         {
                             if (bufferObj->wasUpdated()) // if the buffer has been updated
                             {
+                                auto serializeStart = Timer::getTime();
                                 auto obj = bufferObj->serialize();
+                                Timer::get().record(objectSerializeTimerId, Timer::getTime() - serializeStart);
                                 bufferObj->setNotUpdated();
                                 if (obj)
                                     serializedObjectIt.first->second = obj;
@@ -112,37 +124,77 @@ void World::run()
                         }
                     }));
                 }
+                ThreadPool::get().waitAll(tasks);
             }
-            Timer::get() >> "serialize";
+            Timer::get() >> serializeTimerId;
 
             // Wait for previous buffers to be uploaded
             _link->waitForBufferSending(chrono::milliseconds((unsigned long long)(1e3))); // Maximum time to wait for frames to arrive
-            Timer::get() >> "upload";
+            Timer::get() >> uploadTimerId;
 
             // Ask for the upload of the new buffers, during the next world loop
-            Timer::get() << "upload";
+            Timer::get() << uploadTimerId;
             for (auto& o : serializedObjects)
                 if (o.second)
                     _link->sendBuffer(o.first, std::move(o.second));
+
+            // Amount of data copied to send the buffers, in kilobytes to fit in the duration map
+            Timer::get().setDuration("upload_copied_kB", _link->getCopiedBytes() / 1024);
+
+            // Thread pool statistics
+            Timer::get().setDuration("pool_queue_depth", ThreadPool::get().getQueueDepth());
+            Timer::get().setDuration("pool_task_latency", ThreadPool::get().getTaskLatency());
         }
 
-        // Update the distant attributes
+        // Update the distant attributes which changed since the last loop
+        int distantAttributeCount = 0;
         for (auto& o : _objects)
         {
-            auto attribs = o.second->getDistantAttributes();
+            auto attribs = o.second->getUpdatedDistantAttributes();
             for (auto& attrib : attribs)
             {
                 sendMessage(o.second->getName(), attrib.first, attrib.second);
+                ++distantAttributeCount;
             }
         }
+        Timer::get().setDuration("distant_attributes_sent", distantAttributeCount);
 
         // If the master scene is not an inner scene, we have to send it some information
         if (_scenes[_masterSceneName] != -1)
         {
-            // Send current timings to all Scenes, for display purpose
-            auto& durationMap = Timer::get().getDurationMap();
-            for (auto& d : durationMap)
-                sendMessage(_masterSceneName, "duration", {d.first, (int)d.second});
+            // Send the timings which changed to the master Scene, for display purpose, as a single message
+            Values durations;
+            for (auto& d : Timer::get().getDurationMap())
+            {
+                unsigned long long duration = d.second;
+                auto sentDurationIt = _sentDurations.find(d.first);
+                if (sentDurationIt != _sentDurations.end() && sentDurationIt->second == duration)
+                    continue;
+
+                durations.push_back(d.first);
+                durations.push_back(static_cast<int>(duration));
+                _sentDurations[d.first] = duration;
+            }
+            if (!durations.empty())
+                sendMessage(_masterSceneName, "duration", durations);
+
+            // Send the timer statistics once per second, as they are only useful over many frames
+            if (Timer::getTime() - _statisticsSentTime > 1e6)
+            {
+                _statisticsSentTime = Timer::getTime();
+                Values statistics;
+                for (auto& stats : Timer::get().getStatistics())
+                {
+                    statistics.push_back(stats.first);
+                    statistics.push_back(stats.second.count);
+                    statistics.push_back(stats.second.p50);
+                    statistics.push_back(stats.second.p99);
+                    statistics.push_back(stats.second.max);
+                }
+                if (!statistics.empty())
+                    sendMessage(_masterSceneName, "durationStatistics", statistics);
+            }
+
             // Also send the master clock if needed
             Timer::Point clock;
             if (Timer::get().getMasterClock(clock))
@@ -151,12 +203,19 @@ void World::run()
                 sendMessage(_masterSceneName, "masterClock", clockValues);
             }
 
-            // Send newer logs to all master Scene
-            auto logs = Log::get().getNewLogs();
-            for (auto& log : logs)
-                sendMessage(_masterSceneName, "log", {log.first, (int)log.second});
+            // Send newer logs to the master Scene, as a single message
+            Values logs;
+            for (auto& log : Log::get().getNewLogs())
+            {
+                logs.push_back(log.first);
+                logs.push_back(static_cast<int>(log.second));
+            }
+            if (!logs.empty())
+                sendMessage(_masterSceneName, "log", logs);
         }
 
+        _link->endMessageBatch();
+
         if (_quit)
         {
             for (auto& s : _scenes)
@@ -165,12 +224,12 @@ void World::run()
         }
 
         // Sync with buffer object update
-        Timer::get() >> "loop_world_inner";
-        auto elapsed = Timer::get().getDuration("loop_world_inner");
+        Timer::get() >> loopWorldInnerTimerId;
+        auto elapsed = Timer::get().getDuration(loopWorldInnerTimerId);
         waitSignalBufferObjectUpdated(1e6 / (float)_worldFramerate - elapsed);
 
         // Sync to world framerate
-        Timer::get() >> "loop_world";
+        Timer::get() >> loopWorldTimerId;
     }
 }
 
@@ -195,10 +254,22 @@ void World::applyConfig()
 {
     lock_guard<mutex> lockConfiguration(_configurationMutex);
 
-    // We first destroy all scene and objects
+    // We first destroy all scene and objects, along with the timers named after them
+    for (auto& object : _objects)
+    {
+        auto bufferObject = dynamic_pointer_cast<BufferObject>(object.second);
+        if (bufferObject)
+            Timer::get().release("serialize_" + bufferObject->getDistantName());
+    }
     _scenes.clear();
     _objects.clear();
     _masterSceneName = "";
+    clearSentState();
+    {
+        lock_guard<mutex> lockChildProcess(_childProcessMutex);
+        _launchedScenes.clear();
+    }
+    _configLoadTime = Timer::getTime();
 
     try
     {
@@ -209,7 +280,11 @@ void World::applyConfig()
             return;
         }
 
+        // All the Scenes are launched at once
         const Json::Value& scenes = _config["scenes"];
+        vector<string> pendingScenes;
+        vector<string> readyScenes;
+        std::set<string> spawnedScenes;
         for (const auto& sceneName : scenes.getMemberNames())
         {
             string sceneAddress = scenes[sceneName].isMember("address") ? scenes[sceneName]["address"].asString() : "localhost";
@@ -218,6 +293,50 @@ void World::applyConfig()
 
             if (!addScene(sceneName, sceneDisplay, sceneAddress, spawn))
                 continue;
+            pendingScenes.push_back(sceneName);
+            if (spawn > 0)
+                spawnedScenes.insert(sceneName);
+        }
+
+        // Then each Scene is configured as soon as it answers the handshake
+        // The first scene is the master one, and also receives some ghost objects
+        auto deadline = Timer::getTime() + SPLASH_SCENE_LAUNCH_TIMEOUT * 1000;
+        while (!pendingScenes.empty())
+        {
+            auto sceneName = waitForNextScene(pendingScenes, deadline);
+            if (_quit)
+                return;
+
+            if (sceneName.empty())
+            {
+                // Only the Scenes spawned by this World are expected to answer in time,
+                // the other ones are started by hand, for example from a debugger
+                string spawnedSceneNames;
+                string manualSceneNames;
+                for (const auto& name : pendingScenes)
+                {
+                    if (spawnedScenes.find(name) != spawnedScenes.end())
+                        spawnedSceneNames += " \"" + name + "\"";
+                    else
+                        manualSceneNames += " \"" + name + "\"";
+                }
+
+                if (!spawnedSceneNames.empty())
+                {
+                    Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scenes" << spawnedSceneNames << ". Exiting." << Log::endl;
+                    _quit = true;
+                    return;
+                }
+
+                Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Waiting for scenes to be started manually:" << manualSceneNames << Log::endl;
+                deadline = Timer::getTime() + SPLASH_SCENE_LAUNCH_TIMEOUT * 1000;
+                continue;
+            }
+
+            Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << sceneName << " answered " << (Timer::getTime() - _configLoadTime) / 1000
+                       << "ms after the configuration was loaded" << Log::endl;
+            pendingScenes.erase(find(pendingScenes.begin(), pendingScenes.end(), sceneName));
+            deadline = Timer::getTime() + SPLASH_SCENE_LAUNCH_TIMEOUT * 1000;
 
             // Set the remaining parameters
             for (const auto& paramName : scenes[sceneName].getMemberNames())
@@ -225,36 +344,53 @@ void World::applyConfig()
                 auto values = jsonToValues(scenes[sceneName][paramName]);
                 sendMessage(sceneName, paramName, values);
             }
-        }
 
-        // Configure each scenes
-        // The first scene is the master one, and also receives some ghost objects
-        // First, set the master scene
-        sendMessage(_masterSceneName, "setMaster", {_configFilename});
+            if (sceneName == _masterSceneName)
+                sendMessage(_masterSceneName, "setMaster", {_configFilename});
 
-        // Then, we create the objects
-        for (const auto& scene : _scenes)
-        {
-            const Json::Value& objects = _config["scenes"][scene.first]["objects"];
-            if (!objects)
-                continue;
-
-            // Create the objects
-            auto sceneMembers = objects.getMemberNames();
-            for (const auto& objectName : objects.getMemberNames())
+            // Then, we create the objects right away, so that this Scene can start loading them while the others are launching
+            lock_guard<recursive_mutex> lockObjects(_objectsMutex);
+            for (const auto& objectName : scenes[sceneName]["objects"].getMemberNames())
             {
-                if (!objects[objectName].isMember("type"))
+                const Json::Value& object = scenes[sceneName]["objects"][objectName];
+                if (!object.isMember("type"))
                     continue;
 
-                setAttribute("addObject", {objects[objectName]["type"].asString(), objectName, scene.first, false});
+                auto type = object["type"].asString();
+                sendMessage(sceneName, "addObject", {type, objectName, sceneName});
+                addToWorld(type, objectName);
+                set(objectName, "configFilePath", {Utils::getPathFromFilePath(_configFilename)}, false);
+            }
+
+            // The master Scene holds ghosts of the objects of the other Scenes, which can only be sent once it answered
+            auto sendGhostObjects = [&](const string& ghostSceneName) {
+                for (const auto& objectName : scenes[ghostSceneName]["objects"].getMemberNames())
+                {
+                    const Json::Value& object = scenes[ghostSceneName]["objects"][objectName];
+                    if (object.isMember("type"))
+                        sendMessage(_masterSceneName, "addObject", {object["type"].asString(), objectName, ghostSceneName});
+                }
+            };
+
+            if (sceneName == _masterSceneName)
+            {
+                for (const auto& readySceneName : readyScenes)
+                    sendGhostObjects(readySceneName);
+            }
+            else if (find(readyScenes.begin(), readyScenes.end(), _masterSceneName) != readyScenes.end())
+            {
+                sendGhostObjects(sceneName);
             }
+            readyScenes.push_back(sceneName);
 
-            // Set some default directories
-            sendMessage(SPLASH_ALL_PEERS, "configurationPath", {_configurationPath});
-            sendMessage(SPLASH_ALL_PEERS, "mediaPath", {_configurationPath});
-            sendMessage(SPLASH_ALL_PEERS, "runInBackground", {_runInBackground});
+            sendMessageWithAnswer(sceneName, "sync");
         }
 
+        // Set some default directories
+        sendMessage(SPLASH_ALL_PEERS, "configurationPath", {_configurationPath});
+        sendMessage(SPLASH_ALL_PEERS, "mediaPath", {_configurationPath});
+        sendMessage(SPLASH_ALL_PEERS, "runInBackground", {_runInBackground});
+
         // Make sure all objects have been created in every Scene, by sending a sync message
         for (const auto& s : _scenes)
             sendMessageWithAnswer(s.first, "sync");
@@ -354,6 +490,13 @@ void World::applyConfig()
     }
 }
 
+/*************/
+void World::clearSentState()
+{
+    _sentDurations.clear();
+    _statisticsSentTime = 0;
+}
+
 /*************/
 bool World::addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn)
 {
@@ -396,8 +539,6 @@ bool World::addScene(const std::string& sceneName, const std::string& sceneDispl
         int pid = -1;
         if (spawn > 0)
         {
-            _sceneLaunched = false;
-
             // If the current process is on the correct display, we use an inner Scene
             if (worldDisplay.size() > 0 && display.find(worldDisplay) == display.size() - worldDisplay.size() && !_innerScene)
             {
@@ -434,24 +575,14 @@ bool World::addScene(const std::string& sceneName, const std::string& sceneDispl
                 if (status != 0)
                     Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Error while spawning process for scene " << sceneName << Log::endl;
             }
-
-            // We wait for the child process to be launched
-            unique_lock<mutex> lockChildProcess(_childProcessMutex);
-            while (!_sceneLaunched)
-            {
-                if (cv_status::timeout == _childProcessConditionVariable.wait_for(lockChildProcess, chrono::seconds(5)))
-                {
-                    Log::get() << Log::ERROR << "World::" << __FUNCTION__ << " - Timeout when trying to connect to newly spawned scene \"" << sceneName << "\". Exiting."
-                               << Log::endl;
-                    _quit = true;
-                    return false;
-                }
-            }
         }
 
         _scenes[sceneName] = pid;
         if (_masterSceneName.empty())
+        {
             _masterSceneName = sceneName;
+            clearSentState();
+        }
 
         // Initialize the communication
         if (pid == -1 && spawn)
@@ -468,6 +599,37 @@ bool World::addScene(const std::string& sceneName, const std::string& sceneDispl
     }
 }
 
+/*************/
+string World::waitForNextScene(const vector<string>& scenes, int64_t deadline)
+{
+    auto findLaunchedScene = [&]() -> string {
+        for (const auto& scene : scenes)
+            if (_launchedScenes.find(scene) != _launchedScenes.end())
+                return scene;
+        return "";
+    };
+
+    unique_lock<mutex> lockChildProcess(_childProcessMutex);
+    while (Timer::getTime() < deadline)
+    {
+        auto sceneName = findLaunchedScene();
+        if (!sceneName.empty())
+            return sceneName;
+
+        // Messages sent before a connection is up are lost, so the handshake is repeated until answered.
+        // Scenes only answer once they received the handshake buffer, as buffers go through their own socket
+        lockChildProcess.unlock();
+        _link->sendBuffer(SPLASH_LINK_HANDSHAKE_BUFFER, make_shared<SerializedObject>(1));
+        for (const auto& scene : scenes)
+            sendMessage(scene, "handshake", {});
+        lockChildProcess.lock();
+
+        _childProcessConditionVariable.wait_for(lockChildProcess, chrono::milliseconds(SPLASH_SCENE_HANDSHAKE_PERIOD), [&]() { return !findLaunchedScene().empty(); });
+    }
+
+    return findLaunchedScene();
+}
+
 /*************/
 string World::getObjectsAttributesDescriptions()
 {
@@ -1264,13 +1426,26 @@ void World::registerAttributes()
         {'s'});
     setAttributeDescription("addObject", "Add an object to the scenes");
 
-    addAttribute("sceneLaunched", [&](const Values&) {
-        lock_guard<mutex> lockChildProcess(_childProcessMutex);
-        _sceneLaunched = true;
-        _childProcessConditionVariable.notify_all();
-        return true;
-    });
-    setAttributeDescription("sceneLaunched", "Message sent by Scenes to confirm they are running");
+    addAttribute("firstFrameRendered",
+        [&](const Values& args) {
+            auto duration = Timer::getTime() - _configLoadTime;
+            Timer::get().setDuration("config_to_first_frame", duration);
+            Log::get() << Log::MESSAGE << "World::" << __FUNCTION__ << " - Scene " << args[0].as<string>() << " rendered its first frame " << duration / 1000
+                       << "ms after the configuration was loaded" << Log::endl;
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("firstFrameRendered", "Message sent by Scenes when they render their first frame");
+
+    addAttribute("sceneLaunched",
+        [&](const Values& args) {
+            lock_guard<mutex> lockChildProcess(_childProcessMutex);
+            _launchedScenes.insert(args[0].as<string>());
+            _childProcessConditionVariable.notify_all();
+            return true;
+        },
+        {'s'});
+    setAttributeDescription("sceneLaunched", "Message sent by Scenes as an answer to the handshake, to confirm they are running");
 
     addAttribute("deleteObject",
         [&](const Values& args) {
@@ -1282,7 +1457,12 @@ void World::registerAttributes()
                 _nameRegistry.unregisterName(objectName);
                 auto objectIt = _objects.find(objectName);
                 if (objectIt != _objects.end())
+                {
+                    auto bufferObject = dynamic_pointer_cast<BufferObject>(objectIt->second);
+                    if (bufferObject)
+                        Timer::get().release("serialize_" + bufferObject->getDistantName());
                     _objects.erase(objectIt);
+                }
 
                 // Ask for Scenes to delete the object
                 sendMessage(SPLASH_ALL_PEERS, "deleteObject", args);
@@ -1332,6 +1512,38 @@ void World::registerAttributes()
         [&]() -> Values { return {(int)_enforceRealtime}; },
         {'n'});
     setAttributeDescription("forceRealtime", "Ask the scheduler to run Splash with realtime priority.");
+
+    addAttribute("forceCoreAffinity",
+        [&](const Values& args) {
+            _enforceCoreAffinity = args[0].as<int>();
+
+            addTask([=]() {
+                // The World loop keeps the first core, the worker threads get the other ones
+                vector<int> worldCores{};
+                vector<int> workerCores{};
+                auto coreCount = Utils::getCoreCount();
+                for (int i = 0; i < coreCount; ++i)
+                {
+                    worldCores.push_back(i);
+                    workerCores.push_back(i);
+                }
+
+                if (_enforceCoreAffinity && coreCount > 1)
+                {
+                    worldCores = {0};
+                    workerCores.erase(workerCores.begin());
+                }
+
+                if (!Utils::setAffinity(worldCores))
+                    Log::get() << Log::WARNING << "World::" << __FUNCTION__ << " - Unable to set core affinity" << Log::endl;
+                ThreadPool::get().setAffinity(workerCores);
+            });
+
+            return true;
+        },
+        [&]() -> Values { return {(int)_enforceCoreAffinity}; },
+        {'n'});
+    setAttributeDescription("forceCoreAffinity", "If set to 1, the World loop and its worker threads run on separate cores.");
 #endif
 
     addAttribute("framerate",
@@ -28,9 +28,11 @@
 #include <condition_variable>
 #include <glm/glm.hpp>
 #include <mutex>
+#include <set>
 #include <signal.h>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "./config.h"
@@ -44,6 +46,9 @@
 #include "./core/name_registry.h"
 #include "./core/root_object.h"
 
+#define SPLASH_SCENE_LAUNCH_TIMEOUT 5000 // Maximum time for the next spawned Scene to answer the handshake, in milliseconds
+#define SPLASH_SCENE_HANDSHAKE_PERIOD 10 // Period at which the handshake is sent to the Scenes which did not answer yet, in milliseconds
+
 namespace Splash
 {
 
@@ -118,9 +123,13 @@ class World : public RootObject
     std::string _projectFilename; //!< Project configuration file path
     Json::Value _config;          //!< Configuration as JSon
 
-    bool _sceneLaunched{false};
+    std::unordered_map<std::string, unsigned long long> _sentDurations{}; //!< Durations last sent to the master Scene
+    int64_t _statisticsSentTime{0};                                        //!< Time at which the timer statistics were last sent to the master Scene
+
+    std::set<std::string> _launchedScenes{}; //!< Scenes which answered the handshake
     std::mutex _childProcessMutex;
     std::condition_variable _childProcessConditionVariable;
+    int64_t _configLoadTime{0}; //!< Time at which the configuration was last applied, in microseconds
 
     // Synchronization testings
     int _swapSynchronizationTesting{0}; //!< If not 0, number of frames to keep the same color
@@ -138,7 +147,12 @@ class World : public RootObject
     void applyConfig();
 
     /**
-     * Spawn a scene given its parameters
+     * \brief Forget what was sent to the master Scene, so that everything is sent again to a newly connected one
+     */
+    void clearSentState();
+
+    /**
+     * Spawn a scene given its parameters. This does not wait for the Scene to be running, see waitForNextScene
      * \param name Scene name
      * \param display Display where to spawn the scene
      * \param address Address where to spawn the scene
@@ -146,6 +160,14 @@ class World : public RootObject
      */
     bool addScene(const std::string& sceneName, const std::string& sceneDisplay, const std::string& sceneAddress, bool spawn = true);
 
+    /**
+     * \brief Send the handshake to the given Scenes until one of them answers, which means that messages go through in both directions
+     * \param scenes Names of the Scenes to wait for
+     * \param deadline Time after which to give up, in microseconds
+     * \return Return the name of the first Scene which answered, or an empty string if none did before the deadline
+     */
+    std::string waitForNextScene(const std::vector<std::string>& scenes, int64_t deadline);
+
     /**
      * \brief Copies the camera calibration from the given file to the current configuration
      * \param filename Source configuration file
@@ -0,0 +1,451 @@
+#include "./graphics/calibration_solver.h"
+
+#include <cmath>
+#include <future>
+#include <limits>
+#include <random>
+
+#include "./core/thread_pool.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+/*************/
+// Value along with its derivatives relatively to the calibration parameters, for forward automatic differentiation
+struct Jet
+{
+    double value{0.0};
+    CalibrationSolver::Parameters derivatives{};
+
+    Jet() = default;
+    Jet(double v)
+        : value(v)
+    {
+    }
+};
+
+inline Jet operator+(const Jet& lhs, const Jet& rhs)
+{
+    Jet result(lhs.value + rhs.value);
+    for (size_t i = 0; i < result.derivatives.size(); ++i)
+        result.derivatives[i] = lhs.derivatives[i] + rhs.derivatives[i];
+    return result;
+}
+
+inline Jet operator-(const Jet& lhs, const Jet& rhs)
+{
+    Jet result(lhs.value - rhs.value);
+    for (size_t i = 0; i < result.derivatives.size(); ++i)
+        result.derivatives[i] = lhs.derivatives[i] - rhs.derivatives[i];
+    return result;
+}
+
+inline Jet operator-(const Jet& jet)
+{
+    return Jet(0.0) - jet;
+}
+
+inline Jet operator*(const Jet& lhs, const Jet& rhs)
+{
+    Jet result(lhs.value * rhs.value);
+    for (size_t i = 0; i < result.derivatives.size(); ++i)
+        result.derivatives[i] = lhs.derivatives[i] * rhs.value + lhs.value * rhs.derivatives[i];
+    return result;
+}
+
+inline Jet operator/(const Jet& lhs, const Jet& rhs)
+{
+    Jet result(lhs.value / rhs.value);
+    for (size_t i = 0; i < result.derivatives.size(); ++i)
+        result.derivatives[i] = (lhs.derivatives[i] - result.value * rhs.derivatives[i]) / rhs.value;
+    return result;
+}
+
+inline Jet applyChainRule(double value, double derivative, const Jet& jet)
+{
+    Jet result(value);
+    for (size_t i = 0; i < result.derivatives.size(); ++i)
+        result.derivatives[i] = derivative * jet.derivatives[i];
+    return result;
+}
+
+inline Jet sin(const Jet& jet)
+{
+    return applyChainRule(std::sin(jet.value), std::cos(jet.value), jet);
+}
+
+inline Jet cos(const Jet& jet)
+{
+    return applyChainRule(std::cos(jet.value), -std::sin(jet.value), jet);
+}
+
+inline Jet tan(const Jet& jet)
+{
+    auto value = std::tan(jet.value);
+    return applyChainRule(value, 1.0 + value * value, jet);
+}
+
+/*************/
+// Equivalent to glm::project with the lookAt and projection matrices built by the Camera from these parameters
+template <typename T>
+void projectPoint(const array<T, SPLASH_CALIBRATION_PARAMETERS>& parameters, const glm::dvec3& world, double width, double height, T& x, T& y)
+{
+    using std::cos;
+    using std::sin;
+    using std::tan;
+
+    const T& fov = parameters[0];
+    const T& cx = parameters[1];
+    const T& cy = parameters[2];
+
+    T ch = cos(parameters[6]), sh = sin(parameters[6]);
+    T cp = cos(parameters[7]), sp = sin(parameters[7]);
+    T cb = cos(parameters[8]), sb = sin(parameters[8]);
+
+    // Columns of glm::yawPitchRoll: the camera looks along the first one, the third one being its up vector
+    T forward[3] = {ch * cb + sh * sp * sb, sb * cp, ch * sp * sb - sh * cb};
+    T side[3] = {sh * sp * cb - ch * sb, cb * cp, sb * sh + ch * sp * cb};
+    T up[3] = {sh * cp, -sp, ch * cp};
+
+    T offset[3] = {T(world[0]) - parameters[3], T(world[1]) - parameters[4], T(world[2]) - parameters[5]};
+    T viewX = T(0.0) - (side[0] * offset[0] + side[1] * offset[1] + side[2] * offset[2]);
+    T viewY = up[0] * offset[0] + up[1] * offset[1] + up[2] * offset[2];
+    T depth = forward[0] * offset[0] + forward[1] * offset[1] + forward[2] * offset[2];
+
+    T focal = T(1.0) / tan(fov * T(M_PI / 360.0));
+    T ndcX = focal * T(height / width) * viewX / depth + T(2.0) * (cx - T(0.5));
+    T ndcY = focal * viewY / depth + T(2.0) * (cy - T(0.5));
+
+    x = (ndcX + T(1.0)) * T(width / 2.0);
+    y = (ndcY + T(1.0)) * T(height / 2.0);
+}
+
+/*************/
+bool isInBounds(const CalibrationSolver::Parameters& parameters)
+{
+    return parameters[0] >= 4.0 && parameters[0] <= 120.0 && abs(parameters[1] - 0.5) <= 1.0 && abs(parameters[2] - 0.5) <= 1.0;
+}
+
+/*************/
+// Solve matrix * x = vector in place, for a symmetric positive definite matrix
+bool solveCholesky(array<CalibrationSolver::Parameters, SPLASH_CALIBRATION_PARAMETERS>& matrix, CalibrationSolver::Parameters& vector)
+{
+    const int size = SPLASH_CALIBRATION_PARAMETERS;
+    for (int j = 0; j < size; ++j)
+    {
+        double diagonal = matrix[j][j];
+        for (int k = 0; k < j; ++k)
+            diagonal -= matrix[j][k] * matrix[j][k];
+        if (diagonal <= 0.0)
+            return false;
+        matrix[j][j] = sqrt(diagonal);
+
+        for (int i = j + 1; i < size; ++i)
+        {
+            double value = matrix[i][j];
+            for (int k = 0; k < j; ++k)
+                value -= matrix[i][k] * matrix[j][k];
+            matrix[i][j] = value / matrix[j][j];
+        }
+    }
+
+    for (int i = 0; i < size; ++i)
+    {
+        for (int k = 0; k < i; ++k)
+            vector[i] -= matrix[i][k] * vector[k];
+        vector[i] /= matrix[i][i];
+    }
+
+    for (int i = size - 1; i >= 0; --i)
+    {
+        for (int k = i + 1; k < size; ++k)
+            vector[i] -= matrix[k][i] * vector[k];
+        vector[i] /= matrix[i][i];
+    }
+
+    return true;
+}
+} // end of anonymous namespace
+
+/*************/
+CalibrationSolver::CalibrationSolver(const vector<Point>& points, double width, double height)
+    : _points(points)
+    , _width(width)
+    , _height(height)
+{
+}
+
+/*************/
+void CalibrationSolver::lockFov(double fov)
+{
+    _locked[0] = true;
+    _lockedValues[0] = fov;
+}
+
+/*************/
+void CalibrationSolver::lockPrincipalPoint(double cx, double cy)
+{
+    _locked[1] = _locked[2] = true;
+    _lockedValues[1] = cx;
+    _lockedValues[2] = cy;
+}
+
+/*************/
+void CalibrationSolver::addRandomStarts(const glm::dvec3& eye, uint32_t seed)
+{
+    mt19937 generator(seed);
+    uniform_real_distribution<double> fovDistribution(25.0, 75.0);
+    uniform_real_distribution<double> angleDistribution(0.0, 2.0 * M_PI);
+
+    // Same coverage of the principal point as the former Nelder-Mead search
+    for (double s = 0.0; s <= 1.3; s += 0.3)
+    {
+        for (double t = 0.0; t <= 1.3; t += 0.3)
+        {
+            Parameters start{{fovDistribution(generator), s, t, eye[0], eye[1], eye[2], 0.0, 0.0, 0.0}};
+            for (int i = 6; i < 9; ++i)
+                start[i] = angleDistribution(generator);
+            _starts.push_back(start);
+        }
+    }
+}
+
+/*************/
+CalibrationSolver::Result CalibrationSolver::solve(atomic<float>* progress, const atomic<bool>* cancel) const
+{
+    Result result;
+    if (_points.empty() || _starts.empty())
+        return result;
+
+    vector<Parameters> parameters(_starts);
+    for (auto& start : parameters)
+        for (size_t i = 0; i < start.size(); ++i)
+            if (_locked[i])
+                start[i] = _lockedValues[i];
+
+    vector<double> errors(parameters.size(), numeric_limits<double>::max());
+    vector<char> evaluated(parameters.size(), 0);
+    atomic<bool> stop{false};
+    atomic<uint32_t> processedStarts{0};
+
+    auto& pool = ThreadPool::get();
+    vector<future<void>> futures;
+    for (size_t s = 0; s < parameters.size(); ++s)
+    {
+        futures.push_back(pool.enqueue([&, s]() {
+            if (!stop && !(cancel && *cancel))
+            {
+                errors[s] = refine(parameters[s], stop, cancel);
+                evaluated[s] = 1;
+            }
+
+            auto processed = ++processedStarts;
+            if (progress)
+                *progress = static_cast<float>(processed) / static_cast<float>(parameters.size());
+        }));
+    }
+    pool.waitAll(futures);
+
+    size_t best = parameters.size();
+    for (size_t s = 0; s < parameters.size(); ++s)
+    {
+        if (!evaluated[s])
+            continue;
+        ++result.startsEvaluated;
+        if (best == parameters.size() || errors[s] < errors[best])
+            best = s;
+    }
+
+    if (best == parameters.size() || errors[best] == numeric_limits<double>::max())
+        return result;
+
+    result.parameters = parameters[best];
+    result.error = errors[best];
+    result.rms = computeRMS(parameters[best]);
+    result.success = !(cancel && *cancel);
+    return result;
+}
+
+/*************/
+glm::dvec2 CalibrationSolver::project(const Parameters& parameters, const glm::dvec3& world, double width, double height)
+{
+    double x, y;
+    projectPoint(parameters, world, width, height, x, y);
+    return glm::dvec2(x, y);
+}
+
+/*************/
+glm::dvec3 CalibrationSolver::getEulerAngles(const glm::dvec3& eye, const glm::dvec3& target, const glm::dvec3& up)
+{
+    // Rebuild the columns of the yawPitchRoll matrix, and read the angles back from them
+    auto forward = glm::normalize(target - eye);
+    auto side = glm::normalize(glm::cross(up, forward));
+    auto realUp = glm::cross(forward, side);
+
+    auto yaw = atan2(realUp[0], realUp[2]);
+    auto pitch = asin(std::max(-1.0, std::min(1.0, -realUp[1])));
+    auto roll = atan2(forward[1], side[1]);
+    return glm::dvec3(yaw, pitch, roll);
+}
+
+/*************/
+double CalibrationSolver::refine(Parameters& parameters, atomic<bool>& stop, const atomic<bool>* cancel) const
+{
+    vector<double> residuals;
+    vector<double> candidateResiduals;
+    vector<Parameters> jacobian;
+    auto error = evaluate(parameters, residuals, &jacobian);
+    if (error == numeric_limits<double>::max())
+        return error;
+
+    double lambda = 1e-3;
+    for (int iteration = 0; iteration < SPLASH_CALIBRATION_MAX_ITERATIONS; ++iteration)
+    {
+        if (error < SPLASH_CALIBRATION_EARLY_STOP_ERROR)
+        {
+            stop = true;
+            break;
+        }
+
+        if (stop || (cancel && *cancel))
+            break;
+
+        // Normal equations of the linearized problem. Locked parameters get an identity row, so that they do not move
+        array<Parameters, SPLASH_CALIBRATION_PARAMETERS> normalMatrix{};
+        Parameters gradient{};
+        for (size_t r = 0; r < residuals.size(); ++r)
+        {
+            for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+            {
+                gradient[i] += jacobian[r][i] * residuals[r];
+                for (int j = 0; j <= i; ++j)
+                    normalMatrix[i][j] += jacobian[r][i] * jacobian[r][j];
+            }
+        }
+
+        for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+        {
+            for (int j = 0; j < i; ++j)
+                normalMatrix[j][i] = normalMatrix[i][j];
+
+            if (_locked[i])
+            {
+                for (int j = 0; j < SPLASH_CALIBRATION_PARAMETERS; ++j)
+                    normalMatrix[i][j] = normalMatrix[j][i] = 0.0;
+                normalMatrix[i][i] = 1.0;
+                gradient[i] = 0.0;
+            }
+        }
+
+        // Increase the damping until a step lowers the error
+        bool improved = false;
+        double candidateError = error;
+        Parameters candidate;
+        while (!improved && lambda < 1e12)
+        {
+            auto damped = normalMatrix;
+            for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+                damped[i][i] += lambda * std::max(normalMatrix[i][i], 1e-12);
+
+            Parameters step;
+            for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+                step[i] = -gradient[i];
+
+            if (solveCholesky(damped, step))
+            {
+                for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+                    candidate[i] = parameters[i] + step[i];
+                candidateError = evaluate(candidate, candidateResiduals, nullptr);
+                improved = candidateError < error;
+            }
+
+            lambda = improved ? std::max(lambda / 10.0, 1e-12) : lambda * 10.0;
+        }
+
+        if (!improved)
+            break;
+
+        auto decrease = error - candidateError;
+        parameters = candidate;
+        error = evaluate(parameters, residuals, &jacobian);
+
+        if (decrease < 1e-10 * error)
+            break;
+    }
+
+    return error;
+}
+
+/*************/
+double CalibrationSolver::evaluate(const Parameters& parameters, vector<double>& residuals, vector<Parameters>* jacobian) const
+{
+    if (!isInBounds(parameters))
+        return numeric_limits<double>::max();
+
+    residuals.resize(_points.size() * 2);
+    if (jacobian)
+        jacobian->resize(_points.size() * 2);
+
+    array<Jet, SPLASH_CALIBRATION_PARAMETERS> variables;
+    if (jacobian)
+    {
+        for (size_t i = 0; i < variables.size(); ++i)
+        {
+            variables[i] = Jet(parameters[i]);
+            variables[i].derivatives[i] = _locked[i] ? 0.0 : 1.0;
+        }
+    }
+
+    // Weights are applied so that the sum of squared residuals is the weighted mean squared error
+    double error = 0.0;
+    for (size_t p = 0; p < _points.size(); ++p)
+    {
+        const auto& point = _points[p];
+        double scale = sqrt(point.weight / static_cast<double>(_points.size()));
+
+        if (jacobian)
+        {
+            Jet x, y;
+            projectPoint(variables, point.world, _width, _height, x, y);
+            residuals[p * 2] = scale * (x.value - point.screen[0]);
+            residuals[p * 2 + 1] = scale * (y.value - point.screen[1]);
+            for (int i = 0; i < SPLASH_CALIBRATION_PARAMETERS; ++i)
+            {
+                (*jacobian)[p * 2][i] = scale * x.derivatives[i];
+                (*jacobian)[p * 2 + 1][i] = scale * y.derivatives[i];
+            }
+        }
+        else
+        {
+            auto projected = project(parameters, point.world, _width, _height);
+            residuals[p * 2] = scale * (projected[0] - point.screen[0]);
+            residuals[p * 2 + 1] = scale * (projected[1] - point.screen[1]);
+        }
+
+        error += residuals[p * 2] * residuals[p * 2] + residuals[p * 2 + 1] * residuals[p * 2 + 1];
+    }
+
+    if (!std::isfinite(error))
+        return numeric_limits<double>::max();
+    return error;
+}
+
+/*************/
+double CalibrationSolver::computeRMS(const Parameters& parameters) const
+{
+    double summedDistance = 0.0;
+    for (const auto& point : _points)
+    {
+        auto projected = project(parameters, point.world, _width, _height);
+        auto dx = projected[0] - point.screen[0];
+        auto dy = projected[1] - point.screen[1];
+        summedDistance += dx * dx + dy * dy;
+    }
+    return sqrt(summedDistance / static_cast<double>(_points.size()));
+}
+
+} // end of namespace
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @calibration_solver.h
+ * Estimation of the camera parameters matching a set of calibration points
+ */
+
+#ifndef SPLASH_CALIBRATION_SOLVER_H
+#define SPLASH_CALIBRATION_SOLVER_H
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#define SPLASH_CALIBRATION_PARAMETERS 9        // fov, principal point (2), eye position (3), yaw pitch roll (3)
+#define SPLASH_CALIBRATION_MAX_ITERATIONS 200   // Levenberg-Marquardt iterations per start
+#define SPLASH_CALIBRATION_EARLY_STOP_ERROR 0.5 // Weighted mean squared reprojection error below which all starts are stopped
+
+namespace Splash
+{
+
+class CalibrationSolver
+{
+  public:
+    typedef std::array<double, SPLASH_CALIBRATION_PARAMETERS> Parameters;
+
+    struct Point
+    {
+        glm::dvec3 world{};  //!< Position in the scene
+        glm::dvec2 screen{}; //!< Position in the camera image, in pixels
+        double weight{1.0};  //!< Relative influence on the result
+    };
+
+    struct Result
+    {
+        Parameters parameters{};        //!< Best parameters found
+        double error{0.0};              //!< Weighted mean squared reprojection error, in pixels
+        double rms{0.0};                //!< Unweighted root mean square reprojection error, in pixels
+        bool success{false};            //!< False if no start converged to a valid camera, or if the solver was cancelled
+        uint32_t startsEvaluated{0};    //!< Number of starts which ran before the early stop or the cancellation
+    };
+
+    /**
+     * \brief Constructor
+     * \param points Calibration points
+     * \param width Image width
+     * \param height Image height
+     */
+    CalibrationSolver(const std::vector<Point>& points, double width, double height);
+
+    /**
+     * \brief Keep the field of view at the given value
+     * \param fov Vertical field of view, in degrees
+     */
+    void lockFov(double fov);
+
+    /**
+     * \brief Keep the principal point at the given value
+     * \param cx Relative horizontal position of the principal point
+     * \param cy Relative vertical position of the principal point
+     */
+    void lockPrincipalPoint(double cx, double cy);
+
+    /**
+     * \brief Add a starting point, to be refined along with the random ones
+     * \param parameters Starting parameters
+     */
+    void addStart(const Parameters& parameters) { _starts.push_back(parameters); }
+
+    /**
+     * \brief Add random starting points around the given camera position
+     * \param eye Camera position shared by all starts
+     * \param seed Seed for the random orientations and fields of view
+     */
+    void addRandomStarts(const glm::dvec3& eye, uint32_t seed);
+
+    /**
+     * \brief Refine all the starts in parallel in the thread pool, and keep the best one
+     * \param progress If not null, updated with the ratio of starts processed
+     * \param cancel If not null, the solver stops as soon as possible when it becomes true
+     * \return Return the best result
+     */
+    Result solve(std::atomic<float>* progress = nullptr, const std::atomic<bool>* cancel = nullptr) const;
+
+    /**
+     * \brief Project a point in the image of a camera, as done by the rendering
+     * \param parameters Camera parameters
+     * \param world Point position in the scene
+     * \param width Image width
+     * \param height Image height
+     * \return Return the position in the image, in pixels
+     */
+    static glm::dvec2 project(const Parameters& parameters, const glm::dvec3& world, double width, double height);
+
+    /**
+     * \brief Get the camera orientation from its position, target and up vector
+     * \param eye Camera position
+     * \param target Camera target
+     * \param up Camera up vector
+     * \return Return the yaw, pitch and roll angles
+     */
+    static glm::dvec3 getEulerAngles(const glm::dvec3& eye, const glm::dvec3& target, const glm::dvec3& up);
+
+  private:
+    std::vector<Point> _points;
+    double _width;
+    double _height;
+    std::vector<Parameters> _starts{};
+    std::array<bool, SPLASH_CALIBRATION_PARAMETERS> _locked{};
+    Parameters _lockedValues{};
+
+    /**
+     * \brief Refine a start with Levenberg-Marquardt, using an automatically differentiated Jacobian
+     * \param parameters Starting parameters, replaced by the refined ones
+     * \param stop Set to true by any start reaching the early stop error, in which case the other ones return early
+     * \param cancel If not null, the refinement stops when it becomes true
+     * \return Return the weighted mean squared error, or the max double value if the parameters are out of bounds
+     */
+    double refine(Parameters& parameters, std::atomic<bool>& stop, const std::atomic<bool>* cancel) const;
+
+    /**
+     * \brief Compute the weighted residuals and their Jacobian
+     * \param parameters Camera parameters
+     * \param residuals Residuals, two per point
+     * \param jacobian If not null, derivatives of each residual relatively to each parameter
+     * \return Return the weighted mean squared error, or the max double value if the parameters are out of bounds
+     */
+    double evaluate(const Parameters& parameters, std::vector<double>& residuals, std::vector<Parameters>* jacobian) const;
+
+    /**
+     * \brief Compute the unweighted root mean square error
+     * \param parameters Camera parameters
+     * \return Return the error in pixels
+     */
+    double computeRMS(const Parameters& parameters) const;
+};
+
+} // end of namespace
+
+#endif // SPLASH_CALIBRATION_SOLVER_H
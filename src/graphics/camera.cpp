@@ -1,5 +1,7 @@
 #include "./graphics/camera.h"
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <limits>
 
@@ -90,19 +92,33 @@ Camera::Camera(RootObject* root)
 /*************/
 Camera::~Camera()
 {
+    if (_calibrationFuture.valid())
+    {
+        _calibrationCancelled = true;
+        _calibrationFuture.wait();
+    }
+
+    if (glIsBuffer(_uniformBuffer))
+        glDeleteBuffers(1, &_uniformBuffer);
+
+    if (_renderTimerId)
+        Timer::get().release("render_" + _name);
+
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Camera::~Camera - Destructor" << Log::endl;
 #endif
 }
 
 /*************/
-void Camera::computeBlendingContribution()
+void Camera::computeBlendingContribution(const vector<shared_ptr<Object>>& objects)
 {
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objects.empty() && find(objects.begin(), objects.end(), obj) == objects.end())
+            continue;
 
         obj->computeCameraContribution(computeViewMatrix(), computeProjectionMatrix(), _blendWidth);
     }
@@ -165,18 +181,38 @@ void Camera::computeVertexVisibility()
 }
 
 /*************/
-void Camera::blendingTessellateForCurrentCamera()
+void Camera::blendingTessellateForCurrentCamera(const vector<shared_ptr<Object>>& objects)
 {
     for (auto& o : _objects)
     {
         if (o.expired())
             continue;
         auto obj = o.lock();
+        if (!objects.empty() && find(objects.begin(), objects.end(), obj) == objects.end())
+            continue;
 
         obj->tessellateForThisCamera(computeViewMatrix(), computeProjectionMatrix(), glm::radians(_fov * _width / _height), glm::radians(_fov), _blendWidth, _blendPrecision);
     }
 }
 
+/*************/
+vector<double> Camera::getBlendingState()
+{
+    vector<double> state;
+    auto viewMatrix = computeViewMatrix();
+    auto projectionMatrix = computeProjectionMatrix();
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            state.push_back(viewMatrix[c][r]);
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            state.push_back(projectionMatrix[c][r]);
+    state.push_back(_blendWidth);
+    state.push_back(_blendPrecision);
+
+    return state;
+}
+
 /*************/
 bool Camera::doCalibration()
 {
@@ -197,142 +233,73 @@ bool Camera::doCalibration()
 
     _calibrationCalledOnce = true;
 
-    gsl_multimin_function calibrationFunc;
-    calibrationFunc.n = 9;
-    calibrationFunc.f = &Camera::calibrationCostFunc;
-    calibrationFunc.params = (void*)this;
-
-    Log::get() << "Camera::" << __FUNCTION__ << " - Starting calibration..." << Log::endl;
-
-    const gsl_multimin_fminimizer_type* minimizerType = gsl_multimin_fminimizer_nmsimplex2rand;
-    // Variables we do not want to keep between tries
-    dvec3 eyeOriginal = _eye;
-
-    double minValue = numeric_limits<double>::max();
-    vector<double> selectedValues(9);
-
-    gsl_multimin_fminimizer* minimizer;
-    minimizer = gsl_multimin_fminimizer_alloc(minimizerType, 9);
-    gsl_vector* x = gsl_vector_alloc(9);
-    gsl_vector* step = gsl_vector_alloc(9);
-    gsl_vector_set(step, 0, 10.0);
-    gsl_vector_set(step, 1, 0.1);
-    gsl_vector_set(step, 2, 0.1);
-    for (int i = 3; i < 6; ++i)
-        gsl_vector_set(step, i, 1.0);
-    for (int i = 3; i < 9; ++i)
-        gsl_vector_set(step, i, M_PI / 4.0);
-
-    // First step: find a rough estimate, quickly
-    for (double s = 0.0; s <= 1.3; s += 0.3)
+    // Moving a calibration point while the solver runs queues a single new calibration, with the latest points
+    if (_calibrationFuture.valid())
     {
-        for (double t = 0.0; t <= 1.3; t += 0.3)
-        {
-            gsl_vector_set(x, 0, 50.0 + ((float)rand() / RAND_MAX * 2.0 - 1.0) * 25.0);
-            gsl_vector_set(x, 1, s);
-            gsl_vector_set(x, 2, t);
-            for (int i = 0; i < 3; ++i)
-            {
-                gsl_vector_set(x, i + 3, eyeOriginal[i]);
-                gsl_vector_set(x, i + 6, (float)rand() / RAND_MAX * M_PI * 2.0);
-            }
+        _calibrationQueued = true;
+        return true;
+    }
 
-            gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
+    vector<CalibrationSolver::Point> points;
+    for (auto& point : _calibrationPoints)
+    {
+        if (!point.isSet)
+            continue;
 
-            size_t iter = 0;
-            int status = GSL_CONTINUE;
-            double localMinimum = numeric_limits<double>::max();
-            while (status == GSL_CONTINUE && iter < 1000 && localMinimum > 64.0)
-            {
-                iter++;
-                status = gsl_multimin_fminimizer_iterate(minimizer);
-                if (status)
-                {
-                    Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                    break;
-                }
+        CalibrationSolver::Point solverPoint;
+        solverPoint.world = point.world;
+        solverPoint.screen = dvec2((point.screen.x + 1.0) / 2.0 * _width, (point.screen.y + 1.0) / 2.0 * _height);
+        solverPoint.weight = _weightedCalibrationPoints ? point.weight : 1.0;
+        points.push_back(solverPoint);
+    }
 
-                status = gsl_multimin_test_size(minimizer->size, 1e-2);
-                localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
-            }
+    auto solver = make_shared<CalibrationSolver>(points, _width, _height);
+    if (operator[]("fov").isLocked())
+        solver->lockFov(_fov);
+    if (operator[]("principalPoint").isLocked())
+        solver->lockPrincipalPoint(_cx, _cy);
 
-            if (localMinimum < minValue)
-            {
-                minValue = localMinimum;
-                for (int i = 0; i < 9; ++i)
-                    selectedValues[i] = gsl_vector_get(minimizer->x, i);
-            }
-        }
-    }
+    // The current parameters are a good start when refining an existing calibration
+    auto euler = CalibrationSolver::getEulerAngles(_eye, _target, _up);
+    solver->addStart({{_fov, _cx, _cy, _eye.x, _eye.y, _eye.z, euler.x, euler.y, euler.z}});
+    solver->addRandomStarts(_eye, rand());
 
-    // Second step: we improve on the best result from the previous step
-    for (int index = 0; index < 8; ++index)
-    {
-        gsl_vector_set(step, 0, 1.0);
-        gsl_vector_set(step, 1, 0.05);
-        gsl_vector_set(step, 2, 0.05);
-        for (int i = 3; i < 6; ++i)
-            gsl_vector_set(step, i, 0.1);
-        for (int i = 3; i < 9; ++i)
-            gsl_vector_set(step, i, M_PI / 10.0);
-
-        for (int i = 0; i < 9; ++i)
-            gsl_vector_set(x, i, selectedValues[i]);
-
-        gsl_multimin_fminimizer_set(minimizer, &calibrationFunc, x, step);
-
-        size_t iter = 0;
-        int status = GSL_CONTINUE;
-        double localMinimum = numeric_limits<double>::max();
-        while (status == GSL_CONTINUE && iter < 10000 && localMinimum > 0.5)
-        {
-            iter++;
-            status = gsl_multimin_fminimizer_iterate(minimizer);
-            if (status)
-            {
-                Log::get() << Log::WARNING << "Camera::" << __FUNCTION__ << " - An error has occured during minimization" << Log::endl;
-                break;
-            }
+    Log::get() << "Camera::" << __FUNCTION__ << " - Starting calibration..." << Log::endl;
 
-            status = gsl_multimin_test_size(minimizer->size, 1e-7);
-            localMinimum = gsl_multimin_fminimizer_minimum(minimizer);
-        }
+    _calibrationProgress = 0.f;
+    _calibrationFuture = async(launch::async, [=]() { return solver->solve(&_calibrationProgress, &_calibrationCancelled); });
 
-        if (localMinimum < minValue)
-        {
-            minValue = localMinimum;
-            for (int i = 0; i < 9; ++i)
-                selectedValues[i] = gsl_vector_get(minimizer->x, i);
-        }
-    }
+    return true;
+}
 
-    gsl_vector_free(x);
-    gsl_vector_free(step);
-    gsl_multimin_fminimizer_free(minimizer);
+/*************/
+void Camera::applyCalibration(const CalibrationSolver::Result& result)
+{
+    const auto& values = result.parameters;
 
     // If the result is good enough, apply it. Otherwise, drop!
-    if (minValue > 1000.0)
+    if (!result.success || result.error > 1000.0)
     {
-        Log::get() << "Camera::" << __FUNCTION__ << " - Minumum found at (fov, cx, cy): " << selectedValues[0] << " " << selectedValues[1] << " " << selectedValues[2] << Log::endl;
-        Log::get() << "Camera::" << __FUNCTION__ << " - Minimum value: " << minValue << Log::endl;
+        Log::get() << "Camera::" << __FUNCTION__ << " - Minumum found at (fov, cx, cy): " << values[0] << " " << values[1] << " " << values[2] << Log::endl;
+        Log::get() << "Camera::" << __FUNCTION__ << " - Minimum value: " << result.error << Log::endl;
         Log::get() << "Camera::" << __FUNCTION__ << " - Calibration not set because the found parameters are not good enough." << Log::endl;
     }
     else
     {
-        // Third step: convert the values to camera parameters
+        // Convert the values to camera parameters
         if (!operator[]("fov").isLocked())
-            _fov = selectedValues[0];
+            _fov = values[0];
         if (!operator[]("principalPoint").isLocked())
         {
-            _cx = selectedValues[1];
-            _cy = selectedValues[2];
+            _cx = values[1];
+            _cy = values[2];
         }
 
         dvec3 euler;
         for (int i = 0; i < 3; ++i)
         {
-            _eye[i] = selectedValues[i + 3];
-            euler[i] = selectedValues[i + 6];
+            _eye[i] = values[i + 3];
+            euler[i] = values[i + 6];
         }
         dmat4 rotateMat = yawPitchRoll(euler[0], euler[1], euler[2]);
         dvec4 target = rotateMat * dvec4(1.0, 0.0, 0.0, 0.0);
@@ -346,14 +313,15 @@ bool Camera::doCalibration()
         _up = normalize(_up);
 
         Log::get() << "Camera::" << __FUNCTION__ << " - Minumum found at (fov, cx, cy): " << _fov << " " << _cx << " " << _cy << Log::endl;
-        Log::get() << "Camera::" << __FUNCTION__ << " - Minimum value: " << minValue << Log::endl;
+        Log::get() << "Camera::" << __FUNCTION__ << " - Minimum value: " << result.error << ", RMS reprojection error: " << result.rms << " pixels, from "
+                   << result.startsEvaluated << " starts" << Log::endl;
 
         // Force camera update with the new parameters
         _updatedParams = true;
     }
 
     // Keep the reprojection error
-    _calibrationReprojectionError = minValue;
+    _calibrationReprojectionError = result.rms;
 
     // Propagate the calibration to other Scenes
     auto scene = dynamic_cast<Scene*>(_root);
@@ -369,8 +337,6 @@ bool Camera::doCalibration()
             scene->sendMessageToWorld("sendAll", values);
         }
     }
-
-    return true;
 }
 
 /*************/
@@ -537,15 +503,31 @@ Values Camera::pickVertexOrCalibrationPoint(float x, float y)
 /*************/
 void Camera::render()
 {
+    // Whatever changes the output without going through the attributes or the linked objects forces the render
+    bool forceRender = false;
+
+    if (_calibrationFuture.valid() && _calibrationFuture.wait_for(chrono::seconds(0)) == future_status::ready)
+    {
+        applyCalibration(_calibrationFuture.get());
+        forceRender = true;
+        if (_calibrationQueued)
+        {
+            _calibrationQueued = false;
+            doCalibration();
+        }
+    }
+
     if (_updateColorDepth)
     {
         _msFbo->setParameters(_multisample, _render16bits, false);
         _outFbo->setParameters(false, _render16bits, false);
         _updateColorDepth = false;
+        forceRender = true;
     }
 
     if (_newWidth != 0 && _newHeight != 0)
     {
+        forceRender = true;
         _msFbo->setSize(_newWidth, _newHeight);
         _outFbo->setSize(_newWidth, _newHeight);
         _width = _newWidth;
@@ -562,8 +544,19 @@ void Camera::render()
     {
         _msFbo->setSize(spec.width, spec.height);
         _outFbo->setSize(spec.width, spec.height);
+        forceRender = true;
     }
 
+    // Calibration overlays follow the mouse and the calibration state, which are not tracked
+    forceRender = forceRender || _drawFrame || _displayCalibration || _displayAllCalibrations || !_drawables.empty();
+    if (!needsRender(forceRender))
+        return;
+    ++_contentVersion;
+
+    if (!_renderTimerId)
+        _renderTimerId = Timer::get().getId("render_" + _name);
+    Timer::get() << _renderTimerId;
+
 #ifdef DEBUG
     glGetError();
 #endif
@@ -591,6 +584,11 @@ void Camera::render()
 
     if (!_hidden)
     {
+        updateUniformBuffer();
+
+        auto viewMatrix = computeViewMatrix();
+        auto projectionMatrix = computeProjectionMatrix();
+
         // Draw the objects
         for (auto& o : _objects)
         {
@@ -599,37 +597,11 @@ void Camera::render()
                 continue;
 
             obj->activate();
-
-            vec2 colorBalance = colorBalanceFromTemperature(_colorTemperature);
-            obj->getShader()->setAttribute("uniform", {"_wireframeColor", _wireframeColor.x, _wireframeColor.y, _wireframeColor.z, _wireframeColor.w});
-            obj->getShader()->setAttribute("uniform", {"_cameraAttributes", _blendWidth, _brightness});
-            obj->getShader()->setAttribute("uniform", {"_fovAndColorBalance", _fov * _width / _height * M_PI / 180.0, _fov * M_PI / 180.0, colorBalance.x, colorBalance.y});
-            obj->getShader()->setAttribute("uniform", {"_showCameraCount", (int)_showCameraCount});
-            if (_colorLUT.size() == 768 && _isColorLUTActivated)
-            {
-                obj->getShader()->setAttribute("uniform", {"_colorLUT", _colorLUT});
-                obj->getShader()->setAttribute("uniform", {"_isColorLUT", 1});
-
-                Values m(10);
-                m[0] = "_colorMixMatrix";
-                for (int u = 0; u < 3; ++u)
-                    for (int v = 0; v < 3; ++v)
-                        m[u * 3 + v + 1] = _colorMixMatrix[u][v];
-                obj->getShader()->setAttribute("uniform", m);
-            }
-            else
-            {
-                obj->getShader()->setAttribute("uniform", {"_isColorLUT", 0});
-            }
-
-            obj->setViewProjectionMatrix(computeViewMatrix(), computeProjectionMatrix());
+            obj->setViewProjectionMatrix(viewMatrix, projectionMatrix);
             obj->draw();
             obj->deactivate();
         }
 
-        auto viewMatrix = computeViewMatrix();
-        auto projectionMatrix = computeProjectionMatrix();
-
         // Draw the calibrations points of all the cameras
         if (_displayAllCalibrations)
         {
@@ -748,7 +720,7 @@ void Camera::render()
         Log::get() << Log::WARNING << _type << "::" << __FUNCTION__ << " - Error while rendering the camera: " << error << Log::endl;
 #endif
 
-    return;
+    Timer::get() >> _renderTimerId;
 }
 
 /*************/
@@ -887,95 +859,6 @@ bool Camera::setCalibrationPoint(const Values& screenPoint)
     return true;
 }
 
-/*************/
-double Camera::calibrationCostFunc(const gsl_vector* v, void* params)
-{
-    if (params == NULL)
-        return 0.0;
-
-    Camera& camera = *(Camera*)params;
-
-    double fov = gsl_vector_get(v, 0);
-    double cx = gsl_vector_get(v, 1);
-    double cy = gsl_vector_get(v, 2);
-
-    // Check whether the camera parameters are locked
-    if (camera["fov"].isLocked())
-        fov = camera["fov"]()[0].as<float>();
-    if (camera["principalPoint"].isLocked())
-    {
-        cx = camera["principalPoint"]()[0].as<float>();
-        cy = camera["principalPoint"]()[1].as<float>();
-    }
-
-    // Some limits for the calibration parameters
-    if (fov < 4.0 || fov > 120.0 || abs(cx - 0.5) > 1.0 || abs(cy - 0.5) > 1.0)
-        return numeric_limits<double>::max();
-
-    dvec3 eye;
-    dvec3 target;
-    dvec3 up;
-    dvec3 euler;
-    for (int i = 0; i < 3; ++i)
-    {
-        eye[i] = gsl_vector_get(v, i + 3);
-        euler[i] = gsl_vector_get(v, i + 6);
-    }
-    dmat4 rotateMat = yawPitchRoll(euler[0], euler[1], euler[2]);
-    dvec4 targetTmp = rotateMat * dvec4(1.0, 0.0, 0.0, 0.0);
-    dvec4 upTmp = rotateMat * dvec4(0.0, 0.0, 1.0, 0.0);
-    for (int i = 0; i < 3; ++i)
-    {
-        target[i] = targetTmp[i];
-        up[i] = upTmp[i];
-    }
-    target += eye;
-
-    vector<dvec3> objectPoints;
-    vector<dvec3> imagePoints;
-    vector<float> pointsWeight;
-    for (auto& point : camera._calibrationPoints)
-    {
-        if (!point.isSet)
-            continue;
-
-        objectPoints.emplace_back(dvec3(point.world.x, point.world.y, point.world.z));
-        imagePoints.emplace_back(dvec3((point.screen.x + 1.0) / 2.0 * camera._width, (point.screen.y + 1.0) / 2.0 * camera._height, 0.0));
-        pointsWeight.push_back(point.weight);
-    }
-
-#ifdef DEBUG
-    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Values for the current iteration (fov, cx, cy): " << fov << " " << camera._width - cx << " "
-               << camera._height - cy << Log::endl;
-#endif
-
-    dmat4 lookM = lookAt(eye, target, up);
-    dmat4 projM = dmat4(getProjectionMatrix(fov, camera._near, camera._far, camera._width, camera._height, cx, cy));
-    dmat4 modelM(1.0);
-    dvec4 viewport(0, 0, camera._width, camera._height);
-
-    // Project all the object points, and measure the distance between them and the image points
-    double summedDistance = 0.0;
-    for (uint32_t i = 0; i < imagePoints.size(); ++i)
-    {
-        dvec3 projectedPoint;
-        projectedPoint = project(objectPoints[i], lookM, projM, viewport);
-        projectedPoint.z = 0.0;
-
-        if (camera._weightedCalibrationPoints)
-            summedDistance += pointsWeight[i] * pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
-        else
-            summedDistance += pow(imagePoints[i].x - projectedPoint.x, 2.0) + pow(imagePoints[i].y - projectedPoint.y, 2.0);
-    }
-    summedDistance /= imagePoints.size();
-
-#ifdef DEBUG
-    Log::get() << Log::DEBUGGING << "Camera::" << __FUNCTION__ << " - Actual summed distance: " << summedDistance << Log::endl;
-#endif
-
-    return summedDistance;
-}
-
 /*************/
 dmat4 Camera::computeProjectionMatrix()
 {
@@ -1053,6 +936,46 @@ void Camera::sendCalibrationPointsToObjects()
     }
 }
 
+/*************/
+void Camera::updateUniformBuffer()
+{
+    static_assert(sizeof(CameraUniforms) == 96 + 256 * 16, "CameraUniforms does not match the std140 layout of the cameraUniforms block");
+
+    auto colorBalance = colorBalanceFromTemperature(_colorTemperature);
+    CameraUniforms uniforms;
+    uniforms.wireframeColor = glm::vec4(_wireframeColor);
+    uniforms.fovAndColorBalance = glm::vec4(_fov * _width / _height * M_PI / 180.0, _fov * M_PI / 180.0, colorBalance.x, colorBalance.y);
+    uniforms.cameraAttributes = glm::vec2(_blendWidth, _brightness);
+    uniforms.showCameraCount = _showCameraCount;
+    uniforms.isColorLUT = _colorLUT.size() == 768 && _isColorLUTActivated;
+    if (uniforms.isColorLUT)
+    {
+        for (int u = 0; u < 3; ++u)
+            uniforms.colorMixMatrix[u] = glm::vec4(_colorMixMatrix[u], 0.f);
+        for (int i = 0; i < 256; ++i)
+            uniforms.colorLUT[i] = glm::vec4(_colorLUT[i * 3].as<float>(), _colorLUT[i * 3 + 1].as<float>(), _colorLUT[i * 3 + 2].as<float>(), 0.f);
+    }
+
+    if (!_uniformBuffer)
+        glGenBuffers(1, &_uniformBuffer);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, _uniformBuffer);
+    if (!_uniformBufferReady)
+    {
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniforms), &uniforms, GL_DYNAMIC_DRAW);
+        _uniformBufferReady = true;
+        _cameraUniforms = uniforms;
+    }
+    else if (memcmp(&uniforms, &_cameraUniforms, sizeof(CameraUniforms)) != 0)
+    {
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraUniforms), &uniforms);
+        _cameraUniforms = uniforms;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, SPLASH_SHADER_CAMERA_BINDING, _uniformBuffer);
+}
+
 /*************/
 void Camera::registerAttributes()
 {
@@ -1605,7 +1528,10 @@ void Camera::registerAttributes()
     setAttributeDescription("flashBG", "Switch background to light gray");
 
     addAttribute("getReprojectionError", nullptr, [&]() -> Values { return {_calibrationReprojectionError}; }, {});
-    setAttributeDescription("getReprojectionError", "Get the reprojection error for the current calibration");
+    setAttributeDescription("getReprojectionError", "Get the RMS reprojection error for the current calibration, in pixels");
+
+    addAttribute("calibrationProgress", nullptr, [&]() -> Values { return {_calibrationProgress.load()}; }, {});
+    setAttributeDescription("calibrationProgress", "Get the progress of the running calibration, between 0 and 1");
 }
 
 } // namespace Splash
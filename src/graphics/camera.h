@@ -25,7 +25,9 @@
 #ifndef SPLASH_CAMERA_H
 #define SPLASH_CAMERA_H
 
+#include <atomic>
 #include <functional>
+#include <future>
 #include <list>
 #include <memory>
 #include <string>
@@ -36,15 +38,13 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/euler_angles.hpp>
-#include <gsl/gsl_blas.h>
-#include <gsl/gsl_deriv.h>
-#include <gsl/gsl_multimin.h>
 
 #include "./config.h"
 
 #include "./core/attribute.h"
 #include "./core/coretypes.h"
 #include "./core/graph_object.h"
+#include "./graphics/calibration_solver.h"
 #include "./graphics/framebuffer.h"
 #include "./graphics/geometry.h"
 #include "./graphics/object.h"
@@ -85,13 +85,21 @@ class Camera : public GraphObject
 
     /**
      * \brief Tessellate the objects for this camera
+     * \param objects Objects to tessellate, among the ones linked to this camera. All of them if empty
      */
-    void blendingTessellateForCurrentCamera();
+    void blendingTessellateForCurrentCamera(const std::vector<std::shared_ptr<Object>>& objects = {});
 
     /**
-     * \brief Compute the blending for all objects seen by this camera
+     * \brief Compute the blending for the objects seen by this camera
+     * \param objects Objects to update, among the ones linked to this camera. All of them if empty
      */
-    void computeBlendingContribution();
+    void computeBlendingContribution(const std::vector<std::shared_ptr<Object>>& objects = {});
+
+    /**
+     * \brief Get the parameters the blending depends on
+     * \return Return the view and projection matrices, the blending width and precision
+     */
+    std::vector<double> getBlendingState();
 
     /**
      * \brief Compute the vertex visibility for all objects visible by this camera
@@ -111,8 +119,9 @@ class Camera : public GraphObject
     glm::dmat4 computeViewMatrix();
 
     /**
-     * \brief Compute the calibration given the calibration points
-     * \return Return true if all went well
+     * \brief Start computing the calibration given the calibration points, in the background
+     * The result is applied by the next call to render(). If a calibration is already running, another one follows it
+     * \return Return true if the calibration was started or queued
      */
     bool doCalibration();
 
@@ -238,6 +247,22 @@ class Camera : public GraphObject
     bool _isColorLUTActivated{false};
     glm::mat3 _colorMixMatrix;
 
+    // Uniforms shared by all the rendered objects, laid out as the std140 cameraUniforms block of the shaders
+    struct CameraUniforms
+    {
+        glm::vec4 wireframeColor{};
+        glm::vec4 fovAndColorBalance{};
+        glm::vec2 cameraAttributes{};
+        GLint showCameraCount{0};
+        GLint isColorLUT{0};
+        glm::vec4 colorMixMatrix[3]{}; // Columns of a mat3, padded to vec4
+        glm::vec4 colorLUT[256]{};     // vec3, padded to vec4
+    };
+    CameraUniforms _cameraUniforms{};
+    GLuint _uniformBuffer{0};
+    bool _uniformBufferReady{false};
+    Timer::Id _renderTimerId{};
+
     // Some default models use in various situations
     std::list<std::shared_ptr<Mesh>> _modelMeshes;
     std::unordered_map<std::string, std::shared_ptr<Object>> _models;
@@ -282,7 +307,11 @@ class Camera : public GraphObject
     };
     std::vector<CalibrationPoint> _calibrationPoints;
     int _selectedCalibrationPoint{-1};
-    float _calibrationReprojectionError{0.f};
+    float _calibrationReprojectionError{0.f}; //!< RMS reprojection error of the last calibration, in pixels
+    std::future<CalibrationSolver::Result> _calibrationFuture{};
+    std::atomic<float> _calibrationProgress{1.f};
+    std::atomic<bool> _calibrationCancelled{false};
+    bool _calibrationQueued{false};
 
     //! List of additional objects to draw
     struct Drawable
@@ -298,8 +327,11 @@ class Camera : public GraphObject
     };
     std::list<Drawable> _drawables;
 
-    // Function used for the calibration (camera parameters optimization)
-    static double calibrationCostFunc(const gsl_vector* v, void* params);
+    /**
+     * \brief Apply the result of a calibration, and send it to the other Scenes
+     * \param result Calibration result
+     */
+    void applyCalibration(const CalibrationSolver::Result& result);
 
     /**
      * \brief Load some defaults models, like the locator for calibration
@@ -311,6 +343,11 @@ class Camera : public GraphObject
      */
     void sendCalibrationPointsToObjects();
 
+    /**
+     * \brief Fill the uniform buffer shared by all the rendered objects, and bind it
+     */
+    void updateUniformBuffer();
+
     /**
      * \brief Register new functors to modify attributes
      */
@@ -31,6 +31,9 @@ void Filter::init()
 
     // Intialize FBO, textures and everything OpenGL
     setOutput();
+
+    // Created here and never reset, as the statistics attribute reads it from other threads
+    _statistics = make_unique<TextureStatistics>();
 }
 
 /*************/
@@ -169,6 +172,9 @@ void Filter::render()
     auto input = _inTextures[0].lock();
     auto inputSpec = input->getSpec();
 
+    // User shaders can depend on time, and the automatic black level converges over frames
+    bool forceRender = _autoBlackLevelTargetValue != 0.f || !_shaderSource.empty() || !_shaderSourceFile.empty();
+
     if (inputSpec != _outTextureSpec || (_sizeOverride[0] > 0 && _sizeOverride[1] > 0))
     {
         auto newOutTextureSpec = inputSpec;
@@ -183,9 +189,17 @@ void Filter::render()
         {
             _outTextureSpec = newOutTextureSpec;
             _fbo->setSize(_outTextureSpec.width, _outTextureSpec.height);
+            forceRender = true;
         }
     }
 
+    // Statistics are read back a frame or two after being computed, so as not to stall the render loop
+    if (_statistics && _statistics->retrieve() && _autoBlackLevelTargetValue != 0.f)
+        updateAutoBlackLevel(_statistics->getStatistics());
+
+    if (!needsRender(forceRender))
+        return;
+
     _fbo->bindDraw();
     glViewport(0, 0, _outTextureSpec.width, _outTextureSpec.height);
 
@@ -197,25 +211,29 @@ void Filter::render()
     _fbo->unbindDraw();
 
     _fbo->getColorTexture()->generateMipmap();
+    _timestamp = Timer::getTime();
 
-    // Automatic black level stuff
-    if (_autoBlackLevelTargetValue != 0.f)
-    {
-        auto luminance = _fbo->getColorTexture()->getMeanValue().luminance();
-        auto deltaLuminance = _autoBlackLevelTargetValue - luminance;
-        auto newBlackLevel = _autoBlackLevel + deltaLuminance / 2.f;
+    if (_autoBlackLevelTargetValue != 0.f || _computeStatistics)
+        _statistics->compute(_fbo->getColorTexture());
+}
+
+/*************/
+void Filter::updateAutoBlackLevel(const TextureStatistics::Statistics& statistics)
+{
+    auto luminance = statistics.mean.luminance();
+    auto deltaLuminance = _autoBlackLevelTargetValue - luminance;
+    auto newBlackLevel = _autoBlackLevel + deltaLuminance / 2.f;
 
-        auto currentTime = Timer::getTime() / 1000;
-        auto deltaT = _previousTime == 0 ? 0.f : static_cast<float>((currentTime - _previousTime) / 1e3);
-        _previousTime = currentTime;
+    auto currentTime = Timer::getTime() / 1000;
+    auto deltaT = _previousTime == 0 ? 0.f : static_cast<float>((currentTime - _previousTime) / 1e3);
+    _previousTime = currentTime;
 
-        if (deltaT != 0.f)
-        {
-            auto blackLevelProgress = std::min(1.f, deltaT / _autoBlackLevelSpeed); // Limit to 1.f, otherwise the black level resonates
-            newBlackLevel = min(_autoBlackLevelTargetValue, max(0.f, newBlackLevel));
-            _autoBlackLevel = newBlackLevel * blackLevelProgress + _autoBlackLevel * (1.f - blackLevelProgress);
-            _filterUniforms["_blackLevel"] = {_autoBlackLevel / 255.0};
-        }
+    if (deltaT != 0.f)
+    {
+        auto blackLevelProgress = std::min(1.f, deltaT / _autoBlackLevelSpeed); // Limit to 1.f, otherwise the black level resonates
+        newBlackLevel = min(_autoBlackLevelTargetValue, max(0.f, newBlackLevel));
+        _autoBlackLevel = newBlackLevel * blackLevelProgress + _autoBlackLevel * (1.f - blackLevelProgress);
+        _filterUniforms["_blackLevel"] = {_autoBlackLevel / 255.0};
     }
 }
 
@@ -223,9 +241,16 @@ void Filter::render()
 void Filter::updateUniforms()
 {
     auto shader = _screen->getShader();
+    if (_uniformsShader.lock() != shader)
+    {
+        _uniformsShader = shader;
+        _timeUniform = shader->getUniformHandle("_time");
+        _filmRemainingUniform = shader->getUniformHandle("_filmRemaining");
+        _filmDurationUniform = shader->getUniformHandle("_filmDuration");
+    }
 
     // Built-in uniforms
-    _filterUniforms["_time"] = {static_cast<int>(Timer::getTime() / 1000)};
+    shader->setUniform(_timeUniform, static_cast<int>(Timer::getTime() / 1000));
 
     if (!_colorCurves.empty())
     {
@@ -250,9 +275,9 @@ void Filter::updateUniforms()
                 obj->getAttribute("duration", duration);
                 obj->getAttribute("remaining", remainingTime);
                 if (remainingTime.size() == 1)
-                    shader->setAttribute("uniform", {"_filmRemaining", remainingTime[0].as<float>()});
+                    shader->setUniform(_filmRemainingUniform, remainingTime[0].as<float>());
                 if (duration.size() == 1)
-                    shader->setAttribute("uniform", {"_filmDuration", duration[0].as<float>()});
+                    shader->setUniform(_filmDurationUniform, duration[0].as<float>());
             }
         }
     }
@@ -400,6 +425,40 @@ void Filter::registerAttributes()
         [&]() -> Values { return {_shaderSourceFile}; },
         {'s'});
     setAttributeDescription("fileFilterSource", "Set the fragment shader source for the filter from a file");
+
+    addAttribute("computeStatistics",
+        [&](const Values& args) {
+            _computeStatistics = args[0].as<bool>();
+            return true;
+        },
+        [&]() -> Values { return {static_cast<int>(_computeStatistics)}; },
+        {'n'});
+    setAttributeDescription("computeStatistics", "If set to 1, the statistics of the filter output are computed at each frame. They are always computed when the black level is automatic");
+
+    addAttribute("statistics",
+        nullptr,
+        [&]() -> Values {
+            if (!_statistics)
+                return {};
+
+            auto statistics = _statistics->getStatistics();
+            if (statistics.timestamp == 0)
+                return {};
+            Values histogram;
+            for (auto count : statistics.histogram)
+                histogram.push_back(static_cast<int64_t>(count));
+            return {Values({statistics.mean.r, statistics.mean.g, statistics.mean.b}),
+                Values({statistics.min.r, statistics.min.g, statistics.min.b}),
+                Values({statistics.max.r, statistics.max.g, statistics.max.b}),
+                histogram,
+                static_cast<int64_t>(statistics.pixelCount),
+                statistics.timestamp};
+        },
+        {});
+    setAttributeParameter("statistics", false, false);
+    setAttributeDescription("statistics",
+        "Statistics of the filter output, computed on the GPU: mean, minimum and maximum RGB values (between 0 and 255), luminance histogram over 256 bins, "
+        "pixel count and timestamp in microseconds");
 }
 
 /*************/
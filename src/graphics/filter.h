@@ -38,6 +38,7 @@
 #include "./graphics/object.h"
 #include "./graphics/texture.h"
 #include "./graphics/texture_image.h"
+#include "./graphics/texture_statistics.h"
 #include "./image/image.h"
 
 namespace Splash
@@ -152,14 +153,29 @@ class Filter : public Texture
     float _autoBlackLevel{0.f};
     int64_t _previousTime{0}; //!< Used for computing the current black value regarding black value speed
 
+    bool _computeStatistics{false};                         //!< If true, statistics are computed even without automatic black level
+    std::unique_ptr<TextureStatistics> _statistics{nullptr}; //!< Created in init, only when the filter has a root object
+
     std::string _shaderSource{""};     //!< User defined fragment shader filter
     std::string _shaderSourceFile{""}; //!< User defined fragment shader filter source file
 
+    // Handles to the built-in uniforms, resolved once per shader
+    std::weak_ptr<Shader> _uniformsShader{}; //!< Shader the following handles belong to
+    Shader::UniformHandle _timeUniform{};
+    Shader::UniformHandle _filmRemainingUniform{};
+    Shader::UniformHandle _filmDurationUniform{};
+
     /**
      * \brief Init function called in constructors
      */
     void init();
 
+    /**
+     * \brief Update the automatic black level so that the mean luminance gets closer to the target
+     * \param statistics Statistics of a previous output
+     */
+    void updateAutoBlackLevel(const TextureStatistics::Statistics& statistics);
+
     /**
      * \brief Set the filter fragment shader. Automatically adds attributes corresponding to the uniforms
      * \param source Source fragment shader
@@ -88,7 +88,7 @@ void Geometry::activateAsSharedBuffer()
 /*************/
 void Geometry::activateForFeedback()
 {
-    _feedbackMaxNbrPrimitives = std::max(_verticesNumber / 3, _feedbackMaxNbrPrimitives);
+    _feedbackMaxNbrPrimitives = std::max(getVerticesNumber() / 3, _feedbackMaxNbrPrimitives);
     if (_glTemporaryBuffers.size() < _glBuffers.size() || _buffersDirty || _feedbackMaxNbrPrimitives * 6 > _temporaryBufferSize)
     {
         _glTemporaryBuffers.clear();
@@ -122,6 +122,15 @@ void Geometry::deactivate() const
     _mutex.unlock();
 }
 
+/*************/
+void Geometry::draw() const
+{
+    if (!_useAlternativeBuffers && _glIndexBuffer)
+        glDrawElements(GL_TRIANGLES, _indicesNumber, GL_UNSIGNED_INT, nullptr);
+    else
+        glDrawArrays(GL_TRIANGLES, 0, getVerticesNumber());
+}
+
 /*************/
 void Geometry::deactivateFeedback()
 {
@@ -197,28 +206,62 @@ bool Geometry::linkTo(const shared_ptr<GraphObject>& obj)
 /*************/
 float Geometry::pickVertex(dvec3 p, dvec3& v)
 {
-    float distance = numeric_limits<float>::max();
-    dvec3 closestVertex;
-
     if (_mesh.expired())
-        return distance;
+        return numeric_limits<float>::max();
     auto mesh = _mesh.lock();
 
-    vector<float> vertices = mesh->getVertCoords();
-    for (uint32_t i = 0; i < vertices.size(); i += 4)
+    return mesh->getBVH()->nearestVertex(p, v);
+}
+
+/*************/
+void Geometry::resetAlternativeBuffers()
+{
+    update();
+
+    lock_guard<mutex> lock(_mutex);
+    if (_glBuffers.size() != 4 || !_glBuffers[0])
+        return;
+
+    auto verticesNumber = _glIndexBuffer ? _indicesNumber : _verticesNumber;
+    if (_glAlternativeBuffers.size() != _glBuffers.size() || _alternativeBufferSize < verticesNumber)
     {
-        dvec3 vertex(vertices[i], vertices[i + 1], vertices[i + 2]);
-        float dist = length(p - vertex);
-        if (dist < distance)
+        _glAlternativeBuffers.clear();
+        for (auto& buffer : _glBuffers)
+            _glAlternativeBuffers.push_back(make_shared<GpuBuffer>(buffer->getElementSize(), GL_FLOAT, GL_STATIC_DRAW, verticesNumber, nullptr));
+        _alternativeBufferSize = verticesNumber;
+    }
+
+    if (!_glIndexBuffer)
+    {
+        for (uint32_t idx = 0; idx < _glBuffers.size(); ++idx)
+            glCopyNamedBufferSubData(_glBuffers[idx]->getId(), _glAlternativeBuffers[idx]->getId(), 0, 0, _glBuffers[idx]->getMemorySize());
+    }
+    else
+    {
+        if (!_expandIndicesShader)
         {
-            closestVertex = vertex;
-            distance = dist;
+            _expandIndicesShader = make_shared<Shader>(Shader::prgCompute);
+            _expandIndicesShader->setAttribute("computePhase", {"expandIndices"});
+            _indexNbrUniform = _expandIndicesShader->getUniformHandle("_indexNbr");
+            _componentNbrUniform = _expandIndicesShader->getUniformHandle("_componentNbr");
         }
-    }
 
-    v = closestVertex;
+        // One dispatch per attribute, to stay within the guaranteed number of storage blocks
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, _glIndexBuffer->getId());
+        for (uint32_t idx = 0; idx < _glBuffers.size(); ++idx)
+        {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _glBuffers[idx]->getId());
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _glAlternativeBuffers[idx]->getId());
+            _expandIndicesShader->setUniform(_indexNbrUniform, _indicesNumber);
+            _expandIndicesShader->setUniform(_componentNbrUniform, static_cast<int>(_glBuffers[idx]->getElementSize()));
+            _expandIndicesShader->doCompute(_indicesNumber / 128 + 1);
+        }
+        glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_TRANSFORM_FEEDBACK_BARRIER_BIT);
+    }
 
-    return distance;
+    _alternativeVerticesNumber = verticesNumber;
+    _useAlternativeBuffers = true;
+    _buffersDirty = true;
 }
 
 /*************/
@@ -273,16 +316,28 @@ void Geometry::update()
         else
             _glBuffers[3] = make_shared<GpuBuffer>(4, GL_FLOAT, GL_STATIC_DRAW, _verticesNumber, annexe.data());
 
+        // Meshes fed as independent triangles have no indices, and are drawn as is
+        vector<uint32_t> indices = mesh->getIndices();
+        _indicesNumber = indices.size();
+        if (indices.size() == 0)
+            _glIndexBuffer.reset();
+        else
+            _glIndexBuffer = make_shared<GpuBuffer>(1, GL_UNSIGNED_INT, GL_STATIC_DRAW, _indicesNumber, indices.data());
+
         // Check the buffers
         bool buffersSet = true;
         for (auto& buffer : _glBuffers)
             if (!*buffer)
                 buffersSet = false;
 
+        if (_glIndexBuffer && !*_glIndexBuffer)
+            buffersSet = false;
+
         if (!buffersSet)
         {
             _glBuffers.clear();
             _glBuffers.resize(4);
+            _glIndexBuffer.reset();
             return;
         }
 
@@ -361,6 +416,12 @@ void Geometry::update()
             glEnableVertexAttribArray((GLuint)idx);
         }
 
+        // The index buffer binding is part of the vertex array state
+        if (!_useAlternativeBuffers && _glIndexBuffer)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _glIndexBuffer->getId());
+        else
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
 
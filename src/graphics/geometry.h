@@ -37,6 +37,7 @@
 #include "./core/buffer_object.h"
 #include "./core/coretypes.h"
 #include "./graphics/gpu_buffer.h"
+#include "./graphics/shader.h"
 #include "./mesh/mesh.h"
 
 namespace Splash
@@ -88,10 +89,20 @@ class Geometry : public BufferObject
     void deactivateFeedback();
 
     /**
-     * \brief Get the number of vertices for this geometry
+     * \brief Draw the geometry as triangles, through the index buffer if any. The geometry must be activated
+     */
+    void draw() const;
+
+    /**
+     * \brief Get the number of vertices drawn for this geometry, which is the index count for indexed meshes
      * \return Return the vertice count
      */
-    int getVerticesNumber() const { return _useAlternativeBuffers ? _alternativeVerticesNumber : _verticesNumber; }
+    int getVerticesNumber() const
+    {
+        if (_useAlternativeBuffers)
+            return _alternativeVerticesNumber;
+        return _glIndexBuffer ? _indicesNumber : _verticesNumber;
+    }
 
     /**
      * \brief Get the geometry as serialized
@@ -126,6 +137,22 @@ class Geometry : public BufferObject
      */
     float pickVertex(glm::dvec3 p, glm::dvec3& v);
 
+    /**
+     * \brief Get the timestamp of the mesh, which changes whenever the mesh is modified
+     * \return Return the timestamp, or 0 if there is no mesh
+     */
+    int64_t getMeshTimestamp() const
+    {
+        auto mesh = _mesh.lock();
+        return mesh ? mesh->getTimestamp() : 0;
+    }
+
+    /**
+     * \brief Fill the alternative buffers with the mesh as independent triangles, and use them for drawing.
+     * This is the starting point for blending, which stores per-primitive values in the vertex attributes
+     */
+    void resetAlternativeBuffers();
+
     /**
      * \brief Set the mesh for this object
      * \param mesh Mesh
@@ -159,6 +186,7 @@ class Geometry : public BufferObject
     std::vector<std::shared_ptr<GpuBuffer>> _glBuffers{};
     std::vector<std::shared_ptr<GpuBuffer>> _glAlternativeBuffers{}; // Alternative buffers used for rendering
     std::vector<std::shared_ptr<GpuBuffer>> _glTemporaryBuffers{};   // Temporary buffers used for feedback
+    std::shared_ptr<GpuBuffer> _glIndexBuffer{nullptr};              // Triangle indices, if the mesh is indexed
     bool _buffersDirty{false};
     bool _buffersResized{false}; // Holds whether the alternative buffers have been resized in the previous feedback
     bool _useAlternativeBuffers{false};
@@ -166,6 +194,7 @@ class Geometry : public BufferObject
     SerializedObject _serializedMesh{};
 
     int _verticesNumber{0};
+    int _indicesNumber{0};
     int _alternativeVerticesNumber{0};
     int _alternativeBufferSize{0};
     int _temporaryVerticesNumber{0};
@@ -176,6 +205,11 @@ class Geometry : public BufferObject
     bool _feedbackQueryRunning{false};
     int _feedbackMaxNbrPrimitives{0};
 
+    // Expansion of indexed meshes into independent triangles
+    std::shared_ptr<Shader> _expandIndicesShader{nullptr};
+    Shader::UniformHandle _indexNbrUniform{};
+    Shader::UniformHandle _componentNbrUniform{};
+
     /**
      * \brief Initialization
      */
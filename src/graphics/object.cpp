@@ -112,9 +112,16 @@ void Object::activate()
     }
 
     // Set some uniforms
+    if (_uniformsShader.lock() != _shader)
+    {
+        _uniformsShader = _shader;
+        _normalExpUniform = _shader->getUniformHandle("_normalExp");
+        _colorUniform = _shader->getUniformHandle("_color");
+    }
+
     _shader->setAttribute("sideness", {_sideness});
-    _shader->setAttribute("uniform", {"_normalExp", _normalExponent});
-    _shader->setAttribute("uniform", {"_color", _color.r, _color.g, _color.b, _color.a});
+    _shader->setUniform(_normalExpUniform, _normalExponent);
+    _shader->setUniform(_colorUniform, glm::vec4(_color));
 
     if (_geometries.size() > 0)
     {
@@ -200,7 +207,7 @@ void Object::draw()
         return;
 
     _shader->updateUniforms();
-    glDrawArrays(GL_TRIANGLES, 0, _geometries[0]->getVerticesNumber());
+    _geometries[0]->draw();
 }
 
 /*************/
@@ -360,7 +367,10 @@ void Object::removeGeometry(const shared_ptr<Geometry>& geometry)
 {
     auto geomIt = find(_geometries.begin(), _geometries.end(), geometry);
     if (geomIt != _geometries.end())
+    {
         _geometries.erase(geomIt);
+        ++_contentVersion;
+    }
 }
 
 /*************/
@@ -368,13 +378,34 @@ void Object::removeTexture(const shared_ptr<Texture>& tex)
 {
     auto texIterator = find(_textures.begin(), _textures.end(), tex);
     if (texIterator != _textures.end())
+    {
         _textures.erase(texIterator);
+        ++_contentVersion;
+    }
+}
+
+/*************/
+vector<double> Object::getBlendingState() const
+{
+    lock_guard<mutex> lock(_mutex);
+
+    vector<double> state;
+    auto modelMatrix = computeModelMatrix();
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            state.push_back(modelMatrix[c][r]);
+    state.push_back(_sideness);
+    for (auto& geom : _geometries)
+        state.push_back(static_cast<double>(geom->getMeshTimestamp()));
+
+    return state;
 }
 
 /*************/
 void Object::resetVisibility(int primitiveIdShift)
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     if (!_computeShaderResetVisibility)
     {
@@ -401,6 +432,7 @@ void Object::resetVisibility(int primitiveIdShift)
 void Object::resetBlendingAttribute()
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     if (!_computeShaderResetBlendingAttributes)
     {
@@ -426,23 +458,32 @@ void Object::resetBlendingAttribute()
 void Object::resetTessellation()
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     for (auto& geom : _geometries)
-    {
-        geom->useAlternativeBuffers(false);
-    }
+        geom->resetAlternativeBuffers();
 }
 
 /*************/
 void Object::tessellateForThisCamera(glm::dmat4 viewMatrix, glm::dmat4 projectionMatrix, float fovX, float fovY, float blendWidth, float blendPrecision)
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     if (!_feedbackShaderSubdivideCamera)
     {
         _feedbackShaderSubdivideCamera = make_shared<Shader>(Shader::prgFeedback);
         _feedbackShaderSubdivideCamera->setAttribute("feedbackPhase", {"tessellateFromCamera"});
         _feedbackShaderSubdivideCamera->setAttribute("feedbackVaryings", {"GEOM_OUT.vertex", "GEOM_OUT.texcoord", "GEOM_OUT.normal", "GEOM_OUT.annexe"});
+
+        _tessellationUniforms.blendWidth = _feedbackShaderSubdivideCamera->getUniformHandle("_blendWidth");
+        _tessellationUniforms.blendPrecision = _feedbackShaderSubdivideCamera->getUniformHandle("_blendPrecision");
+        _tessellationUniforms.sideness = _feedbackShaderSubdivideCamera->getUniformHandle("_sideness");
+        _tessellationUniforms.fov = _feedbackShaderSubdivideCamera->getUniformHandle("_fov");
+        _tessellationUniforms.mv = _feedbackShaderSubdivideCamera->getUniformHandle("_mv");
+        _tessellationUniforms.mvp = _feedbackShaderSubdivideCamera->getUniformHandle("_mvp");
+        _tessellationUniforms.ip = _feedbackShaderSubdivideCamera->getUniformHandle("_ip");
+        _tessellationUniforms.mNormal = _feedbackShaderSubdivideCamera->getUniformHandle("_mNormal");
     }
 
     if (_feedbackShaderSubdivideCamera)
@@ -454,26 +495,16 @@ void Object::tessellateForThisCamera(glm::dmat4 viewMatrix, glm::dmat4 projectio
                 geom->update();
                 geom->activate();
 
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_blendWidth", blendWidth});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_blendPrecision", blendPrecision});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_sideness", _sideness});
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_fov", fovX, fovY});
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.blendWidth, blendWidth);
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.blendPrecision, blendPrecision);
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.sideness, _sideness);
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.fov, glm::vec2(fovX, fovY));
 
                 auto mv = viewMatrix * computeModelMatrix();
-                auto mvAsValues = Values(glm::value_ptr(mv), glm::value_ptr(mv) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mv", mvAsValues});
-
-                auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
-                auto mvpAsValues = Values(glm::value_ptr(mvp), glm::value_ptr(mvp) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mvp", mvpAsValues});
-
-                auto ip = glm::inverse(projectionMatrix);
-                auto ipAsValues = Values(glm::value_ptr(ip), glm::value_ptr(ip) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_ip", ipAsValues});
-
-                auto mNormal = projectionMatrix * glm::transpose(glm::inverse(viewMatrix * computeModelMatrix()));
-                auto mNormalAsValues = Values(glm::value_ptr(mNormal), glm::value_ptr(mNormal) + 16);
-                _feedbackShaderSubdivideCamera->setAttribute("uniform", {"_mNormal", mNormalAsValues});
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.mv, glm::mat4(mv));
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.mvp, glm::mat4(projectionMatrix * mv));
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.ip, glm::mat4(glm::inverse(projectionMatrix)));
+                _feedbackShaderSubdivideCamera->setUniform(_tessellationUniforms.mNormal, glm::mat4(projectionMatrix * glm::transpose(glm::inverse(mv))));
 
                 geom->activateForFeedback();
                 _feedbackShaderSubdivideCamera->activate();
@@ -496,6 +527,7 @@ void Object::tessellateForThisCamera(glm::dmat4 viewMatrix, glm::dmat4 projectio
 void Object::transferVisibilityFromTexToAttr(int width, int height, int primitiveIdShift)
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     if (!_computeShaderTransferVisibilityToAttr)
     {
@@ -519,11 +551,18 @@ void Object::transferVisibilityFromTexToAttr(int width, int height, int primitiv
 void Object::computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 projectionMatrix, float blendWidth)
 {
     lock_guard<mutex> lock(_mutex);
+    ++_contentVersion;
 
     if (!_computeShaderComputeBlending)
     {
         _computeShaderComputeBlending = make_shared<Shader>(Shader::prgCompute);
         _computeShaderComputeBlending->setAttribute("computePhase", {"computeCameraContribution"});
+
+        _contributionUniforms.vertexNbr = _computeShaderComputeBlending->getUniformHandle("_vertexNbr");
+        _contributionUniforms.sideness = _computeShaderComputeBlending->getUniformHandle("_sideness");
+        _contributionUniforms.blendWidth = _computeShaderComputeBlending->getUniformHandle("_blendWidth");
+        _contributionUniforms.mvp = _computeShaderComputeBlending->getUniformHandle("_mvp");
+        _contributionUniforms.mNormal = _computeShaderComputeBlending->getUniformHandle("_mNormal");
     }
 
     if (_computeShaderComputeBlending)
@@ -535,17 +574,13 @@ void Object::computeCameraContribution(glm::dmat4 viewMatrix, glm::dmat4 project
 
             // Set uniforms
             auto verticesNbr = geom->getVerticesNumber();
-            _computeShaderComputeBlending->setAttribute("uniform", {"_vertexNbr", verticesNbr});
-            _computeShaderComputeBlending->setAttribute("uniform", {"_sideness", _sideness});
-            _computeShaderComputeBlending->setAttribute("uniform", {"_blendWidth", blendWidth});
-
-            auto mvp = projectionMatrix * viewMatrix * computeModelMatrix();
-            auto mvpAsValues = Values(glm::value_ptr(mvp), glm::value_ptr(mvp) + 16);
-            _computeShaderComputeBlending->setAttribute("uniform", {"_mvp", mvpAsValues});
+            _computeShaderComputeBlending->setUniform(_contributionUniforms.vertexNbr, verticesNbr);
+            _computeShaderComputeBlending->setUniform(_contributionUniforms.sideness, _sideness);
+            _computeShaderComputeBlending->setUniform(_contributionUniforms.blendWidth, blendWidth);
 
-            auto mNormal = projectionMatrix * glm::transpose(glm::inverse(viewMatrix * computeModelMatrix()));
-            auto mNormalAsValues = Values(glm::value_ptr(mNormal), glm::value_ptr(mNormal) + 16);
-            _computeShaderComputeBlending->setAttribute("uniform", {"_mNormal", mNormalAsValues});
+            auto mv = viewMatrix * computeModelMatrix();
+            _computeShaderComputeBlending->setUniform(_contributionUniforms.mvp, glm::mat4(projectionMatrix * mv));
+            _computeShaderComputeBlending->setUniform(_contributionUniforms.mNormal, glm::mat4(projectionMatrix * glm::transpose(glm::inverse(mv))));
 
             _computeShaderComputeBlending->doCompute(verticesNbr / 3);
 
@@ -84,13 +84,21 @@ class Object : public GraphObject
      * \brief Add a geometry to this object
      * \param geometry Geometry to add
      */
-    void addGeometry(const std::shared_ptr<Geometry>& geometry) { _geometries.push_back(geometry); }
+    void addGeometry(const std::shared_ptr<Geometry>& geometry)
+    {
+        _geometries.push_back(geometry);
+        ++_contentVersion;
+    }
 
     /**
      * \brief Add a texture to this object
      * \param texture Texture to add
      */
-    void addTexture(const std::shared_ptr<Texture>& texture) { _textures.push_back(texture); }
+    void addTexture(const std::shared_ptr<Texture>& texture)
+    {
+        _textures.push_back(texture);
+        ++_contentVersion;
+    }
 
     /**
      * \brief Add a calibration point
@@ -121,6 +129,12 @@ class Object : public GraphObject
      */
     inline glm::dmat4 getModelMatrix() const { return computeModelMatrix(); }
 
+    /**
+     * \brief Get the parameters the blending of this object depends on, apart from the cameras
+     * \return Return the model matrix, the sideness and the timestamp of each mesh
+     */
+    std::vector<double> getBlendingState() const;
+
     /**
      * \brief Get the shader used for the object
      * \return Return the shader
@@ -166,7 +180,7 @@ class Object : public GraphObject
     void removeTexture(const std::shared_ptr<Texture>& texture);
 
     /**
-     * \brief Reset tessellation of all linked objects
+     * \brief Reset tessellation of all linked objects, starting again from their meshes as independent triangles
      */
     void resetTessellation();
 
@@ -198,7 +212,11 @@ class Object : public GraphObject
      * \brief Set the model matrix. This overrides the position attribute
      * \param model Model matrix
      */
-    void setModelMatrix(const glm::dmat4& model) { _modelMatrix = model; }
+    void setModelMatrix(const glm::dmat4& model)
+    {
+        _modelMatrix = model;
+        ++_contentVersion;
+    }
 
     /**
      * \brief Subdivide the objects wrt the given camera limits (for blending purposes)
@@ -230,6 +248,19 @@ class Object : public GraphObject
     std::shared_ptr<Shader> _computeShaderTransferVisibilityToAttr{};
     std::shared_ptr<Shader> _feedbackShaderSubdivideCamera{};
 
+    // Handles to the uniforms set at each frame, resolved once per shader
+    std::weak_ptr<Shader> _uniformsShader{}; //!< Graphics shader the following handles belong to
+    Shader::UniformHandle _normalExpUniform{};
+    Shader::UniformHandle _colorUniform{};
+    struct
+    {
+        Shader::UniformHandle blendWidth, blendPrecision, sideness, fov, mv, mvp, ip, mNormal;
+    } _tessellationUniforms;
+    struct
+    {
+        Shader::UniformHandle vertexNbr, sideness, blendWidth, mvp, mNormal;
+    } _contributionUniforms;
+
     // A map for previously used graphics shaders
     std::map<std::string, std::shared_ptr<Shader>> _graphicsShaders;
 
@@ -0,0 +1,307 @@
+#include "./graphics/program_cache.h"
+
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+#include "./utils/timer.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+/*************/
+string stringFromShaderType(GLenum type)
+{
+    switch (type)
+    {
+    default:
+        return string();
+    case GL_VERTEX_SHADER:
+        return "vertex";
+    case GL_TESS_CONTROL_SHADER:
+        return "tess_ctrl";
+    case GL_TESS_EVALUATION_SHADER:
+        return "tess_eval";
+    case GL_GEOMETRY_SHADER:
+        return "geometry";
+    case GL_FRAGMENT_SHADER:
+        return "fragment";
+    case GL_COMPUTE_SHADER:
+        return "compute";
+    }
+}
+} // end of anonymous namespace
+
+/*************/
+ProgramCache::Program::~Program()
+{
+    if (glIsProgram(id))
+        glDeleteProgram(id);
+}
+
+/*************/
+shared_ptr<ProgramCache::Program> ProgramCache::getProgram(const map<GLenum, string>& sources, const vector<string>& feedbackVaryings, const string& name)
+{
+    // The key holds the whole sources, so that programs are never mixed up
+    string key;
+    for (const auto& source : sources)
+        key += to_string(source.first) + ":" + to_string(source.second.size()) + ":" + source.second;
+    for (const auto& varying : feedbackVaryings)
+        key += "varying:" + varying + ";";
+
+    lock_guard<mutex> lock(_mutex);
+    auto programIt = _programs.find(key);
+    if (programIt != _programs.end())
+    {
+        if (auto program = programIt->second.lock())
+        {
+            ++_stats.shared;
+            return program;
+        }
+    }
+
+    initBinaryCache();
+
+    auto startTime = Timer::getTime();
+    auto program = make_shared<Program>();
+    program->id = glCreateProgram();
+    if (loadBinary(*program, key))
+    {
+        ++_stats.loaded;
+    }
+    else
+    {
+        program->linked = compileProgram(*program, sources, feedbackVaryings, name);
+        if (program->linked)
+            saveBinary(*program, key);
+        ++_stats.compiled;
+    }
+    _stats.duration += Timer::getTime() - startTime;
+
+    // Programs released by all their shaders are forgotten, the binary cache makes them cheap to get back
+    for (auto it = _programs.begin(); it != _programs.end();)
+    {
+        if (it->second.expired())
+            it = _programs.erase(it);
+        else
+            ++it;
+    }
+
+    _programs[key] = program;
+    return program;
+}
+
+/*************/
+ProgramCache::Stats ProgramCache::getStats() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _stats;
+}
+
+/*************/
+void ProgramCache::initBinaryCache()
+{
+    if (_binaryCacheChecked)
+        return;
+    _binaryCacheChecked = true;
+
+    GLint formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0)
+    {
+        Log::get() << Log::MESSAGE << "ProgramCache::" << __FUNCTION__ << " - The driver does not support program binaries, shaders will be compiled at every start" << Log::endl;
+        return;
+    }
+
+    auto cachePath = Utils::getCachePath();
+    if (cachePath.empty())
+        return;
+
+    // Binaries are only valid for the driver which created them
+    auto glString = [](GLenum name) {
+        auto str = glGetString(name);
+        return str ? string(reinterpret_cast<const char*>(str)) : string();
+    };
+    _driverSignature = glString(GL_VENDOR) + ";" + glString(GL_RENDERER) + ";" + glString(GL_VERSION);
+    _binaryCachePath = cachePath;
+}
+
+/*************/
+string ProgramCache::getCacheFilePath(const string& key) const
+{
+    stringstream cacheFilename;
+    cacheFilename << hex << hash<string>()(_driverSignature + key) << ".glprogram";
+    return _binaryCachePath + cacheFilename.str();
+}
+
+/*************/
+bool ProgramCache::compileProgram(Program& program, const map<GLenum, string>& sources, const vector<string>& feedbackVaryings, const string& name)
+{
+    vector<GLuint> shaders;
+    bool status = true;
+    for (const auto& source : sources)
+    {
+        auto shader = glCreateShader(source.first);
+        const char* shaderSrc = source.second.c_str();
+        glShaderSource(shader, 1, (const GLchar**)&shaderSrc, 0);
+        glCompileShader(shader);
+
+        GLint compileStatus;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+        if (!compileStatus)
+        {
+            Log::get() << Log::WARNING << "ProgramCache::" << __FUNCTION__ << " - Error while compiling a shader of type " << stringFromShaderType(source.first) << " for program "
+                       << name << Log::endl;
+            GLint length;
+            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+            string log(max(length, 1), '\0');
+            glGetShaderInfoLog(shader, length, &length, &log[0]);
+            Log::get() << Log::WARNING << "ProgramCache::" << __FUNCTION__ << " - Error log: \n" << log.c_str() << Log::endl;
+            status = false;
+        }
+
+        glAttachShader(program.id, shader);
+        shaders.push_back(shader);
+    }
+
+    if (status)
+    {
+        if (!feedbackVaryings.empty())
+        {
+            vector<const GLchar*> varyings;
+            for (const auto& varying : feedbackVaryings)
+                varyings.push_back(varying.c_str());
+            glTransformFeedbackVaryings(program.id, varyings.size(), varyings.data(), GL_SEPARATE_ATTRIBS);
+        }
+
+        glProgramParameteri(program.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(program.id);
+
+        GLint linkStatus;
+        glGetProgramiv(program.id, GL_LINK_STATUS, &linkStatus);
+        if (!linkStatus)
+        {
+            Log::get() << Log::WARNING << "ProgramCache::" << __FUNCTION__ << " - Error while linking the shader program " << name << Log::endl;
+            GLint length;
+            glGetProgramiv(program.id, GL_INFO_LOG_LENGTH, &length);
+            string log(max(length, 1), '\0');
+            glGetProgramInfoLog(program.id, length, &length, &log[0]);
+            Log::get() << Log::WARNING << "ProgramCache::" << __FUNCTION__ << " - Error log: \n" << log.c_str() << Log::endl;
+            status = false;
+        }
+#ifdef DEBUG
+        else
+        {
+            Log::get() << Log::DEBUGGING << "ProgramCache::" << __FUNCTION__ << " - Shader program " << name << " linked successfully" << Log::endl;
+        }
+#endif
+    }
+
+    // The shaders are not needed once the program is linked
+    for (auto shader : shaders)
+    {
+        glDetachShader(program.id, shader);
+        glDeleteShader(shader);
+    }
+
+    return status;
+}
+
+/*************/
+bool ProgramCache::loadBinary(Program& program, const string& key)
+{
+    if (_binaryCachePath.empty())
+        return false;
+
+    auto cachePath = getCacheFilePath(key);
+    ifstream file(cachePath, ios::in | ios::binary | ios::ate);
+    if (!file.is_open())
+        return false;
+    auto fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    // Protects against truncated or corrupted files
+    CacheHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != SPLASH_PROGRAM_CACHE_MAGIC || header.version != SPLASH_PROGRAM_CACHE_VERSION || header.keySize != key.size() || header.binarySize == 0 ||
+        fileSize != sizeof(header) + header.keySize + header.binarySize)
+        return false;
+
+    // The key is stored to rule out hash collisions
+    string storedKey(header.keySize, '\0');
+    file.read(&storedKey[0], header.keySize);
+    if (!file || storedKey != key)
+        return false;
+
+    vector<char> binary(header.binarySize);
+    file.read(binary.data(), binary.size());
+    if (!file)
+        return false;
+
+    glProgramBinary(program.id, header.binaryFormat, binary.data(), binary.size());
+    GLint linkStatus;
+    glGetProgramiv(program.id, GL_LINK_STATUS, &linkStatus);
+    if (!linkStatus)
+    {
+        // Binaries can be rejected after a driver update, in which case the program is compiled and saved again
+        remove(cachePath.c_str());
+        return false;
+    }
+
+    program.linked = true;
+    return true;
+}
+
+/*************/
+bool ProgramCache::saveBinary(const Program& program, const string& key)
+{
+    if (_binaryCachePath.empty())
+        return false;
+
+    GLint binarySize = 0;
+    glGetProgramiv(program.id, GL_PROGRAM_BINARY_LENGTH, &binarySize);
+    if (binarySize <= 0)
+        return false;
+
+    CacheHeader header;
+    vector<char> binary(binarySize);
+    GLenum binaryFormat;
+    glGetProgramBinary(program.id, binarySize, nullptr, &binaryFormat, binary.data());
+    header.binaryFormat = binaryFormat;
+    header.keySize = key.size();
+    header.binarySize = binary.size();
+
+    // Written to a temporary file first, so that the other processes never see a partial program
+    auto cachePath = getCacheFilePath(key);
+    auto tmpPath = cachePath + "." + to_string(getpid()) + ".tmp";
+    {
+        ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(key.data(), key.size());
+        file.write(binary.data(), binary.size());
+        if (!file)
+        {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Splash
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * @program_cache.h
+ * Process-wide registry of linked GL programs, backed by an on-disk cache of program binaries
+ */
+
+#ifndef SPLASH_PROGRAM_CACHE_H
+#define SPLASH_PROGRAM_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./config.h"
+
+#include "./core/coretypes.h"
+
+#define SPLASH_PROGRAM_CACHE_MAGIC 0x47505053 // "SPPG"
+#define SPLASH_PROGRAM_CACHE_VERSION 1
+
+namespace Splash
+{
+
+/*************/
+class ProgramCache
+{
+  public:
+    struct Program
+    {
+        GLuint id{0};
+        bool linked{false};
+        const void* lastUser{nullptr};                             //!< Shader which last sent its uniforms to this program
+        std::unordered_map<std::string, Values> uniformDefaults{}; //!< Uniform values right after linking, as later users can not read them back
+
+        ~Program();
+    };
+
+    struct Stats
+    {
+        uint32_t compiled{0}; //!< Programs compiled from their sources
+        uint32_t loaded{0};   //!< Programs loaded from the binary cache
+        uint32_t shared{0};   //!< Programs reused from another shader
+        int64_t duration{0};  //!< Time spent compiling and loading programs, in microseconds
+    };
+
+    /**
+     * \brief Get the process-wide cache, which is created on first call
+     * \return Return a reference to the cache
+     */
+    static ProgramCache& get()
+    {
+        static auto instance = new ProgramCache;
+        return *instance;
+    }
+
+    /**
+     * \brief Get a program built from the given sources. It is shared with the other shaders using the same sources, and loaded
+     * from the binary cache if possible. It is compiled otherwise. A GL context has to be current.
+     * \param sources Preprocessed sources, indexed by GL shader type
+     * \param feedbackVaryings Varyings captured by transform feedback, as separate attributes
+     * \param name Program name, used for logging
+     * \return Return the program, which is not linked if it could not be built
+     */
+    std::shared_ptr<Program> getProgram(const std::map<GLenum, std::string>& sources, const std::vector<std::string>& feedbackVaryings, const std::string& name);
+
+    /**
+     * \brief Get the cache statistics since the process started
+     * \return Return the statistics
+     */
+    Stats getStats() const;
+
+  private:
+    ProgramCache() = default;
+    ~ProgramCache() = default;
+    ProgramCache(const ProgramCache&) = delete;
+    const ProgramCache& operator=(const ProgramCache&) = delete;
+
+    struct CacheHeader
+    {
+        uint32_t magic{SPLASH_PROGRAM_CACHE_MAGIC};
+        uint32_t version{SPLASH_PROGRAM_CACHE_VERSION};
+        uint32_t binaryFormat{0};
+        uint32_t keySize{0};
+        uint64_t binarySize{0};
+    };
+
+    mutable std::mutex _mutex{};
+    std::unordered_map<std::string, std::weak_ptr<Program>> _programs{}; //!< Programs in use, indexed by their sources
+    Stats _stats{};
+
+    bool _binaryCacheChecked{false};
+    std::string _binaryCachePath{}; //!< Empty if the driver does not support program binaries
+    std::string _driverSignature{};
+
+    /**
+     * \brief Check whether program binaries can be cached, and where
+     */
+    void initBinaryCache();
+
+    /**
+     * \brief Get the path of the binary cache file for the given program
+     * \param key Program key
+     * \return Return the file path
+     */
+    std::string getCacheFilePath(const std::string& key) const;
+
+    /**
+     * \brief Compile and link a program
+     * \param program Program to build, already created
+     * \param sources Preprocessed sources, indexed by GL shader type
+     * \param feedbackVaryings Varyings captured by transform feedback
+     * \param name Program name, used for logging
+     * \return Return true if the program was linked
+     */
+    bool compileProgram(Program& program, const std::map<GLenum, std::string>& sources, const std::vector<std::string>& feedbackVaryings, const std::string& name);
+
+    /**
+     * \brief Load a program from the binary cache
+     * \param program Program to load, already created
+     * \param key Program key
+     * \return Return true if the program was found and accepted by the driver
+     */
+    bool loadBinary(Program& program, const std::string& key);
+
+    /**
+     * \brief Save a linked program to the binary cache
+     * \param program Program to save
+     * \param key Program key
+     * \return Return true if the program was saved
+     */
+    bool saveBinary(const Program& program, const std::string& key);
+};
+
+} // namespace Splash
+
+#endif // SPLASH_PROGRAM_CACHE_H
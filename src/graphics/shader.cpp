@@ -1,9 +1,11 @@
 #include "./graphics/shader.h"
 
+#include "./graphics/program_cache.h"
 #include "./graphics/shaderSources.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
+#include <algorithm>
 #include <fstream>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -24,10 +26,6 @@ Shader::Shader(ProgramType type)
     if (type == prgGraphic)
     {
         _programType = prgGraphic;
-        _shaders[vertex] = glCreateShader(GL_VERTEX_SHADER);
-        _shaders[geometry] = glCreateShader(GL_GEOMETRY_SHADER);
-        _shaders[fragment] = glCreateShader(GL_FRAGMENT_SHADER);
-
         registerGraphicAttributes();
 
         setAttribute("fill", {"texture"});
@@ -35,8 +33,6 @@ Shader::Shader(ProgramType type)
     else if (type == prgCompute)
     {
         _programType = prgCompute;
-        _shaders[compute] = glCreateShader(GL_COMPUTE_SHADER);
-
         registerComputeAttributes();
 
         setAttribute("computePhase", {"resetVisibility"});
@@ -44,11 +40,6 @@ Shader::Shader(ProgramType type)
     else if (type == prgFeedback)
     {
         _programType = prgFeedback;
-        _shaders[vertex] = glCreateShader(GL_VERTEX_SHADER);
-        _shaders[tess_ctrl] = glCreateShader(GL_TESS_CONTROL_SHADER);
-        _shaders[tess_eval] = glCreateShader(GL_TESS_EVALUATION_SHADER);
-        _shaders[geometry] = glCreateShader(GL_GEOMETRY_SHADER);
-
         registerFeedbackAttributes();
 
         setAttribute("feedbackPhase", {"tessellateFromCamera"});
@@ -60,11 +51,9 @@ Shader::Shader(ProgramType type)
 /*************/
 Shader::~Shader()
 {
-    if (glIsProgram(_program))
-        glDeleteProgram(_program);
-    for (auto& shader : _shaders)
-        if (glIsShader(shader.second))
-            glDeleteShader(shader.second);
+    // The program itself is deleted by the cache once no shader uses it anymore
+    if (_program && _program->lastUser == this)
+        _program->lastUser = nullptr;
 
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Shader::~Shader - Destructor" << Log::endl;
@@ -84,14 +73,7 @@ void Shader::activate()
         }
 
         _activated = true;
-
-        for (auto& u : _uniforms)
-        {
-            if (u.second.type == "buffer")
-                glUniformBlockBinding(_program, u.second.glIndex, 1);
-        }
-
-        glUseProgram(_program);
+        useProgram();
 
         if (_sideness == singleSided)
         {
@@ -114,7 +96,7 @@ void Shader::activate()
         }
 
         _activated = true;
-        glUseProgram(_program);
+        useProgram();
         updateUniforms();
         glEnable(GL_RASTERIZER_DISCARD);
         glBeginTransformFeedback(GL_TRIANGLES);
@@ -161,7 +143,7 @@ void Shader::doCompute(GLuint numGroupsX, GLuint numGroupsY)
     }
 
     _activated = true;
-    glUseProgram(_program);
+    useProgram();
     updateUniforms();
     glDispatchCompute(numGroupsX, numGroupsY, 1);
     _activated = false;
@@ -172,59 +154,50 @@ map<string, Values> Shader::getUniforms() const
 {
     map<string, Values> uniforms;
     for (auto& u : _uniforms)
-        uniforms[u.first] = u.second.values;
+    {
+        // Uniforms only resolved through a handle and not declared in the sources are skipped
+        if (u.second.type.empty() && u.second.values.empty() && !u.second.typed)
+            continue;
+
+        if (!u.second.typed)
+        {
+            uniforms[u.first] = u.second.values;
+            continue;
+        }
+
+        Values values;
+        for (uint32_t i = 0; i < u.second.typedSize; ++i)
+        {
+            if (u.second.typedIsInt)
+                values.push_back(u.second.typedInts[i]);
+            else
+                values.push_back(u.second.typedFloats[i]);
+        }
+        uniforms[u.first] = values;
+    }
     return uniforms;
 }
 
 /*************/
 bool Shader::setSource(const std::string& src, const ShaderType type)
 {
-    GLuint shader = _shaders[type];
-
     auto parsedSources = src;
     parseIncludes(parsedSources);
-    const char* shaderSrc = parsedSources.c_str();
-    glShaderSource(shader, 1, (const GLchar**)&shaderSrc, 0);
-    glCompileShader(shader);
-
-    GLint status;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
-    if (status)
-    {
-#ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader of type " << stringFromShaderType(type) << " compiled successfully" << Log::endl;
-#endif
-    }
-    else
-    {
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error while compiling a shader of type " << stringFromShaderType(type) << Log::endl;
-        GLint length;
-        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
-        char* log = (char*)malloc(length);
-        glGetShaderInfoLog(shader, length, &length, log);
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error log: \n" << (const char*)log << Log::endl;
-        free(log);
-    }
 
     _shadersSource[type] = parsedSources;
-    _isLinked = false;
-    return status;
+    resetProgram();
+    return true;
 }
 
 /*************/
 bool Shader::setSource(const map<ShaderType, string>& sources)
 {
-    resetShader(vertex);
-    resetShader(geometry);
-    resetShader(fragment);
     _shadersSource.clear();
-
-    bool status = true;
     for (auto& source : sources)
-        status = status && setSource(source.second, source.first);
+        setSource(source.second, source.first);
 
-    compileProgram();
-    return status;
+    // The program is built right away to report errors to the caller
+    return linkProgram();
 }
 
 /*************/
@@ -269,7 +242,8 @@ void Shader::setTexture(const shared_ptr<Texture>& texture, const GLuint texture
             if (uniformIt->second.glIndex != -1)
             {
                 uniformIt->second.values = {(int)_textures.size()};
-                _uniformsToUpdate.push_back("_textureNbr");
+                uniformIt->second.typed = false;
+                _uniformsToUpdate.push_back(&uniformIt->second);
             }
     }
 }
@@ -277,85 +251,194 @@ void Shader::setTexture(const shared_ptr<Texture>& texture, const GLuint texture
 /*************/
 void Shader::setModelViewProjectionMatrix(const glm::dmat4& mv, const glm::dmat4& mp)
 {
+    if (!_modelViewProjectionMatrixUniform)
+    {
+        _modelViewProjectionMatrixUniform = getUniformHandle("_modelViewProjectionMatrix");
+        _modelViewMatrixUniform = getUniformHandle("_modelViewMatrix");
+        _projectionMatrixUniform = getUniformHandle("_projectionMatrix");
+        _normalMatrixUniform = getUniformHandle("_normalMatrix");
+    }
+
     glm::mat4 floatMv = (glm::mat4)mv;
-    glm::mat4 floatMp = (glm::mat4)mp;
-    glm::mat4 floatMvp = (glm::mat4)(mp * mv);
+    setUniform(_modelViewProjectionMatrixUniform, (glm::mat4)(mp * mv));
+    setUniform(_modelViewMatrixUniform, floatMv);
+    setUniform(_projectionMatrixUniform, (glm::mat4)mp);
+    if (_normalMatrixUniform._uniform->glIndex != -1)
+        setUniform(_normalMatrixUniform, glm::transpose(glm::inverse(floatMv)));
+}
 
-    auto uniformIt = _uniforms.find("_modelViewProjectionMatrix");
-    if (uniformIt != _uniforms.end())
-        if (uniformIt->second.glIndex != -1)
-            glUniformMatrix4fv(uniformIt->second.glIndex, 1, GL_FALSE, glm::value_ptr(floatMvp));
+/*************/
+Shader::UniformHandle Shader::getUniformHandle(const string& name)
+{
+    UniformHandle handle;
+    handle._uniform = &_uniforms[name];
+    return handle;
+}
+
+/*************/
+void Shader::setTypedUniform(UniformHandle handle, const float* values, uint32_t size)
+{
+    auto uniform = handle._uniform;
+    if (!uniform)
+        return;
 
-    if ((uniformIt = _uniforms.find("_modelViewMatrix")) != _uniforms.end())
-        if (uniformIt->second.glIndex != -1)
-            glUniformMatrix4fv(uniformIt->second.glIndex, 1, GL_FALSE, glm::value_ptr(floatMv));
+    // Check if the value changed from previous use
+    if (uniform->typed && !uniform->typedIsInt && uniform->typedSize == size && equal(values, values + size, uniform->typedFloats.begin()))
+        return;
 
-    if ((uniformIt = _uniforms.find("_projectionMatrix")) != _uniforms.end())
-        if (uniformIt->second.glIndex != -1)
-            glUniformMatrix4fv(uniformIt->second.glIndex, 1, GL_FALSE, glm::value_ptr(floatMp));
+    copy(values, values + size, uniform->typedFloats.begin());
+    uniform->typed = true;
+    uniform->typedIsInt = false;
+    uniform->typedSize = size;
 
-    if ((uniformIt = _uniforms.find("_normalMatrix")) != _uniforms.end())
-        if (uniformIt->second.glIndex != -1)
-            glUniformMatrix4fv(uniformIt->second.glIndex, 1, GL_FALSE, glm::value_ptr(glm::transpose(glm::inverse(floatMv))));
+    // Uniforms missing from a linked program are sent again if it is relinked
+    if (!_isLinked || uniform->glIndex != -1)
+        _uniformsToUpdate.push_back(uniform);
 }
 
 /*************/
-void Shader::compileProgram()
+void Shader::setTypedUniform(UniformHandle handle, const GLint* values, uint32_t size)
 {
-    GLint status;
-    if (glIsProgram(_program) == GL_TRUE)
-        glDeleteProgram(_program);
+    auto uniform = handle._uniform;
+    if (!uniform)
+        return;
 
-    _program = glCreateProgram();
-    for (auto& shader : _shaders)
+    // Check if the value changed from previous use
+    if (uniform->typed && uniform->typedIsInt && uniform->typedSize == size && equal(values, values + size, uniform->typedInts.begin()))
+        return;
+
+    copy(values, values + size, uniform->typedInts.begin());
+    uniform->typed = true;
+    uniform->typedIsInt = true;
+    uniform->typedSize = size;
+
+    // Uniforms missing from a linked program are sent again if it is relinked
+    if (!_isLinked || uniform->glIndex != -1)
+        _uniformsToUpdate.push_back(uniform);
+}
+
+/*************/
+void Shader::sendTypedUniform(const Uniform& uniform)
+{
+    if (uniform.typedIsInt)
     {
-        if (glIsShader(shader.second))
+        switch (uniform.typedSize)
         {
-            glGetShaderiv(shader.second, GL_COMPILE_STATUS, &status);
-            if (status == GL_TRUE)
-            {
-                glAttachShader(_program, shader.second);
-#ifdef DEBUG
-                Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader of type " << stringFromShaderType(shader.first) << " successfully attached to the program"
-                           << Log::endl;
-#endif
-            }
+        case 1:
+            glUniform1iv(uniform.glIndex, 1, uniform.typedInts.data());
+            break;
+        case 2:
+            glUniform2iv(uniform.glIndex, 1, uniform.typedInts.data());
+            break;
+        case 3:
+            glUniform3iv(uniform.glIndex, 1, uniform.typedInts.data());
+            break;
+        case 4:
+            glUniform4iv(uniform.glIndex, 1, uniform.typedInts.data());
+            break;
+        }
+    }
+    else
+    {
+        switch (uniform.typedSize)
+        {
+        case 1:
+            glUniform1fv(uniform.glIndex, 1, uniform.typedFloats.data());
+            break;
+        case 2:
+            glUniform2fv(uniform.glIndex, 1, uniform.typedFloats.data());
+            break;
+        case 3:
+            glUniform3fv(uniform.glIndex, 1, uniform.typedFloats.data());
+            break;
+        case 4:
+            glUniform4fv(uniform.glIndex, 1, uniform.typedFloats.data());
+            break;
+        case 9:
+            glUniformMatrix3fv(uniform.glIndex, 1, GL_FALSE, uniform.typedFloats.data());
+            break;
+        case 16:
+            glUniformMatrix4fv(uniform.glIndex, 1, GL_FALSE, uniform.typedFloats.data());
+            break;
         }
     }
 }
 
+/*************/
+void Shader::resetProgram()
+{
+    if (_program && _program->lastUser == this)
+        _program->lastUser = nullptr;
+    _program.reset();
+    _isLinked = false;
+}
+
 /*************/
 bool Shader::linkProgram()
 {
-    GLint status;
-    glLinkProgram(_program);
-    glGetProgramiv(_program, GL_LINK_STATUS, &status);
-    if (status == GL_TRUE)
+    if (!_program)
     {
-#ifdef DEBUG
-        Log::get() << Log::DEBUGGING << "Shader::" << __FUNCTION__ << " - Shader program " << _currentProgramName << " linked successfully" << Log::endl;
-#endif
-
-        for (auto src : _shadersSource)
-            parseUniforms(src.second);
+        map<GLenum, string> sources;
+        for (const auto& source : _shadersSource)
+        {
+            switch (source.first)
+            {
+            default:
+                continue;
+            case vertex:
+                sources[GL_VERTEX_SHADER] = source.second;
+                break;
+            case tess_ctrl:
+                sources[GL_TESS_CONTROL_SHADER] = source.second;
+                break;
+            case tess_eval:
+                sources[GL_TESS_EVALUATION_SHADER] = source.second;
+                break;
+            case geometry:
+                sources[GL_GEOMETRY_SHADER] = source.second;
+                break;
+            case fragment:
+                sources[GL_FRAGMENT_SHADER] = source.second;
+                break;
+            case compute:
+                sources[GL_COMPUTE_SHADER] = source.second;
+                break;
+            }
+        }
 
-        _isLinked = true;
-        return true;
+        _program = ProgramCache::get().getProgram(sources, _feedbackVaryings, _currentProgramName);
     }
-    else
-    {
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error while linking the shader program " << _currentProgramName << Log::endl;
-
-        GLint length;
-        glGetProgramiv(_program, GL_INFO_LOG_LENGTH, &length);
-        char* log = (char*)malloc(length);
-        glGetProgramInfoLog(_program, length, &length, log);
-        Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error log: \n" << (const char*)log << Log::endl;
-        free(log);
 
+    if (!_program->linked)
+    {
         _isLinked = false;
         return false;
     }
+
+    for (auto src : _shadersSource)
+        parseUniforms(src.second);
+
+    for (auto& u : _uniforms)
+        if (u.second.type == "buffer" && u.second.glIndex != -1)
+            glUniformBlockBinding(_program->id, u.second.glIndex, u.second.glBinding);
+
+    _isLinked = true;
+    return true;
+}
+
+/*************/
+void Shader::useProgram()
+{
+    glUseProgram(_program->id);
+
+    // Uniform values are stored in the program, so they are all sent again if another shader used it since
+    if (_program->lastUser != this)
+    {
+        for (auto& u : _uniforms)
+            if (u.second.glIndex != -1 && (u.second.typed || !u.second.values.empty()))
+                _uniformsToUpdate.push_back(&u.second);
+        _program->lastUser = this;
+    }
 }
 
 /*************/
@@ -414,9 +497,19 @@ void Shader::parseUniforms(const std::string& src)
             string name = next.substr(0, next.find(" "));
 
             _uniforms[name].type = "buffer";
-            _uniforms[name].glIndex = glGetUniformBlockIndex(_program, name.c_str());
-            glGenBuffers(1, &_uniforms[name].glBuffer);
-            _uniforms[name].glBufferReady = false;
+            _uniforms[name].glIndex = glGetUniformBlockIndex(_program->id, name.c_str());
+
+            // The camera block is filled by the camera rendering the object, others through the uniform attribute
+            if (name == SPLASH_SHADER_CAMERA_BLOCK)
+            {
+                _uniforms[name].glBinding = SPLASH_SHADER_CAMERA_BINDING;
+            }
+            else
+            {
+                glGenBuffers(1, &_uniforms[name].glBuffer);
+                _uniforms[name].glBinding = SPLASH_SHADER_BUFFER_BINDING;
+                _uniforms[name].glBufferReady = false;
+            }
         }
         else
         {
@@ -446,7 +539,7 @@ void Shader::parseUniforms(const std::string& src)
             _uniforms[name].type = type;
 
             // Get the location
-            _uniforms[name].glIndex = glGetUniformLocation(_program, name.c_str());
+            _uniforms[name].glIndex = glGetUniformLocation(_program->id, name.c_str());
 
             if (type == "int")
                 _uniforms[name].values = {0};
@@ -476,62 +569,70 @@ void Shader::parseUniforms(const std::string& src)
                 Log::get() << Log::WARNING << "Shader::" << __FUNCTION__ << " - Error while parsing uniforms: " << name << " is of unhandled type " << type << Log::endl;
             }
 
-            if (values.size() != 0)
+            if (_uniforms[name].typed)
+            {
+                _uniformsToUpdate.push_back(&_uniforms[name]);
+            }
+            else if (values.size() != 0)
             {
                 _uniforms[name].values = values;
-                _uniformsToUpdate.push_back(name);
+                _uniformsToUpdate.push_back(&_uniforms[name]);
             }
             else
             {
-                // Save the default value
-                if (type == "int")
+                // Save the default value. It is only read from the program by its first user, as the others may have changed it since
+                auto defaultIt = _program->uniformDefaults.find(name);
+                if (defaultIt != _program->uniformDefaults.end())
+                    _uniforms[name].values = defaultIt->second;
+                else if (type == "int")
                 {
                     int v;
-                    glGetUniformiv(_program, _uniforms[name].glIndex, &v);
+                    glGetUniformiv(_program->id, _uniforms[name].glIndex, &v);
                     _uniforms[name].values = {v};
                 }
                 else if (type == "float")
                 {
                     float v;
-                    glGetUniformfv(_program, _uniforms[name].glIndex, &v);
+                    glGetUniformfv(_program->id, _uniforms[name].glIndex, &v);
                     _uniforms[name].values = {v};
                 }
                 else if (type == "vec2")
                 {
                     float v[2];
-                    glGetUniformfv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformfv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1]};
                 }
                 else if (type == "vec3")
                 {
                     float v[3];
-                    glGetUniformfv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformfv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1], v[2]};
                 }
                 else if (type == "vec4")
                 {
                     float v[4];
-                    glGetUniformfv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformfv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1], v[2], v[3]};
                 }
                 else if (type == "ivec2")
                 {
                     int v[2];
-                    glGetUniformiv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformiv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1]};
                 }
                 else if (type == "ivec3")
                 {
                     int v[3];
-                    glGetUniformiv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformiv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1], v[2]};
                 }
                 else if (type == "ivec4")
                 {
                     int v[4];
-                    glGetUniformiv(_program, _uniforms[name].glIndex, v);
+                    glGetUniformiv(_program->id, _uniforms[name].glIndex, v);
                     _uniforms[name].values = {v[0], v[1], v[2], v[3]};
                 }
+                _program->uniformDefaults[name] = _uniforms[name].values;
             }
         }
     }
@@ -542,58 +643,35 @@ void Shader::parseUniforms(const std::string& src)
         string name = u.first;
         if (u.second.type != "buffer")
         {
-            if (glGetUniformLocation(_program, name.c_str()) == -1)
+            if (glGetUniformLocation(_program->id, name.c_str()) == -1)
                 u.second.glIndex = -1;
         }
         else
         {
-            if (glGetUniformBlockIndex(_program, name.c_str()) == GL_INVALID_INDEX)
+            if (glGetUniformBlockIndex(_program->id, name.c_str()) == GL_INVALID_INDEX)
                 u.second.glIndex = -1;
         }
     }
 }
 
-/*************/
-string Shader::stringFromShaderType(int type)
-{
-    switch (type)
-    {
-    default:
-        return string();
-    case vertex:
-        return "vertex";
-    case tess_ctrl:
-        return "tess_ctrl";
-    case tess_eval:
-        return "tess_eval";
-    case geometry:
-        return "geometry";
-    case fragment:
-        return "fragment";
-    case compute:
-        return "compute";
-    }
-}
-
 /*************/
 void Shader::updateUniforms()
 {
     if (_activated)
     {
-        for (uint32_t i = 0; i < _uniformsToUpdate.size(); ++i)
+        for (auto uniformPtr : _uniformsToUpdate)
         {
-            string u = _uniformsToUpdate[i];
-
-            auto uniformIt = _uniforms.find(u);
-            if (uniformIt == _uniforms.end())
+            auto& uniform = *uniformPtr;
+            if (uniform.glIndex == -1)
+            {
+                if (!uniform.typed)
+                    uniform.values.clear(); // To make sure it is sent next time if the index is correctly set
                 continue;
+            }
 
-            auto tmpName = uniformIt->first;
-
-            auto& uniform = uniformIt->second;
-            if (uniform.glIndex == -1)
+            if (uniform.typed)
             {
-                uniform.values.clear(); // To make sure it is sent next time if the index is correctly set
+                sendTypedUniform(uniform);
                 continue;
             }
 
@@ -655,7 +733,7 @@ void Shader::updateUniforms()
                         }
                         glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size() * sizeof(int), data.data());
                         glBindBuffer(GL_UNIFORM_BUFFER, 0);
-                        glBindBufferRange(GL_UNIFORM_BUFFER, 1, uniform.glBuffer, 0, data.size() * sizeof(int));
+                        glBindBufferRange(GL_UNIFORM_BUFFER, uniform.glBinding, uniform.glBuffer, 0, data.size() * sizeof(int));
                     }
                     else
                     {
@@ -688,7 +766,7 @@ void Shader::updateUniforms()
                         }
                         glBufferSubData(GL_UNIFORM_BUFFER, 0, data.size() * sizeof(float), data.data());
                         glBindBuffer(GL_UNIFORM_BUFFER, 0);
-                        glBindBufferRange(GL_UNIFORM_BUFFER, 1, uniform.glBuffer, 0, data.size() * sizeof(float));
+                        glBindBufferRange(GL_UNIFORM_BUFFER, uniform.glBinding, uniform.glBuffer, 0, data.size() * sizeof(float));
                     }
                     else
                     {
@@ -715,16 +793,8 @@ void Shader::updateUniforms()
 /*************/
 void Shader::resetShader(ShaderType type)
 {
-    glDeleteShader(_shaders[type]);
-
-    if (type == vertex)
-        _shaders[type] = glCreateShader(GL_VERTEX_SHADER);
-    else if (type == geometry)
-        _shaders[type] = glCreateShader(GL_GEOMETRY_SHADER);
-    else if (type == fragment)
-        _shaders[type] = glCreateShader(GL_FRAGMENT_SHADER);
-    else
-        return;
+    _shadersSource.erase(type);
+    resetProgram();
 }
 
 /*************/
@@ -748,13 +818,14 @@ void Shader::registerAttributes()
 
         // Check if the values changed from previous use
         auto uniformIt = _uniforms.find(uniformName);
-        if (uniformIt != _uniforms.end() && Value(uniformArgs) == Value(uniformIt->second.values))
+        if (uniformIt != _uniforms.end() && !uniformIt->second.typed && Value(uniformArgs) == Value(uniformIt->second.values))
             return true;
         else if (uniformIt == _uniforms.end())
             uniformIt = (_uniforms.emplace(make_pair(uniformName, Uniform()))).first;
 
         uniformIt->second.values = uniformArgs;
-        _uniformsToUpdate.push_back(uniformName);
+        uniformIt->second.typed = false;
+        _uniformsToUpdate.push_back(&uniformIt->second);
 
         return true;
     });
@@ -778,7 +849,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_TEXTURE, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_TEXTURE, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "object_cubemap" && (_fill != object_cubemap || _shaderOptions != options))
             {
@@ -788,7 +858,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_OBJECT_CUBEMAP, vertex);
                 setSource(options + ShaderSources.GEOMETRY_SHADER_OBJECT_CUBEMAP, geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_OBJECT_CUBEMAP, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "cubemap_projection" && (_fill != cubemap_projection || _shaderOptions != options))
             {
@@ -798,7 +867,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_CUBEMAP_PROJECTION, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_CUBEMAP_PROJECTION, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "filter" && (_fill != filter || _shaderOptions != options))
             {
@@ -808,7 +876,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_FILTER, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_FILTER, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "color" && (_fill != color || _shaderOptions != options))
             {
@@ -818,7 +885,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_DEFAULT, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_COLOR, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "primitiveId" && (_fill != primitiveId || _shaderOptions != options))
             {
@@ -828,7 +894,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_DEFAULT, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_PRIMITIVEID, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "userDefined" && (_fill != userDefined || _shaderOptions != options))
             {
@@ -839,7 +904,6 @@ void Shader::registerGraphicAttributes()
                     setSource(options + ShaderSources.VERTEX_SHADER_FILTER, vertex);
                 if (_shadersSource.find(ShaderType::fragment) == _shadersSource.end())
                     setSource(options + ShaderSources.FRAGMENT_SHADER_FILTER, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "uv" && (_fill != uv || _shaderOptions != options))
             {
@@ -849,7 +913,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_DEFAULT, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_UV, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "warp" && (_fill != warp || _shaderOptions != options))
             {
@@ -859,7 +922,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_WARP, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_WARP, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "warpControl" && (_fill != warpControl || _shaderOptions != options))
             {
@@ -869,7 +931,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_WARP_WIREFRAME, vertex);
                 setSource(options + ShaderSources.GEOMETRY_SHADER_WARP_WIREFRAME, geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_WARP_WIREFRAME, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "wireframe" && (_fill != wireframe || _shaderOptions != options))
             {
@@ -879,7 +940,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_WIREFRAME, vertex);
                 setSource(options + ShaderSources.GEOMETRY_SHADER_WIREFRAME, geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_WIREFRAME, fragment);
-                compileProgram();
             }
             else if (args[0].as<string>() == "window" && (_fill != window || _shaderOptions != options))
             {
@@ -889,7 +949,6 @@ void Shader::registerGraphicAttributes()
                 setSource(options + ShaderSources.VERTEX_SHADER_WINDOW, vertex);
                 resetShader(geometry);
                 setSource(options + ShaderSources.FRAGMENT_SHADER_WINDOW, fragment);
-                compileProgram();
             }
             return true;
         },
@@ -938,25 +997,36 @@ void Shader::registerComputeAttributes()
         {
             _currentProgramName = args[0].as<string>();
             setSource(options + ShaderSources.COMPUTE_SHADER_RESET_VISIBILITY, compute);
-            compileProgram();
         }
         else if ("resetBlending" == args[0].as<string>())
         {
             _currentProgramName = args[0].as<string>();
             setSource(options + ShaderSources.COMPUTE_SHADER_RESET_BLENDING, compute);
-            compileProgram();
         }
         else if ("computeCameraContribution" == args[0].as<string>())
         {
             _currentProgramName = args[0].as<string>();
             setSource(options + ShaderSources.COMPUTE_SHADER_COMPUTE_CAMERA_CONTRIBUTION, compute);
-            compileProgram();
         }
         else if ("transferVisibilityToAttr" == args[0].as<string>())
         {
             _currentProgramName = args[0].as<string>();
             setSource(options + ShaderSources.COMPUTE_SHADER_TRANSFER_VISIBILITY_TO_ATTR, compute);
-            compileProgram();
+        }
+        else if ("expandIndices" == args[0].as<string>())
+        {
+            _currentProgramName = args[0].as<string>();
+            setSource(options + ShaderSources.COMPUTE_SHADER_EXPAND_INDICES, compute);
+        }
+        else if ("convertToYUV" == args[0].as<string>())
+        {
+            _currentProgramName = args[0].as<string>();
+            setSource(options + ShaderSources.COMPUTE_SHADER_CONVERT_TO_YUV, compute);
+        }
+        else if ("computeStatistics" == args[0].as<string>())
+        {
+            _currentProgramName = args[0].as<string>();
+            setSource(options + ShaderSources.COMPUTE_SHADER_COMPUTE_STATISTICS, compute);
         }
 
         return true;
@@ -984,7 +1054,6 @@ void Shader::registerFeedbackAttributes()
             setSource(options + ShaderSources.TESS_CTRL_SHADER_FEEDBACK_TESSELLATE_FROM_CAMERA, tess_ctrl);
             setSource(options + ShaderSources.TESS_EVAL_SHADER_FEEDBACK_TESSELLATE_FROM_CAMERA, tess_eval);
             setSource(options + ShaderSources.GEOMETRY_SHADER_FEEDBACK_TESSELLATE_FROM_CAMERA, geometry);
-            compileProgram();
         }
 
         return true;
@@ -994,19 +1063,11 @@ void Shader::registerFeedbackAttributes()
         if (args.size() < 1)
             return false;
 
-        GLchar* feedbackVaryings[args.size()];
-        vector<string> varyingNames;
-        for (uint32_t i = 0; i < args.size(); ++i)
-        {
-            varyingNames.push_back(args[i].as<string>());
-            feedbackVaryings[i] = new GLchar[256];
-            strcpy(feedbackVaryings[i], varyingNames[i].c_str());
-        }
-
-        glTransformFeedbackVaryings(_program, args.size(), const_cast<const GLchar**>(feedbackVaryings), GL_SEPARATE_ATTRIBS);
-
-        for (uint32_t i = 0; i < args.size(); ++i)
-            delete feedbackVaryings[i];
+        // Varyings have to be set before linking, so the program is fetched again with them
+        _feedbackVaryings.clear();
+        for (const auto& arg : args)
+            _feedbackVaryings.push_back(arg.as<string>());
+        resetProgram();
 
         return true;
     });
@@ -25,6 +25,7 @@
 #ifndef SPLASH_SHADER_H
 #define SPLASH_SHADER_H
 
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
@@ -37,14 +38,37 @@
 #include "./core/attribute.h"
 #include "./core/coretypes.h"
 #include "./core/graph_object.h"
+#include "./graphics/program_cache.h"
 #include "./graphics/texture.h"
 
+#define SPLASH_SHADER_BUFFER_BINDING 1              // Binding point of the uniform blocks set through the uniform attribute
+#define SPLASH_SHADER_CAMERA_BINDING 2              // Binding point of the uniform block shared by all the objects rendered by a camera
+#define SPLASH_SHADER_CAMERA_BLOCK "_cameraUniforms" // Name of the uniform block shared by all the objects rendered by a camera
+
 namespace Splash
 {
 
 class Shader : public GraphObject
 {
+  private:
+    struct Uniform;
+
   public:
+    /**
+     * Handle to a uniform, resolved once from its name and used to set it without any lookup.
+     * It stays valid for the lifetime of the shader, even if its program is recompiled.
+     */
+    class UniformHandle
+    {
+        friend class Shader;
+
+      public:
+        explicit operator bool() const { return _uniform != nullptr; }
+
+      private:
+        Uniform* _uniform{nullptr};
+    };
+
     enum ProgramType
     {
         prgGraphic = 0,
@@ -145,17 +169,17 @@ class Shader : public GraphObject
     std::unordered_map<std::string, std::string> getUniformsDocumentation() const { return _uniformsDocumentation; }
 
     /**
-     * \brief Set a shader source
+     * \brief Set a shader source. It is compiled when the shader is next activated, unless the program is already cached
      * \param src Shader string
      * \param type Shader type
-     * \return Return true if the shader was compiled successfully
+     * \return Return true
      */
     bool setSource(const std::string& src, const ShaderType type);
 
     /**
-     * \brief Set multiple shaders at once
+     * \brief Set multiple shaders at once, and build the program right away
      * \param sources Map of shader sources
-     * \return Return true if all shader could be compiled
+     * \return Return true if the program could be compiled and linked
      */
     bool setSource(const std::map<ShaderType, std::string>& sources);
 
@@ -182,6 +206,28 @@ class Shader : public GraphObject
      */
     void setModelViewProjectionMatrix(const glm::dmat4& mv, const glm::dmat4& mp);
 
+    /**
+     * \brief Get a handle to the given uniform, to set it from typed values instead of through the uniform attribute
+     * \param name Uniform name
+     * \return Return the uniform handle
+     */
+    UniformHandle getUniformHandle(const std::string& name);
+
+    /**
+     * \brief Set a uniform from its handle. The value is queued and sent with the next uniforms update, only if it changed
+     * \param handle Uniform handle
+     * \param value Uniform value, which has to match the type declared in the shader
+     */
+    void setUniform(UniformHandle handle, int value) { setTypedUniform(handle, &value, 1); }
+    void setUniform(UniformHandle handle, float value) { setTypedUniform(handle, &value, 1); }
+    void setUniform(UniformHandle handle, const glm::ivec2& value) { setTypedUniform(handle, &value[0], 2); }
+    void setUniform(UniformHandle handle, const glm::ivec4& value) { setTypedUniform(handle, &value[0], 4); }
+    void setUniform(UniformHandle handle, const glm::vec2& value) { setTypedUniform(handle, &value[0], 2); }
+    void setUniform(UniformHandle handle, const glm::vec3& value) { setTypedUniform(handle, &value[0], 3); }
+    void setUniform(UniformHandle handle, const glm::vec4& value) { setTypedUniform(handle, &value[0], 4); }
+    void setUniform(UniformHandle handle, const glm::mat3& value) { setTypedUniform(handle, &value[0][0], 9); }
+    void setUniform(UniformHandle handle, const glm::mat4& value) { setTypedUniform(handle, &value[0][0], 16); }
+
     /**
      * \brief Set the currently queued uniforms updates
      */
@@ -192,9 +238,9 @@ class Shader : public GraphObject
     std::atomic_bool _activated{false};
     ProgramType _programType{prgGraphic};
 
-    std::unordered_map<int, GLuint> _shaders;
     std::unordered_map<int, std::string> _shadersSource;
-    GLuint _program{0};
+    std::vector<std::string> _feedbackVaryings{};
+    std::shared_ptr<ProgramCache::Program> _program{nullptr}; //!< Program shared with the other shaders built from the same sources
     bool _isLinked = {false};
 
     struct Uniform
@@ -203,11 +249,19 @@ class Shader : public GraphObject
         Values values{};
         GLint glIndex{-1};
         GLuint glBuffer{0};
+        GLuint glBinding{SPLASH_SHADER_BUFFER_BINDING};
         bool glBufferReady{false};
+
+        // Value set through a handle, used instead of values until the uniform attribute is set again
+        bool typed{false};
+        bool typedIsInt{false};
+        uint32_t typedSize{0};
+        std::array<float, 16> typedFloats{};
+        std::array<GLint, 4> typedInts{};
     };
-    std::map<std::string, Uniform> _uniforms;
+    std::map<std::string, Uniform> _uniforms; // Elements are never erased, which keeps the handles valid
     std::unordered_map<std::string, std::string> _uniformsDocumentation;
-    std::vector<std::string> _uniformsToUpdate;
+    std::vector<Uniform*> _uniformsToUpdate;
     std::vector<std::shared_ptr<Texture>> _textures; // Currently used textures
     std::string _currentProgramName{};
 
@@ -217,16 +271,28 @@ class Shader : public GraphObject
     Sideness _sideness{doubleSided};
     std::vector<int> _layout{0, 0, 0, 0};
 
+    // Handles for the matrices set by setModelViewProjectionMatrix
+    UniformHandle _modelViewProjectionMatrixUniform{};
+    UniformHandle _modelViewMatrixUniform{};
+    UniformHandle _projectionMatrixUniform{};
+    UniformHandle _normalMatrixUniform{};
+
     /**
-     * \brief Compile the shader program
+     * \brief Release the current program, after the sources changed
      */
-    void compileProgram();
+    void resetProgram();
 
     /**
-     * \brief Link the shader program
+     * \brief Get the program matching the current sources from the program cache if needed, and find its uniforms
+     * \return Return true if the program is linked
      */
     bool linkProgram();
 
+    /**
+     * \brief Use the program, queueing all the uniforms for update if another shader used it since last time
+     */
+    void useProgram();
+
     /**
      * \brief Parses the shader to replace includes by the corresponding sources
      * \param src Shader source
@@ -239,11 +305,19 @@ class Shader : public GraphObject
     void parseUniforms(const std::string& src);
 
     /**
-     * \brief Get a string expression of the shader type, used for logging
-     * \param type Shader type
-     * \return Return the shader type as a string
+     * \brief Store a typed uniform value, and queue it for update if it changed
+     * \param handle Uniform handle
+     * \param values Pointer to the values
+     * \param size Value count
+     */
+    void setTypedUniform(UniformHandle handle, const float* values, uint32_t size);
+    void setTypedUniform(UniformHandle handle, const GLint* values, uint32_t size);
+
+    /**
+     * \brief Send a uniform value set through a handle
+     * \param uniform Uniform to send
      */
-    std::string stringFromShaderType(int type);
+    void sendTypedUniform(const Uniform& uniform);
 
     /**
      * \brief Replace a shader with an empty one
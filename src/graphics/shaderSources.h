@@ -144,6 +144,20 @@ struct ShaderSources
                 yuv = pow(yuv, vec3(2.2));
                 return yuv;
             }
+        )"},
+        //
+        // Uniforms shared by all the objects rendered by a camera, filled once per frame by the camera
+        {"cameraUniforms", R"(
+            layout(std140) uniform _cameraUniforms
+            {
+                vec4 _wireframeColor;
+                vec4 _fovAndColorBalance; // fovX and fovY, r/g and b/g
+                vec2 _cameraAttributes; // blendWidth and brightness
+                int _showCameraCount;
+                int _isColorLUT;
+                mat3 _colorMixMatrix;
+                vec3 _colorLUT[256];
+            };
         )"}};
 
 /**
@@ -241,6 +255,197 @@ struct ShaderSources
         }
     )"};
 
+    /**
+     * Compute shader to expand an indexed vertex attribute into independent triangles
+     */
+    const std::string COMPUTE_SHADER_EXPAND_INDICES{R"(
+        #extension GL_ARB_compute_shader : enable
+        #extension GL_ARB_shader_storage_buffer_object : enable
+
+        layout(local_size_x = 128) in;
+
+        layout (std430, binding = 0) buffer inputBuffer
+        {
+            float inputData[];
+        };
+
+        layout (std430, binding = 1) buffer indexBuffer
+        {
+            uint indices[];
+        };
+
+        layout (std430, binding = 2) buffer outputBuffer
+        {
+            float outputData[];
+        };
+
+        uniform int _indexNbr;
+        uniform int _componentNbr;
+
+        void main(void)
+        {
+            int globalID = int(gl_GlobalInvocationID.x);
+
+            if (globalID < _indexNbr)
+            {
+                int source = int(indices[globalID]) * _componentNbr;
+                int destination = globalID * _componentNbr;
+                for (int idx = 0; idx < _componentNbr; ++idx)
+                    outputData[destination + idx] = inputData[source + idx];
+            }
+        }
+    )"};
+
+    /**
+     * Compute shader to convert an RGBA texture to NV12 or I420 (BT.601, limited range), written to a buffer as packed bytes
+     */
+    const std::string COMPUTE_SHADER_CONVERT_TO_YUV{R"(
+        #extension GL_ARB_compute_shader : enable
+        #extension GL_ARB_shader_storage_buffer_object : enable
+
+        layout(local_size_x = 128) in;
+
+        layout (std430, binding = 0) buffer outputBuffer
+        {
+            uint outputData[];
+        };
+
+        uniform sampler2D _tex0;
+        uniform ivec2 _size;
+        uniform int _interleaved; // 1 for NV12, 0 for I420
+
+        float luma(vec3 rgb)
+        {
+            return 16.0 + dot(rgb, vec3(65.481, 128.553, 24.966));
+        }
+
+        vec2 chroma(vec3 rgb)
+        {
+            return vec2(128.0 + dot(rgb, vec3(-37.797, -74.203, 112.0)), 128.0 + dot(rgb, vec3(112.0, -93.786, -18.214)));
+        }
+
+        uint byteValue(int index)
+        {
+            float value;
+            int lumaSize = _size.x * _size.y;
+            if (index < lumaSize)
+            {
+                value = luma(texelFetch(_tex0, ivec2(index % _size.x, index / _size.x), 0).rgb);
+            }
+            else
+            {
+                // Chroma is averaged over blocks of 2x2 pixels
+                int chromaWidth = _size.x / 2;
+                int chromaIndex = index - lumaSize;
+                int component;
+                if (_interleaved == 1)
+                {
+                    component = chromaIndex % 2;
+                    chromaIndex /= 2;
+                }
+                else
+                {
+                    component = chromaIndex / (lumaSize / 4);
+                    chromaIndex %= lumaSize / 4;
+                }
+
+                ivec2 texel = ivec2(chromaIndex % chromaWidth, chromaIndex / chromaWidth) * 2;
+                vec3 rgb = texelFetch(_tex0, texel, 0).rgb + texelFetch(_tex0, texel + ivec2(1, 0), 0).rgb + texelFetch(_tex0, texel + ivec2(0, 1), 0).rgb +
+                           texelFetch(_tex0, texel + ivec2(1, 1), 0).rgb;
+                value = chroma(rgb * 0.25)[component];
+            }
+
+            return uint(clamp(round(value), 0.0, 255.0));
+        }
+
+        void main(void)
+        {
+            int word = int(gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x);
+            int index = word * 4;
+            if (index >= _size.x * _size.y * 3 / 2)
+                return;
+
+            outputData[word] = byteValue(index) | (byteValue(index + 1) << 8) | (byteValue(index + 2) << 16) | (byteValue(index + 3) << 24);
+        }
+    )"};
+
+    /**
+     * Compute shader to reduce a texture to its mean, minimum and maximum values, and to its luminance histogram
+     */
+    const std::string COMPUTE_SHADER_COMPUTE_STATISTICS{R"(
+        #extension GL_ARB_compute_shader : enable
+        #extension GL_ARB_shader_storage_buffer_object : enable
+
+        layout(local_size_x = 16, local_size_y = 16) in;
+
+        // Values are stored as 8 bits integers. Minimums are stored inverted so that all the fields start at zero
+        layout (std430, binding = 0) buffer statisticsBuffer
+        {
+            uint sums[3];
+            uint pixelCount;
+            uint invertedMins[3];
+            uint maxs[3];
+            uint histogram[256];
+        };
+
+        uniform sampler2D _tex0;
+        uniform int _level;
+
+        shared uint groupSums[3];
+        shared uint groupPixelCount;
+        shared uint groupInvertedMins[3];
+        shared uint groupMaxs[3];
+        shared uint groupHistogram[256];
+
+        void main(void)
+        {
+            // Each group has 256 invocations, one per histogram bin
+            uint localIndex = gl_LocalInvocationIndex;
+            groupHistogram[localIndex] = 0u;
+            if (localIndex < 3u)
+            {
+                groupSums[localIndex] = 0u;
+                groupInvertedMins[localIndex] = 0u;
+                groupMaxs[localIndex] = 0u;
+            }
+            if (localIndex == 0u)
+                groupPixelCount = 0u;
+            memoryBarrierShared();
+            barrier();
+
+            // Values are first reduced within the group, to limit the contention on the buffer
+            ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+            if (all(lessThan(texel, textureSize(_tex0, _level))))
+            {
+                vec3 color = clamp(texelFetch(_tex0, texel, _level).rgb, 0.0, 1.0);
+                uvec3 value = uvec3(round(color * 255.0));
+                for (int c = 0; c < 3; ++c)
+                {
+                    atomicAdd(groupSums[c], value[c]);
+                    atomicMax(groupInvertedMins[c], 255u - value[c]);
+                    atomicMax(groupMaxs[c], value[c]);
+                }
+                atomicAdd(groupPixelCount, 1u);
+
+                float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+                atomicAdd(groupHistogram[uint(round(luminance * 255.0))], 1u);
+            }
+            memoryBarrierShared();
+            barrier();
+
+            if (groupHistogram[localIndex] != 0u)
+                atomicAdd(histogram[localIndex], groupHistogram[localIndex]);
+            if (localIndex < 3u)
+            {
+                atomicAdd(sums[localIndex], groupSums[localIndex]);
+                atomicMax(invertedMins[localIndex], groupInvertedMins[localIndex]);
+                atomicMax(maxs[localIndex], groupMaxs[localIndex]);
+            }
+            if (localIndex == 0u)
+                atomicAdd(pixelCount, groupPixelCount);
+        }
+    )"};
+
     /**
      * Compute shader to reset all camera contribution to zero
      */
@@ -753,6 +958,7 @@ struct ShaderSources
      */
     const std::string VERTEX_SHADER_DEFAULT{R"(
         #include getSmoothBlendFromVertex
+        #include cameraUniforms
 
         layout(location = 0) in vec4 _vertex;
         layout(location = 1) in vec2 _texcoord;
@@ -761,7 +967,6 @@ struct ShaderSources
 
         uniform mat4 _modelViewProjectionMatrix;
         uniform mat4 _normalMatrix;
-        uniform vec2 _cameraAttributes = vec2(0.05, 1.0); // blendWidth and brightness
 
         out VertexData
         {
@@ -1148,6 +1353,7 @@ struct ShaderSources
      */
     const std::string VERTEX_SHADER_TEXTURE{R"(
         #include getSmoothBlendFromVertex
+        #include cameraUniforms
 
         layout(location = 0) in vec4 _vertex;
         layout(location = 1) in vec2 _texcoord;
@@ -1156,7 +1362,6 @@ struct ShaderSources
 
         uniform mat4 _modelViewProjectionMatrix;
         uniform mat4 _normalMatrix;
-        uniform vec2 _cameraAttributes = vec2(0.05, 1.0); // blendWidth and brightness
 
         out VertexData
         {
@@ -1208,17 +1413,11 @@ struct ShaderSources
         uniform vec2 _tex0_size = vec2(1.0);
         uniform vec2 _tex1_size = vec2(1.0);
 
-        uniform int _showCameraCount = 0;
+        #include cameraUniforms
+
         uniform int _sideness = 0;
         uniform int _textureNbr = 0;
-        uniform vec2 _cameraAttributes = vec2(0.05, 1.0); // blendWidth and brightness
-        uniform vec4 _fovAndColorBalance = vec4(0.0, 0.0, 1.0, 1.0); // fovX and fovY, r/g and b/g
-        uniform int _isColorLUT = 0;
         uniform vec4 _color = vec4(0.0, 0.0, 0.0, 1.0);
-        uniform vec3 _colorLUT[256];
-        uniform mat3 _colorMixMatrix = mat3(1.0, 0.0, 0.0,
-                                            0.0, 1.0, 0.0,
-                                            0.0, 0.0, 1.0);
         uniform float _normalExp = 0.0;
 
         in VertexData
@@ -1311,8 +1510,9 @@ struct ShaderSources
     const std::string FRAGMENT_SHADER_COLOR{R"(
         #define PI 3.14159265359
 
+        #include cameraUniforms
+
         uniform int _sideness = 0;
-        uniform vec4 _fovAndColorBalance = vec4(0.0, 0.0, 1.0, 1.0); // fovX and fovY, r/g and b/g
         uniform vec4 _color = vec4(0.0, 1.0, 0.0, 1.0);
 
         in VertexData
@@ -1343,8 +1543,9 @@ struct ShaderSources
     const std::string FRAGMENT_SHADER_UV{R"(
         #define PI 3.14159265359
 
+        #include cameraUniforms
+
         uniform int _sideness = 0;
-        uniform vec4 _fovAndColorBalance = vec4(0.0, 0.0, 1.0, 1.0); // fovX and fovY, r/g and b/g
 
         in VertexData
         {
@@ -1387,8 +1588,7 @@ struct ShaderSources
 
         out vec4 fragColor;
 
-        uniform vec2 _cameraAttributes = vec2(0.05, 1.0); // blendWidth and brightness
-        uniform vec4 _fovAndColorBalance = vec4(0.0, 0.0, 1.0, 1.0); // fovX and fovY, r/g and b/g
+        #include cameraUniforms
 
         void main(void)
         {
@@ -1475,9 +1675,9 @@ struct ShaderSources
             vec4 position;
         } vertexIn;
 
-        uniform vec4 _wireframeColor = vec4(1.0, 0.0, 0.0, 1.0);
+        #include cameraUniforms
+
         uniform int _sideness = 0;
-        uniform vec4 _fovAndColorBalance = vec4(0.0, 0.0, 1.0, 1.0); // fovX and fovY, r/g and b/g
         out vec4 fragColor;
 
         float edgeFactor()
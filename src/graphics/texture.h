@@ -134,6 +134,12 @@ class Texture : public GraphObject
      */
     void registerAttributes();
 
+    /**
+     * \brief Get the version of the content of the texture, which is its timestamp
+     * \return Return the version
+     */
+    uint64_t getContentVersion() const override { return _timestamp; }
+
   private:
     /**
      * \brief As says its name
@@ -2,11 +2,14 @@
 
 #include <string>
 
+#include "./core/thread_pool.h"
 #include "./image/image.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
 
 #define SPLASH_TEXTURE_COPY_THREADS 2
+#define SPLASH_TEXTURE_MAX_PBO_COUNT 8
+#define SPLASH_TEXTURE_PBO_FENCE_TIMEOUT 1e8 // in ns
 
 using namespace std;
 
@@ -37,8 +40,11 @@ Texture_Image::~Texture_Image()
 #ifdef DEBUG
     Log::get() << Log::DEBUGGING << "Texture_Image::~Texture_Image - Destructor" << Log::endl;
 #endif
+    // Copies to the mapped PBO may still be running
+    ThreadPool::get().waitAll(_pboCopyThreads);
+
     glDeleteTextures(1, &_glTex);
-    glDeleteBuffers(2, _pbos);
+    deletePbos();
 }
 
 /*************/
@@ -62,35 +68,6 @@ void Texture_Image::generateMipmap() const
     glGenerateTextureMipmap(_glTex);
 }
 
-/*************/
-RgbValue Texture_Image::getMeanValue() const
-{
-    int level = _texLevels - 1;
-    int width, height;
-    glGetTextureLevelParameteriv(_glTex, level, GL_TEXTURE_WIDTH, &width);
-    glGetTextureLevelParameteriv(_glTex, level, GL_TEXTURE_HEIGHT, &height);
-    auto size = width * height * 4;
-    ResizableArray<uint8_t> buffer(size);
-    glGetTextureImage(_glTex, level, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, buffer.size(), buffer.data());
-
-    RgbValue meanColor;
-    for (int y = 0; y < height; ++y)
-    {
-        RgbValue rowMeanColor;
-        for (int x = 0; x < width; ++x)
-        {
-            auto index = (x + y * width) * 4;
-            RgbValue color(buffer[index], buffer[index + 1], buffer[index + 2]);
-            rowMeanColor += color;
-        }
-        rowMeanColor /= static_cast<float>(width);
-        meanColor += rowMeanColor;
-    }
-    meanColor /= height;
-
-    return meanColor;
-}
-
 /*************/
 bool Texture_Image::linkTo(const std::shared_ptr<GraphObject>& obj)
 {
@@ -414,7 +391,7 @@ void Texture_Image::update()
     }
 
     // Update the textures if the format changed
-    if (spec != _spec || !spec.videoFrame)
+    if (spec != _spec || static_cast<GLint>(internalFormat) != _texInternalFormat)
     {
         // glTexStorage2D is immutable, so we have to delete the texture first
         glDeleteTextures(1, &_glTex);
@@ -459,50 +436,64 @@ void Texture_Image::update()
             glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, img->data());
             img->unlockWrite();
         }
-        updatePbos(spec.width, spec.height, spec.pixelBytes());
 
-        // Fill one of the PBOs right now
-        GLubyte* pixels = (GLubyte*)glMapNamedBufferRange(_pbos[0], 0, imageDataSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
-        if (pixels != NULL)
-        {
-            img->lockWrite();
-            memcpy((void*)pixels, img->data(), imageDataSize);
-            glUnmapNamedBuffer(_pbos[0]);
-            img->unlockWrite();
-        }
-
-        // And copy it to the second PBO
-        glCopyNamedBufferSubData(_pbos[0], _pbos[1], 0, 0, imageDataSize);
+        updatePbos(imageDataSize);
         _spec = spec;
+        _texInternalFormat = internalFormat;
     }
-    // Update the content of the texture, i.e the image
-    else
+    // Still images are uploaded right away, the texture storage being kept
+    else if (!spec.videoFrame)
     {
-        // Copy the pixels from the current PBO to the texture
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbos[_pboReadIndex]);
+        img->lockWrite();
         if (!isCompressed)
-            glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, 0);
+            glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, img->data());
         else
-            glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, 0);
-        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, img->data());
+        img->unlockWrite();
+        _pboUploadPending = false;
+    }
+    // Update the content of the texture, i.e the image
+    else
+    {
+        if (_pbos.size() != _pboCount || _pboSize != static_cast<uint32_t>(imageDataSize))
+            updatePbos(imageDataSize);
+
+        // Copy the pixels from the PBO filled during the previous update to the texture
+        if (_pboUploadPending)
+        {
+            auto& slot = _pbos[_pboWriteIndex];
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+            if (!isCompressed)
+                glTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, glChannelOrder, dataFormat, 0);
+            else
+                glCompressedTextureSubImage2D(_glTex, 0, 0, 0, spec.width, spec.height, internalFormat, imageDataSize, 0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-        _pboReadIndex = (_pboReadIndex + 1) % 2;
+            // The PBO can not be written to until the GPU is done reading it
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            _pboUploadPending = false;
+        }
 
         // Fill the next PBO with the image pixels
-        GLubyte* pixels = (GLubyte*)glMapNamedBufferRange(_pbos[_pboReadIndex], 0, imageDataSize, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
-        if (pixels != NULL)
+        _pboWriteIndex = (_pboWriteIndex + 1) % _pbos.size();
+        auto& slot = _pbos[_pboWriteIndex];
+        waitForPbo(slot);
+
+        if (slot.data != nullptr)
         {
             img->lockWrite();
 
+            auto pixels = slot.data;
             int stride = SPLASH_TEXTURE_COPY_THREADS;
             int size = imageDataSize;
             for (int i = 0; i < stride - 1; ++i)
             {
-                _pboCopyThreads.push_back(
-                    async(launch::async, [=]() { copy((char*)img->data() + size / stride * i, (char*)img->data() + size / stride * (i + 1), (char*)pixels + size / stride * i); }));
+                _pboCopyThreads.push_back(ThreadPool::get().enqueue(
+                    [=]() { copy((char*)img->data() + size / stride * i, (char*)img->data() + size / stride * (i + 1), pixels + size / stride * i); }));
             }
-            _pboCopyThreads.push_back(
-                async(launch::async, [=]() { copy((char*)img->data() + size / stride * (stride - 1), (char*)img->data() + size, (char*)pixels + size / stride * (stride - 1)); }));
+            _pboCopyThreads.push_back(ThreadPool::get().enqueue(
+                [=]() { copy((char*)img->data() + size / stride * (stride - 1), (char*)img->data() + size, pixels + size / stride * (stride - 1)); }));
+            _pboUploadPending = true;
         }
     }
 
@@ -533,9 +524,9 @@ void Texture_Image::flushPbo()
 {
     if (!_pboCopyThreads.empty())
     {
-        _pboCopyThreads.clear(); // This waits for the threaded copies to finish
-
-        glUnmapNamedBuffer(_pbos[_pboReadIndex]);
+        // The PBOs are coherent, no need to unmap them for the copied data to be visible to the GPU
+        ThreadPool::get().waitAll(_pboCopyThreads);
+        _pboCopyThreads.clear();
 
         if (!_img.expired())
             _img.lock()->unlockWrite();
@@ -553,15 +544,58 @@ void Texture_Image::init()
         return;
 
     _timestamp = Timer::getTime();
+}
+
+/*************/
+void Texture_Image::updatePbos(uint32_t size)
+{
+    deletePbos();
+
+    _pbos.resize(_pboCount);
+    _pboSize = size;
+    _pboWriteIndex = 0;
+    _pboUploadPending = false;
 
-    glCreateBuffers(2, _pbos);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    for (auto& slot : _pbos)
+    {
+        glCreateBuffers(1, &slot.buffer);
+        glNamedBufferStorage(slot.buffer, size, nullptr, flags);
+        slot.data = static_cast<char*>(glMapNamedBufferRange(slot.buffer, 0, size, flags));
+        if (slot.data == nullptr)
+            Log::get() << Log::WARNING << "Texture_Image::" << __FUNCTION__ << " - Unable to map PBO for texture " << _name << Log::endl;
+    }
+}
+
+/*************/
+void Texture_Image::deletePbos()
+{
+    for (auto& slot : _pbos)
+    {
+        if (slot.fence != nullptr)
+            glDeleteSync(slot.fence);
+        // Deleting a buffer also unmaps it
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    _pbos.clear();
 }
 
 /*************/
-void Texture_Image::updatePbos(int width, int height, int bytes)
+void Texture_Image::waitForPbo(PboSlot& slot)
 {
-    glNamedBufferData(_pbos[0], width * height * bytes, 0, GL_STREAM_DRAW);
-    glNamedBufferData(_pbos[1], width * height * bytes, 0, GL_STREAM_DRAW);
+    if (slot.fence == nullptr)
+        return;
+
+    if (glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        auto start = Timer::getTime();
+        glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, SPLASH_TEXTURE_PBO_FENCE_TIMEOUT);
+        ++_pboStallCount;
+        _pboStallDuration += Timer::getTime() - start;
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
 }
 
 /*************/
@@ -593,6 +627,19 @@ void Texture_Image::registerAttributes()
         },
         {'n', 'n'});
     setAttributeDescription("size", "Change the texture size");
+
+    addAttribute("pboCount",
+        [&](const Values& args) {
+            _pboCount = std::max(2, std::min(args[0].as<int>(), SPLASH_TEXTURE_MAX_PBO_COUNT));
+            return true;
+        },
+        [&]() -> Values { return {_pboCount}; },
+        {'n'});
+    setAttributeDescription("pboCount", "Number of pixel buffers used to stream the image to the GPU, between 2 and 8");
+
+    addAttribute("pboStalls", nullptr, [&]() -> Values { return {_pboStallCount, _pboStallDuration}; }, {});
+    setAttributeParameter("pboStalls", false, false);
+    setAttributeDescription("pboStalls", "Number of times the upload waited for the GPU to release a pixel buffer, and total waiting time in us");
 }
 
 } // end of namespace
@@ -86,7 +86,7 @@ class Texture_Image : public Texture
     void unbind() override;
 
     /**
-     * \brief Flush the PBO copy which may still be happening. Do this before closing the current context!
+     * \brief Wait for the PBO copy which may still be happening. Do this before closing the current context!
      */
     void flushPbo();
 
@@ -96,10 +96,10 @@ class Texture_Image : public Texture
     void generateMipmap() const;
 
     /**
-     * Computed the mean value for the image
-     * \return Return the mean RGB value
+     * \brief Get the number of mipmap levels of the texture
+     * \return Return the level count
      */
-    RgbValue getMeanValue() const;
+    int getMipmapLevels() const { return _texLevels; }
 
     /**
      * \brief Get the id of the gl texture
@@ -171,12 +171,28 @@ class Texture_Image : public Texture
     void update() final;
 
   private:
+    /**
+     * Persistently mapped pixel buffer, filled from the CPU and read by the texture upload
+     */
+    struct PboSlot
+    {
+        GLuint buffer{0};
+        char* data{nullptr};  //!< Persistent, coherent mapping of the buffer
+        GLsync fence{nullptr}; //!< Signaled when the texture upload from this buffer is done
+    };
+
     GLuint _glTex{0};
-    GLuint _pbos[2];
     int _multisample{0};
     bool _cubemap{false};
-    int _pboReadIndex{0};
+
+    std::vector<PboSlot> _pbos{};
+    uint32_t _pboCount{3};        //!< Number of PBOs in the ring
+    uint32_t _pboSize{0};         //!< Size of each PBO
+    uint32_t _pboWriteIndex{0};   //!< Index of the PBO filled during the last update
+    bool _pboUploadPending{false}; //!< True if the PBO at _pboWriteIndex has to be uploaded to the texture
     std::vector<std::future<void>> _pboCopyThreads;
+    uint64_t _pboStallCount{0};    //!< Number of times a PBO was still in use by the GPU when needed
+    uint64_t _pboStallDuration{0}; //!< Total time spent waiting for the GPU to release a PBO, in us
 
     // Store some texture parameters
     static constexpr int _texLevels{4};
@@ -207,12 +223,21 @@ class Texture_Image : public Texture
     GLenum getChannelOrder(const ImageBufferSpec& spec);
 
     /**
-     * \brief Update the pbos according to the parameters
-     * \param width Width
-     * \param height Height
-     * \param bytes Bytes per pixel
+     * \brief Recreate the PBO ring according to the parameters
+     * \param size Size of each PBO
+     */
+    void updatePbos(uint32_t size);
+
+    /**
+     * \brief Delete the PBO ring
+     */
+    void deletePbos();
+
+    /**
+     * \brief Wait for the GPU to be done with the given PBO, updating the stall counters if it was not
+     * \param slot PBO slot
      */
-    void updatePbos(int width, int height, int bytes);
+    void waitForPbo(PboSlot& slot);
 
     /**
      * \brief Register new functors to modify attributes
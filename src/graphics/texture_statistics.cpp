@@ -0,0 +1,138 @@
+#include "./graphics/texture_statistics.h"
+
+#include <algorithm>
+
+#include "./utils/timer.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+// Layout of the buffer written by the statistics compute shader. Minimums are stored inverted, so that all the fields start at zero
+struct StatisticsBuffer
+{
+    uint32_t sums[3];
+    uint32_t pixelCount;
+    uint32_t invertedMins[3];
+    uint32_t maxs[3];
+    uint32_t histogram[SPLASH_TEXTURE_STATISTICS_BINS];
+};
+static_assert(sizeof(StatisticsBuffer) == (10 + SPLASH_TEXTURE_STATISTICS_BINS) * sizeof(uint32_t), "StatisticsBuffer does not match the std430 layout of the statistics buffer");
+} // end of anonymous namespace
+
+/*************/
+TextureStatistics::~TextureStatistics()
+{
+    for (auto& fence : _fences)
+        if (fence)
+            glDeleteSync(fence);
+
+    glDeleteBuffers(_buffers.size(), _buffers.data());
+}
+
+/*************/
+void TextureStatistics::compute(const shared_ptr<Texture_Image>& texture)
+{
+    if (!texture)
+        return;
+
+    if (!_shader)
+    {
+        _shader = make_shared<Shader>(Shader::prgCompute);
+        _shader->setAttribute("computePhase", {"computeStatistics"});
+        _levelUniform = _shader->getUniformHandle("_level");
+
+        _buffers.resize(SPLASH_TEXTURE_STATISTICS_BUFFERS);
+        glCreateBuffers(_buffers.size(), _buffers.data());
+        for (auto buffer : _buffers)
+            glNamedBufferStorage(buffer, sizeof(StatisticsBuffer), nullptr, GL_MAP_READ_BIT);
+        _fences.resize(_buffers.size(), nullptr);
+        _timestamps.resize(_buffers.size(), 0);
+    }
+
+    // If the GPU is late, the reduction is skipped instead of waiting for a buffer
+    if (_fences[_writeIndex])
+        return;
+
+    // The finest mipmap level for which the sums can not overflow is reduced
+    auto spec = texture->getSpec();
+    int level = 0;
+    uint32_t width = spec.width;
+    uint32_t height = spec.height;
+    while (level < texture->getMipmapLevels() - 1 && static_cast<uint64_t>(width) * height > SPLASH_TEXTURE_STATISTICS_MAX_PIXELS)
+    {
+        width = max(1u, width / 2);
+        height = max(1u, height / 2);
+        ++level;
+    }
+
+    auto buffer = _buffers[_writeIndex];
+    glClearNamedBufferData(buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    glActiveTexture(GL_TEXTURE0);
+    texture->bind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+    _shader->setUniform(_levelUniform, level);
+    _shader->doCompute((width + SPLASH_TEXTURE_STATISTICS_GROUP_SIZE - 1) / SPLASH_TEXTURE_STATISTICS_GROUP_SIZE,
+        (height + SPLASH_TEXTURE_STATISTICS_GROUP_SIZE - 1) / SPLASH_TEXTURE_STATISTICS_GROUP_SIZE);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    texture->unbind();
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    _fences[_writeIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _timestamps[_writeIndex] = Timer::getTime();
+    _pendingBuffers.push_back(_writeIndex);
+
+    _writeIndex = (_writeIndex + 1) % _buffers.size();
+}
+
+/*************/
+TextureStatistics::Statistics TextureStatistics::getStatistics() const
+{
+    lock_guard<mutex> lock(_mutex);
+    return _statistics;
+}
+
+/*************/
+bool TextureStatistics::retrieve()
+{
+    if (_pendingBuffers.empty())
+        return false;
+
+    auto index = _pendingBuffers.front();
+    auto status = glClientWaitSync(_fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+
+    glDeleteSync(_fences[index]);
+    _fences[index] = nullptr;
+    _pendingBuffers.pop_front();
+
+    auto data = static_cast<const StatisticsBuffer*>(glMapNamedBufferRange(_buffers[index], 0, sizeof(StatisticsBuffer), GL_MAP_READ_BIT));
+    if (!data)
+        return false;
+
+    Statistics statistics;
+    statistics.pixelCount = data->pixelCount;
+    statistics.timestamp = _timestamps[index];
+    statistics.histogram.assign(data->histogram, data->histogram + SPLASH_TEXTURE_STATISTICS_BINS);
+    if (statistics.pixelCount != 0)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            statistics.mean[c] = static_cast<float>(data->sums[c]) / static_cast<float>(statistics.pixelCount);
+            statistics.min[c] = static_cast<float>(255 - data->invertedMins[c]);
+            statistics.max[c] = static_cast<float>(data->maxs[c]);
+        }
+    }
+    glUnmapNamedBuffer(_buffers[index]);
+
+    lock_guard<mutex> lock(_mutex);
+    _statistics = statistics;
+    return true;
+}
+
+} // namespace Splash
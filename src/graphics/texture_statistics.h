@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * @texture_statistics.h
+ * Statistics of a texture, reduced on the GPU and read back asynchronously
+ */
+
+#ifndef SPLASH_TEXTURE_STATISTICS_H
+#define SPLASH_TEXTURE_STATISTICS_H
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "./config.h"
+
+#include "./graphics/shader.h"
+#include "./graphics/texture_image.h"
+#include "./utils/cgutils.h"
+
+#define SPLASH_TEXTURE_STATISTICS_BINS 256             // Has to match the histogram size of the statistics compute shader
+#define SPLASH_TEXTURE_STATISTICS_GROUP_SIZE 16        // Has to match the local size of the statistics compute shader
+#define SPLASH_TEXTURE_STATISTICS_MAX_PIXELS (1 << 24) // Above this pixel count, the sums of 8 bits values could overflow
+#define SPLASH_TEXTURE_STATISTICS_BUFFERS 2
+
+namespace Splash
+{
+
+/*************/
+class TextureStatistics
+{
+  public:
+    struct Statistics
+    {
+        RgbValue mean{};
+        RgbValue min{};
+        RgbValue max{};
+        std::vector<uint32_t> histogram{}; //!< Luminance histogram, with SPLASH_TEXTURE_STATISTICS_BINS bins
+        uint64_t pixelCount{0};
+        int64_t timestamp{0}; //!< Time at which the reduction was issued, in microseconds. Zero if nothing was reduced yet
+    };
+
+    /**
+     * \brief Constructor
+     */
+    TextureStatistics() = default;
+
+    /**
+     * \brief Destructor
+     */
+    ~TextureStatistics();
+
+    /**
+     * No copy constructor
+     */
+    TextureStatistics(const TextureStatistics&) = delete;
+    TextureStatistics& operator=(const TextureStatistics&) = delete;
+
+    /**
+     * \brief Issue the reduction of the given texture on the GPU. If all the buffers are still in use, nothing is done. Needs a GL context
+     * \param texture Texture to reduce, its mipmaps have to be up to date
+     */
+    void compute(const std::shared_ptr<Texture_Image>& texture);
+
+    /**
+     * \brief Get the statistics of the last reduction done by the GPU
+     * \return Return the statistics
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * \brief Retrieve the result of the oldest reduction, if the GPU is done with it. This does not block, and needs a GL context
+     * \return Return true if new statistics were retrieved
+     */
+    bool retrieve();
+
+  private:
+    mutable std::mutex _mutex{};
+    Statistics _statistics{};
+
+    std::shared_ptr<Shader> _shader{nullptr};
+    Shader::UniformHandle _levelUniform{};
+
+    std::vector<GLuint> _buffers{};
+    std::vector<GLsync> _fences{};      //!< Fence of the reduction into each buffer, nullptr if the buffer is free
+    std::vector<int64_t> _timestamps{}; //!< Time at which the reduction into each buffer was issued
+    std::deque<int> _pendingBuffers{};  //!< Buffers being filled by the GPU, oldest first
+    int _writeIndex{0};
+};
+
+} // namespace Splash
+
+#endif
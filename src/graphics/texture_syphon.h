@@ -33,6 +33,7 @@
 #include "coretypes.h"
 #include "texture.h"
 #include "texture_syphon_client.h"
+#include "./utils/timer.h"
 
 namespace Splash
 {
@@ -116,6 +117,12 @@ class Texture_Syphon : public Texture
      * \brief Register new functors to modify attributes
      */
     void registerAttributes();
+
+    /**
+     * \brief Get the version of the content of the texture. Syphon does not tell when frames are received, so it changes every time
+     * \return Return the version
+     */
+    uint64_t getContentVersion() const final { return Timer::getTime(); }
 };
 
 } // end of namespace
@@ -128,13 +128,20 @@ void Warp::render()
     auto camera = _inCamera.lock();
     auto input = camera->getTexture();
 
+    // Control points are drawn according to the mouse selection, which is not tracked
+    bool forceRender = _showControlPoints;
+
     auto inputSpec = input->getSpec();
     if (inputSpec != _outTextureSpec)
     {
         _outTextureSpec = inputSpec;
         _fbo->setSize(inputSpec.width, inputSpec.height);
+        forceRender = true;
     }
 
+    if (!needsRender(forceRender))
+        return;
+
     _fbo->bindDraw();
     glEnable(GL_FRAMEBUFFER_SRGB);
     glViewport(0, 0, _outTextureSpec.width, _outTextureSpec.height);
@@ -179,6 +186,7 @@ void Warp::render()
     _fbo->unbindDraw();
 
     _fbo->getColorTexture()->generateMipmap();
+    _timestamp = Timer::getTime();
 }
 
 /*************/
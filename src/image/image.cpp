@@ -9,6 +9,7 @@
 #include <stb_image.h>
 #include <stb_image_write.h>
 
+#include "./core/thread_pool.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/timer.h"
@@ -143,11 +144,12 @@ shared_ptr<SerializedObject> Image::serialize() const
         return {};
 
     {
-        vector<future<void>> threads;
+        vector<future<void>> tasks;
         int stride = SPLASH_IMAGE_COPY_THREADS;
         for (int i = 0; i < stride - 1; ++i)
-            threads.push_back(async(launch::async, ([=]() { copy(imgPtr + imgSize / stride * i, imgPtr + imgSize / stride * (i + 1), currentObjPtr + imgSize / stride * i); })));
+            tasks.push_back(ThreadPool::get().enqueue([=]() { copy(imgPtr + imgSize / stride * i, imgPtr + imgSize / stride * (i + 1), currentObjPtr + imgSize / stride * i); }));
         copy(imgPtr + imgSize / stride * (stride - 1), imgPtr + imgSize, currentObjPtr + imgSize / stride * (stride - 1));
+        ThreadPool::get().waitAll(tasks);
     }
 
     if (Timer::get().isDebug())
@@ -183,17 +185,19 @@ bool Image::deserialize(const shared_ptr<SerializedObject>& obj)
         ImageBufferSpec spec;
         spec.from_string(xmlSpec.c_str());
 
-        ImageBufferSpec curSpec = _bufferDeserialize.getSpec();
-        if (spec != curSpec)
-            _bufferDeserialize = ImageBuffer(spec);
-
+        // Borrowed data, for example from a shared memory slot, is used in place
         auto rawBuffer = obj->grabData();
         rawBuffer.shift(SPLASH_IMAGE_SERIALIZED_HEADER_SIZE);
-        _bufferDeserialize.setRawBuffer(std::move(rawBuffer));
+        _bufferDeserialize = ImageBuffer(spec, std::move(rawBuffer));
 
         if (!_bufferImage)
             _bufferImage = unique_ptr<ImageBuffer>(new ImageBuffer());
         std::swap(*_bufferImage, _bufferDeserialize);
+
+        // A borrowed buffer replaced before being displayed is handed back right away
+        if (_bufferDeserialize.isExternal())
+            _bufferDeserialize = ImageBuffer();
+
         _imageUpdated = true;
 
         updateTimestamp();
@@ -276,6 +280,10 @@ void Image::update()
         _image.swap(_bufferImage);
         _imageUpdated = false;
 
+        // The borrowed buffer which was displayed until now is handed back, only the displayed one is kept
+        if (_bufferImage && _bufferImage->isExternal())
+            _bufferImage.reset();
+
         if (_remoteType.empty() || _type == _remoteType)
             updateMediaInfo();
     }
@@ -8,8 +8,8 @@
 #include <fcntl.h>
 #endif
 #include <fstream>
-#include <hap.h>
 
+#include "./core/thread_pool.h"
 #include "./utils/cgutils.h"
 #include "./utils/osutils.h"
 #include "./utils/log.h"
@@ -63,6 +63,15 @@ void Image_FFmpeg::freeFFmpegObjects()
 #endif
     }
 
+    // The read loop starts the keyframe index build, so it is only stopped once the loop is done
+    _keyframeIndex.cancel();
+    if (_keyframeIndexFuture.valid())
+        _keyframeIndexFuture.wait();
+    _keyframeIndex.clear();
+    _seekTarget = -1;
+    _readKeyframe = -1;
+    _readTimestamp = -1;
+
     if (_avContext)
     {
         avformat_close_input(&_avContext);
@@ -83,6 +92,7 @@ bool Image_FFmpeg::read(const string& filename)
 {
     // First: cleanup
     freeFFmpegObjects();
+    _mediaFilePath = filename;
 
     if (avformat_open_input(&_avContext, filename.c_str(), nullptr, nullptr) != 0)
     {
@@ -269,6 +279,13 @@ void Image_FFmpeg::readLoop()
         return;
     }
 
+    // Build the keyframe index in the background, it is only useful for codecs with inter frames
+    if (!_intraOnly)
+    {
+        auto streamIndex = _videoStreamIndex;
+        _keyframeIndexFuture = async(launch::async, [=]() { _keyframeIndex.build(_mediaFilePath, streamIndex); });
+    }
+
     if (videoCodec)
     {
         AVDictionary* optionsDict = nullptr;
@@ -328,8 +345,12 @@ void Image_FFmpeg::readLoop()
         return;
     }
 
+    // Frames are converted directly into pool buffers, except if the converted frame is larger
+    // than the image spec (odd widths), in which case an intermediate buffer is needed
+    ImageBufferSpec yuyvSpec(videoCodecContext->width, videoCodecContext->height, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
     int numBytes = av_image_get_buffer_size(AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
-    vector<unsigned char> buffer(numBytes);
+    bool convertInPlace = numBytes == yuyvSpec.rawSize();
+    vector<unsigned char> buffer(convertInPlace ? 0 : numBytes);
 
     struct SwsContext* swsContext = nullptr;
     if (!isHap)
@@ -345,7 +366,8 @@ void Image_FFmpeg::readLoop()
             nullptr,
             nullptr);
 
-        av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, buffer.data(), AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
+        if (!convertInPlace)
+            av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, buffer.data(), AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
     }
 
     AVPacket packet;
@@ -353,6 +375,48 @@ void Image_FFmpeg::readLoop()
 
     _videoTimeBase = (double)videoStream->time_base.num / (double)videoStream->time_base.den;
 
+    // After a seek, frames are decoded from the previous keyframe but only queued from the seek target
+    // Half a frame of tolerance absorbs timestamp rounding
+    int64_t seekTolerance = 0;
+    if (videoStream->avg_frame_rate.num > 0)
+        seekTolerance = static_cast<int64_t>(av_q2d(av_inv_q(videoStream->avg_frame_rate)) * 0.5e6);
+    auto reachedSeekTarget = [&](int64_t timing) -> bool {
+        auto target = _seekTarget.load();
+        if (target < 0)
+            return true;
+        if (timing + seekTolerance < target)
+            return false;
+        _seekTarget.compare_exchange_strong(target, -1);
+        return true;
+    };
+    uint32_t decoderSeekCount = _seekCount;
+
+    // Hap frames being decoded, queued in order once decoded
+    // Frames decoded before a seek are dropped
+    deque<unique_ptr<PendingHapFrame>> pendingHapFrames;
+    auto queueDecodedHapFrames = [&](size_t framesToKeep) {
+        while (pendingHapFrames.size() > framesToKeep)
+        {
+            auto& pendingFrame = pendingHapFrames.front();
+            vector<future<void>> decoding;
+            decoding.push_back(std::move(pendingFrame->decoded));
+            ThreadPool::get().waitAll(decoding);
+            av_packet_free(&pendingFrame->packet);
+
+            {
+                lock_guard<mutex> lockFrames(_videoQueueMutex);
+                if (pendingFrame->success && pendingFrame->seekCount == _seekCount && reachedSeekTarget(pendingFrame->timing))
+                {
+                    _timedFrames.emplace_back();
+                    std::swap(_timedFrames[_timedFrames.size() - 1].frame, pendingFrame->frame);
+                    _timedFrames[_timedFrames.size() - 1].timing = pendingFrame->timing;
+                }
+            }
+
+            pendingHapFrames.pop_front();
+        }
+    };
+
     // This implements looping
     do
     {
@@ -372,10 +436,26 @@ void Image_FFmpeg::readLoop()
                 uint64_t timing = 0;
                 bool hasFrame = false;
 
+                // Keep track of the reading position, to know whether a seek can be done by decoding forward
+                if (packet.pts != AV_NOPTS_VALUE)
+                {
+                    if (packet.flags & AV_PKT_FLAG_KEY)
+                        _readKeyframe = packet.pts;
+                    if ((packet.flags & AV_PKT_FLAG_KEY) || packet.pts > _readTimestamp)
+                        _readTimestamp = packet.pts;
+                }
+
                 //
                 // If the codec is handled by FFmpeg
                 if (!isHap)
                 {
+                    // Frames buffered in the decoder are from before the last seek
+                    if (decoderSeekCount != _seekCount)
+                    {
+                        avcodec_flush_buffers(videoCodecContext);
+                        decoderSeekCount = _seekCount;
+                    }
+
                     auto frameFinished = false;
                     if (avcodec_send_packet(videoCodecContext, &packet) < 0)
                         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Error while decoding a frame in file " << _filepath << Log::endl;
@@ -384,13 +464,14 @@ void Image_FFmpeg::readLoop()
 
                     if (frameFinished)
                     {
-                        sws_scale(swsContext, (const uint8_t* const*)frame->data, frame->linesize, 0, videoCodecContext->height, rgbFrame->data, rgbFrame->linesize);
+                        img = _framePool->acquire(yuyvSpec);
+                        auto pixels = reinterpret_cast<uint8_t*>(img->data());
 
-                        ImageBufferSpec spec(videoCodecContext->width, videoCodecContext->height, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
-                        img.reset(new ImageBuffer(spec));
-
-                        unsigned char* pixels = reinterpret_cast<unsigned char*>(img->data());
-                        copy(buffer.begin(), buffer.end(), pixels);
+                        if (convertInPlace)
+                            av_image_fill_arrays(rgbFrame->data, rgbFrame->linesize, pixels, AV_PIX_FMT_YUYV422, videoCodecContext->width, videoCodecContext->height, 1);
+                        sws_scale(swsContext, (const uint8_t* const*)frame->data, frame->linesize, 0, videoCodecContext->height, rgbFrame->data, rgbFrame->linesize);
+                        if (!convertInPlace)
+                            copy(buffer.begin(), buffer.begin() + img->getSize(), pixels);
 
                         if (packet.pts != AV_NOPTS_VALUE)
                             timing = static_cast<uint64_t>((double)av_frame_get_best_effort_timestamp(frame) * _videoTimeBase * 1e6);
@@ -408,66 +489,41 @@ void Image_FFmpeg::readLoop()
                 // If the codec is marked as Hap / Hap alpha / Hap Q
                 else if (isHap)
                 {
-                    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
-                    // First, we check the texture format type
-                    std::string textureFormat;
-                    if (hapDecodeFrame(packet.data, packet.size, nullptr, 0, textureFormat))
+                    // Frames are decoded on the thread pool while the next packets are read,
+                    // the packet being kept alive until its frame is decoded
+                    auto pendingFrame = unique_ptr<PendingHapFrame>(new PendingHapFrame());
+                    pendingFrame->packet = av_packet_clone(&packet);
+                    if (pendingFrame->packet && pendingFrame->decoder.parse(pendingFrame->packet->data, pendingFrame->packet->size))
                     {
-                        // Check if we need to resize the reader buffer
-                        // We set the size so as to have just enough place for the given texture format
-                        ImageBufferSpec spec;
-                        if (textureFormat == "RGB_DXT1")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, (int)(ceil((float)videoCodecContext->height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else if (textureFormat == "RGBA_DXT5")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else if (textureFormat == "YCoCg_DXT5")
-                        {
-                            spec = ImageBufferSpec(videoCodecContext->width, videoCodecContext->height, 1, 8, ImageBufferSpec::Type::UINT8);
-                        }
-                        else
-                        {
-                            av_packet_unref(&packet);
-                            return;
-                        }
-
-                        spec.format = {textureFormat};
-                        img.reset(new ImageBuffer(spec));
-
-                        unsigned long outputBufferBytes = spec.width * spec.height * spec.channels;
-
-                        if (hapDecodeFrame(packet.data, packet.size, img->data(), outputBufferBytes, textureFormat))
+                        auto spec = HapDecoder::getImageSpec(videoCodecContext->width, videoCodecContext->height, pendingFrame->decoder.getFormat());
+                        if (spec.rawSize() != 0)
                         {
+                            pendingFrame->frame = _framePool->acquire(spec);
                             if (packet.pts != AV_NOPTS_VALUE)
-                                timing = static_cast<uint64_t>((double)packet.pts * _videoTimeBase * 1e6);
-                            else
-                                timing = 0.0;
+                                pendingFrame->timing = static_cast<uint64_t>((double)packet.pts * _videoTimeBase * 1e6);
+                            pendingFrame->seekCount = _seekCount;
 
-                            hasFrame = true;
+                            auto framePtr = pendingFrame.get();
+                            pendingFrame->decoded = ThreadPool::get().enqueue(
+                                [framePtr]() { framePtr->success = framePtr->decoder.decode(framePtr->frame->data(), framePtr->frame->getSize()); });
+                            pendingHapFrames.push_back(std::move(pendingFrame));
                         }
                     }
+
+                    if (pendingFrame)
+                        av_packet_free(&pendingFrame->packet);
+
+                    queueDecodedHapFrames(SPLASH_FFMPEG_HAP_DECODE_AHEAD);
                 }
 
-                int64_t totalBufferSize = 0;
                 {
                     lock_guard<mutex> lockFrames(_videoQueueMutex);
-                    if (hasFrame)
+                    if (hasFrame && reachedSeekTarget(timing))
                     {
-
-                        // Add the frame size to the history
-                        _framesSize.push_back(img->getSize());
-
                         _timedFrames.emplace_back();
                         std::swap(_timedFrames[_timedFrames.size() - 1].frame, img);
                         _timedFrames[_timedFrames.size() - 1].timing = timing;
                     }
-
-                    // Check the current buffer size (sum of all frames in buffer)
-                    for (auto& f : _framesSize)
-                        totalBufferSize += f;
                 }
 
                 int timedFramesBuffered = _timedFrames.size();
@@ -476,8 +532,8 @@ void Image_FFmpeg::readLoop()
                 av_packet_unref(&packet);
 
                 // Do not store more than a few frames in memory
-                // _maximumBufferSize is divided by 2 as another frame queue is held by the display loop
-                while (timedFramesBuffered > 0 && totalBufferSize > _maximumBufferSize / 2 && _continueRead)
+                // The pool accounts for all the frames in use, including the ones held by the display loop
+                while (timedFramesBuffered > 0 && _framePool->getUsedSize() > _maximumBufferSize && _continueRead)
                 {
                     this_thread::sleep_for(chrono::milliseconds(5));
                     lock_guard<mutex> lockSeek(_videoSeekMutex);
@@ -528,6 +584,8 @@ void Image_FFmpeg::readLoop()
             }
         }
 
+        queueDecodedHapFrames(0);
+
         // This prevents looping to happen before the queue has been consumed
         lock_guard<mutex> lockEnd(_videoEndMutex);
         // Seek to the beginning, or whatever time is set in _trimStart
@@ -610,18 +668,25 @@ void Image_FFmpeg::seek(float seconds)
     else if (seconds > duration)
         seconds = duration;
 
-    int frame = static_cast<int>(floor(seconds / _videoTimeBase));
-    if (avformat_seek_file(_avContext, _videoStreamIndex, 0, frame, frame, seekFlag) < 0)
+    // The demuxer is sent to the keyframe preceding the target, and the reader decodes forward from there
+    // If the target is ahead of the reader in the same group of pictures, decoding forward is enough
+    int64_t frame = static_cast<int64_t>(floor(seconds / _videoTimeBase));
+    int64_t keyframe = _keyframeIndex.getKeyframeBefore(frame);
+    bool decodeForward = _keyframeIndex.isReady() && keyframe == _readKeyframe && frame > _readTimestamp;
+
+    if (!decodeForward && avformat_seek_file(_avContext, _videoStreamIndex, INT64_MIN, keyframe, keyframe, seekFlag) < 0)
     {
         Log::get() << Log::WARNING << "Image_FFmpeg::" << __FUNCTION__ << " - Could not seek to timestamp " << seconds << Log::endl;
     }
     else
     {
         lock_guard<mutex> lockQueue(_videoQueueMutex);
-        // As seeking will no necessarily go to the desired timestamp, but to the closest i-frame,
-        // we will set _startTime at the next frame in the videoDisplayLoop
+        // Frames are queued again starting from the target, and _startTime will be set from the first one in the videoDisplayLoop
         _startTime = -1;
         _timedFrames.clear();
+        _seekTarget = static_cast<int64_t>(seconds * 1e6);
+        if (!decodeForward)
+            ++_seekCount;
 #if HAVE_PORTAUDIO
         if (_speaker)
             _speaker->clearQueue();
@@ -648,7 +713,6 @@ void Image_FFmpeg::videoDisplayLoop()
         {
             lock_guard<mutex> lockFrames(_videoQueueMutex);
             std::swap(localQueue, _timedFrames);
-            _framesSize.clear();
         }
 
         // This sets the start time after a seek
@@ -771,6 +835,7 @@ void Image_FFmpeg::registerAttributes()
         [&](const Values& args) {
             int64_t sizeMB = max(16, args[0].as<int>());
             _maximumBufferSize = sizeMB * (int64_t)1048576;
+            _framePool->setMaximumSize(_maximumBufferSize);
             return true;
         },
         [&]() -> Values { return {_maximumBufferSize / (int64_t)1048576}; },
@@ -778,6 +843,17 @@ void Image_FFmpeg::registerAttributes()
     setAttributeParameter("bufferSize", true, true);
     setAttributeDescription("bufferSize", "Set the maximum buffer size for the video (in MB)");
 
+    addAttribute("framePoolStats",
+        [&](const Values&) { return true; },
+        [&]() -> Values {
+            return {Value(static_cast<int64_t>(_framePool->getHitCount()), "hits"),
+                Value(static_cast<int64_t>(_framePool->getMissCount()), "misses"),
+                Value(_framePool->getHighWaterMark() / (int64_t)1048576, "highWater")};
+        },
+        {});
+    setAttributeParameter("framePoolStats", false, true);
+    setAttributeDescription("framePoolStats", "Frame pool statistics: buffers reused, buffers allocated and memory high-water mark (in MB)");
+
     addAttribute("duration",
         [&](const Values&) { return false; },
         [&]() -> Values {
@@ -44,11 +44,17 @@ extern "C" {
 
 #include "./core/attribute.h"
 #include "./core/coretypes.h"
+#include "./core/imagebuffer_pool.h"
 #include "./image/image.h"
+#include "./image/keyframe_index.h"
+#include "./utils/hap_decoder.h"
 #if HAVE_PORTAUDIO
 #include "./sound/speaker.h"
 #endif
 
+// Number of Hap frames decoded in parallel, ahead of the one being queued
+#define SPLASH_FFMPEG_HAP_DECODE_AHEAD 3
+
 namespace Splash
 {
 
@@ -92,9 +98,29 @@ class Image_FFmpeg : public Image
     };
     std::deque<TimedFrame> _timedFrames;
 
-    // Frame size history, used to keep the frame buffer smaller than _maximumBufferSize
-    std::vector<int64_t> _framesSize{};
+    struct PendingHapFrame
+    {
+        HapDecoder decoder{};
+        AVPacket* packet{nullptr};
+        std::unique_ptr<ImageBuffer> frame{};
+        int64_t timing{0}; // in us
+        uint32_t seekCount{0};
+        std::future<void> decoded{};
+        bool success{false};
+    };
+    std::atomic_uint _seekCount{0}; // Incremented on each seek, to drop frames decoded before it
+
+    // Seeking is frame accurate: the reader decodes from the previous keyframe and drops frames until the target
+    KeyframeIndex _keyframeIndex{};
+    std::future<void> _keyframeIndexFuture{};
+    std::string _mediaFilePath{""};
+    std::atomic<int64_t> _seekTarget{-1};    // in us, -1 if no seek is in progress
+    std::atomic<int64_t> _readKeyframe{-1};  // Last keyframe read, in the stream time base
+    std::atomic<int64_t> _readTimestamp{-1}; // Latest timestamp read since this keyframe, in the stream time base
+
+    // Decoded frames are taken from this pool, which also keeps track of the memory they use
     int64_t _maximumBufferSize{(int64_t)1 << 29};
+    std::shared_ptr<ImageBufferPool> _framePool{std::make_shared<ImageBufferPool>(_maximumBufferSize)};
 
     std::mutex _videoQueueMutex;
     std::mutex _videoSeekMutex;
@@ -3,8 +3,8 @@
 #include <chrono>
 
 #include <opencv2/opencv.hpp>
-#include <hap.h>
 
+#include "./image/pixel_conversion.h"
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
@@ -111,17 +111,31 @@ void Image_OpenCV::readLoop()
             return;
         }
 
+        // Three channels captures are converted to RGBA, which is faster to upload than BGR
+        auto isBGR = capture.channels() == 3;
+        auto channels = isBGR ? 4 : capture.channels();
         auto spec = _readBuffer.getSpec();
-        if (static_cast<int>(spec.width) != capture.rows || static_cast<int>(spec.height) != capture.cols || static_cast<int>(spec.channels) != capture.channels())
+        if (static_cast<int>(spec.width) != capture.cols || static_cast<int>(spec.height) != capture.rows || static_cast<int>(spec.channels) != channels)
         {
-            ImageBufferSpec newSpec(capture.cols, capture.rows, capture.channels(), 8 * capture.channels(), ImageBufferSpec::Type::UINT8);
-            newSpec.format = "BGR";
+            ImageBufferSpec newSpec(capture.cols, capture.rows, channels, 8 * channels, ImageBufferSpec::Type::UINT8);
+            newSpec.format = isBGR ? "RGBA" : "BGR";
             _readBuffer = ImageBuffer(newSpec);
         }
-        unsigned char* pixels = reinterpret_cast<unsigned char*>(_readBuffer.data());
+        auto pixels = reinterpret_cast<uint8_t*>(_readBuffer.data());
 
-        unsigned int imageSize = capture.rows * capture.cols * capture.channels();
-        copy(capture.data, capture.data + imageSize, pixels);
+        if (isBGR && capture.isContinuous())
+        {
+            PixelConversion::bgrToRGBA(capture.data, pixels, capture.cols, capture.rows);
+        }
+        else if (isBGR)
+        {
+            for (int row = 0; row < capture.rows; ++row)
+                PixelConversion::bgrToRGBA(capture.ptr(row), pixels + row * capture.cols * 4, capture.cols, 1);
+        }
+        else
+        {
+            PixelConversion::copy(capture.data, pixels, capture.total() * capture.elemSize());
+        }
 
         lock_guard<shared_timed_mutex> lockWrite(_writeMutex);
         if (!_bufferImage)
@@ -1,6 +1,5 @@
 #include "./image/image_shmdata.h"
 
-#include <hap.h>
 #include <regex>
 
 // All existing 64bits x86 CPUs have SSE2
@@ -14,12 +13,12 @@
 #include <glm/glm.hpp>
 #endif
 
+#include "./image/pixel_conversion.h"
 #include "./utils/cgutils.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
 #include "./utils/timer.h"
 
-#define SPLASH_SHMDATA_THREADS 2
 #define SPLASH_SHMDATA_WITH_POOL 0 // FIXME: there is an issue with the threadpool in the shmdata callback
 
 using namespace std;
@@ -90,6 +89,9 @@ void Image_Shmdata::onCaps(const string& dataType)
         _isYUV = false;
         _is420 = false;
         _is422 = false;
+        _isNV12 = false;
+        _isYUY2 = false;
+        _is10Bit = false;
 
         regex regHap, regWidth, regHeight;
         regex regVideo, regFormat;
@@ -160,6 +162,21 @@ void Image_Shmdata::onCaps(const string& dataType)
                     _isYUV = true;
                     _is420 = true;
                 }
+                else if ("I420_10LE" == substr)
+                {
+                    _bpp = 24;
+                    _channels = 3;
+                    _isYUV = true;
+                    _is420 = true;
+                    _is10Bit = true;
+                }
+                else if ("NV12" == substr)
+                {
+                    _bpp = 12;
+                    _channels = 3;
+                    _isYUV = true;
+                    _isNV12 = true;
+                }
                 else if ("UYVY" == substr)
                 {
                     _bpp = 12;
@@ -167,6 +184,13 @@ void Image_Shmdata::onCaps(const string& dataType)
                     _isYUV = true;
                     _is422 = true;
                 }
+                else if ("YUY2" == substr)
+                {
+                    _bpp = 16;
+                    _channels = 3;
+                    _isYUV = true;
+                    _isYUY2 = true;
+                }
             }
         }
         else if (regex_match(dataType, regHap))
@@ -224,35 +248,21 @@ void Image_Shmdata::readHapFrame(void* data, int data_size)
 {
     lock_guard<shared_timed_mutex> lock(_writeMutex);
 
-    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
-    // First, we check the texture format type
-    auto textureFormat = string("");
-    if (!hapDecodeFrame(data, data_size, nullptr, 0, textureFormat))
+    // The header is parsed once, giving both the texture format and the chunks to decode
+    if (!_hapDecoder.parse(data, data_size))
         return;
 
     // Check if we need to resize the reader buffer
-    // We set the size so as to have just enough place for the given texture format
-    auto bufSpec = _readerBuffer.getSpec();
-    if (bufSpec.width != _width || (bufSpec.height != _height && textureFormat != _textureFormat))
+    auto spec = HapDecoder::getImageSpec(_width, _height, _hapDecoder.getFormat());
+    if (spec.rawSize() == 0)
+        return;
+    if (_readerBuffer.getSpec() != spec)
     {
-        _textureFormat = textureFormat;
-
-        ImageBufferSpec spec;
-        if (textureFormat == "RGB_DXT1")
-            spec = ImageBufferSpec(_width, (int)(ceil((float)_height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
-        else if (textureFormat == "RGBA_DXT5")
-            spec = ImageBufferSpec(_width, _height, 1, 8, ImageBufferSpec::Type::UINT8);
-        else if (textureFormat == "YCoCg_DXT5")
-            spec = ImageBufferSpec(_width, _height, 1, 8, ImageBufferSpec::Type::UINT8);
-        else
-            return;
-
-        spec.format = textureFormat;
+        _textureFormat = _hapDecoder.getFormat();
         _readerBuffer = ImageBuffer(spec);
     }
 
-    unsigned long outputBufferBytes = bufSpec.width * bufSpec.height * bufSpec.channels;
-    if (!hapDecodeFrame(data, data_size, _readerBuffer.data(), outputBufferBytes, textureFormat))
+    if (!_hapDecoder.decode(_readerBuffer.data(), _readerBuffer.getSize(), SPLASH_SHMDATA_WITH_POOL))
         return;
 
     if (!_bufferImage)
@@ -279,7 +289,7 @@ void Image_Shmdata::readUncompressedFrame(void* data, int /*data_size*/)
         if (_channels == 4)
             spec.format.push_back('A');
 
-        if (_is420 || _is422)
+        if (_isYUV)
         {
             spec.format = "UYVY";
             spec.bpp = 16;
@@ -288,47 +298,36 @@ void Image_Shmdata::readUncompressedFrame(void* data, int /*data_size*/)
         _readerBuffer = ImageBuffer(spec);
     }
 
+    auto pixels = reinterpret_cast<uint8_t*>(_readerBuffer.data());
+    auto frame = static_cast<const uint8_t*>(data);
     if (!_isYUV && (_channels == 3 || _channels == 4))
     {
-        char* pixels = (char*)(_readerBuffer).data();
-        vector<future<void>> threads;
-        for (int block = 0; block < SPLASH_SHMDATA_THREADS; ++block)
-        {
-            int size = _width * _height * _channels * sizeof(char);
-            threads.push_back(async(launch::async, [=]() {
-                int sizeOfBlock; // We compute the size of the block, to handle image size non divisible by SPLASH_SHMDATA_THREADS
-                if (size - size / SPLASH_SHMDATA_THREADS * block < 2 * size / SPLASH_SHMDATA_THREADS)
-                    sizeOfBlock = size - size / SPLASH_SHMDATA_THREADS * block;
-                else
-                    sizeOfBlock = size / SPLASH_SHMDATA_THREADS;
-
-                memcpy(pixels + size / SPLASH_SHMDATA_THREADS * block, (const char*)data + size / SPLASH_SHMDATA_THREADS * block, sizeOfBlock);
-            }));
-        }
+        PixelConversion::copy(frame, pixels, _width * _height * _channels, SPLASH_SHMDATA_WITH_POOL);
     }
     else if (_is420)
     {
-        const unsigned char* Y = static_cast<const unsigned char*>(data);
-        const unsigned char* U = static_cast<const unsigned char*>(data) + _width * _height;
-        const unsigned char* V = static_cast<const unsigned char*>(data) + _width * _height * 5 / 4;
-        char* pixels = (char*)(_readerBuffer).data();
-
-        for (uint32_t y = 0; y < _height; ++y)
+        // 10 bits frames are brought down to 8 bits, then converted as any I420 frame
+        if (_is10Bit)
         {
-            for (uint32_t x = 0; x < _width; x += 2)
-            {
-                pixels[(x + y * _width) * 2 + 0] = U[(x / 2) + (y / 2) * (_width / 2)];
-                pixels[(x + y * _width) * 2 + 1] = Y[x + y * _width];
-                pixels[(x + y * _width) * 2 + 2] = V[(x / 2) + (y / 2) * (_width / 2)];
-                pixels[(x + y * _width) * 2 + 3] = Y[x + y * _width + 1];
-            }
+            size_t sampleCount = _width * _height * 3 / 2;
+            _unpackedFrame.resize(sampleCount);
+            PixelConversion::unpack10Bit(static_cast<const uint16_t*>(data), _unpackedFrame.data(), sampleCount, SPLASH_SHMDATA_WITH_POOL);
+            frame = _unpackedFrame.data();
         }
+
+        PixelConversion::i420ToUYVY(frame, frame + _width * _height, frame + _width * _height * 5 / 4, pixels, _width, _height, SPLASH_SHMDATA_WITH_POOL);
+    }
+    else if (_isNV12)
+    {
+        PixelConversion::nv12ToUYVY(frame, frame + _width * _height, pixels, _width, _height, SPLASH_SHMDATA_WITH_POOL);
+    }
+    else if (_isYUY2)
+    {
+        PixelConversion::yuy2ToUYVY(frame, pixels, _width, _height, SPLASH_SHMDATA_WITH_POOL);
     }
     else if (_is422)
     {
-        const unsigned char* YUV = static_cast<const unsigned char*>(data);
-        char* pixels = (char*)(_readerBuffer).data();
-        copy(YUV, YUV + _width * _height * 2, pixels);
+        PixelConversion::copy(frame, pixels, _width * _height * 2, SPLASH_SHMDATA_WITH_POOL);
     }
     else
         return;
@@ -31,6 +31,7 @@
 #include "./config.h"
 
 #include "./image/image.h"
+#include "./utils/hap_decoder.h"
 #include "./utils/osutils.h"
 
 namespace Splash
@@ -77,8 +78,13 @@ class Image_Shmdata : public Image
     bool _isYUV{false};
     bool _is420{false};
     bool _is422{false};
+    bool _isNV12{false};
+    bool _isYUY2{false};
+    bool _is10Bit{false};
+    std::vector<uint8_t> _unpackedFrame{}; //!< Holds 10 bits frames once converted to 8 bits
 
     // Hap specific attributes
+    HapDecoder _hapDecoder{};
     std::string _textureFormat{""};
 
     /**
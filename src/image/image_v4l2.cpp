@@ -5,6 +5,8 @@
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#include "./image/pixel_conversion.h"
+
 #if HAVE_DATAPATH
 #include "rgb133v4l2.h"
 #endif
@@ -99,19 +101,38 @@ void Image_V4L2::captureThreadFunc()
     int result = 0;
     struct v4l2_buffer buffer;
     enum v4l2_buf_type bufferType;
-    auto bufferSize = _outputWidth * _outputHeight * _spec.pixelBytes();
+    auto bufferSize = _captureSpec.rawSize();
+    auto isConverted = _captureSpec != _spec;
 
     if (!_hasStreamingIO)
     {
         unique_lock<shared_timed_mutex> lockWrite(_writeMutex, std::defer_lock);
         while (_captureThreadRun)
         {
-            if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
+            if (!_bufferImage || _bufferImage->getSpec() != _spec)
                 _bufferImage = unique_ptr<ImageBuffer>(new ImageBuffer(_spec));
 
-            lockWrite.lock();
-            result = ::read(_deviceFd, _bufferImage->data(), bufferSize);
-            lockWrite.unlock();
+            if (isConverted)
+            {
+                if (_imageBuffers.empty() || _imageBuffers[0]->getSpec() != _captureSpec)
+                {
+                    _imageBuffers.clear();
+                    _imageBuffers.push_back(unique_ptr<ImageBuffer>(new ImageBuffer(_captureSpec)));
+                }
+                result = ::read(_deviceFd, _imageBuffers[0]->data(), bufferSize);
+                if (result >= 0)
+                {
+                    lockWrite.lock();
+                    convertCapturedFrame(*_imageBuffers[0], *_bufferImage);
+                    lockWrite.unlock();
+                }
+            }
+            else
+            {
+                lockWrite.lock();
+                result = ::read(_deviceFd, _bufferImage->data(), bufferSize);
+                lockWrite.unlock();
+            }
 
             if (result < 0)
             {
@@ -129,7 +150,7 @@ void Image_V4L2::captureThreadFunc()
         _imageBuffers.clear();
         for (uint32_t i = 0; i < _bufferCount; ++i)
         {
-            _imageBuffers.push_back(unique_ptr<ImageBuffer>(new ImageBuffer(_spec)));
+            _imageBuffers.push_back(unique_ptr<ImageBuffer>(new ImageBuffer(_captureSpec)));
 
             memset(&buffer, 0, sizeof(buffer));
             buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
@@ -191,11 +212,15 @@ void Image_V4L2::captureThreadFunc()
                         return;
                     }
 
-                    if (!_bufferImage || _bufferImage->getSpec() != _imageBuffers[buffer.index]->getSpec())
+                    if (!_bufferImage || _bufferImage->getSpec() != _spec)
                         _bufferImage = unique_ptr<ImageBuffer>(new ImageBuffer(_spec));
 
+                    // Converted frames are written to the output image, otherwise the capture buffer is swapped with it
                     lockWrite.lock();
-                    _bufferImage.swap(_imageBuffers[buffer.index]);
+                    if (isConverted)
+                        convertCapturedFrame(*_imageBuffers[buffer.index], *_bufferImage);
+                    else
+                        _bufferImage.swap(_imageBuffers[buffer.index]);
                     lockWrite.unlock();
 
                     _imageUpdated = true;
@@ -484,11 +509,31 @@ bool Image_V4L2::openCaptureDevice(const std::string& devicePath)
     case V4L2_PIX_FMT_YUYV:
         _spec = ImageBufferSpec(_outputWidth, _outputHeight, 3, 16, ImageBufferSpec::Type::UINT8, "YUYV");
         break;
+    case V4L2_PIX_FMT_NV12:
+        _spec = ImageBufferSpec(_outputWidth, _outputHeight, 3, 16, ImageBufferSpec::Type::UINT8, "UYVY");
+        break;
     }
 
+    // NV12 frames are captured as a single channel image holding both planes, and converted to UYVY
+    if (_outputPixelFormat == V4L2_PIX_FMT_NV12)
+        _captureSpec = ImageBufferSpec(_outputWidth, _outputHeight * 3 / 2, 1, 8, ImageBufferSpec::Type::UINT8, "NV12");
+    else
+        _captureSpec = _spec;
+
     return true;
 }
 
+/*************/
+void Image_V4L2::convertCapturedFrame(const ImageBuffer& captured, ImageBuffer& image)
+{
+    auto source = reinterpret_cast<const uint8_t*>(captured.data());
+    auto destination = reinterpret_cast<uint8_t*>(image.data());
+    auto spec = image.getSpec();
+
+    if (_outputPixelFormat == V4L2_PIX_FMT_NV12)
+        PixelConversion::nv12ToUYVY(source, source + spec.width * spec.height, destination, spec.width, spec.height);
+}
+
 /*************/
 void Image_V4L2::closeCaptureDevice()
 {
@@ -729,6 +774,8 @@ void Image_V4L2::registerAttributes()
                 _outputPixelFormat = V4L2_PIX_FMT_RGB24;
             else if (format == "YUYV")
                 _outputPixelFormat = V4L2_PIX_FMT_YUYV;
+            else if (format == "NV12")
+                _outputPixelFormat = V4L2_PIX_FMT_NV12;
             else
                 _outputPixelFormat = V4L2_PIX_FMT_RGB24;
 
@@ -750,12 +797,15 @@ void Image_V4L2::registerAttributes()
             case V4L2_PIX_FMT_YUYV:
                 format = "YUYV";
                 break;
+            case V4L2_PIX_FMT_NV12:
+                format = "NV12";
+                break;
             }
             return {format};
         },
         {'s'});
     setAttributeParameter("pixelFormat", true, true);
-    setAttributeDescription("pixelFormat", "Set the desired output format, either RGB or YUYV");
+    setAttributeDescription("pixelFormat", "Set the desired output format, either RGB, YUYV or NV12 (converted to UYVY)");
 }
 
 } // namespace Splash
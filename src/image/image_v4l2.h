@@ -111,6 +111,7 @@ class Image_V4L2 : public Image
     std::atomic_bool _automaticResizing{false};
 
     ImageBufferSpec _spec{};
+    ImageBufferSpec _captureSpec{}; //!< Spec of the buffers filled by the device, which differs from _spec if frames are converted
 
     std::future<void> _captureFuture{};
 
@@ -119,6 +120,13 @@ class Image_V4L2 : public Image
      */
     void captureThreadFunc();
 
+    /**
+     * \brief Convert a frame captured in a format not supported by the textures
+     * \param captured Frame filled by the device
+     * \param image Converted frame
+     */
+    void convertCapturedFrame(const ImageBuffer& captured, ImageBuffer& image);
+
     /**
      * \brief As the name suggests
      */
@@ -0,0 +1,188 @@
+#include "./image/keyframe_index.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+/*************/
+bool KeyframeIndex::build(const string& filepath, int streamIndex)
+{
+    _ready = false;
+    _keyframes.clear();
+
+    auto cachePath = getCacheFilePath(filepath, streamIndex);
+    if (!cachePath.empty() && load(cachePath))
+    {
+        _ready = true;
+        return true;
+    }
+
+    if (!scan(filepath, streamIndex))
+        return false;
+
+    if (!cachePath.empty() && !save(cachePath))
+        Log::get() << Log::WARNING << "KeyframeIndex::" << __FUNCTION__ << " - Could not write the keyframe index to " << cachePath << Log::endl;
+
+    _ready = true;
+    return true;
+}
+
+/*************/
+void KeyframeIndex::clear()
+{
+    _ready = false;
+    _cancel = false;
+    _keyframes.clear();
+}
+
+/*************/
+int64_t KeyframeIndex::getKeyframeBefore(int64_t timestamp) const
+{
+    if (!_ready || _keyframes.empty())
+        return timestamp;
+
+    auto keyframeIt = upper_bound(_keyframes.begin(), _keyframes.end(), timestamp);
+    if (keyframeIt == _keyframes.begin())
+        return _keyframes.front();
+
+    return *(--keyframeIt);
+}
+
+/*************/
+string KeyframeIndex::getCacheFilePath(const string& filepath, int streamIndex)
+{
+    struct stat fileStat;
+    if (stat(filepath.c_str(), &fileStat) != 0)
+        return "";
+
+    auto cacheDir = Utils::getCachePath();
+    if (cacheDir.empty())
+        return "";
+
+    auto key = filepath + ":" + to_string(fileStat.st_size) + ":" + to_string(fileStat.st_mtime) + ":" + to_string(streamIndex);
+    stringstream filename;
+    filename << hex << hash<string>()(key) << ".kfi";
+    return cacheDir + filename.str();
+}
+
+/*************/
+bool KeyframeIndex::load(const string& cachePath)
+{
+    ifstream file(cachePath, ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+
+    uint32_t magic = 0, version = 0;
+    uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || magic != SPLASH_KEYFRAME_INDEX_MAGIC || version != SPLASH_KEYFRAME_INDEX_VERSION)
+        return false;
+
+    // Protects against truncated or corrupted files
+    file.seekg(0, ios::end);
+    auto dataSize = static_cast<uint64_t>(file.tellg()) - sizeof(magic) - sizeof(version) - sizeof(count);
+    if (count == 0 || dataSize != count * sizeof(int64_t))
+        return false;
+    file.seekg(sizeof(magic) + sizeof(version) + sizeof(count), ios::beg);
+
+    _keyframes.resize(count);
+    file.read(reinterpret_cast<char*>(_keyframes.data()), count * sizeof(int64_t));
+    if (!file || !is_sorted(_keyframes.begin(), _keyframes.end()))
+    {
+        _keyframes.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool KeyframeIndex::save(const string& cachePath) const
+{
+    // Written to a temporary file first, so that concurrent readers never see a partial index
+    auto tmpPath = cachePath + "." + to_string(getpid()) + ".tmp";
+    {
+        ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        uint32_t magic = SPLASH_KEYFRAME_INDEX_MAGIC;
+        uint32_t version = SPLASH_KEYFRAME_INDEX_VERSION;
+        uint64_t count = _keyframes.size();
+        file.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        file.write(reinterpret_cast<const char*>(_keyframes.data()), count * sizeof(int64_t));
+        if (!file)
+            return false;
+    }
+
+    return rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+}
+
+/*************/
+bool KeyframeIndex::scan(const string& filepath, int streamIndex)
+{
+    AVFormatContext* context = nullptr;
+    if (avformat_open_input(&context, filepath.c_str(), nullptr, nullptr) != 0)
+        return false;
+
+    if (streamIndex < 0 || static_cast<uint32_t>(streamIndex) >= context->nb_streams)
+    {
+        avformat_close_input(&context);
+        return false;
+    }
+
+    // Only the video stream is of interest, other streams are skipped by the demuxer when possible
+    for (uint32_t i = 0; i < context->nb_streams; ++i)
+        if (static_cast<int>(i) != streamIndex)
+            context->streams[i]->discard = AVDISCARD_ALL;
+
+    AVPacket packet;
+    av_init_packet(&packet);
+    packet.data = nullptr;
+    packet.size = 0;
+
+    vector<int64_t> keyframes;
+    while (!_cancel && av_read_frame(context, &packet) >= 0)
+    {
+        if (packet.stream_index == streamIndex && (packet.flags & AV_PKT_FLAG_KEY))
+        {
+            auto timestamp = packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+            if (timestamp != AV_NOPTS_VALUE)
+                keyframes.push_back(timestamp);
+        }
+        av_packet_unref(&packet);
+    }
+
+    avformat_close_input(&context);
+
+    if (_cancel || keyframes.empty())
+        return false;
+
+    sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(unique(keyframes.begin(), keyframes.end()), keyframes.end());
+    _keyframes = std::move(keyframes);
+
+    return true;
+}
+
+} // end of namespace
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @keyframe_index.h
+ * Index of the keyframes of a video stream, cached on disk
+ */
+
+#ifndef SPLASH_KEYFRAME_INDEX_H
+#define SPLASH_KEYFRAME_INDEX_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define SPLASH_KEYFRAME_INDEX_MAGIC 0x49464b53 // "SKFI"
+#define SPLASH_KEYFRAME_INDEX_VERSION 1
+
+namespace Splash
+{
+
+/*************/
+class KeyframeIndex
+{
+  public:
+    /**
+     * \brief Load the index for the given video stream from the cache, or build it by scanning the file and save it to the cache
+     * \param filepath Media file path
+     * \param streamIndex Video stream index
+     * \return Return true if the index is ready
+     */
+    bool build(const std::string& filepath, int streamIndex);
+
+    /**
+     * \brief Interrupt a build running in another thread
+     */
+    void cancel() { _cancel = true; }
+
+    /**
+     * \brief Reset the index, once no build is running anymore
+     */
+    void clear();
+
+    /**
+     * \brief Check whether the index can be used
+     * \return Return true if the index is ready
+     */
+    bool isReady() const { return _ready; }
+
+    /**
+     * \brief Get the last keyframe at or before the given timestamp
+     * \param timestamp Timestamp, in the stream time base
+     * \return Return the keyframe timestamp, or the first keyframe if there is none before
+     */
+    int64_t getKeyframeBefore(int64_t timestamp) const;
+
+    /**
+     * \brief Get the number of keyframes
+     * \return Return the keyframe count
+     */
+    size_t getKeyframeCount() const { return _ready ? _keyframes.size() : 0; }
+
+  private:
+    std::vector<int64_t> _keyframes{}; //!< Sorted keyframe timestamps
+    std::atomic_bool _ready{false};
+    std::atomic_bool _cancel{false};
+
+    /**
+     * \brief Get the cache file for a media, which changes with the media path, size and modification time
+     * \param filepath Media file path
+     * \param streamIndex Video stream index
+     * \return Return the cache file path, or an empty string if there is no cache directory
+     */
+    static std::string getCacheFilePath(const std::string& filepath, int streamIndex);
+
+    /**
+     * \brief Load the keyframes from a cache file
+     * \param cachePath Cache file path
+     * \return Return true if the file was valid
+     */
+    bool load(const std::string& cachePath);
+
+    /**
+     * \brief Save the keyframes to a cache file
+     * \param cachePath Cache file path
+     * \return Return true if the file was written
+     */
+    bool save(const std::string& cachePath) const;
+
+    /**
+     * \brief Read all the packets of the stream to find its keyframes
+     * \param filepath Media file path
+     * \param streamIndex Video stream index
+     * \return Return true if the scan went through the whole file
+     */
+    bool scan(const std::string& filepath, int streamIndex);
+};
+
+} // end of namespace
+
+#endif // SPLASH_KEYFRAME_INDEX_H
@@ -0,0 +1,402 @@
+#include "./image/pixel_conversion.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SPLASH_PIXEL_CONVERSION_X86 1
+#include <immintrin.h>
+#else
+#define SPLASH_PIXEL_CONVERSION_X86 0
+#endif
+
+#include "./core/thread_pool.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace PixelConversion
+{
+
+namespace
+{
+/*************/
+// Scalar rows, also used for the remainder of the vectorized rows
+void i420RowScalar(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, uint32_t width)
+{
+    for (uint32_t x = 0; x < width / 2; ++x)
+    {
+        dst[4 * x + 0] = u[x];
+        dst[4 * x + 1] = y[2 * x];
+        dst[4 * x + 2] = v[x];
+        dst[4 * x + 3] = y[2 * x + 1];
+    }
+}
+
+/*************/
+void nv12RowScalar(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+{
+    for (uint32_t x = 0; x < width / 2; ++x)
+    {
+        dst[4 * x + 0] = uv[2 * x];
+        dst[4 * x + 1] = y[2 * x];
+        dst[4 * x + 2] = uv[2 * x + 1];
+        dst[4 * x + 3] = y[2 * x + 1];
+    }
+}
+
+/*************/
+void yuy2RowScalar(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    for (uint32_t x = 0; x < width / 2; ++x)
+    {
+        dst[4 * x + 0] = src[4 * x + 1];
+        dst[4 * x + 1] = src[4 * x + 0];
+        dst[4 * x + 2] = src[4 * x + 3];
+        dst[4 * x + 3] = src[4 * x + 2];
+    }
+}
+
+/*************/
+void bgrRowScalar(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        dst[4 * x + 0] = src[3 * x + 2];
+        dst[4 * x + 1] = src[3 * x + 1];
+        dst[4 * x + 2] = src[3 * x + 0];
+        dst[4 * x + 3] = 255;
+    }
+}
+
+/*************/
+void unpack10BitScalar(const uint16_t* src, uint8_t* dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i)
+        dst[i] = static_cast<uint8_t>(min(src[i] >> 2, 255));
+}
+
+#if SPLASH_PIXEL_CONVERSION_X86
+/*************/
+// SSE4.1 rows, which also rely on SSSE3 shuffles
+__attribute__((target("sse4.1"))) void i420RowSSE41(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        auto chroma = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)));
+        auto luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x), _mm_unpacklo_epi8(chroma, luma));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x + 16), _mm_unpackhi_epi8(chroma, luma));
+    }
+    i420RowScalar(y + x, u + x / 2, v + x / 2, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("sse4.1"))) void nv12RowSSE41(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        auto chroma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + x));
+        auto luma = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x), _mm_unpacklo_epi8(chroma, luma));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x + 16), _mm_unpackhi_epi8(chroma, luma));
+    }
+    nv12RowScalar(y + x, uv + x, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("sse4.1"))) void yuy2RowSSE41(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    const auto mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    uint32_t x = 0;
+    for (; x + 8 <= width; x += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x), _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x)), mask));
+    yuy2RowScalar(src + 2 * x, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("sse4.1"))) void bgrRowSSE41(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    const auto mask = _mm_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const auto alpha = _mm_slli_epi32(_mm_set1_epi32(0xFF), 24);
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+    {
+        // 16 pixels are read as 3 vectors, then realigned by groups of 4 pixels
+        auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x));
+        auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x + 16));
+        auto third = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * x + 32));
+        auto out = reinterpret_cast<__m128i*>(dst + 4 * x);
+        _mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(first, mask), alpha));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(second, first, 12), mask), alpha));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(third, second, 8), mask), alpha));
+        _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(third, 4), mask), alpha));
+    }
+    bgrRowScalar(src + 3 * x, dst + 4 * x, width - x);
+}
+
+/*************/
+__attribute__((target("sse4.1"))) void unpack10BitSSE41(const uint16_t* src, uint8_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        auto low = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), 2);
+        auto high = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+    }
+    unpack10BitScalar(src + i, dst + i, count - i);
+}
+
+/*************/
+// AVX2 rows. As unpacking works inside each 128 bits lane, the results are reordered before being stored
+__attribute__((target("avx2"))) void storeInterleavedAVX2(__m256i chroma, __m256i luma, uint8_t* dst)
+{
+    auto low = _mm256_unpacklo_epi8(chroma, luma);
+    auto high = _mm256_unpackhi_epi8(chroma, luma);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_permute2x128_si256(low, high, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_permute2x128_si256(low, high, 0x31));
+}
+
+/*************/
+__attribute__((target("avx2"))) void i420RowAVX2(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + 32 <= width; x += 32)
+    {
+        auto uValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x / 2));
+        auto vValues = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x / 2));
+        auto chroma = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi8(uValues, vValues)), _mm_unpackhi_epi8(uValues, vValues), 1);
+        storeInterleavedAVX2(chroma, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x)), dst + 2 * x);
+    }
+    i420RowSSE41(y + x, u + x / 2, v + x / 2, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("avx2"))) void nv12RowAVX2(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width)
+{
+    uint32_t x = 0;
+    for (; x + 32 <= width; x += 32)
+        storeInterleavedAVX2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(uv + x)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + x)), dst + 2 * x);
+    nv12RowSSE41(y + x, uv + x, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("avx2"))) void yuy2RowAVX2(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    const auto mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * x), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x)), mask));
+    yuy2RowSSE41(src + 2 * x, dst + 2 * x, width - x);
+}
+
+/*************/
+__attribute__((target("avx2"))) void bgrRowAVX2(const uint8_t* src, uint8_t* dst, uint32_t width)
+{
+    const auto mask = _mm256_setr_epi8(2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128, 2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+    const auto alpha = _mm256_slli_epi32(_mm256_set1_epi32(0xFF), 24);
+    uint32_t x = 0;
+    // Each lane is loaded with 16 bytes to convert 4 pixels, the last load of a row must not read past its end
+    for (; x + 18 <= width; x += 16)
+    {
+        auto in = src + 3 * x;
+        auto first = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+        auto second = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 24))), _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 36)), 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x), _mm256_or_si256(_mm256_shuffle_epi8(first, mask), alpha));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x + 32), _mm256_or_si256(_mm256_shuffle_epi8(second, mask), alpha));
+    }
+    bgrRowSSE41(src + 3 * x, dst + 4 * x, width - x);
+}
+
+/*************/
+__attribute__((target("avx2"))) void unpack10BitAVX2(const uint16_t* src, uint8_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        auto low = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), 2);
+        auto high = _mm256_srli_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16)), 2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8));
+    }
+    unpack10BitSSE41(src + i, dst + i, count - i);
+}
+#endif
+
+/*************/
+struct Kernels
+{
+    void (*i420Row)(const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+    void (*nv12Row)(const uint8_t*, const uint8_t*, uint8_t*, uint32_t);
+    void (*yuy2Row)(const uint8_t*, uint8_t*, uint32_t);
+    void (*bgrRow)(const uint8_t*, uint8_t*, uint32_t);
+    void (*unpack10Bit)(const uint16_t*, uint8_t*, uint32_t);
+};
+
+const Kernels scalarKernels{i420RowScalar, nv12RowScalar, yuy2RowScalar, bgrRowScalar, unpack10BitScalar};
+#if SPLASH_PIXEL_CONVERSION_X86
+const Kernels sse41Kernels{i420RowSSE41, nv12RowSSE41, yuy2RowSSE41, bgrRowSSE41, unpack10BitSSE41};
+const Kernels avx2Kernels{i420RowAVX2, nv12RowAVX2, yuy2RowAVX2, bgrRowAVX2, unpack10BitAVX2};
+#endif
+
+/*************/
+InstructionSet detectInstructionSet()
+{
+#if SPLASH_PIXEL_CONVERSION_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return InstructionSet::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return InstructionSet::SSE41;
+#endif
+    return InstructionSet::Scalar;
+}
+
+/*************/
+atomic<InstructionSet>& currentInstructionSet()
+{
+    static atomic<InstructionSet> instructionSet{getSupportedInstructionSet()};
+    return instructionSet;
+}
+
+/*************/
+const Kernels& getKernels()
+{
+    switch (currentInstructionSet().load(memory_order_relaxed))
+    {
+    default:
+    case InstructionSet::Scalar:
+        return scalarKernels;
+#if SPLASH_PIXEL_CONVERSION_X86
+    case InstructionSet::SSE41:
+        return sse41Kernels;
+    case InstructionSet::AVX2:
+        return avx2Kernels;
+#endif
+    }
+}
+
+/*************/
+// Split the rows in blocks, run by the thread pool and the calling thread, or all by the calling thread
+void forEachRowBlock(uint32_t rows, bool useThreadPool, const function<void(uint32_t, uint32_t)>& convert)
+{
+    auto& pool = ThreadPool::get();
+    auto blockCount = min<uint32_t>(pool.getWorkerCount() + 1, rows / SPLASH_PIXEL_CONVERSION_ROWS_PER_TASK);
+    if (!useThreadPool || blockCount <= 1)
+    {
+        convert(0, rows);
+        return;
+    }
+
+    vector<future<void>> futures;
+    auto blockSize = (rows + blockCount - 1) / blockCount;
+    for (uint32_t begin = blockSize; begin < rows; begin += blockSize)
+    {
+        auto end = min(begin + blockSize, rows);
+        futures.push_back(pool.enqueue([=, &convert]() { convert(begin, end); }));
+    }
+    convert(0, blockSize);
+    pool.waitAll(futures);
+}
+} // end of anonymous namespace
+
+/*************/
+InstructionSet getSupportedInstructionSet()
+{
+    static const InstructionSet supported = detectInstructionSet();
+    return supported;
+}
+
+/*************/
+InstructionSet getInstructionSet()
+{
+    return currentInstructionSet().load();
+}
+
+/*************/
+bool setInstructionSet(InstructionSet instructionSet)
+{
+    if (static_cast<int>(instructionSet) > static_cast<int>(getSupportedInstructionSet()))
+        return false;
+    currentInstructionSet().store(instructionSet);
+    return true;
+}
+
+/*************/
+void i420ToUYVY(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool)
+{
+    auto row = getKernels().i420Row;
+    auto chromaWidth = width / 2;
+    forEachRowBlock(height, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t line = begin; line < end; ++line)
+            row(y + line * width, u + (line / 2) * chromaWidth, v + (line / 2) * chromaWidth, dst + line * width * 2, width);
+    });
+}
+
+/*************/
+void nv12ToUYVY(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool)
+{
+    auto row = getKernels().nv12Row;
+    forEachRowBlock(height, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t line = begin; line < end; ++line)
+            row(y + line * width, uv + (line / 2) * width, dst + line * width * 2, width);
+    });
+}
+
+/*************/
+void yuy2ToUYVY(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool)
+{
+    auto row = getKernels().yuy2Row;
+    forEachRowBlock(height, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t line = begin; line < end; ++line)
+            row(src + line * width * 2, dst + line * width * 2, width);
+    });
+}
+
+/*************/
+void bgrToRGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool)
+{
+    auto row = getKernels().bgrRow;
+    forEachRowBlock(height, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t line = begin; line < end; ++line)
+            row(src + static_cast<size_t>(line) * width * 3, dst + static_cast<size_t>(line) * width * 4, width);
+    });
+}
+
+/*************/
+void unpack10Bit(const uint16_t* src, uint8_t* dst, size_t count, bool useThreadPool)
+{
+    // Samples are processed by rows of an arbitrary width, to share the splitting with the image conversions
+    const uint32_t rowSize = 4096;
+    auto unpack = getKernels().unpack10Bit;
+    auto rows = static_cast<uint32_t>((count + rowSize - 1) / rowSize);
+    forEachRowBlock(rows, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        auto first = static_cast<size_t>(begin) * rowSize;
+        auto last = min(static_cast<size_t>(end) * rowSize, count);
+        unpack(src + first, dst + first, static_cast<uint32_t>(last - first));
+    });
+}
+
+/*************/
+void copy(const uint8_t* src, uint8_t* dst, size_t size, bool useThreadPool)
+{
+    const uint32_t rowSize = 16384;
+    auto rows = static_cast<uint32_t>((size + rowSize - 1) / rowSize);
+    forEachRowBlock(rows, useThreadPool, [&](uint32_t begin, uint32_t end) {
+        auto first = static_cast<size_t>(begin) * rowSize;
+        auto last = min(static_cast<size_t>(end) * rowSize, size);
+        memcpy(dst + first, src + first, last - first);
+    });
+}
+
+} // end of namespace PixelConversion
+
+} // end of namespace Splash
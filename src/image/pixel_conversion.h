@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * @pixel_conversion.h
+ * Pixel format conversions for the image inputs, vectorized and run in parallel over rows
+ */
+
+#ifndef SPLASH_PIXEL_CONVERSION_H
+#define SPLASH_PIXEL_CONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+#define SPLASH_PIXEL_CONVERSION_ROWS_PER_TASK 64 // Minimum number of rows converted by each task of the thread pool
+
+namespace Splash
+{
+
+namespace PixelConversion
+{
+
+enum class InstructionSet
+{
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+/**
+ * \brief Get the best instruction set supported by the CPU
+ * \return Return the instruction set
+ */
+InstructionSet getSupportedInstructionSet();
+
+/**
+ * \brief Get the instruction set currently used by the conversions
+ * \return Return the instruction set
+ */
+InstructionSet getInstructionSet();
+
+/**
+ * \brief Set the instruction set used by the conversions. By default, the best one supported is used
+ * \param instructionSet Instruction set
+ * \return Return false if the CPU does not support it
+ */
+bool setInstructionSet(InstructionSet instructionSet);
+
+/**
+ * \brief Convert a planar I420 image to packed UYVY
+ * \param y Luma plane, of width x height bytes
+ * \param u U plane, of width/2 x height/2 bytes
+ * \param v V plane, of width/2 x height/2 bytes
+ * \param dst Output, of width x height x 2 bytes
+ * \param width Image width, which has to be even
+ * \param height Image height
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void i420ToUYVY(const uint8_t* y, const uint8_t* u, const uint8_t* v, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool = true);
+
+/**
+ * \brief Convert a semi-planar NV12 image to packed UYVY
+ * \param y Luma plane, of width x height bytes
+ * \param uv Interleaved chroma plane, of width x height/2 bytes
+ * \param dst Output, of width x height x 2 bytes
+ * \param width Image width, which has to be even
+ * \param height Image height
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void nv12ToUYVY(const uint8_t* y, const uint8_t* uv, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool = true);
+
+/**
+ * \brief Convert a packed YUY2 (also named YUYV) image to packed UYVY
+ * \param src Input, of width x height x 2 bytes
+ * \param dst Output, of width x height x 2 bytes
+ * \param width Image width, which has to be even
+ * \param height Image height
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void yuy2ToUYVY(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool = true);
+
+/**
+ * \brief Convert a packed BGR image to RGBA, with an opaque alpha
+ * \param src Input, of width x height x 3 bytes
+ * \param dst Output, of width x height x 4 bytes
+ * \param width Image width
+ * \param height Image height
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void bgrToRGBA(const uint8_t* src, uint8_t* dst, uint32_t width, uint32_t height, bool useThreadPool = true);
+
+/**
+ * \brief Convert 10 bits samples stored in the low bits of 16 bits words to 8 bits
+ * \param src Input samples
+ * \param dst Output samples
+ * \param count Sample count
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void unpack10Bit(const uint16_t* src, uint8_t* dst, size_t count, bool useThreadPool = true);
+
+/**
+ * \brief Copy a buffer, in parallel
+ * \param src Input
+ * \param dst Output
+ * \param size Size in bytes
+ * \param useThreadPool If false, the conversion runs on the calling thread only
+ */
+void copy(const uint8_t* src, uint8_t* dst, size_t size, bool useThreadPool = true);
+
+} // end of namespace PixelConversion
+
+} // end of namespace Splash
+
+#endif // SPLASH_PIXEL_CONVERSION_H
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 
+#include "./core/thread_pool.h"
 #include "./utils/log.h"
 #include "./utils/timer.h"
 #include "./core/world.h"
@@ -30,6 +31,7 @@ Queue::Queue(RootObject* root)
 /*************/
 Queue::~Queue()
 {
+    Timer::get().release("queue_switch_" + _name);
 }
 
 /*************/
@@ -121,44 +123,53 @@ void Queue::update()
         {
             auto& sourceParameters = _playlist[_currentSourceIndex];
 
-            if (!_currentSource || _currentSource->getType() != sourceParameters.type)
-                _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type));
-
-            if (_currentSource)
-                _playing = true;
-            else
-                _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create("image"));
-            dynamic_pointer_cast<Image>(_currentSource)->zero();
-            dynamic_pointer_cast<Image>(_currentSource)->setName(_name + DISTANT_NAME_SUFFIX);
-
-            _currentSource->setAttribute("file", {sourceParameters.filename});
-
-            if (_useClock && !sourceParameters.freeRun)
+            if (_nextSource && _nextSourceIndex == _currentSourceIndex)
             {
-                // If we use the master clock, set a timeshift to be correctly placed in the video
-                // (as the source gets its clock from the same Timer)
-                _currentSource->setAttribute("timeShift", {-(float)sourceParameters.start / 1e6});
-                _currentSource->setAttribute("useClock", {1});
+                // The source has been opened and buffered beforehand, it only has to be resumed
+                // The previous one is released off the update loop, as stopping its reader can take a while
+                auto previousSource = make_shared<shared_ptr<BufferObject>>(std::move(_currentSource));
+                ThreadPool::get().enqueue([previousSource]() { previousSource->reset(); });
+                _currentSource = _nextSource;
+                _currentSource->setAttribute("pause", {0});
+                _currentSourceTimestamp = _nextSourceTimestamp;
+                _playing = true;
             }
             else
             {
-                _currentSource->setAttribute("useClock", {0});
+                if (!_currentSource || _currentSource->getType() != sourceParameters.type)
+                    _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type));
+
+                if (_currentSource)
+                    _playing = true;
+                else
+                    _currentSource = dynamic_pointer_cast<BufferObject>(_factory->create("image"));
+
+                _currentSourceTimestamp = _currentSource->getTimestamp();
+                setupSource(_currentSource, sourceParameters);
             }
 
             _root->sendMessage(_name, "source", {sourceParameters.type});
 
-            for (const auto& arg : sourceParameters.args)
-            {
-                if (!arg.isNamed())
-                    continue;
-
-                _currentSource->setAttribute(arg.getName(), arg.as<Values>());
-            }
+            // The switch latency is measured from the scheduled cut time to the first frame of the new source
+            _switchCutTime = Timer::getTime() - (_currentTime - sourceParameters.start);
+            _switchTime = Timer::getTime();
 
             Log::get() << Log::MESSAGE << "Queue::" << __FUNCTION__ << " - Playing file: " << sourceParameters.filename << Log::endl;
         }
+
+        _nextSource.reset();
+        _nextSourceIndex = -1;
     }
 
+    if (_switchCutTime >= 0 && _currentSource && _currentSource->getTimestamp() != _currentSourceTimestamp)
+    {
+        _switchLatency = max<int64_t>(0, max(_currentSource->getTimestamp(), _switchTime) - _switchCutTime);
+        Timer::get().setDuration("queue_switch_" + _name, _switchLatency);
+        _switchCutTime = -1;
+    }
+
+    prefetchNextSource();
+
     if (!_useClock && !_playlist[_currentSourceIndex].freeRun && _seeked)
     {
         // If we don't use the master clock, we want to seek accordingly in the file
@@ -170,6 +181,75 @@ void Queue::update()
         _currentSource->update();
 }
 
+/*************/
+void Queue::setupSource(const shared_ptr<BufferObject>& source, const Source& sourceParameters)
+{
+    dynamic_pointer_cast<Image>(source)->zero();
+    dynamic_pointer_cast<Image>(source)->setName(_name + DISTANT_NAME_SUFFIX);
+
+    source->setAttribute("file", {sourceParameters.filename});
+
+    if (_useClock && !sourceParameters.freeRun)
+    {
+        // If we use the master clock, set a timeshift to be correctly placed in the video
+        // (as the source gets its clock from the same Timer)
+        source->setAttribute("timeShift", {-(float)sourceParameters.start / 1e6});
+        source->setAttribute("useClock", {1});
+    }
+    else
+    {
+        source->setAttribute("useClock", {0});
+    }
+
+    for (const auto& arg : sourceParameters.args)
+    {
+        if (!arg.isNamed())
+            continue;
+
+        source->setAttribute(arg.getName(), arg.as<Values>());
+    }
+}
+
+/*************/
+void Queue::prefetchNextSource()
+{
+    if (_prefetchWindow <= 0 || _currentSourceIndex < 0 || _currentSourceIndex >= static_cast<int32_t>(_playlist.size()))
+        return;
+
+    // Find the next source, and when it is scheduled
+    auto nextIndex = _currentSourceIndex + 1;
+    int64_t timeToNext = 0;
+    if (nextIndex < static_cast<int32_t>(_playlist.size()))
+    {
+        timeToNext = _playlist[nextIndex].start - _currentTime;
+    }
+    else if (!_useClock && _loop)
+    {
+        nextIndex = 0;
+        timeToNext = _playlist[_currentSourceIndex].stop - _currentTime;
+    }
+    else
+    {
+        return;
+    }
+
+    if (nextIndex == _nextSourceIndex || timeToNext > _prefetchWindow)
+        return;
+
+    // The source is opened paused, so that its reader fills its buffer without the playback starting
+    auto& sourceParameters = _playlist[nextIndex];
+    _nextSourceIndex = nextIndex;
+    _nextSource = dynamic_pointer_cast<BufferObject>(_factory->create(sourceParameters.type));
+    if (!_nextSource)
+        return;
+
+    _nextSource->setAttribute("pause", {1});
+    _nextSourceTimestamp = _nextSource->getTimestamp();
+    setupSource(_nextSource, sourceParameters);
+
+    Log::get() << Log::DEBUGGING << "Queue::" << __FUNCTION__ << " - Prefetching file: " << sourceParameters.filename << Log::endl;
+}
+
 /*************/
 void Queue::cleanPlaylist(vector<Source>& playlist)
 {
@@ -323,6 +403,10 @@ void Queue::registerAttributes()
 
             cleanPlaylist(_playlist);
 
+            // Indices may not match anymore
+            _nextSource.reset();
+            _nextSourceIndex = -1;
+
             return true;
         },
         [&]() -> Values {
@@ -347,6 +431,16 @@ void Queue::registerAttributes()
     setAttributeParameter("playlist", true, true);
     setAttributeDescription("playlist", "Set the playlist as an array of [type, filename, start, end, (args)]");
 
+    addAttribute("prefetchWindow",
+        [&](const Values& args) {
+            _prefetchWindow = static_cast<int64_t>(max(0.f, args[0].as<float>()) * 1e6);
+            return true;
+        },
+        [&]() -> Values { return {(float)_prefetchWindow / 1e6}; },
+        {'n'});
+    setAttributeParameter("prefetchWindow", true, true);
+    setAttributeDescription("prefetchWindow", "Time before its start at which the next source is opened and buffered, in seconds. Set to 0 to disable");
+
     addAttribute("seek",
         [&](const Values& args) {
             int64_t seekTime = args[0].as<float>() * 1e6;
@@ -359,6 +453,13 @@ void Queue::registerAttributes()
     setAttributeParameter("seek", false, true);
     setAttributeDescription("seek", "Seek through the playlist");
 
+    addAttribute("switchLatency",
+        [&](const Values&) { return true; },
+        [&]() -> Values { return {(float)_switchLatency / 1e3}; },
+        {});
+    setAttributeParameter("switchLatency", false, true);
+    setAttributeDescription("switchLatency", "Delay between the scheduled start of the last source and its first frame, in milliseconds");
+
     addAttribute("useClock",
         [&](const Values& args) {
             _useClock = args[0].as<int>();
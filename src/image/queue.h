@@ -116,6 +116,16 @@ class Queue : public BufferObject
     bool _defaultSource{false};
 
     int32_t _currentSourceIndex{-1};
+    int64_t _currentSourceTimestamp{0}; // Timestamp of the current source when it was set up
+
+    std::shared_ptr<BufferObject> _nextSource{nullptr}; // The next source, opened beforehand
+    int32_t _nextSourceIndex{-1};
+    int64_t _nextSourceTimestamp{0};
+    int64_t _prefetchWindow{1000000}; // in us
+
+    int64_t _switchCutTime{-1}; // Scheduled time of the last switch, or -1 if its first frame has been received
+    int64_t _switchTime{0};     // Time at which the last switch happened
+    int64_t _switchLatency{0};  // in us
     bool _playing{false};
 
     bool _loop{false};
@@ -123,6 +133,18 @@ class Queue : public BufferObject
     int64_t _startTime{-1};   // Beginning of the current loop, in us
     int64_t _currentTime{-1}; // Elapsed time since _startTime
 
+    /**
+     * \brief Set up a source from the playlist parameters
+     * \param source Source to set up
+     * \param sourceParameters Playlist parameters
+     */
+    void setupSource(const std::shared_ptr<BufferObject>& source, const Source& sourceParameters);
+
+    /**
+     * \brief Open the next source of the playlist if it starts within the prefetch window
+     */
+    void prefetchNextSource();
+
     /**
      * \brief Clean the playlist for holes and overlaps
      * \param playlist Playlist to clean
@@ -206,6 +228,12 @@ class QueueSurrogate : public Texture
      * \brief Register new functors to modify attributes
      */
     void registerAttributes();
+
+    /**
+     * \brief Get the version of the content of the queue, which is rendered by its inner filter
+     * \return Return the version
+     */
+    uint64_t getContentVersion() const final { return _filter->getGraphVersion(); }
 };
 
 } // end of namespace
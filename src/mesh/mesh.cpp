@@ -1,6 +1,9 @@
 #include "./mesh/mesh.h"
 
+#include <algorithm>
+
 #include "./core/root_object.h"
+#include "./mesh/mesh_optimizer.h"
 #include "./mesh/meshloader.h"
 #include "./utils/log.h"
 #include "./utils/osutils.h"
@@ -106,6 +109,46 @@ vector<float> Mesh::getAnnexe() const
     return annexe;
 }
 
+/*************/
+vector<uint32_t> Mesh::getIndices() const
+{
+    lock_guard<Spinlock> lock(_readMutex);
+    return _mesh.indices;
+}
+
+/*************/
+shared_ptr<const MeshBVH> Mesh::getBVH() const
+{
+    lock_guard<mutex> lockBVH(_bvhMutex);
+
+    vector<glm::vec4> vertices;
+    vector<uint32_t> indices;
+    {
+        lock_guard<Spinlock> lock(_readMutex);
+        if (_bvh && _bvhTimestamp == _timestamp)
+            return _bvh;
+
+        vertices = _mesh.vertices;
+        indices = _mesh.indices;
+        // A deserialized mesh gets its timestamp before being swapped in by update()
+        _bvhTimestamp = _meshUpdated ? -1 : _timestamp;
+    }
+
+    // Deformations keep the triangles, only the bounds need an update. Existing hierarchies are shared, hence the copy
+    if (_bvh)
+    {
+        auto bvh = make_shared<MeshBVH>(*_bvh);
+        if (bvh->refit(vertices, indices))
+        {
+            _bvh = bvh;
+            return _bvh;
+        }
+    }
+
+    _bvh = make_shared<MeshBVH>(vertices, indices);
+    return _bvh;
+}
+
 /*************/
 bool Mesh::read(const string& filename)
 {
@@ -122,6 +165,7 @@ bool Mesh::read(const string& filename)
         mesh.vertices = objLoader.getVertices();
         mesh.uvs = objLoader.getUVs();
         mesh.normals = objLoader.getNormals();
+        mesh.indices = objLoader.getIndices();
 
         lock_guard<shared_timed_mutex> lock(_writeMutex);
         _mesh = mesh;
@@ -145,18 +189,24 @@ shared_ptr<SerializedObject> Mesh::serialize() const
     data.push_back(getUVCoords());
     data.push_back(getNormals());
     data.push_back(getAnnexe());
+    auto indices = getIndices();
 
     lock_guard<Spinlock> lock(_readMutex);
     int nbrVertices = data[0].size() / 4;
-    int totalSize = sizeof(nbrVertices); // We add to all this the total number of vertices
+    int nbrIndices = indices.size();
+    int totalSize = sizeof(nbrVertices) + sizeof(nbrIndices); // We add to all this the total number of vertices and indices
     for (auto& d : data)
         totalSize += d.size() * sizeof(d[0]);
+    totalSize += indices.size() * sizeof(uint32_t);
     obj->resize(totalSize);
 
     auto currentObjPtr = obj->data();
     const char* ptr = reinterpret_cast<const char*>(&nbrVertices);
     copy(ptr, ptr + sizeof(nbrVertices), currentObjPtr);
     currentObjPtr += sizeof(nbrVertices);
+    ptr = reinterpret_cast<const char*>(&nbrIndices);
+    copy(ptr, ptr + sizeof(nbrIndices), currentObjPtr);
+    currentObjPtr += sizeof(nbrIndices);
 
     for (auto& d : data)
     {
@@ -165,6 +215,9 @@ shared_ptr<SerializedObject> Mesh::serialize() const
         currentObjPtr += d.size() * sizeof(float);
     }
 
+    ptr = reinterpret_cast<const char*>(indices.data());
+    copy(ptr, ptr + indices.size() * sizeof(uint32_t), currentObjPtr);
+
     if (Timer::get().isDebug())
         Timer::get() >> ("serialize " + _name);
 
@@ -180,15 +233,24 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
     if (Timer::get().isDebug())
         Timer::get() << "deserialize " + _name;
 
-    // First, we get the number of vertices
-    int nbrVertices;
-    char* ptr = reinterpret_cast<char*>(&nbrVertices);
+    // First, we get the number of vertices and indices
+    int nbrVertices, nbrIndices;
+    if (obj->size() < sizeof(nbrVertices) + sizeof(nbrIndices))
+    {
+        Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Bad buffer received, discarding" << Log::endl;
+        return false;
+    }
 
     auto currentObjPtr = obj->data();
+    char* ptr = reinterpret_cast<char*>(&nbrVertices);
     copy(currentObjPtr, currentObjPtr + sizeof(nbrVertices), ptr); // This will fail if float have different size between sender and receiver
     currentObjPtr += sizeof(nbrVertices);
+    ptr = reinterpret_cast<char*>(&nbrIndices);
+    copy(currentObjPtr, currentObjPtr + sizeof(nbrIndices), ptr);
+    currentObjPtr += sizeof(nbrIndices);
 
-    if (nbrVertices < 0 || nbrVertices > static_cast<int>(obj->size()))
+    auto baseSize = sizeof(nbrVertices) + sizeof(nbrIndices) + static_cast<size_t>(nbrVertices) * 10 * sizeof(float) + static_cast<size_t>(nbrIndices) * sizeof(uint32_t);
+    if (nbrVertices < 0 || nbrIndices < 0 || baseSize > obj->size())
     {
         Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Bad buffer received, discarding" << Log::endl;
         return false;
@@ -200,7 +262,7 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
     data.push_back(vector<float>(nbrVertices * 4));
 
     bool hasAnnexe = false;
-    if (obj->size() > static_cast<uint32_t>(nbrVertices) * 4 * 14) // Check whether there is an annexe buffer in all this
+    if (obj->size() >= baseSize + static_cast<size_t>(nbrVertices) * 4 * sizeof(float)) // Check whether there is an annexe buffer in all this
     {
         hasAnnexe = true;
         data.push_back(vector<float>(nbrVertices * 4));
@@ -216,6 +278,16 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
             currentObjPtr += d.size() * sizeof(float);
         }
 
+        vector<uint32_t> indices(nbrIndices);
+        ptr = reinterpret_cast<char*>(indices.data());
+        copy(currentObjPtr, currentObjPtr + indices.size() * sizeof(uint32_t), ptr);
+
+        if (indices.size() % 3 != 0 || any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= static_cast<uint32_t>(nbrVertices); }))
+        {
+            Log::get() << Log::WARNING << "Mesh::" << __FUNCTION__ << " - Received indices do not match the vertices, discarding" << Log::endl;
+            return false;
+        }
+
         // Next step: use these values to reset the vertices of _mesh
         MeshContainer mesh;
 
@@ -255,6 +327,8 @@ bool Mesh::deserialize(const shared_ptr<SerializedObject>& obj)
             }
         }
 
+        mesh.indices = std::move(indices);
+
         _bufferMesh = mesh;
         _meshUpdated = true;
 
@@ -294,8 +368,6 @@ void Mesh::createDefaultMesh(int subdiv)
         subdiv = 0;
     _planeSubdivisions = subdiv;
 
-    MeshContainer mesh;
-
     vector<glm::vec2> positions;
     vector<glm::vec2> uvs;
 
@@ -317,39 +389,49 @@ void Mesh::createDefaultMesh(int subdiv)
         }
     }
 
-    for (int v = 0; v < subdiv + 1; ++v)
+    auto mesh = createGridMesh(positions, uvs, subdiv + 2, subdiv + 2);
+
+    lock_guard<shared_timed_mutex> lock(_writeMutex);
+    _mesh = std::move(mesh);
+
+    updateTimestamp();
+}
+
+/*************/
+Mesh::MeshContainer Mesh::createGridMesh(const vector<glm::vec2>& positions, const vector<glm::vec2>& uvs, int width, int height)
+{
+    MeshContainer mesh;
+    if (width < 2 || height < 2 || positions.size() != static_cast<size_t>(width * height) || uvs.size() != positions.size())
+        return mesh;
+
+    for (size_t i = 0; i < positions.size(); ++i)
     {
-        for (int u = 0; u < subdiv + 1; ++u)
+        mesh.vertices.push_back(glm::vec4(positions[i], 0.0, 1.0));
+        mesh.uvs.push_back(uvs[i]);
+        mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
+    }
+
+    for (int v = 0; v < height - 1; ++v)
+    {
+        for (int u = 0; u < width - 1; ++u)
         {
-            mesh.vertices.push_back(glm::vec4(positions[u + v * (subdiv + 2)], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(positions[u + 1 + v * (subdiv + 2)], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(positions[u + (v + 1) * (subdiv + 2)], 0.0, 1.0));
-
-            mesh.vertices.push_back(glm::vec4(positions[u + 1 + v * (subdiv + 2)], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(positions[u + 1 + (v + 1) * (subdiv + 2)], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(positions[u + (v + 1) * (subdiv + 2)], 0.0, 1.0));
-
-            mesh.uvs.push_back(uvs[u + v * (subdiv + 2)]);
-            mesh.uvs.push_back(uvs[u + 1 + v * (subdiv + 2)]);
-            mesh.uvs.push_back(uvs[u + (v + 1) * (subdiv + 2)]);
-
-            mesh.uvs.push_back(uvs[u + 1 + v * (subdiv + 2)]);
-            mesh.uvs.push_back(uvs[u + 1 + (v + 1) * (subdiv + 2)]);
-            mesh.uvs.push_back(uvs[u + (v + 1) * (subdiv + 2)]);
-
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
+            uint32_t topLeft = u + v * width;
+            uint32_t bottomLeft = u + (v + 1) * width;
+
+            mesh.indices.push_back(topLeft);
+            mesh.indices.push_back(topLeft + 1);
+            mesh.indices.push_back(bottomLeft);
+
+            mesh.indices.push_back(topLeft + 1);
+            mesh.indices.push_back(bottomLeft + 1);
+            mesh.indices.push_back(bottomLeft);
         }
     }
 
-    lock_guard<shared_timed_mutex> lock(_writeMutex);
-    _mesh = std::move(mesh);
+    // Rows wider than the post-transform cache do not reuse the vertices of the previous row
+    mesh.indices = MeshOptimizer::optimizeVertexCache(mesh.indices, mesh.vertices.size());
 
-    updateTimestamp();
+    return mesh;
 }
 
 /*************/
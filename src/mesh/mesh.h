@@ -36,6 +36,7 @@
 #include "./core/attribute.h"
 #include "./core/buffer_object.h"
 #include "./core/coretypes.h"
+#include "./mesh/mesh_bvh.h"
 
 namespace Splash
 {
@@ -92,6 +93,18 @@ class Mesh : public BufferObject
      */
     virtual std::vector<float> getAnnexe() const;
 
+    /**
+     * \brief Get the indices of the vertices forming the triangles of the mesh
+     * \return Return the indices, or an empty vector if the vertices are listed triangle by triangle
+     */
+    virtual std::vector<uint32_t> getIndices() const;
+
+    /**
+     * \brief Get the bounding volume hierarchy of the mesh, built again or refitted if the mesh changed since the last call
+     * \return Return the hierarchy, which is not modified afterwards and can be kept while the mesh changes
+     */
+    std::shared_ptr<const MeshBVH> getBVH() const;
+
     /**
      * \brief Read / update the mesh
      * \param filename File to load from
@@ -124,6 +137,7 @@ class Mesh : public BufferObject
         std::vector<glm::vec2> uvs;
         std::vector<glm::vec3> normals;
         std::vector<glm::vec4> annexe;
+        std::vector<uint32_t> indices; //!< Triangle list, empty for meshes fed as independent triangles
     };
 
     std::string _filepath{};
@@ -133,11 +147,25 @@ class Mesh : public BufferObject
     bool _benchmark{false};
     int _planeSubdivisions{0};
 
+    mutable std::mutex _bvhMutex{};
+    mutable std::shared_ptr<const MeshBVH> _bvh{nullptr};
+    mutable int64_t _bvhTimestamp{-1};
+
     /**
      * \brief Register new functors to modify attributes
      */
     void registerAttributes();
 
+    /**
+     * \brief Create an indexed mesh from a grid of vertices, in the XY plane
+     * \param positions Vertex positions, row by row
+     * \param uvs Vertex UV coordinates, same order as positions
+     * \param width Number of vertices per row
+     * \param height Number of rows
+     * \return Return the mesh
+     */
+    static MeshContainer createGridMesh(const std::vector<glm::vec2>& positions, const std::vector<glm::vec2>& uvs, int width, int height);
+
   private:
     void init();
 
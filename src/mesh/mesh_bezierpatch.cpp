@@ -117,36 +117,7 @@ void Mesh_BezierPatch::createPatch(Patch& patch)
     _patch = patch;
     _patchUpdated = true;
 
-    MeshContainer mesh;
-    for (int v = 0; v < height - 1; ++v)
-    {
-        for (int u = 0; u < width - 1; ++u)
-        {
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + v * width], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + 1 + v * width], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + (v + 1) * width], 0.0, 1.0));
-
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + 1 + (v + 1) * width], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + (v + 1) * width], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(patch.vertices[u + 1 + v * width], 0.0, 1.0));
-
-            mesh.uvs.push_back(patch.uvs[u + v * width]);
-            mesh.uvs.push_back(patch.uvs[u + 1 + v * width]);
-            mesh.uvs.push_back(patch.uvs[u + (v + 1) * width]);
-
-            mesh.uvs.push_back(patch.uvs[u + 1 + (v + 1) * width]);
-            mesh.uvs.push_back(patch.uvs[u + (v + 1) * width]);
-            mesh.uvs.push_back(patch.uvs[u + 1 + v * width]);
-
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-        }
-    }
-    _bezierControl = mesh;
+    _bezierControl = createGridMesh(patch.vertices, patch.uvs, width, height);
 
     updateTimestamp();
 }
@@ -202,35 +173,7 @@ void Mesh_BezierPatch::updatePatch()
     }
 
     // Create the mesh
-    MeshContainer mesh;
-    for (int v = 0; v < _patchResolution - 1; ++v)
-    {
-        for (int u = 0; u < _patchResolution - 1; ++u)
-        {
-            mesh.vertices.push_back(glm::vec4(vertices[u + v * _patchResolution], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(vertices[u + 1 + v * _patchResolution], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(vertices[u + (v + 1) * _patchResolution], 0.0, 1.0));
-
-            mesh.vertices.push_back(glm::vec4(vertices[u + 1 + v * _patchResolution], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(vertices[u + 1 + (v + 1) * _patchResolution], 0.0, 1.0));
-            mesh.vertices.push_back(glm::vec4(vertices[u + (v + 1) * _patchResolution], 0.0, 1.0));
-
-            mesh.uvs.push_back(uvs[u + v * _patchResolution]);
-            mesh.uvs.push_back(uvs[u + 1 + v * _patchResolution]);
-            mesh.uvs.push_back(uvs[u + (v + 1) * _patchResolution]);
-
-            mesh.uvs.push_back(uvs[u + 1 + v * _patchResolution]);
-            mesh.uvs.push_back(uvs[u + 1 + (v + 1) * _patchResolution]);
-            mesh.uvs.push_back(uvs[u + (v + 1) * _patchResolution]);
-
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-            mesh.normals.push_back(glm::vec3(0.0, 0.0, 1.0));
-        }
-    }
+    auto mesh = createGridMesh(vertices, uvs, _patchResolution, _patchResolution);
 
     _bufferMesh = mesh;
     _bezierMesh = mesh;
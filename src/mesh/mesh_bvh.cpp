@@ -0,0 +1,334 @@
+#include "./mesh/mesh_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+/*************/
+double distanceToBox(const glm::dvec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+    double squaredDistance = 0.0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        double delta = max({static_cast<double>(boxMin[axis]) - point[axis], 0.0, point[axis] - static_cast<double>(boxMax[axis])});
+        squaredDistance += delta * delta;
+    }
+    return squaredDistance;
+}
+
+/*************/
+bool intersectBox(const glm::dvec3& origin, const glm::dvec3& invDirection, const glm::vec3& boxMin, const glm::vec3& boxMax, double maxDistance, double& entry)
+{
+    double tMin = 0.0;
+    double tMax = maxDistance;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        // Parallel to the slab, where 0 * inf would give NaN for an origin on one of its planes
+        if (std::isinf(invDirection[axis]))
+        {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+                return false;
+            continue;
+        }
+
+        double t0 = (boxMin[axis] - origin[axis]) * invDirection[axis];
+        double t1 = (boxMax[axis] - origin[axis]) * invDirection[axis];
+        if (t0 > t1)
+            swap(t0, t1);
+        tMin = max(tMin, t0);
+        tMax = min(tMax, t1);
+        if (tMin > tMax)
+            return false;
+    }
+    entry = tMin;
+    return true;
+}
+} // end of anonymous namespace
+
+/*************/
+MeshBVH::MeshBVH(const vector<glm::vec4>& vertices, const vector<uint32_t>& indices)
+{
+    if (!setTriangles(vertices, indices) || _indices.empty())
+        return;
+
+    auto triangleCount = static_cast<uint32_t>(_indices.size() / 3);
+    vector<glm::vec3> centroids(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        const auto& a = _vertices[_indices[t * 3]];
+        const auto& b = _vertices[_indices[t * 3 + 1]];
+        const auto& c = _vertices[_indices[t * 3 + 2]];
+        for (int axis = 0; axis < 3; ++axis)
+            centroids[t][axis] = (a[axis] + b[axis] + c[axis]) / 3.f;
+    }
+
+    _triangleOrder.resize(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+        _triangleOrder[t] = t;
+
+    // A binary tree with leaves of at least half the maximum size has less than this many nodes
+    _nodes.reserve(4 * triangleCount / SPLASH_MESH_BVH_LEAF_SIZE + 1);
+    build(0, triangleCount, centroids);
+}
+
+/*************/
+bool MeshBVH::refit(const vector<glm::vec4>& vertices, const vector<uint32_t>& indices)
+{
+    if (vertices.size() != _vertices.size())
+        return false;
+    if (indices.empty() ? _indices.size() != vertices.size() - vertices.size() % 3 : indices != _indices)
+        return false;
+
+    for (size_t v = 0; v < vertices.size(); ++v)
+        _vertices[v] = glm::vec3(vertices[v][0], vertices[v][1], vertices[v][2]);
+
+    // Children come after their parent, so going backward updates them first
+    for (auto nodeIndex = _nodes.size(); nodeIndex-- > 0;)
+    {
+        auto& node = _nodes[nodeIndex];
+        if (node.count != 0)
+        {
+            computeLeafBounds(node);
+            continue;
+        }
+
+        const auto& left = _nodes[nodeIndex + 1];
+        const auto& right = _nodes[node.first];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            node.min[axis] = min(left.min[axis], right.min[axis]);
+            node.max[axis] = max(left.max[axis], right.max[axis]);
+        }
+    }
+
+    return true;
+}
+
+/*************/
+float MeshBVH::nearestVertex(const glm::dvec3& point, glm::dvec3& vertex) const
+{
+    if (_nodes.empty())
+        return numeric_limits<float>::max();
+
+    double bestDistance = numeric_limits<double>::max();
+    uint32_t bestVertex = 0;
+
+    vector<uint32_t> stack{0};
+    while (!stack.empty())
+    {
+        auto nodeIndex = stack.back();
+        const auto& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        if (distanceToBox(point, node.min, node.max) >= bestDistance)
+            continue;
+
+        if (node.count != 0)
+        {
+            for (uint32_t t = node.first; t < node.first + node.count; ++t)
+            {
+                for (uint32_t i = 0; i < 3; ++i)
+                {
+                    auto index = _indices[_triangleOrder[t] * 3 + i];
+                    auto delta = glm::dvec3(_vertices[index]) - point;
+                    auto distance = glm::dot(delta, delta);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestVertex = index;
+                    }
+                }
+            }
+            continue;
+        }
+
+        // Visit the closest child first, so that the other one is more likely to be culled
+        uint32_t left = nodeIndex + 1;
+        uint32_t right = node.first;
+        if (distanceToBox(point, _nodes[left].min, _nodes[left].max) < distanceToBox(point, _nodes[right].min, _nodes[right].max))
+            swap(left, right);
+        stack.push_back(left);
+        stack.push_back(right);
+    }
+
+    vertex = glm::dvec3(_vertices[bestVertex]);
+    return static_cast<float>(sqrt(bestDistance));
+}
+
+/*************/
+bool MeshBVH::intersectRay(const glm::dvec3& origin, const glm::dvec3& direction, RayHit& hit, double maxDistance) const
+{
+    if (_nodes.empty())
+        return false;
+
+    glm::dvec3 invDirection;
+    for (int axis = 0; axis < 3; ++axis)
+        invDirection[axis] = 1.0 / direction[axis];
+
+    RayHit closest;
+    closest.distance = maxDistance;
+    bool found = false;
+
+    vector<uint32_t> stack{0};
+    while (!stack.empty())
+    {
+        auto nodeIndex = stack.back();
+        const auto& node = _nodes[nodeIndex];
+        stack.pop_back();
+
+        double entry;
+        if (!intersectBox(origin, invDirection, node.min, node.max, closest.distance, entry))
+            continue;
+
+        if (node.count == 0)
+        {
+            stack.push_back(node.first);
+            stack.push_back(nodeIndex + 1);
+            continue;
+        }
+
+        // Möller-Trumbore intersection, accepting both windings
+        for (uint32_t t = node.first; t < node.first + node.count; ++t)
+        {
+            auto triangle = _triangleOrder[t];
+            auto a = glm::dvec3(_vertices[_indices[triangle * 3]]);
+            auto edge1 = glm::dvec3(_vertices[_indices[triangle * 3 + 1]]) - a;
+            auto edge2 = glm::dvec3(_vertices[_indices[triangle * 3 + 2]]) - a;
+
+            auto p = glm::cross(direction, edge2);
+            auto determinant = glm::dot(edge1, p);
+            if (abs(determinant) < numeric_limits<double>::epsilon())
+                continue;
+
+            auto invDeterminant = 1.0 / determinant;
+            auto s = origin - a;
+            auto u = glm::dot(s, p) * invDeterminant;
+            if (u < 0.0 || u > 1.0)
+                continue;
+
+            auto q = glm::cross(s, edge1);
+            auto v = glm::dot(direction, q) * invDeterminant;
+            if (v < 0.0 || u + v > 1.0)
+                continue;
+
+            auto distance = glm::dot(edge2, q) * invDeterminant;
+            if (distance < 0.0 || distance >= closest.distance)
+                continue;
+
+            closest.distance = distance;
+            closest.triangle = triangle;
+            closest.barycentric = glm::dvec2(u, v);
+            found = true;
+        }
+    }
+
+    if (!found)
+        return false;
+
+    closest.position = origin + closest.distance * direction;
+    hit = closest;
+    return true;
+}
+
+/*************/
+bool MeshBVH::setTriangles(const vector<glm::vec4>& vertices, const vector<uint32_t>& indices)
+{
+    if (indices.size() % 3 != 0 || any_of(indices.begin(), indices.end(), [&](uint32_t index) { return index >= vertices.size(); }))
+        return false;
+
+    _vertices.resize(vertices.size());
+    for (size_t v = 0; v < vertices.size(); ++v)
+        _vertices[v] = glm::vec3(vertices[v][0], vertices[v][1], vertices[v][2]);
+
+    if (!indices.empty())
+    {
+        _indices = indices;
+    }
+    else
+    {
+        _indices.resize(vertices.size() - vertices.size() % 3);
+        for (uint32_t i = 0; i < _indices.size(); ++i)
+            _indices[i] = i;
+    }
+
+    return true;
+}
+
+/*************/
+void MeshBVH::build(uint32_t first, uint32_t count, const vector<glm::vec3>& centroids)
+{
+    auto nodeIndex = static_cast<uint32_t>(_nodes.size());
+    _nodes.emplace_back();
+
+    glm::vec3 centroidMin(numeric_limits<float>::max());
+    glm::vec3 centroidMax(-numeric_limits<float>::max());
+    for (uint32_t t = first; t < first + count; ++t)
+    {
+        const auto& centroid = centroids[_triangleOrder[t]];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            centroidMin[axis] = min(centroidMin[axis], centroid[axis]);
+            centroidMax[axis] = max(centroidMax[axis], centroid[axis]);
+        }
+    }
+
+    int splitAxis = 0;
+    for (int axis = 1; axis < 3; ++axis)
+        if (centroidMax[axis] - centroidMin[axis] > centroidMax[splitAxis] - centroidMin[splitAxis])
+            splitAxis = axis;
+
+    // Triangles sharing the same centroid can not be split further
+    if (count <= SPLASH_MESH_BVH_LEAF_SIZE || centroidMax[splitAxis] == centroidMin[splitAxis])
+    {
+        _nodes[nodeIndex].first = first;
+        _nodes[nodeIndex].count = count;
+        computeLeafBounds(_nodes[nodeIndex]);
+        return;
+    }
+
+    // Median split along the largest extent of the centroids
+    auto begin = _triangleOrder.begin() + first;
+    auto middle = begin + count / 2;
+    nth_element(begin, middle, begin + count, [&](uint32_t lhs, uint32_t rhs) { return centroids[lhs][splitAxis] < centroids[rhs][splitAxis]; });
+
+    build(first, count / 2, centroids);
+    auto rightIndex = static_cast<uint32_t>(_nodes.size());
+    build(first + count / 2, count - count / 2, centroids);
+
+    auto& node = _nodes[nodeIndex];
+    const auto& left = _nodes[nodeIndex + 1];
+    const auto& right = _nodes[rightIndex];
+    node.first = rightIndex;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        node.min[axis] = min(left.min[axis], right.min[axis]);
+        node.max[axis] = max(left.max[axis], right.max[axis]);
+    }
+}
+
+/*************/
+void MeshBVH::computeLeafBounds(Node& node) const
+{
+    node.min = glm::vec3(numeric_limits<float>::max());
+    node.max = glm::vec3(-numeric_limits<float>::max());
+    for (uint32_t t = node.first; t < node.first + node.count; ++t)
+    {
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            const auto& vertex = _vertices[_indices[_triangleOrder[t] * 3 + i]];
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                node.min[axis] = min(node.min[axis], vertex[axis]);
+                node.max[axis] = max(node.max[axis], vertex[axis]);
+            }
+        }
+    }
+}
+
+} // end of namespace
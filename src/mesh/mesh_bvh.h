@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mesh_bvh.h
+ * Bounding volume hierarchy over the triangles of a mesh, for nearest vertex and ray queries
+ */
+
+#ifndef SPLASH_MESH_BVH_H
+#define SPLASH_MESH_BVH_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#define SPLASH_MESH_BVH_LEAF_SIZE 4 // Maximum number of triangles per leaf
+
+namespace Splash
+{
+
+class MeshBVH
+{
+  public:
+    struct RayHit
+    {
+        double distance{std::numeric_limits<double>::max()}; //!< Distance along the ray, in units of the ray direction
+        uint32_t triangle{0};                                 //!< Index of the triangle, in the mesh triangle list
+        glm::dvec3 position{};                               //!< Hit position, in mesh coordinates
+        glm::dvec2 barycentric{};                            //!< Barycentric coordinates of the hit, relatively to the second and third vertices
+    };
+
+    /**
+     * \brief Constructor, which builds the hierarchy
+     * \param vertices Vertex positions
+     * \param indices Triangle list indices. If empty, vertices are read three by three as independent triangles
+     */
+    MeshBVH(const std::vector<glm::vec4>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+     * \brief Update the bounds after the vertices moved, keeping the tree structure
+     * \param vertices New vertex positions
+     * \param indices Triangle list indices
+     * \return Return false if the triangles differ from the ones the hierarchy was built from, in which case it has to be built again
+     */
+    bool refit(const std::vector<glm::vec4>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+     * \brief Get the number of triangles in the hierarchy
+     * \return Return the triangle count
+     */
+    size_t getTriangleCount() const { return _triangleOrder.size(); }
+
+    /**
+     * \brief Find the vertex closest to the given point. Vertices not used by any triangle are ignored
+     * \param point Point to look around, in mesh coordinates
+     * \param vertex Closest vertex, left untouched if the mesh is empty
+     * \return Return the distance to the closest vertex, or the max float value if the mesh is empty
+     */
+    float nearestVertex(const glm::dvec3& point, glm::dvec3& vertex) const;
+
+    /**
+     * \brief Find the first intersection between a ray and the mesh triangles, whatever their winding
+     * \param origin Ray origin, in mesh coordinates
+     * \param direction Ray direction
+     * \param hit Closest hit along the ray, left untouched if there is none
+     * \param maxDistance Hits farther than this distance are ignored
+     * \return Return true if the ray hits the mesh
+     */
+    bool intersectRay(const glm::dvec3& origin, const glm::dvec3& direction, RayHit& hit, double maxDistance = std::numeric_limits<double>::max()) const;
+
+  private:
+    struct Node
+    {
+        glm::vec3 min{};
+        glm::vec3 max{};
+        uint32_t first{0}; //!< First triangle for a leaf, second child for an inner node, the first one being right after its parent
+        uint32_t count{0}; //!< Triangle count, 0 for inner nodes
+    };
+
+    std::vector<glm::vec3> _vertices{};
+    std::vector<uint32_t> _indices{};
+    std::vector<uint32_t> _triangleOrder{}; //!< Triangles sorted by leaf
+    std::vector<Node> _nodes{};              //!< Nodes in depth-first order, children always coming after their parent
+
+    /**
+     * \brief Copy the positions and triangles, generating the indices for meshes without
+     * \param vertices Vertex positions
+     * \param indices Triangle list indices
+     * \return Return false if the indices are not a valid triangle list, in which case the mesh is left empty
+     */
+    bool setTriangles(const std::vector<glm::vec4>& vertices, const std::vector<uint32_t>& indices);
+
+    /**
+     * \brief Build the subtree holding the given range of _triangleOrder
+     * \param first First triangle of the range
+     * \param count Triangle count
+     * \param centroids Centroid of every triangle
+     */
+    void build(uint32_t first, uint32_t count, const std::vector<glm::vec3>& centroids);
+
+    /**
+     * \brief Set the bounds of a leaf from its triangles
+     * \param node Leaf to update
+     */
+    void computeLeafBounds(Node& node) const;
+};
+
+} // end of namespace
+
+#endif // SPLASH_MESH_BVH_H
@@ -0,0 +1,217 @@
+#include "./mesh/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+namespace Splash
+{
+namespace MeshOptimizer
+{
+
+namespace
+{
+const float cacheDecayPower = 1.5f;
+const float lastTriangleScore = 0.75f;
+const float valenceBoostScale = 2.f;
+const float valenceBoostPower = 0.5f;
+const uint32_t invalidTriangle = numeric_limits<uint32_t>::max();
+
+/*************/
+float computeVertexScore(int cachePosition, uint32_t remainingTriangles)
+{
+    // Vertices with no triangle left to draw are of no interest
+    if (remainingTriangles == 0)
+        return -1.f;
+
+    float score = 0.f;
+    if (cachePosition >= 0)
+    {
+        // Vertices of the last triangle get a fixed score, so that the next one does not share its three vertices
+        if (cachePosition < 3)
+            score = lastTriangleScore;
+        else
+            score = pow(1.f - static_cast<float>(cachePosition - 3) / static_cast<float>(SPLASH_MESH_VERTEX_CACHE_SIZE - 3), cacheDecayPower);
+    }
+
+    // Favor vertices with few triangles left, to avoid leaving isolated triangles behind
+    score += valenceBoostScale * pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+    return score;
+}
+
+/*************/
+bool isValidTriangleList(const vector<uint32_t>& indices, size_t vertexCount)
+{
+    if (indices.size() % 3 != 0)
+        return false;
+    return all_of(indices.begin(), indices.end(), [&](uint32_t index) { return index < vertexCount; });
+}
+} // end of anonymous namespace
+
+/*************/
+vector<uint32_t> optimizeVertexCache(const vector<uint32_t>& indices, size_t vertexCount)
+{
+    if (indices.empty() || !isValidTriangleList(indices, vertexCount))
+        return indices;
+
+    auto triangleCount = indices.size() / 3;
+
+    // Triangles using each vertex, the ones still to be drawn being kept first
+    vector<uint32_t> remainingTriangles(vertexCount, 0);
+    for (auto index : indices)
+        ++remainingTriangles[index];
+
+    vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remainingTriangles[v];
+
+    vector<uint32_t> adjacency(indices.size());
+    {
+        vector<uint32_t> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        vertexScores[v] = computeVertexScore(-1, remainingTriangles[v]);
+
+    vector<bool> triangleEmitted(triangleCount, false);
+    uint32_t bestTriangle = 0;
+    float bestScore = -numeric_limits<float>::max();
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        auto score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if (score > bestScore)
+        {
+            bestScore = score;
+            bestTriangle = static_cast<uint32_t>(t);
+        }
+    }
+
+    vector<uint32_t> cache;
+    vector<uint32_t> nextCache;
+    cache.reserve(SPLASH_MESH_VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(SPLASH_MESH_VERTEX_CACHE_SIZE + 3);
+
+    vector<uint32_t> optimized;
+    optimized.reserve(indices.size());
+    size_t scanCursor = 0;
+
+    while (optimized.size() < indices.size())
+    {
+        // When no triangle in the cache is left, start again from the first one not yet drawn
+        if (bestTriangle == invalidTriangle)
+        {
+            while (triangleEmitted[scanCursor])
+                ++scanCursor;
+            bestTriangle = static_cast<uint32_t>(scanCursor);
+        }
+
+        triangleEmitted[bestTriangle] = true;
+        const uint32_t* triangle = &indices[bestTriangle * 3];
+
+        nextCache.clear();
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            auto vertex = triangle[i];
+            optimized.push_back(vertex);
+            if (find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+                nextCache.push_back(vertex);
+
+            // Move the emitted triangle past the ones still to be drawn
+            auto first = adjacency.begin() + adjacencyOffsets[vertex];
+            auto last = first + remainingTriangles[vertex];
+            auto triangleIt = find(first, last, bestTriangle);
+            if (triangleIt != last)
+            {
+                iter_swap(triangleIt, last - 1);
+                --remainingTriangles[vertex];
+            }
+        }
+
+        // The vertices of the emitted triangle go to the front of the cache, the others are pushed back
+        for (auto vertex : cache)
+            if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+                nextCache.push_back(vertex);
+        cache.swap(nextCache);
+
+        for (size_t i = SPLASH_MESH_VERTEX_CACHE_SIZE; i < cache.size(); ++i)
+            vertexScores[cache[i]] = computeVertexScore(-1, remainingTriangles[cache[i]]);
+
+        for (size_t i = 0; i < min<size_t>(cache.size(), SPLASH_MESH_VERTEX_CACHE_SIZE); ++i)
+            vertexScores[cache[i]] = computeVertexScore(static_cast<int>(i), remainingTriangles[cache[i]]);
+
+        // Update the score of the triangles touched by the cache change, and pick the best one
+        bestTriangle = invalidTriangle;
+        bestScore = -numeric_limits<float>::max();
+        for (auto vertex : cache)
+        {
+            for (uint32_t a = 0; a < remainingTriangles[vertex]; ++a)
+            {
+                auto t = adjacency[adjacencyOffsets[vertex] + a];
+                auto score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        if (cache.size() > SPLASH_MESH_VERTEX_CACHE_SIZE)
+            cache.resize(SPLASH_MESH_VERTEX_CACHE_SIZE);
+    }
+
+    return optimized;
+}
+
+/*************/
+vector<uint32_t> optimizeVertexFetch(vector<uint32_t>& indices, size_t vertexCount)
+{
+    const uint32_t unused = numeric_limits<uint32_t>::max();
+    vector<uint32_t> remap(vertexCount, unused);
+    if (!isValidTriangleList(indices, vertexCount))
+    {
+        for (size_t v = 0; v < vertexCount; ++v)
+            remap[v] = static_cast<uint32_t>(v);
+        return remap;
+    }
+
+    uint32_t nextVertex = 0;
+    for (auto& index : indices)
+    {
+        if (remap[index] == unused)
+            remap[index] = nextVertex++;
+        index = remap[index];
+    }
+
+    for (auto& vertex : remap)
+        if (vertex == unused)
+            vertex = nextVertex++;
+
+    return remap;
+}
+
+/*************/
+float computeACMR(const vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+{
+    if (indices.size() < 3 || !isValidTriangleList(indices, vertexCount))
+        return 0.f;
+
+    // Each vertex stores the transform count at which it entered the cache
+    vector<uint64_t> cacheTimestamps(vertexCount, 0);
+    uint64_t transformCount = 0;
+    for (auto index : indices)
+    {
+        if (cacheTimestamps[index] == 0 || transformCount - cacheTimestamps[index] >= cacheSize)
+            cacheTimestamps[index] = ++transformCount;
+    }
+
+    return static_cast<float>(transformCount) / static_cast<float>(indices.size() / 3);
+}
+
+} // end of namespace
+} // end of namespace
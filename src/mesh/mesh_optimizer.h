@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @mesh_optimizer.h
+ * Reordering of indexed triangle meshes, to make the best use of the GPU vertex caches
+ */
+
+#ifndef SPLASH_MESH_OPTIMIZER_H
+#define SPLASH_MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define SPLASH_MESH_VERTEX_CACHE_SIZE 32 // Size of the simulated post-transform cache
+
+namespace Splash
+{
+namespace MeshOptimizer
+{
+
+/**
+ * \brief Reorder the triangles so that consecutive triangles share their vertices as much as possible,
+ * following Tom Forsyth's "Linear-speed vertex cache optimisation"
+ * \param indices Triangle list indices
+ * \param vertexCount Number of vertices referenced by the indices
+ * \return Return the reordered indices, or the input indices if they are not a valid triangle list
+ */
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+/**
+ * \brief Renumber the vertices in the order in which they are first used, so that vertex fetches are mostly linear
+ * \param indices Triangle list indices, updated in place
+ * \param vertexCount Number of vertices referenced by the indices
+ * \return Return the new index of each vertex, unused vertices being moved to the end
+ */
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+/**
+ * \brief Move the vertices to the position given by a remap table
+ * \param vertices Vertex attribute, updated in place
+ * \param remap New index of each vertex, as returned by optimizeVertexFetch
+ */
+template <typename T>
+void remapVertices(std::vector<T>& vertices, const std::vector<uint32_t>& remap)
+{
+    if (vertices.size() != remap.size())
+        return;
+
+    std::vector<T> remapped(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+        remapped[remap[i]] = vertices[i];
+    vertices.swap(remapped);
+}
+
+/**
+ * \brief Compute the average number of vertices transformed per triangle, with a FIFO cache of the given size
+ * \param indices Triangle list indices
+ * \param vertexCount Number of vertices referenced by the indices
+ * \param cacheSize Simulated cache size
+ * \return Return the ACMR, between 0.5 for an ideal mesh and 3.0 when no vertex is reused
+ */
+float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+} // end of namespace
+} // end of namespace
+
+#endif // SPLASH_MESH_OPTIMIZER_H
@@ -85,7 +85,7 @@ void Mesh_Shmdata::onData(void* data, int /*data_size*/)
     }
 
     intPtr += 8 * verticeNbr;
-    // Then create the faces
+    // Then create the faces, as independent triangles: the mesh is left without indices and drawn as is
     MeshContainer newMesh;
     for (int p = 0; p < polyNbr; ++p)
     {
@@ -0,0 +1,660 @@
+#include "./mesh/meshloader.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "./core/thread_pool.h"
+#include "./mesh/mesh_optimizer.h"
+#include "./utils/log.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+
+namespace Splash
+{
+namespace Loader
+{
+
+namespace
+{
+/*************/
+// Read-only mapping of a whole file
+class MappedFile
+{
+  public:
+    explicit MappedFile(const string& filename)
+    {
+        auto fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+        {
+            auto address = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED)
+            {
+                _data = static_cast<const char*>(address);
+                _size = fileStat.st_size;
+                madvise(address, _size, MADV_WILLNEED);
+            }
+        }
+
+        close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (_data)
+            munmap(const_cast<char*>(_data), _size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    explicit operator bool() const { return _data != nullptr; }
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+  private:
+    const char* _data{nullptr};
+    size_t _size{0};
+};
+
+/*************/
+struct CacheHeader
+{
+    uint32_t magic{SPLASH_MESH_CACHE_MAGIC};
+    uint32_t version{SPLASH_MESH_CACHE_VERSION};
+    uint64_t vertexCount{0};
+    uint64_t indexCount{0};
+};
+
+/*************/
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*************/
+inline void skipBlanks(const char*& ptr, const char* end)
+{
+    while (ptr < end && isBlank(*ptr))
+        ++ptr;
+}
+
+/*************/
+// Locale independent decimal parsing, in the spirit of std::from_chars
+bool parseFloat(const char*& ptr, const char* end, float& value)
+{
+    static const array<double, 23> powersOfTen{
+        {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22}};
+
+    auto current = ptr;
+    bool negative = false;
+    if (current < end && (*current == '-' || *current == '+'))
+        negative = *current++ == '-';
+
+    // Up to 19 significant digits fit in the mantissa, the next ones only change the exponent
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int significantDigits = 0;
+    bool hasDigits = false;
+    for (; current < end && *current >= '0' && *current <= '9'; ++current)
+    {
+        hasDigits = true;
+        if (significantDigits < 19)
+        {
+            mantissa = mantissa * 10 + (*current - '0');
+            if (mantissa != 0)
+                ++significantDigits;
+        }
+        else
+        {
+            ++exponent;
+        }
+    }
+
+    if (current < end && *current == '.')
+    {
+        for (++current; current < end && *current >= '0' && *current <= '9'; ++current)
+        {
+            hasDigits = true;
+            if (significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + (*current - '0');
+                if (mantissa != 0)
+                    ++significantDigits;
+                --exponent;
+            }
+        }
+    }
+
+    if (!hasDigits)
+        return false;
+
+    if (current < end && (*current == 'e' || *current == 'E'))
+    {
+        auto exponentPtr = current + 1;
+        bool negativeExponent = false;
+        if (exponentPtr < end && (*exponentPtr == '-' || *exponentPtr == '+'))
+            negativeExponent = *exponentPtr++ == '-';
+
+        if (exponentPtr < end && *exponentPtr >= '0' && *exponentPtr <= '9')
+        {
+            int explicitExponent = 0;
+            for (; exponentPtr < end && *exponentPtr >= '0' && *exponentPtr <= '9'; ++exponentPtr)
+                explicitExponent = min(explicitExponent * 10 + (*exponentPtr - '0'), 1000);
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            current = exponentPtr;
+        }
+    }
+
+    auto result = static_cast<double>(mantissa);
+    if (exponent < 0 && exponent >= -22)
+        result /= powersOfTen[-exponent];
+    else if (exponent > 0 && exponent <= 22)
+        result *= powersOfTen[exponent];
+    else if (exponent != 0)
+        result *= pow(10.0, exponent);
+
+    value = static_cast<float>(negative ? -result : result);
+    ptr = current;
+    return true;
+}
+
+/*************/
+bool parseInt(const char*& ptr, const char* end, int& value)
+{
+    auto current = ptr;
+    bool negative = false;
+    if (current < end && (*current == '-' || *current == '+'))
+        negative = *current++ == '-';
+
+    if (current == end || *current < '0' || *current > '9')
+        return false;
+
+    int64_t result = 0;
+    for (; current < end && *current >= '0' && *current <= '9'; ++current)
+        result = min<int64_t>(result * 10 + (*current - '0'), numeric_limits<int>::max());
+
+    value = static_cast<int>(negative ? -result : result);
+    ptr = current;
+    return true;
+}
+
+/*************/
+// Read up to N floats, and return the number of values read
+template <typename T, int N>
+int parseFloats(const char*& ptr, const char* end, T& values)
+{
+    int count = 0;
+    for (; count < N; ++count)
+    {
+        skipBlanks(ptr, end);
+        float value;
+        if (!parseFloat(ptr, end, value))
+            break;
+        values[count] = value;
+    }
+    return count;
+}
+} // end of anonymous namespace
+
+/*************/
+struct Obj::Chunk
+{
+    std::vector<glm::vec4> vertices{};
+    std::vector<glm::vec2> uvs{};
+    std::vector<glm::vec3> normals{};
+    std::vector<FaceVertex> triangles{};
+
+    // Triangle vertices holding relative indices, resolved to indices local to the chunk until the chunks are merged
+    std::vector<uint32_t> relativeVertices{};
+    std::vector<uint32_t> relativeUVs{};
+    std::vector<uint32_t> relativeNormals{};
+
+    uint32_t invalidVertices{0}; // Vertices with less than three coordinates, kept as is so that the next indices do not shift
+};
+
+/*************/
+bool Obj::load(const string& filename, bool useCache)
+{
+    clearFileContent();
+    _meshVertices.clear();
+    _meshUVs.clear();
+    _meshNormals.clear();
+    _meshIndices.clear();
+
+    auto cachePath = useCache ? getCacheFilePath(filename) : "";
+    if (!cachePath.empty() && loadCache(cachePath))
+    {
+        Log::get() << Log::DEBUGGING << "Loader::Obj::" << __FUNCTION__ << " - Loaded mesh " << filename << " from cache " << cachePath << Log::endl;
+        return true;
+    }
+
+    {
+        MappedFile file(filename);
+        if (!file)
+            return false;
+
+        if (!parse(file.data(), file.size()))
+        {
+            clearFileContent();
+            return false;
+        }
+    }
+
+    buildIndexedMesh();
+    clearFileContent();
+
+    if (_meshIndices.empty())
+        return false;
+
+    if (!cachePath.empty() && !saveCache(cachePath))
+        Log::get() << Log::WARNING << "Loader::Obj::" << __FUNCTION__ << " - Could not write the mesh cache to " << cachePath << Log::endl;
+
+    return true;
+}
+
+/*************/
+bool Obj::parse(const char* data, size_t size)
+{
+    // Chunks start at the beginning of a line, and are large enough for the tasks overhead to be negligible
+    auto& pool = ThreadPool::get();
+    auto chunkCount = max<size_t>(1, min<size_t>(pool.getWorkerCount() * 4, size / SPLASH_OBJ_MIN_CHUNK_SIZE));
+    vector<const char*> bounds{data};
+    for (size_t c = 1; c < chunkCount; ++c)
+    {
+        auto bound = max(data + size * c / chunkCount, bounds.back());
+        auto lineEnd = static_cast<const char*>(memchr(bound, '\n', data + size - bound));
+        bounds.push_back(lineEnd ? lineEnd + 1 : data + size);
+    }
+    bounds.push_back(data + size);
+
+    vector<Chunk> chunks(chunkCount);
+    if (chunkCount == 1)
+    {
+        parseChunk(bounds[0], bounds[1], chunks[0]);
+    }
+    else
+    {
+        vector<future<void>> futures;
+        for (size_t c = 0; c < chunkCount; ++c)
+            futures.push_back(pool.enqueue([&, c]() { parseChunk(bounds[c], bounds[c + 1], chunks[c]); }));
+        pool.waitAll(futures);
+    }
+
+    // Merge the chunks, in file order
+    size_t vertexCount = 0, uvCount = 0, normalCount = 0, triangleVertexCount = 0, invalidVertices = 0;
+    for (auto& chunk : chunks)
+    {
+        vertexCount += chunk.vertices.size();
+        invalidVertices += chunk.invalidVertices;
+        uvCount += chunk.uvs.size();
+        normalCount += chunk.normals.size();
+        triangleVertexCount += chunk.triangles.size();
+    }
+
+    _vertices.reserve(vertexCount);
+    _uvs.reserve(uvCount);
+    _normals.reserve(normalCount);
+    _triangles.reserve(triangleVertexCount);
+
+    for (auto& chunk : chunks)
+    {
+        for (auto index : chunk.relativeVertices)
+            chunk.triangles[index].vertexId += _vertices.size();
+        for (auto index : chunk.relativeUVs)
+            chunk.triangles[index].uvId += _uvs.size();
+        for (auto index : chunk.relativeNormals)
+            chunk.triangles[index].normalId += _normals.size();
+
+        _vertices.insert(_vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+        _uvs.insert(_uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        _normals.insert(_normals.end(), chunk.normals.begin(), chunk.normals.end());
+        _triangles.insert(_triangles.end(), chunk.triangles.begin(), chunk.triangles.end());
+        chunk = Chunk();
+    }
+
+    if (invalidVertices != 0)
+        Log::get() << Log::WARNING << "Loader::Obj::" << __FUNCTION__ << " - " << invalidVertices << " vertices have less than three coordinates, missing ones are set to 0"
+                   << Log::endl;
+
+    return !_vertices.empty() && !_triangles.empty();
+}
+
+/*************/
+void Obj::parseChunk(const char* begin, const char* end, Chunk& chunk)
+{
+    vector<FaceVertex> face;
+    vector<pair<uint32_t, int>> relativeIds; // Face vertex and attribute, 0 for vertex, 1 for uv, 2 for normal
+
+    auto ptr = begin;
+    while (ptr < end)
+    {
+        auto lineEnd = static_cast<const char*>(memchr(ptr, '\n', end - ptr));
+        if (!lineEnd)
+            lineEnd = end;
+
+        skipBlanks(ptr, lineEnd);
+        if (lineEnd - ptr >= 2 && ptr[0] == 'v' && isBlank(ptr[1]))
+        {
+            ptr += 2;
+            glm::vec4 vertex(0.f, 0.f, 0.f, 1.f);
+            if (parseFloats<glm::vec4, 4>(ptr, lineEnd, vertex) < 3)
+                ++chunk.invalidVertices;
+            chunk.vertices.push_back(vertex);
+        }
+        else if (lineEnd - ptr >= 3 && ptr[0] == 'v' && ptr[1] == 't' && isBlank(ptr[2]))
+        {
+            ptr += 3;
+            glm::vec2 uv(0.f, 0.f);
+            parseFloats<glm::vec2, 2>(ptr, lineEnd, uv);
+            chunk.uvs.push_back(uv);
+        }
+        else if (lineEnd - ptr >= 3 && ptr[0] == 'v' && ptr[1] == 'n' && isBlank(ptr[2]))
+        {
+            ptr += 3;
+            glm::vec3 normal(0.f, 0.f, 0.f);
+            parseFloats<glm::vec3, 3>(ptr, lineEnd, normal);
+            chunk.normals.push_back(normal);
+        }
+        else if (lineEnd - ptr >= 2 && ptr[0] == 'f' && isBlank(ptr[1]))
+        {
+            ptr += 2;
+            face.clear();
+            bool isValid = true;
+            relativeIds.clear();
+
+            while (isValid)
+            {
+                skipBlanks(ptr, lineEnd);
+                if (ptr == lineEnd)
+                    break;
+
+                // Indices are 1-based, negative ones being relative to the end of the list read so far
+                FaceVertex faceVertex;
+                int ids[3]{0, 0, 0};
+                if (!parseInt(ptr, lineEnd, ids[0]) || ids[0] == 0)
+                {
+                    isValid = false;
+                    break;
+                }
+
+                // UV and normal indices are optional, as in "v", "v/vt", "v//vn" or "v/vt/vn"
+                for (int attribute = 1; attribute < 3; ++attribute)
+                {
+                    if (ptr == lineEnd || *ptr != '/')
+                        break;
+                    ++ptr;
+                    parseInt(ptr, lineEnd, ids[attribute]);
+                }
+
+                const size_t counts[3]{chunk.vertices.size(), chunk.uvs.size(), chunk.normals.size()};
+                int* targets[3]{&faceVertex.vertexId, &faceVertex.uvId, &faceVertex.normalId};
+                for (int attribute = 0; attribute < 3; ++attribute)
+                {
+                    if (ids[attribute] > 0)
+                    {
+                        *targets[attribute] = ids[attribute] - 1;
+                    }
+                    else if (ids[attribute] < 0)
+                    {
+                        *targets[attribute] = static_cast<int>(counts[attribute]) + ids[attribute];
+                        relativeIds.push_back(make_pair(static_cast<uint32_t>(face.size()), attribute));
+                    }
+                }
+
+                face.push_back(faceVertex);
+
+                // Skip anything left in the token
+                while (ptr < lineEnd && !isBlank(*ptr))
+                    ++ptr;
+            }
+
+            // Polygons are triangulated as fans, which is fine for convex ones
+            if (isValid && face.size() >= 3)
+            {
+                for (uint32_t i = 1; i + 1 < face.size(); ++i)
+                {
+                    auto triangleStart = static_cast<uint32_t>(chunk.triangles.size());
+                    const uint32_t corners[3]{0, i, i + 1};
+                    for (uint32_t corner = 0; corner < 3; ++corner)
+                    {
+                        chunk.triangles.push_back(face[corners[corner]]);
+                        for (auto& relativeId : relativeIds)
+                        {
+                            if (relativeId.first != corners[corner])
+                                continue;
+                            auto& relativeList = relativeId.second == 0 ? chunk.relativeVertices : (relativeId.second == 1 ? chunk.relativeUVs : chunk.relativeNormals);
+                            relativeList.push_back(triangleStart + corner);
+                        }
+                    }
+                }
+            }
+        }
+
+        ptr = lineEnd + 1;
+    }
+}
+
+/*************/
+void Obj::buildIndexedMesh()
+{
+    struct VertexKey
+    {
+        int vertexId;
+        int uvId;
+        uint32_t normalBits[3];
+
+        bool operator==(const VertexKey& key) const
+        {
+            return vertexId == key.vertexId && uvId == key.uvId && normalBits[0] == key.normalBits[0] && normalBits[1] == key.normalBits[1] &&
+                   normalBits[2] == key.normalBits[2];
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey& key) const
+        {
+            size_t hash = std::hash<int>()(key.vertexId);
+            hash = hash * 31 + std::hash<int>()(key.uvId);
+            for (auto bits : key.normalBits)
+                hash = hash * 31 + std::hash<uint32_t>()(bits);
+            return hash;
+        }
+    };
+
+    unordered_map<VertexKey, uint32_t, VertexKeyHash> uniqueVertices;
+    uniqueVertices.reserve(_vertices.size());
+    _meshIndices.reserve(_triangles.size());
+
+    auto isValidId = [](int id, size_t count) { return id >= 0 && static_cast<size_t>(id) < count; };
+
+    size_t invalidTriangles = 0;
+    for (size_t t = 0; t < _triangles.size(); t += 3)
+    {
+        const FaceVertex* triangle = &_triangles[t];
+
+        // UVs and normals are only used if all the vertices of the triangle have them
+        bool hasUVs = true, hasNormals = true, isValid = true;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            isValid = isValid && isValidId(triangle[i].vertexId, _vertices.size());
+            hasUVs = hasUVs && isValidId(triangle[i].uvId, _uvs.size());
+            hasNormals = hasNormals && isValidId(triangle[i].normalId, _normals.size());
+        }
+
+        if (!isValid)
+        {
+            ++invalidTriangles;
+            continue;
+        }
+
+        // Faces without normals get a flat one, which keeps them from sharing vertices with non coplanar neighbours
+        glm::vec3 faceNormal(0.f, 0.f, 1.f);
+        if (!hasNormals)
+        {
+            auto edge1 = glm::vec3(_vertices[triangle[1].vertexId] - _vertices[triangle[0].vertexId]);
+            auto edge2 = glm::vec3(_vertices[triangle[2].vertexId] - _vertices[triangle[0].vertexId]);
+            auto normal = glm::cross(edge1, edge2);
+            if (glm::length(normal) > 0.f)
+                faceNormal = glm::normalize(normal);
+        }
+
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            auto& faceVertex = triangle[i];
+            auto normal = hasNormals ? _normals[faceVertex.normalId] : faceNormal;
+
+            VertexKey key;
+            key.vertexId = faceVertex.vertexId;
+            key.uvId = hasUVs ? faceVertex.uvId : -1;
+            memcpy(key.normalBits, &normal[0], sizeof(key.normalBits));
+
+            auto vertexIt = uniqueVertices.find(key);
+            if (vertexIt != uniqueVertices.end())
+            {
+                _meshIndices.push_back(vertexIt->second);
+                continue;
+            }
+
+            auto index = static_cast<uint32_t>(_meshVertices.size());
+            uniqueVertices[key] = index;
+            _meshIndices.push_back(index);
+            _meshVertices.push_back(_vertices[faceVertex.vertexId]);
+            _meshUVs.push_back(hasUVs ? _uvs[key.uvId] : glm::vec2(0.f, 0.f));
+            _meshNormals.push_back(normal);
+        }
+    }
+
+    if (invalidTriangles != 0)
+        Log::get() << Log::WARNING << "Loader::Obj::" << __FUNCTION__ << " - " << invalidTriangles << " faces refer to missing vertices and were skipped" << Log::endl;
+
+    _meshIndices = MeshOptimizer::optimizeVertexCache(_meshIndices, _meshVertices.size());
+    auto remap = MeshOptimizer::optimizeVertexFetch(_meshIndices, _meshVertices.size());
+    MeshOptimizer::remapVertices(_meshVertices, remap);
+    MeshOptimizer::remapVertices(_meshUVs, remap);
+    MeshOptimizer::remapVertices(_meshNormals, remap);
+}
+
+/*************/
+string Obj::getCacheFilePath(const string& filename)
+{
+    struct stat fileStat;
+    if (stat(filename.c_str(), &fileStat) != 0)
+        return "";
+
+    auto cacheDir = Utils::getCachePath();
+    if (cacheDir.empty())
+        return "";
+
+    auto key = filename + ":" + to_string(fileStat.st_size) + ":" + to_string(fileStat.st_mtime);
+    stringstream cacheFilename;
+    cacheFilename << hex << hash<string>()(key) << ".mesh";
+    return cacheDir + cacheFilename.str();
+}
+
+/*************/
+bool Obj::loadCache(const string& cachePath)
+{
+    MappedFile file(cachePath);
+    if (!file || file.size() < sizeof(CacheHeader))
+        return false;
+
+    CacheHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != SPLASH_MESH_CACHE_MAGIC || header.version != SPLASH_MESH_CACHE_VERSION)
+        return false;
+
+    // Protects against truncated or corrupted files
+    auto vertexSize = sizeof(glm::vec4) + sizeof(glm::vec2) + sizeof(glm::vec3);
+    if (header.vertexCount == 0 || header.indexCount == 0 || header.indexCount % 3 != 0 || header.vertexCount > file.size() / vertexSize ||
+        header.indexCount > file.size() / sizeof(uint32_t) || file.size() != sizeof(header) + header.vertexCount * vertexSize + header.indexCount * sizeof(uint32_t))
+        return false;
+
+    auto ptr = file.data() + sizeof(header);
+    auto vertices = reinterpret_cast<const glm::vec4*>(ptr);
+    _meshVertices.assign(vertices, vertices + header.vertexCount);
+    ptr += header.vertexCount * sizeof(glm::vec4);
+    auto uvs = reinterpret_cast<const glm::vec2*>(ptr);
+    _meshUVs.assign(uvs, uvs + header.vertexCount);
+    ptr += header.vertexCount * sizeof(glm::vec2);
+    auto normals = reinterpret_cast<const glm::vec3*>(ptr);
+    _meshNormals.assign(normals, normals + header.vertexCount);
+    ptr += header.vertexCount * sizeof(glm::vec3);
+    auto indices = reinterpret_cast<const uint32_t*>(ptr);
+    _meshIndices.assign(indices, indices + header.indexCount);
+
+    if (any_of(_meshIndices.begin(), _meshIndices.end(), [&](uint32_t index) { return index >= header.vertexCount; }))
+    {
+        _meshVertices.clear();
+        _meshUVs.clear();
+        _meshNormals.clear();
+        _meshIndices.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool Obj::saveCache(const string& cachePath) const
+{
+    // Written to a temporary file first, so that the other processes never see a partial mesh
+    auto tmpPath = cachePath + "." + to_string(getpid()) + ".tmp";
+    {
+        ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+        if (!file.is_open())
+            return false;
+
+        CacheHeader header;
+        header.vertexCount = _meshVertices.size();
+        header.indexCount = _meshIndices.size();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(_meshVertices.data()), _meshVertices.size() * sizeof(glm::vec4));
+        file.write(reinterpret_cast<const char*>(_meshUVs.data()), _meshUVs.size() * sizeof(glm::vec2));
+        file.write(reinterpret_cast<const char*>(_meshNormals.data()), _meshNormals.size() * sizeof(glm::vec3));
+        file.write(reinterpret_cast<const char*>(_meshIndices.data()), _meshIndices.size() * sizeof(uint32_t));
+        if (!file)
+        {
+            remove(tmpPath.c_str());
+            return false;
+        }
+    }
+
+    if (rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+void Obj::clearFileContent()
+{
+    vector<glm::vec4>().swap(_vertices);
+    vector<glm::vec2>().swap(_uvs);
+    vector<glm::vec3>().swap(_normals);
+    vector<FaceVertex>().swap(_triangles);
+}
+
+} // end of namespace
+} // end of namespace
@@ -25,15 +25,15 @@
 #ifndef SPLASH_MESHLOADER_H
 #define SPLASH_MESHLOADER_H
 
-#include <fstream>
-#include <iostream>
-#include <sstream>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
 
-#include "../utils/log.h"
+#define SPLASH_MESH_CACHE_MAGIC 0x4a424f53 // "SOBJ"
+#define SPLASH_MESH_CACHE_VERSION 1
+#define SPLASH_OBJ_MIN_CHUNK_SIZE (1 << 20) // Smallest part of a file parsed by a single task
 
 namespace Splash
 {
@@ -46,10 +46,11 @@ class Base
   public:
     virtual ~Base(){};
 
-    virtual bool load(const std::string& filename) = 0;
+    virtual bool load(const std::string& filename, bool useCache = true) = 0;
     virtual std::vector<glm::vec4> getVertices() const = 0;
     virtual std::vector<glm::vec2> getUVs() const = 0;
     virtual std::vector<glm::vec3> getNormals() const = 0;
+    virtual std::vector<uint32_t> getIndices() const = 0;
     virtual std::vector<std::vector<int>> getFaces() const = 0;
 };
 
@@ -59,236 +60,106 @@ class Obj : public Base
   public:
     ~Obj(){};
 
-    /**/
-    bool load(const std::string& filename)
-    {
-        std::ifstream file(filename, std::ios::in);
-        if (!file.is_open())
-            return false;
-
-        _vertices.clear();
-        _uvs.clear();
-        _normals.clear();
-        _faces.clear();
-
-        for (std::string line; std::getline(file, line);)
-        {
-
-            std::string::size_type pos;
-            if ((pos = line.find("o ")) == 0)
-            {
-                continue;
-            }
-            else if ((pos = line.find("v ")) == 0)
-            {
-                pos += 1;
-                glm::vec4 vertex;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    vertex[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 4);
-
-                if (index < 3)
-                    vertex[3] = 1.f;
-
-                _vertices.push_back(vertex);
-            }
-            else if ((pos = line.find("vt ")) == 0)
-            {
-                pos += 2;
-                glm::vec2 uv;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    uv[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 2);
-
-                _uvs.push_back(uv);
-            }
-            else if ((pos = line.find("vn ")) == 0)
-            {
-                pos += 2;
-                glm::vec3 normal;
-                int index = 0;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    normal[index] = std::stof(line);
-                    index++;
-                    pos = line.find(" ");
-                } while (pos != std::string::npos && index < 3);
-
-                _normals.push_back(normal);
-            }
-            else if ((pos = line.find("f ")) == 0)
-            {
-                pos += 1;
-
-                std::vector<FaceVertex> face;
-                std::string::size_type nextSlash, nextSpace;
-                do
-                {
-                    pos++;
-                    line = line.substr(pos);
-                    nextSpace = line.find(" ");
-
-                    FaceVertex faceVertex;
-                    faceVertex.vertexId = std::stoi(line) - 1;
-
-                    nextSlash = line.find("/");
-                    if (nextSlash != std::string::npos && (nextSpace == std::string::npos || nextSlash < nextSpace))
-                    {
-                        line = line.substr(nextSlash + 1);
-                        nextSlash = line.find("/");
-                        if (nextSlash != 0)
-                        {
-                            nextSpace = line.find(" ");
-                            faceVertex.uvId = std::stoi(line) - 1;
-                        }
-                    }
-                    else
-                        nextSlash = line.find("/");
-                    if (nextSlash != std::string::npos && (nextSpace == std::string::npos || nextSlash < nextSpace))
-                    {
-                        line = line.substr(nextSlash + 1);
-                        nextSpace = line.find(" ");
-                        faceVertex.normalId = std::stoi(line) - 1;
-                    }
-
-                    face.push_back(faceVertex);
-
-                    pos = nextSpace;
-                } while (pos != std::string::npos);
-
-                // We triangulate faces right away if needed
-                // Only tris and quads are supported
-                if (face.size() == 3)
-                {
-                    _faces.push_back(face);
-                }
-                else if (face.size() >= 4)
-                {
-                    std::vector<FaceVertex> newFace;
-                    newFace.push_back(face[0]);
-                    newFace.push_back(face[1]);
-                    newFace.push_back(face[2]);
-                    _faces.push_back(newFace);
-
-                    newFace.clear();
-                    newFace.push_back(face[2]);
-                    newFace.push_back(face[3]);
-                    newFace.push_back(face[0]);
-                    _faces.push_back(newFace);
-                }
-            }
-        }
-
-        // Check that we have faces, vertices and UVs
-        if (_vertices.size() == 0 || _faces.size() == 0)
-        {
-            _vertices.clear();
-            _faces.clear();
-            _uvs.clear();
-            _normals.clear();
-
-            return false;
-        }
-
-        return true;
-    }
+    /**
+     * \brief Load a mesh file, from the binary cache if it is up to date
+     * \param filename Path to the OBJ file
+     * \param useCache If true, read the cache and write it if it is missing
+     * \return Return true if the mesh was loaded
+     */
+    bool load(const std::string& filename, bool useCache = true);
 
     /**/
-    std::vector<glm::vec4> getVertices() const
-    {
-        std::vector<glm::vec4> vertices;
-
-        for (auto& face : _faces)
-        {
-            vertices.push_back(_vertices[face[0].vertexId]);
-            vertices.push_back(_vertices[face[1].vertexId]);
-            vertices.push_back(_vertices[face[2].vertexId]);
-        }
-
-        return vertices;
-    }
+    std::vector<glm::vec4> getVertices() const { return _meshVertices; }
 
     /**/
-    std::vector<glm::vec2> getUVs() const
-    {
-        std::vector<glm::vec2> uvs;
-
-        for (auto& face : _faces)
-        {
-            if (face[0].uvId == -1)
-                for (uint32_t i = 0; i < face.size(); ++i)
-                    uvs.push_back(glm::vec2(0.f, 0.f));
-            else
-            {
-                uvs.push_back(_uvs[face[0].uvId]);
-                uvs.push_back(_uvs[face[1].uvId]);
-                uvs.push_back(_uvs[face[2].uvId]);
-            }
-        }
-
-        return uvs;
-    }
+    std::vector<glm::vec2> getUVs() const { return _meshUVs; }
 
     /**/
-    std::vector<glm::vec3> getNormals() const
-    {
-        std::vector<glm::vec3> normals;
-
-        for (auto& face : _faces)
-        {
-            if (face[0].normalId == -1)
-            {
-                auto edge1 = glm::vec3(_vertices[face[1].vertexId] - _vertices[face[0].vertexId]);
-                auto edge2 = glm::vec3(_vertices[face[2].vertexId] - _vertices[face[0].vertexId]);
-                auto normal = glm::normalize(glm::cross(edge1, edge2));
-
-                normals.push_back(normal);
-                normals.push_back(normal);
-                normals.push_back(normal);
-            }
-            else
-            {
-                normals.push_back(_normals[face[0].normalId]);
-                normals.push_back(_normals[face[1].normalId]);
-                normals.push_back(_normals[face[2].normalId]);
-            }
-        }
+    std::vector<glm::vec3> getNormals() const { return _meshNormals; }
 
-        return normals;
-    }
+    /**/
+    std::vector<uint32_t> getIndices() const { return _meshIndices; }
 
     /**/
     std::vector<std::vector<int>> getFaces() const { return std::vector<std::vector<int>>(); }
 
-  private:
-    std::vector<glm::vec4> _vertices;
-    std::vector<glm::vec2> _uvs;
-    std::vector<glm::vec3> _normals;
+    /**
+     * \brief Get the cache file for a mesh, which changes with the mesh path, size and modification time
+     * \param filename Mesh file path
+     * \return Return the cache file path, or an empty string if there is no cache directory
+     */
+    static std::string getCacheFilePath(const std::string& filename);
 
+    /**
+     * \brief Get the number of triangles of the mesh
+     * \return Return the triangle count
+     */
+    size_t getTriangleCount() const { return _meshIndices.size() / 3; }
+
+  private:
     struct FaceVertex
     {
         int vertexId{-1};
         int uvId{-1};
         int normalId{-1};
     };
-    std::vector<std::vector<FaceVertex>> _faces;
+
+    struct Chunk;
+
+    // Content of the file, with faces split into triangles
+    std::vector<glm::vec4> _vertices;
+    std::vector<glm::vec2> _uvs;
+    std::vector<glm::vec3> _normals;
+    std::vector<FaceVertex> _triangles;
+
+    // Indexed mesh, with each unique combination of position, UV and normal stored once
+    std::vector<glm::vec4> _meshVertices;
+    std::vector<glm::vec2> _meshUVs;
+    std::vector<glm::vec3> _meshNormals;
+    std::vector<uint32_t> _meshIndices;
+
+    /**
+     * \brief Parse the content of an OBJ file, split in chunks parsed in parallel
+     * \param data File content
+     * \param size File size
+     * \return Return true if the file contains at least a face
+     */
+    bool parse(const char* data, size_t size);
+
+    /**
+     * \brief Parse the lines between the given bounds
+     * \param begin Beginning of the first line
+     * \param end End of the last line
+     * \param chunk Chunk to fill
+     */
+    static void parseChunk(const char* begin, const char* end, Chunk& chunk);
+
+    /**
+     * \brief Merge the face vertices sharing the same position, UV and normal, and order the triangles for the vertex cache
+     */
+    void buildIndexedMesh();
+
+    /**
+     * \brief Load the indexed mesh from a cache file
+     * \param cachePath Cache file path
+     * \return Return true if the file was valid
+     */
+    bool loadCache(const std::string& cachePath);
+
+    /**
+     * \brief Save the indexed mesh to a cache file
+     * \param cachePath Cache file path
+     * \return Return true if the file was written
+     */
+    bool saveCache(const std::string& cachePath) const;
+
+    /**
+     * \brief Release the content of the file, once the indexed mesh is built
+     */
+    void clearFileContent();
 };
 
 } // end of namespace
 } // end of namespace
 
-#endif
+#endif // SPLASH_MESHLOADER_H
@@ -1,9 +1,14 @@
 #include "./sink/sink.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include "./utils/timer.h"
 
+#define SPLASH_SINK_MAX_FRAMES 8 // Frames kept for reuse, more are allocated if the readers hold them all
+#define SPLASH_SINK_CONVERSION_GROUP_SIZE 128 // Has to match the local size of the conversion compute shader
+#define SPLASH_SINK_CONVERSION_GROUPS_PER_ROW 1024
+
 using namespace std;
 
 namespace Splash
@@ -29,10 +34,14 @@ Sink::~Sink()
 
     if (_mappedPixels)
     {
-        glUnmapNamedBuffer(_pbos[_pboWriteIndex]);
+        glUnmapNamedBuffer(_pbos[_mappedIndex]);
         _mappedPixels = nullptr;
     }
 
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
     glDeleteBuffers(_pbos.size(), _pbos.data());
 }
 
@@ -43,6 +52,31 @@ string Sink::getCaps() const
            to_string(_framerate) + "/1,pixel-aspect-ratio=(fraction)1/1";
 }
 
+/*************/
+ResizableArray<uint8_t> Sink::getBuffer() const
+{
+    auto frame = getLastFrame();
+    if (!frame)
+        return {};
+    return frame->pixels;
+}
+
+/*************/
+shared_ptr<const Sink::Frame> Sink::getLastFrame() const
+{
+    lock_guard<mutex> lock(_frameMutex);
+    return _lastFrame;
+}
+
+/*************/
+shared_ptr<const Sink::Frame> Sink::waitForFrame(uint64_t sequence, chrono::microseconds timeout) const
+{
+    unique_lock<mutex> lock(_frameMutex);
+    if (!_frameCondition.wait_for(lock, timeout, [&]() { return _lastFrame && _lastFrame->sequence > sequence; }))
+        return nullptr;
+    return _lastFrame;
+}
+
 /*************/
 bool Sink::linkTo(const shared_ptr<GraphObject>& obj)
 {
@@ -89,31 +123,122 @@ void Sink::update()
     if (textureSpec.rawSize() == 0)
         return;
 
-    if (!_pbos.empty() && _mappedPixels)
+    // The buffer handled by the last render is given back to the ring
+    if (_mappedPixels)
     {
-        glUnmapNamedBuffer(_pbos[_pboWriteIndex]);
+        glUnmapNamedBuffer(_pbos[_mappedIndex]);
         _mappedPixels = nullptr;
+        _mappedIndex = -1;
     }
 
     if (!_opened)
         return;
 
+    // Frames already read back are handled even if no new frame is requested
+    mapReadyPbo();
+
     uint64_t currentTime = Timer::get().getTime();
     uint64_t period = static_cast<uint64_t>(1e6 / (double)_framerate);
     if (period != 0 && _lastFrameTiming != 0 && currentTime - _lastFrameTiming < period)
         return;
     _lastFrameTiming = currentTime;
 
-    if (_spec != textureSpec || _pbos.size() != _pboCount)
+    auto spec = getOutputSpec(textureSpec);
+    if (_spec != spec || _pbos.size() != _pboCount)
+    {
+        if (_mappedPixels)
+        {
+            glUnmapNamedBuffer(_pbos[_mappedIndex]);
+            _mappedPixels = nullptr;
+            _mappedIndex = -1;
+        }
+        updatePbos(spec.rawSize());
+        _spec = spec;
+    }
+
+    // If the GPU is late, all the buffers can be in use. The frame is dropped instead of waiting
+    if (_pboFences[_pboWriteIndex] || _pboWriteIndex == _mappedIndex)
     {
-        updatePbos(textureSpec.width, textureSpec.height, textureSpec.pixelBytes());
-        _spec = textureSpec;
-        _image = ImageBuffer(_spec);
+        ++_droppedFrames;
+        return;
+    }
+
+    readbackToPbo(_pboWriteIndex);
+    _pboFences[_pboWriteIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _pboTimestamps[_pboWriteIndex] = Timer::getTime();
+    _pendingPbos.push_back(_pboWriteIndex);
+
+    _pboWriteIndex = (_pboWriteIndex + 1) % _pbos.size();
+}
+
+/*************/
+ImageBufferSpec Sink::getOutputSpec(const ImageBufferSpec& textureSpec) const
+{
+    if (_outputFormat != "NV12" && _outputFormat != "I420")
+        return textureSpec;
+
+    // The conversion handles 8 bits RGBA textures. The sizes allow for the chroma planes to be subsampled and written as whole words
+    if (textureSpec.type != ImageBufferSpec::Type::UINT8 || textureSpec.channels != 4 || textureSpec.bpp != 32 || textureSpec.width % 4 != 0 || textureSpec.height % 2 != 0)
+        return textureSpec;
+
+    return ImageBufferSpec(textureSpec.width, textureSpec.height, 3, 12, ImageBufferSpec::Type::UINT8, _outputFormat);
+}
+
+/*************/
+void Sink::mapReadyPbo()
+{
+    if (_pendingPbos.empty())
+        return;
+
+    auto index = _pendingPbos.front();
+    auto status = glClientWaitSync(_pboFences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return;
+
+    glDeleteSync(_pboFences[index]);
+    _pboFences[index] = nullptr;
+    _pendingPbos.pop_front();
+
+    _mappedPixels = (GLubyte*)glMapNamedBufferRange(_pbos[index], 0, _spec.rawSize(), GL_MAP_READ_BIT);
+    _mappedIndex = _mappedPixels ? index : -1;
+    _mappedTimestamp = _pboTimestamps[index];
+}
+
+/*************/
+void Sink::readbackToPbo(int index)
+{
+    // Frames converted to YUV are written directly to the buffer by a compute shader
+    if (_spec.format == "NV12" || _spec.format == "I420")
+    {
+        if (!_conversionShader)
+        {
+            _conversionShader = make_shared<Shader>(Shader::prgCompute);
+            _conversionShader->setAttribute("computePhase", {"convertToYUV"});
+            _conversionSizeUniform = _conversionShader->getUniformHandle("_size");
+            _conversionInterleavedUniform = _conversionShader->getUniformHandle("_interleaved");
+        }
+
+        // Each invocation writes four bytes, and the groups are spread over two dimensions to stay within the dispatch limits
+        auto groupCount = (static_cast<uint32_t>(_spec.rawSize()) / 4 + SPLASH_SINK_CONVERSION_GROUP_SIZE - 1) / SPLASH_SINK_CONVERSION_GROUP_SIZE;
+        auto groupCountX = min<uint32_t>(groupCount, SPLASH_SINK_CONVERSION_GROUPS_PER_ROW);
+        auto groupCountY = (groupCount + groupCountX - 1) / groupCountX;
+
+        glActiveTexture(GL_TEXTURE0);
+        _inputTexture->bind();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, _pbos[index]);
+        _conversionShader->setUniform(_conversionSizeUniform, glm::ivec2(_spec.width, _spec.height));
+        _conversionShader->setUniform(_conversionInterleavedUniform, static_cast<int>(_spec.format == "NV12"));
+        _conversionShader->doCompute(groupCountX, groupCountY);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        _inputTexture->unbind();
+
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        return;
     }
 
     // TODO: figure out why replacing glGetTexImage with glGetTextureImage is not straightforward
     _inputTexture->bind();
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[_pboWriteIndex]);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[index]);
     if (_spec.bpp == 32)
         glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
     else if (_spec.bpp == 24)
@@ -127,25 +252,59 @@ void Sink::update()
 
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     _inputTexture->unbind();
+}
 
-    _pboWriteIndex = (_pboWriteIndex + 1) % _pbos.size();
+/*************/
+void Sink::handlePixels(const char* pixels, const ImageBufferSpec& spec)
+{
+    // The frame is not visible to the readers until published, so it is written without holding the lock
+    auto frame = getFreeFrame(spec);
+    memcpy(frame->pixels.data(), pixels, spec.rawSize());
+    frame->timestamp = _mappedTimestamp;
 
-    _mappedPixels = (GLubyte*)glMapNamedBufferRange(_pbos[_pboWriteIndex], 0, _spec.rawSize(), GL_MAP_READ_BIT);
+    {
+        lock_guard<mutex> lock(_frameMutex);
+        frame->sequence = ++_frameSequence;
+        _lastFrame = frame;
+    }
+    _frameCondition.notify_all();
 }
 
 /*************/
-void Sink::handlePixels(const char* pixels, const ImageBufferSpec& spec)
+shared_ptr<Sink::Frame> Sink::getFreeFrame(const ImageBufferSpec& spec)
 {
-    uint32_t size = spec.rawSize();
-    if (size != _buffer.size())
-        _buffer.resize(size);
+    lock_guard<mutex> lock(_frameMutex);
+
+    // A frame only referenced by this list is held by no reader, nor is it the last frame
+    auto frameIt = find_if(_frames.begin(), _frames.end(), [](const shared_ptr<Frame>& frame) { return frame.use_count() == 1; });
+    shared_ptr<Frame> frame;
+    if (frameIt != _frames.end())
+    {
+        frame = *frameIt;
+    }
+    else
+    {
+        frame = make_shared<Frame>();
+        if (_frames.size() < SPLASH_SINK_MAX_FRAMES)
+            _frames.push_back(frame);
+    }
+
+    if (frame->spec != spec || frame->pixels.size() != static_cast<size_t>(spec.rawSize()))
+    {
+        frame->spec = spec;
+        frame->pixels = ResizableArray<uint8_t>(spec.rawSize());
+    }
 
-    memcpy(_buffer.data(), pixels, size);
+    return frame;
 }
 
 /*************/
-void Sink::updatePbos(int width, int height, int bytes)
+void Sink::updatePbos(int size)
 {
+    for (auto& fence : _pboFences)
+        if (fence)
+            glDeleteSync(fence);
+
     if (!_pbos.empty())
         glDeleteBuffers(_pbos.size(), _pbos.data());
 
@@ -153,8 +312,11 @@ void Sink::updatePbos(int width, int height, int bytes)
     glCreateBuffers(_pbos.size(), _pbos.data());
 
     for (uint32_t i = 0; i < _pbos.size(); ++i)
-        glNamedBufferData(_pbos[i], width * height * bytes, 0, GL_STREAM_READ);
+        glNamedBufferData(_pbos[i], size, 0, GL_STREAM_READ);
 
+    _pboFences = vector<GLsync>(_pbos.size(), nullptr);
+    _pboTimestamps = vector<int64_t>(_pbos.size(), 0);
+    _pendingPbos.clear();
     _pboWriteIndex = 0;
 }
 
@@ -170,7 +332,24 @@ void Sink::registerAttributes()
         },
         [&]() -> Values { return {(int)_pboCount}; },
         {'n'});
-    setAttributeDescription("bufferCount", "Number of GPU buffers to use for data download to CPU memory");
+    setAttributeDescription("bufferCount", "Number of GPU buffers to use for data download to CPU memory. Frames are dropped if they are all in use");
+
+    addAttribute("droppedFrames", nullptr, [&]() -> Values { return {static_cast<int64_t>(_droppedFrames)}; }, {});
+    setAttributeDescription("droppedFrames", "Number of frames dropped because the GPU was late in reading back the previous ones");
+
+    addAttribute("format",
+        [&](const Values& args) {
+            auto format = args[0].as<string>();
+            if (format != "native" && format != "NV12" && format != "I420")
+                return false;
+            _outputFormat = format;
+            return true;
+        },
+        [&]() -> Values { return {_outputFormat}; },
+        {'s'});
+    setAttributeDescription("format",
+        "Output format, either native (as the input texture), NV12 or I420. YUV formats are converted on the GPU, "
+        "for 8 bits RGBA inputs with a width multiple of 4 and an even height");
 
     addAttribute("framerate",
         [&](const Values& args) {
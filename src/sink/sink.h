@@ -25,6 +25,9 @@
 #ifndef SPLASH_SINK_H
 #define SPLASH_SINK_H
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
 #include <memory>
 #include <mutex>
@@ -35,6 +38,7 @@
 #include "./core/coretypes.h"
 #include "./core/graph_object.h"
 #include "./core/resizable_array.h"
+#include "./graphics/shader.h"
 #include "./graphics/texture.h"
 
 namespace Splash
@@ -43,6 +47,14 @@ namespace Splash
 class Sink : public GraphObject
 {
   public:
+    struct Frame
+    {
+        ImageBufferSpec spec{};
+        ResizableArray<uint8_t> pixels{};
+        uint64_t sequence{0}; //!< Index of the frame since the sink was created, starting at 1
+        int64_t timestamp{0}; //!< Time at which the frame was read from the GPU, in microseconds
+    };
+
     /**
      * Constructor
      */
@@ -54,10 +66,24 @@ class Sink : public GraphObject
     virtual ~Sink() override;
 
     /**
-     * Get the current buffer as a resizable array
+     * Get a copy of the current buffer as a resizable array
      * \return Return the buffer
      */
-    ResizableArray<uint8_t> getBuffer() const { return _buffer; };
+    ResizableArray<uint8_t> getBuffer() const;
+
+    /**
+     * \brief Get the last frame, without copying it. The frame is not modified by the sink while it is held
+     * \return Return the frame, or nullptr if none has been received yet
+     */
+    std::shared_ptr<const Frame> getLastFrame() const;
+
+    /**
+     * \brief Wait for a frame more recent than the given one
+     * \param sequence Sequence number of the last frame known by the caller
+     * \param timeout Maximum waiting time
+     * \return Return the frame, or nullptr if none was received before the timeout
+     */
+    std::shared_ptr<const Frame> waitForFrame(uint64_t sequence, std::chrono::microseconds timeout) const;
 
     /**
      * Generate a caps from the input texture spec
@@ -88,7 +114,8 @@ class Sink : public GraphObject
     void render() override;
 
   protected:
-    uint32_t _framerate{30}; //!< Maximum framerate
+    uint32_t _framerate{30};             //!< Maximum framerate
+    std::string _outputFormat{"native"}; //!< Format of the frames, either native (as read from the input texture), NV12 or I420
 
     /**
      * \brief Register new functors to modify attributes
@@ -98,30 +125,66 @@ class Sink : public GraphObject
   private:
     std::shared_ptr<Texture> _inputTexture{nullptr};
     ImageBufferSpec _spec{};
-    ImageBuffer _image{};
-    std::mutex _lockPixels{};
-    ResizableArray<uint8_t> _buffer{};
+
+    mutable std::mutex _frameMutex{};
+    mutable std::condition_variable _frameCondition{};
+    std::vector<std::shared_ptr<Frame>> _frames{}; //!< Frames to write to, reused once released by their readers
+    std::shared_ptr<Frame> _lastFrame{nullptr};
+    uint64_t _frameSequence{0};
 
     bool _opened{false}; //!< If true, the sink lets frames through
 
     uint64_t _lastFrameTiming{0};
     uint32_t _pboCount{3};
     std::vector<GLuint> _pbos{};
+    std::vector<GLsync> _pboFences{};      //!< Fence of the readback into each buffer, nullptr if the buffer is free
+    std::vector<int64_t> _pboTimestamps{}; //!< Time at which the readback into each buffer was issued
+    std::deque<int> _pendingPbos{};        //!< Buffers being filled by the GPU, oldest first
     int _pboWriteIndex{0};
+    int _mappedIndex{-1};
     GLubyte* _mappedPixels{nullptr};
+    int64_t _mappedTimestamp{0};
+    uint64_t _droppedFrames{0}; //!< Frames not read back because all the buffers were in use
+
+    std::shared_ptr<Shader> _conversionShader{nullptr};
+    Shader::UniformHandle _conversionSizeUniform{};
+    Shader::UniformHandle _conversionInterleavedUniform{};
 
     /**
      * Class to be implemented to copy the _mappedPixels somewhere
      */
     virtual void handlePixels(const char* pixels, const ImageBufferSpec& spec);
 
+    /**
+     * \brief Get a frame which is not held by any reader, to copy the next pixels to
+     * \param spec Frame spec
+     * \return Return the frame
+     */
+    std::shared_ptr<Frame> getFreeFrame(const ImageBufferSpec& spec);
+
+    /**
+     * \brief Get the spec of the frames read back from the given input texture spec
+     * \param textureSpec Input texture spec
+     * \return Return the output spec, which differs from the input if it is converted on the GPU
+     */
+    ImageBufferSpec getOutputSpec(const ImageBufferSpec& textureSpec) const;
+
+    /**
+     * \brief Map the oldest buffer being filled, if the GPU is done with it. This does not block
+     */
+    void mapReadyPbo();
+
+    /**
+     * \brief Read the input texture back into the given buffer, converting it to the output format
+     * \param index Buffer index
+     */
+    void readbackToPbo(int index);
+
     /**
      * \brief Update the pbos according to the parameters
-     * \param width Width
-     * \param height Height
-     * \param bytes Bytes per pixel
+     * \param size Size of each buffer in bytes
      */
-    void updatePbos(int width, int height, int bytes);
+    void updatePbos(int size);
 };
 
 } // namespace Splash
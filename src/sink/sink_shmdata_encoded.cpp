@@ -17,6 +17,9 @@ Sink_Shmdata_Encoded::Sink_Shmdata_Encoded(RootObject* root)
     _type = "sink_shmdata_encoded";
     registerAttributes();
 
+    // Frames are converted on the GPU to the encoder input format whenever possible
+    _outputFormat = "I420";
+
     av_register_all();
 }
 
@@ -104,7 +107,9 @@ bool Sink_Shmdata_Encoded::initFFmpegObjects(const ImageBufferSpec& spec)
         return false;
     }
 
-    _swsContext = sws_getContext(spec.width, spec.height, AV_PIX_FMT_RGB32, spec.width, spec.height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    // Frames already converted on the GPU are sent as is, the others are converted here
+    if (spec.format != "I420")
+        _swsContext = sws_getContext(spec.width, spec.height, AV_PIX_FMT_RGB32, spec.width, spec.height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
 
     _frame = av_frame_alloc();
     _yuvFrame = av_frame_alloc();
@@ -114,22 +119,21 @@ bool Sink_Shmdata_Encoded::initFFmpegObjects(const ImageBufferSpec& spec)
         return false;
     }
 
-    _frame->format = AV_PIX_FMT_RGB32;
+    // The input frame points directly to the pixels handed by the sink, see handlePixels
+    _frame->format = _swsContext ? AV_PIX_FMT_RGB32 : AV_PIX_FMT_YUV420P;
     _frame->width = spec.width;
     _frame->height = spec.height;
-    if (av_image_alloc(_frame->data, _frame->linesize, _context->width, _context->height, AV_PIX_FMT_RGB32, 32) < 0)
-    {
-        Log::get() << Log::WARNING << "Sink_Shmdata_Encoded::" << __FUNCTION__ << " - Unable to allocate raw RGBA picture buffer" << Log::endl;
-        return false;
-    }
 
-    _yuvFrame->format = AV_PIX_FMT_YUV420P;
-    _yuvFrame->width = spec.width;
-    _yuvFrame->height = spec.height;
-    if (av_image_alloc(_yuvFrame->data, _yuvFrame->linesize, _context->width, _context->height, AV_PIX_FMT_YUV420P, 32) < 0)
+    if (_swsContext)
     {
-        Log::get() << Log::WARNING << "Sink_Shmdata_Encoded::" << __FUNCTION__ << " - Unable to allocate raw YUV420 picture buffer" << Log::endl;
-        return false;
+        _yuvFrame->format = AV_PIX_FMT_YUV420P;
+        _yuvFrame->width = spec.width;
+        _yuvFrame->height = spec.height;
+        if (av_image_alloc(_yuvFrame->data, _yuvFrame->linesize, _context->width, _context->height, AV_PIX_FMT_YUV420P, 32) < 0)
+        {
+            Log::get() << Log::WARNING << "Sink_Shmdata_Encoded::" << __FUNCTION__ << " - Unable to allocate raw YUV420 picture buffer" << Log::endl;
+            return false;
+        }
     }
 
     _startTime = Timer::get().getTime();
@@ -149,10 +153,17 @@ void Sink_Shmdata_Encoded::freeFFmpegObjects()
     if (_frame)
         av_frame_free(&_frame);
     if (_yuvFrame)
+    {
+        if (_swsContext)
+            av_freep(&_yuvFrame->data[0]);
         av_frame_free(&_yuvFrame);
+    }
 
     if (_swsContext)
+    {
         sws_freeContext(_swsContext);
+        _swsContext = nullptr;
+    }
 }
 
 /*************/
@@ -216,14 +227,23 @@ void Sink_Shmdata_Encoded::handlePixels(const char* pixels, const ImageBufferSpe
     _packet.data = nullptr;
     _packet.size = 0;
 
-    av_image_fill_arrays(_frame->data, _frame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_RGB32, spec.width, spec.height, 1);
-    sws_scale(_swsContext, _frame->data, _frame->linesize, 0, spec.height, _yuvFrame->data, _yuvFrame->linesize);
+    AVFrame* frame = _frame;
+    if (_swsContext)
+    {
+        av_image_fill_arrays(_frame->data, _frame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_RGB32, spec.width, spec.height, 1);
+        sws_scale(_swsContext, _frame->data, _frame->linesize, 0, spec.height, _yuvFrame->data, _yuvFrame->linesize);
+        frame = _yuvFrame;
+    }
+    else
+    {
+        av_image_fill_arrays(_frame->data, _frame->linesize, reinterpret_cast<const uint8_t*>(pixels), AV_PIX_FMT_YUV420P, spec.width, spec.height, 1);
+    }
 
-    _yuvFrame->pts = (static_cast<double>((Timer::get().getTime() - _startTime)) / 1e3) / _framerate;
-    _yuvFrame->quality = _context->global_quality;
-    _yuvFrame->pict_type = AV_PICTURE_TYPE_NONE;
+    frame->pts = (static_cast<double>((Timer::get().getTime() - _startTime)) / 1e3) / _framerate;
+    frame->quality = _context->global_quality;
+    frame->pict_type = AV_PICTURE_TYPE_NONE;
 
-    auto ret = avcodec_send_frame(_context, _yuvFrame);
+    auto ret = avcodec_send_frame(_context, frame);
     if (ret < 0)
     {
         Log::get() << Log::WARNING << "Sink_Shmdata_Encoded::" << __FUNCTION__ << " - Error encoding frame" << Log::endl;
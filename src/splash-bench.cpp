@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * @splash-bench.cpp
+ * Headless benchmark, running a configuration for a number of frames and reporting the timings of each stage
+ */
+
+#include <atomic>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <thread>
+
+#include "./splash.h"
+
+#define SPLASH_BENCH_DEFAULT_FRAMES 600
+#define SPLASH_BENCH_DEFAULT_TOLERANCE 20.0 // Allowed increase of the median duration of a stage over the baseline, in percent
+#define SPLASH_BENCH_MIN_DURATION 100       // Stages with a shorter median duration in the baseline are dominated by noise, and not checked, in microseconds
+#define SPLASH_BENCH_TIMEOUT 30             // Maximum time without any new frame before giving up, in seconds
+#define SPLASH_BENCH_WARMUP_FRAMES 60       // Frames rendered before the statistics are reset and the measurement starts
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+void printHelp()
+{
+    cout << "Basic usage: splash-bench [arguments] [config.json]" << endl;
+    cout << "Runs the given configuration with hidden windows, and writes the timings of each stage as JSON." << endl;
+    cout << "Scenes are only measured if they run in this process, so their display should not be set in the configuration." << endl;
+    cout << "Options:" << endl;
+    cout << "\t-b (--baseline) [filename] : compare the median durations to those of a previous output, and fail if a stage regressed" << endl;
+    cout << "\t-f (--frames) [count] : number of frames to render (default: " << SPLASH_BENCH_DEFAULT_FRAMES << ")" << endl;
+    cout << "\t-o (--output) [filename] : file to write the results to (default: splash-bench.json)" << endl;
+    cout << "\t-t (--tolerance) [percent] : allowed regression over the baseline (default: " << SPLASH_BENCH_DEFAULT_TOLERANCE << ")" << endl;
+    cout << "The first " << SPLASH_BENCH_WARMUP_FRAMES << " frames are not measured." << endl;
+    cout << "Exit status: 0 on success, 1 if a stage regressed, 2 if the benchmark could not run" << endl;
+}
+
+/*************/
+bool loadJson(const string& filename, Json::Value& json)
+{
+    ifstream in(filename, ios::in | ios::binary);
+    if (!in)
+    {
+        Log::get() << Log::ERROR << "splash-bench - Unable to open file " << filename << Log::endl;
+        return false;
+    }
+
+    Json::Reader reader;
+    if (!reader.parse(in, json))
+    {
+        Log::get() << Log::ERROR << "splash-bench - Unable to parse file " << filename << ": " << reader.getFormattedErrorMessages() << Log::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+Json::Value getStagesTimings()
+{
+    Json::Value stages;
+    for (const auto& statistics : Timer::get().getStatistics())
+    {
+        Json::Value stage;
+        stage["count"] = static_cast<Json::UInt64>(statistics.second.count);
+        stage["p50"] = static_cast<Json::UInt64>(statistics.second.p50);
+        stage["p99"] = static_cast<Json::UInt64>(statistics.second.p99);
+        stage["max"] = static_cast<Json::UInt64>(statistics.second.max);
+        stages[statistics.first] = stage;
+    }
+    return stages;
+}
+
+/*************/
+bool checkRegressions(const Json::Value& stages, const Json::Value& baselineStages, double tolerance)
+{
+    bool regressed = false;
+    for (const auto& name : baselineStages.getMemberNames())
+    {
+        auto baselineDuration = baselineStages[name]["p50"].asUInt64();
+        if (baselineDuration < SPLASH_BENCH_MIN_DURATION)
+            continue;
+
+        // A stage which disappeared can not be compared, and may hide a broken configuration
+        if (!stages.isMember(name))
+        {
+            cout << "Missing stage " << name << ", baseline is " << baselineDuration << "us" << endl;
+            regressed = true;
+            continue;
+        }
+
+        auto duration = stages[name]["p50"].asUInt64();
+        if (static_cast<double>(duration) > static_cast<double>(baselineDuration) * (1.0 + tolerance / 100.0))
+        {
+            cout << "Regression of stage " << name << ": " << duration << "us, baseline is " << baselineDuration << "us" << endl;
+            regressed = true;
+        }
+    }
+    return regressed;
+}
+} // end of anonymous namespace
+
+/*************/
+int main(int argc, char** argv)
+{
+    // Scenes which can not run in this process are spawned as child processes of this executable
+    for (int i = 1; i < argc; ++i)
+    {
+        if (string(argv[i]) == "--child" || string(argv[i]) == "-c")
+        {
+            World world(argc, argv);
+            world.run();
+            return world.getStatus();
+        }
+    }
+
+    uint64_t frameCount = SPLASH_BENCH_DEFAULT_FRAMES;
+    double tolerance = SPLASH_BENCH_DEFAULT_TOLERANCE;
+    string outputPath = "splash-bench.json";
+    string baselinePath = "";
+
+    while (true)
+    {
+        static struct option longOptions[] = {{"baseline", required_argument, 0, 'b'},
+            {"frames", required_argument, 0, 'f'},
+            {"help", no_argument, 0, 'h'},
+            {"output", required_argument, 0, 'o'},
+            {"tolerance", required_argument, 0, 't'},
+            {0, 0, 0, 0}};
+
+        int optionIndex = 0;
+        auto ret = getopt_long(argc, argv, "b:f:ho:t:", longOptions, &optionIndex);
+
+        if (ret == -1)
+            break;
+
+        switch (ret)
+        {
+        default:
+        {
+            printHelp();
+            return 2;
+        }
+        case 'h':
+        {
+            printHelp();
+            return 0;
+        }
+        case 'b':
+        {
+            baselinePath = string(optarg);
+            break;
+        }
+        case 'f':
+        {
+            frameCount = max(1, atoi(optarg));
+            break;
+        }
+        case 'o':
+        {
+            outputPath = string(optarg);
+            break;
+        }
+        case 't':
+        {
+            tolerance = max(0.0, atof(optarg));
+            break;
+        }
+        }
+    }
+
+    string configPath = optind < argc ? string(argv[optind]) : string(DATADIR) + "benchmark.json";
+
+    // Checked here, as the World exits on invalid configurations
+    Json::Value config;
+    if (!loadJson(configPath, config))
+        return 2;
+
+    Json::Value baseline;
+    if (!baselinePath.empty() && !loadJson(baselinePath, baseline))
+        return 2;
+
+    // The World parses its own arguments, so getopt has to be reset
+    string hideArg = "--hide";
+    vector<char*> worldArgv = {argv[0], const_cast<char*>(hideArg.c_str()), const_cast<char*>(configPath.c_str()), nullptr};
+    optind = 0;
+    World world(static_cast<int>(worldArgv.size()) - 1, worldArgv.data());
+
+    // Frames are counted from the Scene timings, and the World is stopped once enough of them were rendered
+    // The statistics are reset after the warm-up, so that they only hold the measured frames
+    atomic_bool worldRunning{true};
+    bool completed = false;
+    uint64_t renderedFrames = 0;
+    int64_t firstFrameTime = 0;
+    int64_t lastFrameTime = 0;
+    thread watcher([&]() {
+        auto lastProgressTime = Timer::getTime();
+        bool warmedUp = false;
+        uint64_t warmupFrames = 0;
+        while (worldRunning)
+        {
+            this_thread::sleep_for(chrono::milliseconds(10));
+            auto currentTime = Timer::getTime();
+            auto frames = Timer::get().getStatistics("rendering").count;
+            if (!warmedUp)
+            {
+                if (frames != warmupFrames)
+                {
+                    warmupFrames = frames;
+                    lastProgressTime = currentTime;
+                }
+
+                if (frames >= SPLASH_BENCH_WARMUP_FRAMES)
+                {
+                    Timer::get().resetStatistics();
+                    warmedUp = true;
+                }
+            }
+            else if (frames != renderedFrames)
+            {
+                if (renderedFrames == 0)
+                    firstFrameTime = currentTime;
+                renderedFrames = frames;
+                lastFrameTime = currentTime;
+                lastProgressTime = currentTime;
+            }
+
+            if (renderedFrames >= frameCount)
+            {
+                completed = true;
+                break;
+            }
+
+            if (currentTime - lastProgressTime > SPLASH_BENCH_TIMEOUT * 1000000ll)
+            {
+                Log::get() << Log::ERROR << "splash-bench - No frame rendered for " << SPLASH_BENCH_TIMEOUT << " seconds, giving up" << Log::endl;
+                break;
+            }
+        }
+        world.set(world.getName(), "quit", {});
+    });
+
+    world.run();
+    worldRunning = false;
+    watcher.join();
+
+    Json::Value results;
+    results["configuration"] = configPath;
+    results["frames"] = static_cast<Json::UInt64>(renderedFrames);
+    if (renderedFrames > 1 && lastFrameTime > firstFrameTime)
+        results["framerate"] = static_cast<double>(renderedFrames - 1) * 1e6 / static_cast<double>(lastFrameTime - firstFrameTime);
+    results["configToFirstFrame"] = static_cast<Json::UInt64>(Timer::get().getDuration("config_to_first_frame"));
+    results["stages"] = getStagesTimings();
+
+    ofstream out(outputPath, ios::out | ios::binary | ios::trunc);
+    out << results.toStyledString();
+    if (!out)
+    {
+        Log::get() << Log::ERROR << "splash-bench - Unable to write the results to " << outputPath << Log::endl;
+        return 2;
+    }
+
+    if (!completed)
+    {
+        Log::get() << Log::ERROR << "splash-bench - Only " << renderedFrames << " frames out of " << frameCount << " were rendered" << Log::endl;
+        return 2;
+    }
+
+    if (!baselinePath.empty() && checkRegressions(results["stages"], baseline["stages"], tolerance))
+        return 1;
+
+    return 0;
+}
@@ -30,8 +30,6 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "./hap.h"
-
 #include "./config.h"
 #include "./core/coretypes.h"
 #include "./utils/log.h"
@@ -237,15 +235,6 @@ inline glm::dmat4 getProjectionMatrix(float fov, float near, float far, float wi
     return glm::frustum(l, r, b, t, n, f);
 }
 
-/*************/
-// HAP
-/*************/
-// Hap chunk callback
-void hapDecodeCallback(HapDecodeWorkFunction func, void* p, unsigned int count, void* info);
-// Decode a Hap frame
-// If out is null, only sets the format
-bool hapDecodeFrame(void* in, unsigned int inSize, void* out, unsigned int outSize, std::string& format);
-
 } // end of namespace
 
 #endif
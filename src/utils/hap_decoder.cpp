@@ -0,0 +1,277 @@
+#include "./utils/hap_decoder.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <future>
+
+#include <snappy.h>
+
+#include "./core/thread_pool.h"
+#include "./utils/log.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+
+// Section types and second-stage compressors, as defined by the Hap specification
+const uint8_t hapSectionDecodeInstructions = 0x01;
+const uint8_t hapSectionChunkCompressors = 0x02;
+const uint8_t hapSectionChunkSizes = 0x03;
+const uint8_t hapSectionChunkOffsets = 0x04;
+
+const uint8_t hapCompressorNone = 0x0A;
+const uint8_t hapCompressorSnappy = 0x0B;
+const uint8_t hapCompressorComplex = 0x0C;
+
+const uint8_t hapFormatRgbDxt1 = 0x0B;
+const uint8_t hapFormatRgbaDxt5 = 0x0E;
+const uint8_t hapFormatYcocgDxt5 = 0x0F;
+
+/*************/
+uint32_t readUint32(const uint8_t* data)
+{
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 | static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+/*************/
+// A section starts with its size on 3 bytes followed by its type, or with a null size followed by the type and the size on 4 bytes
+bool readSectionHeader(const uint8_t* data, size_t size, size_t& headerSize, size_t& sectionSize, uint8_t& type)
+{
+    if (size < 4)
+        return false;
+
+    sectionSize = static_cast<size_t>(data[0]) | static_cast<size_t>(data[1]) << 8 | static_cast<size_t>(data[2]) << 16;
+    type = data[3];
+    headerSize = 4;
+
+    if (sectionSize == 0)
+    {
+        if (size < 8)
+            return false;
+        sectionSize = readUint32(data + 4);
+        headerSize = 8;
+    }
+
+    return sectionSize <= size - headerSize;
+}
+
+} // end of anonymous namespace
+
+/*************/
+bool HapDecoder::parse(const void* data, size_t size)
+{
+    _format.clear();
+    _chunks.clear();
+    _decodedSize = 0;
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    size_t headerSize, sectionSize;
+    uint8_t type;
+    if (!readSectionHeader(bytes, size, headerSize, sectionSize, type))
+    {
+        Log::get() << Log::WARNING << "HapDecoder::" << __FUNCTION__ << " - Invalid frame header. Frame discarded" << Log::endl;
+        return false;
+    }
+
+    switch (type & 0x0F)
+    {
+    default:
+        Log::get() << Log::WARNING << "HapDecoder::" << __FUNCTION__ << " - Unknown texture format. Frame discarded" << Log::endl;
+        return false;
+    case hapFormatRgbDxt1:
+        _format = "RGB_DXT1";
+        break;
+    case hapFormatRgbaDxt5:
+        _format = "RGBA_DXT5";
+        break;
+    case hapFormatYcocgDxt5:
+        _format = "YCoCg_DXT5";
+        break;
+    }
+
+    auto payload = bytes + headerSize;
+    bool isValid = true;
+    switch (type >> 4)
+    {
+    default:
+        isValid = false;
+        break;
+    case hapCompressorNone:
+    case hapCompressorSnappy:
+    {
+        Chunk chunk;
+        chunk.data = reinterpret_cast<const char*>(payload);
+        chunk.size = sectionSize;
+        chunk.snappy = (type >> 4) == hapCompressorSnappy;
+        _chunks.push_back(chunk);
+        break;
+    }
+    case hapCompressorComplex:
+        isValid = parseDecodeInstructions(payload, sectionSize);
+        break;
+    }
+
+    // Chunks are decoded one after the other in the output buffer
+    for (auto& chunk : _chunks)
+    {
+        if (!isValid)
+            break;
+
+        if (chunk.snappy)
+            isValid = snappy::GetUncompressedLength(chunk.data, chunk.size, &chunk.outputSize);
+        else
+            chunk.outputSize = chunk.size;
+
+        chunk.outputOffset = _decodedSize;
+        _decodedSize += chunk.outputSize;
+    }
+
+    if (!isValid || _chunks.empty())
+    {
+        Log::get() << Log::WARNING << "HapDecoder::" << __FUNCTION__ << " - Invalid frame data. Frame discarded" << Log::endl;
+        _format.clear();
+        _chunks.clear();
+        _decodedSize = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/*************/
+bool HapDecoder::parseDecodeInstructions(const uint8_t* data, size_t size)
+{
+    size_t headerSize, sectionSize;
+    uint8_t type;
+    if (!readSectionHeader(data, size, headerSize, sectionSize, type) || type != hapSectionDecodeInstructions)
+        return false;
+
+    const uint8_t* compressors = nullptr;
+    const uint8_t* sizes = nullptr;
+    const uint8_t* offsets = nullptr;
+    size_t compressorsSize = 0, sizesSize = 0, offsetsSize = 0;
+
+    auto instructions = data + headerSize;
+    auto remaining = sectionSize;
+    while (remaining > 0)
+    {
+        size_t innerHeaderSize, innerSectionSize;
+        uint8_t innerType;
+        if (!readSectionHeader(instructions, remaining, innerHeaderSize, innerSectionSize, innerType))
+            return false;
+
+        auto content = instructions + innerHeaderSize;
+        if (innerType == hapSectionChunkCompressors)
+        {
+            compressors = content;
+            compressorsSize = innerSectionSize;
+        }
+        else if (innerType == hapSectionChunkSizes)
+        {
+            sizes = content;
+            sizesSize = innerSectionSize;
+        }
+        else if (innerType == hapSectionChunkOffsets)
+        {
+            offsets = content;
+            offsetsSize = innerSectionSize;
+        }
+
+        instructions += innerHeaderSize + innerSectionSize;
+        remaining -= innerHeaderSize + innerSectionSize;
+    }
+
+    auto chunkCount = compressorsSize;
+    if (!compressors || !sizes || chunkCount == 0 || sizesSize != chunkCount * 4 || (offsets && offsetsSize != chunkCount * 4))
+        return false;
+
+    // Chunk offsets are relative to the end of the decode instructions
+    auto chunkData = data + headerSize + sectionSize;
+    auto chunkDataSize = size - headerSize - sectionSize;
+    size_t position = 0;
+
+    _chunks.resize(chunkCount);
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        auto& chunk = _chunks[i];
+        chunk.size = readUint32(sizes + i * 4);
+        size_t offset = offsets ? readUint32(offsets + i * 4) : position;
+        if (offset > chunkDataSize || chunk.size > chunkDataSize - offset)
+            return false;
+
+        if (compressors[i] == hapCompressorSnappy)
+            chunk.snappy = true;
+        else if (compressors[i] != hapCompressorNone)
+            return false;
+
+        chunk.data = reinterpret_cast<const char*>(chunkData + offset);
+        position = offset + chunk.size;
+    }
+
+    return true;
+}
+
+/*************/
+bool HapDecoder::decode(void* out, size_t outSize, bool useThreadPool) const
+{
+    if (_chunks.empty() || outSize < _decodedSize)
+        return false;
+
+    auto output = static_cast<char*>(out);
+    atomic_bool success{true};
+    if (_chunks.size() == 1 || !useThreadPool)
+    {
+        for (const auto& chunk : _chunks)
+            if (!decodeChunk(chunk, output))
+                success = false;
+    }
+    else
+    {
+        vector<future<void>> tasks;
+        for (const auto& chunk : _chunks)
+            tasks.push_back(ThreadPool::get().enqueue([&success, &chunk, output]() {
+                if (!decodeChunk(chunk, output))
+                    success = false;
+            }));
+        ThreadPool::get().waitAll(tasks);
+    }
+
+    if (!success)
+        Log::get() << Log::WARNING << "HapDecoder::" << __FUNCTION__ << " - An error occured while decoding frame" << Log::endl;
+
+    return success;
+}
+
+/*************/
+bool HapDecoder::decodeChunk(const Chunk& chunk, char* out)
+{
+    if (chunk.snappy)
+        return snappy::RawUncompress(chunk.data, chunk.size, out + chunk.outputOffset);
+
+    memcpy(out + chunk.outputOffset, chunk.data, chunk.size);
+    return true;
+}
+
+/*************/
+ImageBufferSpec HapDecoder::getImageSpec(int width, int height, const string& format)
+{
+    // We are using kind of a hack to store a DXT compressed image in an ImageBuffer
+    // We set the size so as to have just enough place for the given texture format
+    ImageBufferSpec spec;
+    if (format == "RGB_DXT1")
+        spec = ImageBufferSpec(width, (int)(ceil((float)height / 2.f)), 1, 8, ImageBufferSpec::Type::UINT8);
+    else if (format == "RGBA_DXT5" || format == "YCoCg_DXT5")
+        spec = ImageBufferSpec(width, height, 1, 8, ImageBufferSpec::Type::UINT8);
+    else
+        return spec;
+
+    spec.format = format;
+    return spec;
+}
+
+} // end of namespace
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @hap_decoder.h
+ * Decoder for Hap frames, decompressing their chunks in parallel
+ */
+
+#ifndef SPLASH_HAP_DECODER_H
+#define SPLASH_HAP_DECODER_H
+
+#include <string>
+#include <vector>
+
+#include "./core/imagebuffer.h"
+
+namespace Splash
+{
+
+/*************/
+class HapDecoder
+{
+  public:
+    /**
+     * \brief Parse the header of a Hap frame. The frame is not copied and must stay valid until it is decoded
+     * \param data Frame data
+     * \param size Frame size
+     * \return Return true if the frame is a valid Hap frame with a supported texture format
+     */
+    bool parse(const void* data, size_t size);
+
+    /**
+     * \brief Decode the last parsed frame, decompressing its chunks on the thread pool
+     * \param out Output buffer
+     * \param outSize Output buffer size, which must be at least getDecodedSize()
+     * \param useThreadPool If false, the chunks are decompressed on the calling thread
+     * \return Return true if the frame has been decoded
+     */
+    bool decode(void* out, size_t outSize, bool useThreadPool = true) const;
+
+    /**
+     * \brief Get the texture format of the last parsed frame, among RGB_DXT1, RGBA_DXT5 and YCoCg_DXT5
+     * \return Return the texture format
+     */
+    std::string getFormat() const { return _format; }
+
+    /**
+     * \brief Get the size of the last parsed frame, once decoded
+     * \return Return the size in bytes
+     */
+    size_t getDecodedSize() const { return _decodedSize; }
+
+    /**
+     * \brief Get the number of chunks of the last parsed frame
+     * \return Return the chunk count
+     */
+    size_t getChunkCount() const { return _chunks.size(); }
+
+    /**
+     * \brief Get the spec of the image buffer to decode a frame into
+     * \param width Video width
+     * \param height Video height
+     * \param format Texture format, as returned by getFormat()
+     * \return Return the spec, which has a null size if the format is not supported
+     */
+    static ImageBufferSpec getImageSpec(int width, int height, const std::string& format);
+
+  private:
+    struct Chunk
+    {
+        const char* data{nullptr};
+        size_t size{0};
+        size_t outputOffset{0};
+        size_t outputSize{0};
+        bool snappy{false};
+    };
+
+    std::string _format{};
+    std::vector<Chunk> _chunks{};
+    size_t _decodedSize{0};
+
+    /**
+     * \brief Parse the decode instructions of a chunked frame, and the chunks following them
+     * \param data Frame data, starting with the decode instructions
+     * \param size Frame size
+     * \return Return true if the instructions are valid
+     */
+    bool parseDecodeInstructions(const uint8_t* data, size_t size);
+
+    /**
+     * \brief Decode a single chunk
+     * \param chunk Chunk to decode
+     * \param out Output buffer
+     * \return Return true if the chunk has been decoded
+     */
+    static bool decodeChunk(const Chunk& chunk, char* out);
+};
+
+} // end of namespace
+
+#endif // SPLASH_HAP_DECODER_H
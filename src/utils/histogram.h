@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2018 Emmanuel Durand
+ *
+ * This file is part of Splash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Splash is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Splash.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * @histogram.h
+ * Fixed size histogram with logarithmic buckets, in the spirit of HdrHistogram
+ */
+
+#ifndef SPLASH_HISTOGRAM_H
+#define SPLASH_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#define SPLASH_HISTOGRAM_PRECISION_BITS 5 // 32 buckets per power of two, for a relative error below 3%
+
+namespace Splash
+{
+
+/*************/
+// Values up to 2^32 are counted, higher values are clamped. Values below 64 are counted exactly.
+// Recording is lock-free, and safe as long as a single thread records into a given histogram.
+class Histogram
+{
+  public:
+    /**
+     * \brief Add a value to the histogram
+     * \param value Value to add
+     */
+    void record(uint64_t value)
+    {
+        value = std::min(value, static_cast<uint64_t>(_highestValue));
+        _buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+
+        auto currentMax = _max.load(std::memory_order_relaxed);
+        while (value > currentMax && !_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed))
+            continue;
+    }
+
+    /**
+     * \brief Add the values of another histogram to this one
+     * \param histogram Histogram to merge
+     */
+    void merge(const Histogram& histogram)
+    {
+        for (uint32_t i = 0; i < _bucketCount; ++i)
+        {
+            auto count = histogram._buckets[i].load(std::memory_order_relaxed);
+            if (count)
+                _buckets[i].fetch_add(count, std::memory_order_relaxed);
+        }
+        _count.fetch_add(histogram._count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        _max.store(std::max(_max.load(std::memory_order_relaxed), histogram._max.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Remove all values from the histogram
+     */
+    void reset()
+    {
+        for (auto& bucket : _buckets)
+            bucket.store(0, std::memory_order_relaxed);
+        _count.store(0, std::memory_order_relaxed);
+        _max.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Get the number of recorded values
+     * \return Return the value count
+     */
+    uint64_t getCount() const { return _count.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Get the highest recorded value
+     * \return Return the maximum
+     */
+    uint64_t getMax() const { return _max.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Get the value below which the given percentage of the recorded values fall
+     * \param percentile Percentile, between 0 and 100
+     * \return Return the highest value of the bucket holding the percentile, or 0 if the histogram is empty
+     */
+    uint64_t getPercentile(double percentile) const
+    {
+        auto count = getCount();
+        if (count == 0)
+            return 0;
+
+        auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::min(100.0, std::max(0.0, percentile)) * 0.01 * count)));
+        uint64_t cumulated = 0;
+        for (uint32_t i = 0; i < _bucketCount; ++i)
+        {
+            cumulated += _buckets[i].load(std::memory_order_relaxed);
+            if (cumulated >= target)
+                return std::min(getBucketHighestValue(i), getMax());
+        }
+
+        return getMax();
+    }
+
+  private:
+    static const uint32_t _subBucketCount{1 << SPLASH_HISTOGRAM_PRECISION_BITS};
+    static const uint32_t _linearCount{2 * _subBucketCount};
+    static const uint32_t _bucketCount{_linearCount + (32 - SPLASH_HISTOGRAM_PRECISION_BITS - 1) * _subBucketCount};
+    static const uint64_t _highestValue{0xFFFFFFFF};
+
+    std::array<std::atomic_uint, _bucketCount> _buckets{};
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _max{0};
+
+    /**
+     * \brief Get the bucket holding the given value
+     * \param value Value, up to _highestValue
+     * \return Return the bucket index
+     */
+    static uint32_t getBucketIndex(uint64_t value)
+    {
+        if (value < _linearCount)
+            return static_cast<uint32_t>(value);
+
+        uint32_t magnitude = 63 - __builtin_clzll(value);
+        uint32_t shift = magnitude - SPLASH_HISTOGRAM_PRECISION_BITS;
+        return _linearCount + (magnitude - SPLASH_HISTOGRAM_PRECISION_BITS - 1) * _subBucketCount + static_cast<uint32_t>((value >> shift) - _subBucketCount);
+    }
+
+    /**
+     * \brief Get the highest value held by the given bucket
+     * \param index Bucket index
+     * \return Return the value
+     */
+    static uint64_t getBucketHighestValue(uint32_t index)
+    {
+        if (index < _linearCount)
+            return index;
+
+        uint32_t shift = (index - _linearCount) / _subBucketCount + 1;
+        uint64_t subBucket = (index - _linearCount) % _subBucketCount + _subBucketCount;
+        return ((subBucket + 1) << shift) - 1;
+    }
+};
+
+} // end of namespace
+
+#endif // SPLASH_HISTOGRAM_H
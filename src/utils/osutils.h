@@ -201,6 +201,27 @@ inline std::string getHomePath()
     return std::string(pw->pw_dir);
 }
 
+/**
+ * \brief Get the path where Splash stores its cached data, creating it if needed
+ * \return Return the cache path, or an empty string if it could not be created
+ */
+inline std::string getCachePath()
+{
+    std::string basePath;
+    if (getenv("XDG_CACHE_HOME"))
+        basePath = std::string(getenv("XDG_CACHE_HOME"));
+    else
+        basePath = getHomePath() + "/.cache";
+
+    auto cachePath = basePath + "/splash/";
+    mkdir(basePath.c_str(), 0755);
+    mkdir(cachePath.c_str(), 0755);
+    if (!isDir(cachePath))
+        return "";
+
+    return cachePath;
+}
+
 /**
  * \brief Get the directory path from the file path.
  * \param filepath File path
@@ -0,0 +1,302 @@
+#include "./utils/timer.h"
+
+#include <algorithm>
+#include <array>
+
+#include "./utils/log.h"
+
+using namespace std;
+
+namespace Splash
+{
+
+namespace
+{
+// Each thread keeps its own cache of identifiers, so that no lock is needed once a timer is known
+thread_local unordered_map<string, Timer::Id> localIds;
+} // end of anonymous namespace
+
+/*************/
+struct Timer::ThreadHistograms
+{
+    array<atomic<Histogram*>, SPLASH_TIMER_MAX_COUNT> histograms{};
+
+    ~ThreadHistograms()
+    {
+        for (auto& histogram : histograms)
+            delete histogram.load();
+    }
+};
+
+/*************/
+Timer::Id Timer::getId(const string& name)
+{
+    auto localIdIt = localIds.find(name);
+    if (localIdIt != localIds.end() && isCurrent(localIdIt->second))
+        return localIdIt->second;
+
+    Id id;
+    {
+        lock_guard<mutex> lock(_registryMutex);
+        auto idIt = _ids.find(name);
+        if (idIt != _ids.end())
+        {
+            id.index = idIt->second;
+        }
+        else
+        {
+            uint32_t index;
+            if (!_freeSlots.empty())
+            {
+                index = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            else
+            {
+                index = _slotCount.load(memory_order_acquire);
+                if (index == SPLASH_TIMER_MAX_COUNT)
+                {
+                    // Invalid identifiers are not cached, so that a slot released later can be used
+                    if (!_slotsExhaustedWarned)
+                        Log::get() << Log::WARNING << "Timer::" << __FUNCTION__ << " - Maximum number of timers reached, timer " << name << " and the next ones are ignored"
+                                   << Log::endl;
+                    _slotsExhaustedWarned = true;
+                    return id;
+                }
+                _slotCount.store(index + 1, memory_order_release);
+            }
+
+            _slots[index].name = name;
+            _ids[name] = index;
+            id.index = index;
+        }
+        id.generation = _slots[id.index].generation.load(memory_order_acquire);
+    }
+
+    localIds[name] = id;
+    return id;
+}
+
+/*************/
+Timer::Id Timer::findId(const string& name) const
+{
+    auto localIdIt = localIds.find(name);
+    if (localIdIt != localIds.end() && isCurrent(localIdIt->second))
+        return localIdIt->second;
+
+    Id id;
+    lock_guard<mutex> lock(_registryMutex);
+    auto idIt = _ids.find(name);
+    if (idIt != _ids.end())
+    {
+        id.index = idIt->second;
+        id.generation = _slots[id.index].generation.load(memory_order_acquire);
+        localIds[name] = id;
+    }
+    return id;
+}
+
+/*************/
+void Timer::release(const string& name)
+{
+    lock_guard<mutex> lock(_registryMutex);
+    auto idIt = _ids.find(name);
+    if (idIt == _ids.end())
+        return;
+
+    auto index = idIt->second;
+    _ids.erase(idIt);
+
+    // Changing the generation first invalidates the identifiers held by the users of this timer
+    auto& slot = _slots[index];
+    slot.generation.fetch_add(1, memory_order_acq_rel);
+    slot.name.clear();
+    slot.started.store(false, memory_order_release);
+    slot.hasDuration.store(false, memory_order_release);
+    slot.duration.store(0, memory_order_release);
+    resetHistograms(index);
+
+    _freeSlots.push_back(index);
+    _slotsExhaustedWarned = false;
+}
+
+/*************/
+void Timer::resetStatistics()
+{
+    {
+        lock_guard<mutex> lock(_registryMutex);
+        auto slotCount = _slotCount.load(memory_order_acquire);
+        for (uint32_t i = 0; i < slotCount; ++i)
+            resetHistograms(i);
+    }
+
+    lock_guard<Spinlock> lock(_statisticsMutex);
+    _remoteStatistics.clear();
+}
+
+/*************/
+void Timer::record(Id id, unsigned long long duration)
+{
+    if (!isCurrent(id))
+        return;
+
+    auto& slot = _slots[id.index];
+    slot.duration.store(duration, memory_order_release);
+    slot.hasDuration.store(true, memory_order_release);
+
+    auto& histogram = getThreadHistograms().histograms[id.index];
+    auto histogramPtr = histogram.load(memory_order_acquire);
+    if (!histogramPtr)
+    {
+        histogramPtr = new Histogram();
+        histogram.store(histogramPtr, memory_order_release);
+    }
+    histogramPtr->record(duration);
+}
+
+/*************/
+unordered_map<string, unsigned long long> Timer::getDurationMap() const
+{
+    unordered_map<string, unsigned long long> durations;
+    // The registry is locked as the names of released slots change
+    lock_guard<mutex> lock(_registryMutex);
+    auto slotCount = _slotCount.load(memory_order_acquire);
+    for (uint32_t i = 0; i < slotCount; ++i)
+        if (!_slots[i].name.empty() && _slots[i].hasDuration.load(memory_order_acquire))
+            durations[_slots[i].name] = _slots[i].duration.load(memory_order_acquire);
+    return durations;
+}
+
+/*************/
+Timer::Statistics Timer::getStatistics(const string& name) const
+{
+    Statistics statistics;
+    auto id = findId(name);
+    if (id)
+    {
+        Histogram histogram;
+        mergeHistograms(id.index, histogram);
+        statistics = {histogram.getCount(), histogram.getPercentile(50.0), histogram.getPercentile(99.0), histogram.getMax()};
+    }
+
+    if (statistics.count == 0)
+    {
+        lock_guard<Spinlock> lock(_statisticsMutex);
+        auto remoteIt = _remoteStatistics.find(name);
+        if (remoteIt != _remoteStatistics.end())
+            statistics = remoteIt->second;
+    }
+
+    return statistics;
+}
+
+/*************/
+unordered_map<string, Timer::Statistics> Timer::getStatistics() const
+{
+    unordered_map<string, Statistics> statistics;
+    {
+        lock_guard<Spinlock> lock(_statisticsMutex);
+        statistics = _remoteStatistics;
+    }
+
+    Histogram histogram;
+    lock_guard<mutex> lock(_registryMutex);
+    auto slotCount = _slotCount.load(memory_order_acquire);
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        if (_slots[i].name.empty())
+            continue;
+
+        histogram.reset();
+        mergeHistograms(i, histogram);
+        if (histogram.getCount() == 0)
+            continue;
+
+        statistics[_slots[i].name] = {histogram.getCount(), histogram.getPercentile(50.0), histogram.getPercentile(99.0), histogram.getMax()};
+    }
+
+    return statistics;
+}
+
+/*************/
+Timer::ThreadHistograms& Timer::getThreadHistograms()
+{
+    // Registers the histograms of the thread on first use, and merges them into the retired ones when the thread ends
+    struct Registration
+    {
+        shared_ptr<ThreadHistograms> histograms{make_shared<ThreadHistograms>()};
+
+        Registration()
+        {
+            auto& timer = Timer::get();
+            lock_guard<mutex> lock(timer._histogramsMutex);
+            timer._threadHistograms.push_back(histograms);
+        }
+
+        ~Registration()
+        {
+            auto& timer = Timer::get();
+            lock_guard<mutex> lock(timer._histogramsMutex);
+            if (!timer._retiredHistograms)
+                timer._retiredHistograms = make_shared<ThreadHistograms>();
+
+            for (uint32_t i = 0; i < SPLASH_TIMER_MAX_COUNT; ++i)
+            {
+                auto histogram = histograms->histograms[i].load(memory_order_acquire);
+                if (!histogram)
+                    continue;
+
+                auto& retired = timer._retiredHistograms->histograms[i];
+                if (!retired.load(memory_order_acquire))
+                    retired.store(new Histogram(), memory_order_release);
+                retired.load(memory_order_acquire)->merge(*histogram);
+            }
+
+            auto& threadHistograms = timer._threadHistograms;
+            threadHistograms.erase(std::remove(threadHistograms.begin(), threadHistograms.end(), histograms), threadHistograms.end());
+        }
+    };
+
+    static thread_local Registration registration;
+    return *registration.histograms;
+}
+
+/*************/
+void Timer::mergeHistograms(uint32_t index, Histogram& histogram) const
+{
+    lock_guard<mutex> lock(_histogramsMutex);
+    for (const auto& threadHistograms : _threadHistograms)
+    {
+        auto threadHistogram = threadHistograms->histograms[index].load(memory_order_acquire);
+        if (threadHistogram)
+            histogram.merge(*threadHistogram);
+    }
+
+    if (_retiredHistograms)
+    {
+        auto retiredHistogram = _retiredHistograms->histograms[index].load(memory_order_acquire);
+        if (retiredHistogram)
+            histogram.merge(*retiredHistogram);
+    }
+}
+
+/*************/
+void Timer::resetHistograms(uint32_t index)
+{
+    lock_guard<mutex> lock(_histogramsMutex);
+    for (const auto& threadHistograms : _threadHistograms)
+    {
+        auto threadHistogram = threadHistograms->histograms[index].load(memory_order_acquire);
+        if (threadHistogram)
+            threadHistogram->reset();
+    }
+
+    if (_retiredHistograms)
+    {
+        auto retiredHistogram = _retiredHistograms->histograms[index].load(memory_order_acquire);
+        if (retiredHistogram)
+            retiredHistogram->reset();
+    }
+}
+
+} // end of namespace
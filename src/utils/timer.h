@@ -29,14 +29,19 @@
 #include <chrono>
 #include <ctime>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "./config.h"
 #include "./core/coretypes.h"
 #include "./core/spinlock.h"
+#include "./utils/histogram.h"
+
+#define SPLASH_TIMER_MAX_COUNT 1024
 
 namespace Splash
 {
@@ -56,6 +61,27 @@ class Timer
         bool paused{false};
     };
 
+    /**
+     * Identifier of a registered timer
+     */
+    struct Id
+    {
+        uint32_t index{SPLASH_TIMER_MAX_COUNT};
+        uint32_t generation{0}; //!< Generation of the slot, which changes when the timer is released and its slot reused
+        explicit operator bool() const { return index < SPLASH_TIMER_MAX_COUNT; }
+    };
+
+    /**
+     * Statistics over all the measures of a timer, in us
+     */
+    struct Statistics
+    {
+        uint64_t count{0};
+        uint64_t p50{0};
+        uint64_t p99{0};
+        uint64_t max{0};
+    };
+
     /**
      * \brief Get the singleton
      * \return Return the Timer singleton
@@ -89,65 +115,80 @@ class Timer
      */
     bool isLoose() const { return _looseClock; }
 
+    /**
+     * \brief Get the identifier of a timer, registering it if needed
+     * \brief Using identifiers instead of names avoids looking up the timer by name at each call
+     * \param name Timer name
+     * \return Return the timer identifier, which is invalid if too many timers were registered
+     */
+    Id getId(const std::string& name);
+
+    /**
+     * \brief Release a timer, so that its slot can be reused. Identifiers of this timer become invalid
+     * \brief This should be called for timers named after objects, once the object is destroyed
+     * \param name Timer name
+     */
+    void release(const std::string& name);
+
+    /**
+     * \brief Clear the statistics of all the timers, for example to start a measurement after a warm-up
+     */
+    void resetStatistics();
+
     /**
      * \brief Start a duration measurement
-     * \param name Duration name
+     * \param id Timer identifier
      */
-    void start(const std::string& name)
+    void start(Id id)
     {
-        if (!_enabled)
+        if (!_enabled || !isCurrent(id))
             return;
 
-        auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-        auto timeIt = _timeMap.find(name);
-        if (timeIt == _timeMap.end())
-            _timeMap[name].store(currentTime, std::memory_order_acq_rel);
-        else
-            timeIt->second = currentTime;
+        auto& slot = _slots[id.index];
+        slot.start.store(getTime(), std::memory_order_release);
+        slot.started.store(true, std::memory_order_release);
     }
+    void start(const std::string& name) { start(getId(name)); }
 
     /**
-     * \brief End a duration measurement
-     * \param name Duration name
+     * \brief End a duration measurement, and add it to the timer statistics
+     * \param id Timer identifier
      */
-    void stop(const std::string& name)
+    void stop(Id id)
     {
-        if (!_enabled)
+        if (!_enabled || !isCurrent(id))
             return;
 
-        auto timeIt = _timeMap.find(name);
-        if (timeIt != _timeMap.end())
-        {
-            auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        auto& slot = _slots[id.index];
+        if (!slot.started.load(std::memory_order_acquire))
+            return;
 
-            auto durationIt = _durationMap.find(name);
-            if (durationIt == _durationMap.end())
-                _durationMap[name].store(currentTime - timeIt->second.load(std::memory_order_acq_rel), std::memory_order_acq_rel);
-            else
-                durationIt->second = currentTime - timeIt->second.load(std::memory_order_acq_rel);
-        }
+        record(id, getTime() - slot.start.load(std::memory_order_acquire));
     }
+    void stop(const std::string& name) { stop(getId(name)); }
+
+    /**
+     * \brief Set the last duration of a timer, and add it to the timer statistics
+     * \param id Timer identifier
+     * \param duration Duration in us
+     */
+    void record(Id id, unsigned long long duration);
 
     /**
      * \brief Wait for the specified timer to reach a certain value, in us
-     * \param name Duration name
+     * \param id Timer identifier
      * \param duration Desired duration
      * \return Return false if the timer does not exist
      */
-    bool waitUntilDuration(const std::string& name, unsigned long long duration)
+    bool waitUntilDuration(Id id, unsigned long long duration)
     {
         if (!_enabled)
             return false;
 
-        if (_timeMap.find(name) == _timeMap.end())
+        if (!isCurrent(id) || !_slots[id.index].started.load(std::memory_order_acquire))
             return false;
 
-        auto currentTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-        auto timeIt = _timeMap.find(name);
-        auto durationIt = _durationMap.find(name);
-        unsigned long long elapsed;
-
-        elapsed = currentTime - timeIt->second.load(std::memory_order_acq_rel);
+        unsigned long long elapsed = getTime() - _slots[id.index].start.load(std::memory_order_acquire);
 
         timespec nap;
         nap.tv_sec = 0;
@@ -160,47 +201,66 @@ class Timer
             overtime = true;
         }
 
-        if (durationIt == _durationMap.end())
-            _durationMap[name].store(std::max(duration, elapsed), std::memory_order_acq_rel);
-        else
-            durationIt->second = std::max(duration, elapsed);
+        record(id, std::max(duration, elapsed));
 
         nanosleep(&nap, NULL);
 
         return overtime;
     }
+    bool waitUntilDuration(const std::string& name, unsigned long long duration) { return waitUntilDuration(getId(name), duration); }
 
     /**
      * \brief Get the last occurence of the specified duration
-     * \param name Duration name
+     * \param id Timer identifier
      * \return Return the duration in us
      */
-    unsigned long long getDuration(const std::string& name) const
-    {
-        auto durationIt = _durationMap.find(name);
-        if (durationIt == _durationMap.end())
-            return 0;
-        return durationIt->second;
-    }
+    unsigned long long getDuration(Id id) const { return isCurrent(id) ? _slots[id.index].duration.load(std::memory_order_acquire) : 0; }
+    unsigned long long getDuration(const std::string& name) const { return getDuration(findId(name)); }
 
     /**
-     * \brief Get the whole duration map
-     * \return Return the whole duration map
+     * \brief Get the last value of all the durations
+     * \return Return the durations, by name
      */
-    const std::unordered_map<std::string, std::atomic_ullong>& getDurationMap() const { return _durationMap; }
+    std::unordered_map<std::string, unsigned long long> getDurationMap() const;
 
     /**
-     * \brief Set an element in the duration map. Used for transmitting timings between pairs
+     * \brief Set an element in the duration map. Used for transmitting timings between pairs, or values which are not timings
+     * \brief The value is not added to the timer statistics
      * \param name Duration name
      * \param value Duration in us
      */
     void setDuration(const std::string& name, unsigned long long value)
     {
-        auto durationIt = _durationMap.find(name);
-        if (durationIt == _durationMap.end())
-            _durationMap[name].store(value, std::memory_order_acq_rel);
-        else
-            durationIt->second = value;
+        auto id = getId(name);
+        if (!id)
+            return;
+
+        _slots[id.index].duration.store(value, std::memory_order_release);
+        _slots[id.index].hasDuration.store(true, std::memory_order_release);
+    }
+
+    /**
+     * \brief Get the statistics of a timer, over all the threads which used it
+     * \param name Timer name
+     * \return Return the statistics, with a count of 0 if there are none
+     */
+    Statistics getStatistics(const std::string& name) const;
+
+    /**
+     * \brief Get the statistics of all the timers, including the ones received from the pairs
+     * \return Return the statistics, by timer name
+     */
+    std::unordered_map<std::string, Statistics> getStatistics() const;
+
+    /**
+     * \brief Set the statistics of a timer measured by a pair, used when no local measure exists
+     * \param name Timer name
+     * \param statistics Timer statistics
+     */
+    void setStatistics(const std::string& name, const Statistics& statistics)
+    {
+        std::lock_guard<Spinlock> lock(_statisticsMutex);
+        _remoteStatistics[name] = statistics;
     }
 
     /**
@@ -210,28 +270,31 @@ class Timer
      */
     unsigned long long sinceLastSeen(const std::string& name)
     {
-        if (_timeMap.find(name) == _timeMap.end())
+        auto id = getId(name);
+        if (!isCurrent(id) || !_slots[id.index].started.load(std::memory_order_acquire))
         {
-            start(name);
+            start(id);
             return 0;
         }
 
-        stop(name);
-        unsigned long long duration = getDuration(name);
-        start(name);
+        stop(id);
+        unsigned long long duration = getDuration(id);
+        start(id);
         return duration;
     }
 
     /**
      * Some facilities
      */
-    Timer& operator<<(const std::string& name)
+    Timer& operator<<(Id id)
     {
-        start(name);
+        start(id);
         _currentDuration.store(0, std::memory_order_acq_rel);
         return *this;
     }
 
+    Timer& operator<<(const std::string& name) { return operator<<(getId(name)); }
+
     Timer& operator>>(unsigned long long duration)
     {
         _timerMutex.lock(); // We lock the mutex to prevent this value to be reset by another call to timer
@@ -241,7 +304,7 @@ class Timer
         return *this;
     }
 
-    bool operator>>(const std::string& name)
+    bool operator>>(Id id)
     {
         unsigned long long duration = 0;
         if (_isDurationSet && _durationThreadId == std::this_thread::get_id())
@@ -254,12 +317,14 @@ class Timer
 
         bool overtime = false;
         if (duration > 0)
-            overtime = waitUntilDuration(name, duration);
+            overtime = waitUntilDuration(id, duration);
         else
-            stop(name);
+            stop(id);
         return overtime;
     }
 
+    bool operator>>(const std::string& name) { return operator>>(getId(name)); }
+
     unsigned long long operator[](const std::string& name) { return getDuration(name); }
 
     /**
@@ -345,14 +410,73 @@ class Timer
     static inline int64_t getTime() { return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
 
   private:
+    struct ThreadHistograms;
+
     Timer() {}
     ~Timer() {}
     Timer(const Timer&) = delete;
     const Timer& operator=(const Timer&) = delete;
 
+    /**
+     * \brief Get the identifier of a timer, without registering it
+     * \param name Timer name
+     * \return Return the timer identifier, which is invalid if the timer does not exist
+     */
+    Id findId(const std::string& name) const;
+
+    /**
+     * \brief Check that an identifier is valid, and that its timer was not released since
+     * \param id Timer identifier
+     * \return Return true if the identifier can be used
+     */
+    bool isCurrent(Id id) const { return id && _slots[id.index].generation.load(std::memory_order_acquire) == id.generation; }
+
+    /**
+     * \brief Get the histograms of the calling thread, creating them if needed
+     * \return Return the histograms
+     */
+    ThreadHistograms& getThreadHistograms();
+
+    /**
+     * \brief Merge the histograms of all the threads for the given timer
+     * \param index Timer index
+     * \param histogram Histogram to merge into
+     */
+    void mergeHistograms(uint32_t index, Histogram& histogram) const;
+
+    /**
+     * \brief Clear the histograms of all the threads for the given timer
+     * \param index Timer index
+     */
+    void resetHistograms(uint32_t index);
+
   private:
-    std::unordered_map<std::string, std::atomic_ullong> _timeMap;
-    std::unordered_map<std::string, std::atomic_ullong> _durationMap;
+    struct Slot
+    {
+        std::string name{}; //!< Empty if the slot is not used
+        std::atomic_uint generation{0};
+        std::atomic_llong start{0};
+        std::atomic_ullong duration{0};
+        std::atomic_bool started{false};
+        std::atomic_bool hasDuration{false};
+    };
+
+    // Slots of released timers are reused, identifiers of the previous timer being invalidated by the slot generation
+    std::unique_ptr<Slot[]> _slots{new Slot[SPLASH_TIMER_MAX_COUNT]};
+    std::atomic_uint _slotCount{0};
+    mutable std::mutex _registryMutex{};
+    std::unordered_map<std::string, uint32_t> _ids{};
+    std::vector<uint32_t> _freeSlots{};
+    bool _slotsExhaustedWarned{false}; //!< The warning about running out of slots is only shown once, until a slot is released
+
+    // Each thread records into its own histograms, merged when reading the statistics
+    mutable std::mutex _histogramsMutex{};
+    std::vector<std::shared_ptr<ThreadHistograms>> _threadHistograms{};
+    std::shared_ptr<ThreadHistograms> _retiredHistograms{}; //!< Histograms of the threads which ended
+
+    mutable Spinlock _statisticsMutex{};
+    std::unordered_map<std::string, Statistics> _remoteStatistics{};
+
     std::atomic_ullong _currentDuration{0};
     bool _isDurationSet{false};
     std::thread::id _durationThreadId;
@@ -0,0 +1,189 @@
+/*
+ * Measures the seek-to-first-frame time of the video files given as arguments (or found in the given directories):
+ * - keyframe: seek to the keyframe before the target and show the first decoded frame, as done before the keyframe index
+ * - indexed: seek to the indexed keyframe before the target and decode forward to the exact frame, as done by Image_FFmpeg
+ * The error is the distance between the target and the frame shown
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#include "./image/keyframe_index.h"
+#include "./utils/osutils.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int seekCount = 32;
+
+/*************/
+struct SeekResult
+{
+    double meanLatency{0.0}; // in ms
+    double maxLatency{0.0};  // in ms
+    double meanError{0.0};   // in ms
+};
+
+/*************/
+// Decode from the current position until a frame at or after the target, and return its timestamp
+bool decodeUntil(AVFormatContext* context, AVCodecContext* codecContext, int streamIndex, int64_t target, AVFrame* frame, int64_t& frameTimestamp)
+{
+    AVPacket packet;
+    av_init_packet(&packet);
+
+    while (av_read_frame(context, &packet) >= 0)
+    {
+        if (packet.stream_index == streamIndex && avcodec_send_packet(codecContext, &packet) == 0)
+        {
+            while (avcodec_receive_frame(codecContext, frame) == 0)
+            {
+                auto timestamp = av_frame_get_best_effort_timestamp(frame);
+                av_frame_unref(frame);
+                if (timestamp >= target)
+                {
+                    frameTimestamp = timestamp;
+                    av_packet_unref(&packet);
+                    return true;
+                }
+            }
+        }
+        av_packet_unref(&packet);
+    }
+
+    return false;
+}
+
+/*************/
+SeekResult benchmarkSeeks(
+    AVFormatContext* context, AVCodecContext* codecContext, int streamIndex, const vector<int64_t>& targets, const KeyframeIndex* index, int64_t tolerance, double timeBase)
+{
+    SeekResult result;
+    auto frame = av_frame_alloc();
+
+    for (auto target : targets)
+    {
+        auto start = chrono::steady_clock::now();
+
+        auto seekTimestamp = index ? index->getKeyframeBefore(target) : target;
+        avformat_seek_file(context, streamIndex, INT64_MIN, seekTimestamp, seekTimestamp, 0);
+        avcodec_flush_buffers(codecContext);
+
+        int64_t frameTimestamp = 0;
+        if (!decodeUntil(context, codecContext, streamIndex, index ? target - tolerance : INT64_MIN, frame, frameTimestamp))
+            frameTimestamp = target;
+
+        auto latency = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count();
+        result.meanLatency += latency / targets.size();
+        result.maxLatency = max(result.maxLatency, latency);
+        result.meanError += abs(frameTimestamp - target) * timeBase * 1e3 / targets.size();
+    }
+
+    av_frame_free(&frame);
+    return result;
+}
+
+/*************/
+void benchmarkFile(const string& filepath)
+{
+    AVFormatContext* context = nullptr;
+    if (avformat_open_input(&context, filepath.c_str(), nullptr, nullptr) != 0 || avformat_find_stream_info(context, nullptr) < 0)
+    {
+        cout << filepath << ": could not open file" << endl;
+        return;
+    }
+
+    auto streamIndex = av_find_best_stream(context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    auto codec = streamIndex >= 0 ? avcodec_find_decoder(context->streams[streamIndex]->codecpar->codec_id) : nullptr;
+    if (!codec)
+    {
+        cout << filepath << ": no supported video stream" << endl;
+        avformat_close_input(&context);
+        return;
+    }
+
+    auto stream = context->streams[streamIndex];
+    auto codecContext = avcodec_alloc_context3(codec);
+    avcodec_parameters_to_context(codecContext, stream->codecpar);
+    avcodec_open2(codecContext, codec, nullptr);
+
+    auto indexStart = chrono::steady_clock::now();
+    KeyframeIndex index;
+    index.build(filepath, streamIndex);
+    auto indexDuration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - indexStart).count();
+
+    // Random targets over the whole stream, the same for both strategies
+    auto timeBase = av_q2d(stream->time_base);
+    auto duration = stream->duration != AV_NOPTS_VALUE ? stream->duration : static_cast<int64_t>(context->duration / (timeBase * AV_TIME_BASE));
+    int64_t tolerance = stream->avg_frame_rate.num > 0 ? static_cast<int64_t>(av_q2d(av_inv_q(stream->avg_frame_rate)) * 0.5 / timeBase) : 0;
+
+    mt19937 generator(42);
+    uniform_int_distribution<int64_t> distribution(0, max<int64_t>(0, duration - 1));
+    vector<int64_t> targets(seekCount);
+    for (auto& target : targets)
+        target = distribution(generator);
+
+    auto keyframeResult = benchmarkSeeks(context, codecContext, streamIndex, targets, nullptr, tolerance, timeBase);
+    auto indexedResult = benchmarkSeeks(context, codecContext, streamIndex, targets, &index, tolerance, timeBase);
+
+    cout << Utils::getFilenameFromFilePath(filepath) << " (" << codec->name << ", " << index.getKeyframeCount() << " keyframes, index ready in " << indexDuration
+         << " ms)" << endl;
+    cout << "    keyframe: mean " << keyframeResult.meanLatency << " ms, max " << keyframeResult.maxLatency << " ms, mean error " << keyframeResult.meanError << " ms"
+         << endl;
+    cout << "    indexed:  mean " << indexedResult.meanLatency << " ms, max " << indexedResult.maxLatency << " ms, mean error " << indexedResult.meanError << " ms"
+         << endl;
+
+    avcodec_free_context(&codecContext);
+    avformat_close_input(&context);
+}
+
+} // end of anonymous namespace
+
+/*************/
+int main(int argc, char** argv)
+{
+    av_register_all();
+    av_log_set_level(AV_LOG_QUIET);
+
+    vector<string> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        string path = argv[i];
+        if (!Utils::isDir(path))
+        {
+            files.push_back(path);
+            continue;
+        }
+
+        for (const auto& filename : Utils::listDirContent(path))
+        {
+            auto extension = filename.substr(filename.rfind('.') + 1);
+            if (extension == "mov" || extension == "mp4" || extension == "mkv" || extension == "avi")
+                files.push_back(path + "/" + filename);
+        }
+    }
+
+    if (files.empty())
+    {
+        cout << "No video file to benchmark. Usage: " << argv[0] << " [file or directory]..." << endl;
+        return 0;
+    }
+
+    sort(files.begin(), files.end());
+    for (const auto& file : files)
+        benchmarkFile(file);
+
+    return 0;
+}
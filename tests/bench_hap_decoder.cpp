@@ -0,0 +1,173 @@
+/*
+ * Measures the CPU decoding throughput of 4K Hap frames, for the three supported texture formats:
+ * - serial: one frame decoded after the other, its chunks being decompressed in parallel
+ * - ahead: several frames decoded in parallel, as done by Image_FFmpeg
+ * Frames are synthetic DXT data, compressed with snappy as a Hap encoder would
+ */
+
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <snappy.h>
+
+#include "./core/thread_pool.h"
+#include "./utils/hap_decoder.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int width = 3840;
+const int height = 2160;
+const int frameCount = 120;
+const size_t framesAhead = 3; // Same as SPLASH_FFMPEG_HAP_DECODE_AHEAD
+
+/*************/
+void writeSectionHeader(vector<char>& frame, size_t size, uint8_t type)
+{
+    if (size < (1 << 24))
+    {
+        for (int i = 0; i < 3; ++i)
+            frame.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+        frame.push_back(static_cast<char>(type));
+    }
+    else
+    {
+        frame.insert(frame.end(), {0, 0, 0, static_cast<char>(type)});
+        for (int i = 0; i < 4; ++i)
+            frame.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+    }
+}
+
+/*************/
+// Fills DXT blocks with slowly varying endpoints and noisy indices, which compresses roughly like real footage
+vector<char> generateTexture(size_t size)
+{
+    vector<char> texture(size);
+    uint32_t seed = 42;
+    for (size_t i = 0; i < size; i += 8)
+    {
+        seed = seed * 1664525 + 1013904223;
+        uint16_t endpoint = static_cast<uint16_t>(i / 4096);
+        memcpy(texture.data() + i, &endpoint, sizeof(endpoint));
+        memcpy(texture.data() + i + 2, &endpoint, sizeof(endpoint));
+        uint32_t indices = (seed >> 28) ? 0xAAAAAAAA : seed;
+        memcpy(texture.data() + i + 4, &indices, sizeof(indices));
+    }
+    return texture;
+}
+
+/*************/
+vector<char> encodeFrame(const vector<char>& texture, uint8_t format, size_t chunkCount)
+{
+    vector<string> chunks(chunkCount);
+    auto chunkSize = texture.size() / chunkCount;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        auto size = (i == chunkCount - 1) ? texture.size() - i * chunkSize : chunkSize;
+        snappy::Compress(texture.data() + i * chunkSize, size, &chunks[i]);
+    }
+
+    vector<char> frame;
+    if (chunkCount == 1)
+    {
+        writeSectionHeader(frame, chunks[0].size(), 0xB0 | format);
+        frame.insert(frame.end(), chunks[0].begin(), chunks[0].end());
+        return frame;
+    }
+
+    vector<char> instructions;
+    writeSectionHeader(instructions, chunkCount, 0x02);
+    for (size_t i = 0; i < chunkCount; ++i)
+        instructions.push_back(0x0B);
+    writeSectionHeader(instructions, chunkCount * 4, 0x03);
+    for (const auto& chunk : chunks)
+        for (int i = 0; i < 4; ++i)
+            instructions.push_back(static_cast<char>((chunk.size() >> (8 * i)) & 0xFF));
+
+    vector<char> payload;
+    writeSectionHeader(payload, instructions.size(), 0x01);
+    payload.insert(payload.end(), instructions.begin(), instructions.end());
+    for (const auto& chunk : chunks)
+        payload.insert(payload.end(), chunk.begin(), chunk.end());
+
+    writeSectionHeader(frame, payload.size(), 0xC0 | format);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return frame;
+}
+
+/*************/
+double decodeSerial(const vector<char>& frame, vector<char>& output)
+{
+    HapDecoder decoder;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        decoder.parse(frame.data(), frame.size());
+        decoder.decode(output.data(), output.size());
+    }
+    return frameCount / chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+}
+
+/*************/
+double decodeAhead(const vector<char>& frame, vector<vector<char>>& outputs)
+{
+    deque<future<void>> decoding;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < frameCount; ++i)
+    {
+        auto& output = outputs[i % outputs.size()];
+        decoding.push_back(ThreadPool::get().enqueue([&frame, &output]() {
+            HapDecoder decoder;
+            decoder.parse(frame.data(), frame.size());
+            decoder.decode(output.data(), output.size());
+        }));
+
+        while (decoding.size() > framesAhead || (i == frameCount - 1 && !decoding.empty()))
+        {
+            vector<future<void>> next;
+            next.push_back(std::move(decoding.front()));
+            ThreadPool::get().waitAll(next);
+            decoding.pop_front();
+        }
+    }
+    return frameCount / chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+}
+
+} // end of anonymous namespace
+
+/*************/
+int main()
+{
+    struct Variant
+    {
+        string name;
+        string format;
+        uint8_t formatCode;
+    };
+    vector<Variant> variants{{"Hap", "RGB_DXT1", 0x0B}, {"Hap Alpha", "RGBA_DXT5", 0x0E}, {"HapQ", "YCoCg_DXT5", 0x0F}};
+
+    cout << "Decoding " << frameCount << " frames at " << width << "x" << height << " with " << ThreadPool::get().getWorkerCount() << " workers" << endl;
+    for (const auto& variant : variants)
+    {
+        auto spec = HapDecoder::getImageSpec(width, height, variant.format);
+        auto texture = generateTexture(spec.rawSize());
+        vector<vector<char>> outputs(framesAhead + 1, vector<char>(spec.rawSize()));
+
+        for (size_t chunkCount : {1, 8})
+        {
+            auto frame = encodeFrame(texture, variant.formatCode, chunkCount);
+            auto serialRate = decodeSerial(frame, outputs[0]);
+            auto aheadRate = decodeAhead(frame, outputs);
+            cout << variant.name << " (" << chunkCount << " chunks, ratio " << static_cast<double>(texture.size()) / frame.size() << "): serial " << serialRate
+                 << " fps, ahead " << aheadRate << " fps" << endl;
+        }
+    }
+
+    return 0;
+}
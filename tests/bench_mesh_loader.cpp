@@ -0,0 +1,200 @@
+/*
+ * Measures the loading throughput of the OBJ files given as arguments, or of a generated grid mesh:
+ * - legacy: line by line parsing with getline and stof, as done before the memory-mapped parser, without vertex merging
+ * - parallel: memory-mapped parsing in parallel, followed by vertex merging and reordering, as done by Loader::Obj
+ * - cache: loading of the binary cache written by the previous run
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "./mesh/meshloader.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int gridSize = 1024;
+
+/*************/
+// Trimmed down copy of the previous parser, for comparison purpose
+size_t legacyParse(const string& filename)
+{
+    ifstream file(filename, ios::in);
+    vector<glm::vec4> vertices;
+    vector<glm::vec2> uvs;
+    vector<glm::vec3> normals;
+    vector<glm::ivec4> faces;
+    size_t triangles = 0;
+
+    for (string line; getline(file, line);)
+    {
+        string::size_type pos;
+        if ((pos = line.find("v ")) == 0)
+        {
+            glm::vec4 vertex;
+            int index = 0;
+            pos += 1;
+            do
+            {
+                pos++;
+                line = line.substr(pos);
+                vertex[index++] = stof(line);
+                pos = line.find(" ");
+            } while (pos != string::npos && index < 4);
+            vertices.push_back(vertex);
+        }
+        else if ((pos = line.find("vt ")) == 0)
+        {
+            glm::vec2 uv;
+            int index = 0;
+            pos += 2;
+            do
+            {
+                pos++;
+                line = line.substr(pos);
+                uv[index++] = stof(line);
+                pos = line.find(" ");
+            } while (pos != string::npos && index < 2);
+            uvs.push_back(uv);
+        }
+        else if ((pos = line.find("vn ")) == 0)
+        {
+            glm::vec3 normal;
+            int index = 0;
+            pos += 2;
+            do
+            {
+                pos++;
+                line = line.substr(pos);
+                normal[index++] = stof(line);
+                pos = line.find(" ");
+            } while (pos != string::npos && index < 3);
+            normals.push_back(normal);
+        }
+        else if ((pos = line.find("f ")) == 0)
+        {
+            glm::ivec4 face;
+            int index = 0;
+            pos += 1;
+            do
+            {
+                pos++;
+                line = line.substr(pos);
+                face[index++] = stoi(line) - 1;
+                pos = line.find(" ");
+            } while (pos != string::npos && index < 4);
+            faces.push_back(face);
+            triangles += index >= 4 ? 2 : 1;
+        }
+    }
+
+    return triangles;
+}
+
+/*************/
+void writeGrid(const string& filename)
+{
+    ofstream file(filename);
+    for (int v = 0; v < gridSize; ++v)
+    {
+        for (int u = 0; u < gridSize; ++u)
+        {
+            file << "v " << u * 0.01 << " " << v * 0.01 << " " << (u * v % 97) * 0.001 << "\n";
+            file << "vt " << u / static_cast<float>(gridSize) << " " << v / static_cast<float>(gridSize) << "\n";
+        }
+    }
+    file << "vn 0 0 1\n";
+
+    for (int v = 0; v < gridSize - 1; ++v)
+    {
+        for (int u = 0; u < gridSize - 1; ++u)
+        {
+            int topLeft = u + v * gridSize + 1;
+            int bottomLeft = topLeft + gridSize;
+            file << "f " << topLeft << "/" << topLeft << "/1 " << topLeft + 1 << "/" << topLeft + 1 << "/1 " << bottomLeft + 1 << "/" << bottomLeft + 1 << "/1 " << bottomLeft
+                 << "/" << bottomLeft << "/1\n";
+        }
+    }
+}
+
+/*************/
+void printResult(const string& label, double duration, size_t fileSize, size_t triangles)
+{
+    cout << "    " << label << duration << " ms, " << fileSize / (duration * 1e3) << " MB/s, " << triangles / (duration * 1e3) << " Mtriangles/s" << endl;
+}
+
+/*************/
+void benchmarkFile(const string& filename)
+{
+    struct stat fileStat;
+    if (stat(filename.c_str(), &fileStat) != 0)
+    {
+        cout << filename << ": could not open file" << endl;
+        return;
+    }
+    size_t fileSize = fileStat.st_size;
+
+    auto start = chrono::steady_clock::now();
+    auto legacyTriangles = legacyParse(filename);
+    auto legacyDuration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count();
+
+    Loader::Obj loader;
+    start = chrono::steady_clock::now();
+    if (!loader.load(filename, false))
+    {
+        cout << filename << ": could not parse file" << endl;
+        return;
+    }
+    auto parallelDuration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count();
+    auto triangles = loader.getTriangleCount();
+
+    // The first load with the cache enabled writes it if needed
+    loader.load(filename);
+    start = chrono::steady_clock::now();
+    loader.load(filename);
+    auto cacheDuration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count();
+
+    cout << filename << " (" << fileSize / 1000000.0 << " MB, " << triangles << " triangles, " << loader.getVertices().size() << " unique vertices)" << endl;
+    printResult("legacy:   ", legacyDuration, fileSize, legacyTriangles);
+    printResult("parallel: ", parallelDuration, fileSize, triangles);
+    printResult("cache:    ", cacheDuration, fileSize, triangles);
+}
+
+} // end of anonymous namespace
+
+/*************/
+int main(int argc, char** argv)
+{
+    vector<string> files;
+    for (int i = 1; i < argc; ++i)
+        files.push_back(argv[i]);
+
+    string generatedFile;
+    if (files.empty())
+    {
+        generatedFile = "bench_mesh_loader_grid.obj";
+        writeGrid(generatedFile);
+        files.push_back(generatedFile);
+    }
+
+    for (const auto& file : files)
+        benchmarkFile(file);
+
+    if (!generatedFile.empty())
+    {
+        remove(Loader::Obj::getCacheFilePath(generatedFile).c_str());
+        remove(generatedFile.c_str());
+    }
+
+    return 0;
+}
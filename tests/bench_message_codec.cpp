@@ -0,0 +1,219 @@
+/*
+ * Compares the throughput of the Link message encodings, through a ZMQ inproc socket:
+ * - legacy: one multipart message per Value, as sent by Link before the MessageCodec
+ * - codec: one MessageCodec frame per message
+ * - batched: one MessageCodec frame per batch of messages, as sent by the World loop
+ */
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <zmq.hpp>
+
+#include "./core/message_codec.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int messageCount = 200000;
+const int batchSize = 64;
+
+/*************/
+vector<MessageCodec::Message> getSampleMessages()
+{
+    // Typical traffic: timings sent to the master Scene, slider updates and file paths
+    return {{"scene", "duration", {"loop_world", 16667}},
+        {"camera_1", "eye", {1.0, 2.5, -3.0}},
+        {"image_1", "file", {"/home/user/videos/some_video_file.mov"}},
+        {"warp_1", "patchControl", {Values({0.0, 0.0}), Values({0.5, 0.0}), Values({1.0, 0.0})}}};
+}
+
+/*************/
+void sendLegacy(zmq::socket_t& socket, const MessageCodec::Message& message)
+{
+    zmq::message_t msg(message.target.size() + 1);
+    memcpy(msg.data(), message.target.c_str(), message.target.size() + 1);
+    socket.send(msg, ZMQ_SNDMORE);
+
+    msg.rebuild(message.attribute.size() + 1);
+    memcpy(msg.data(), message.attribute.c_str(), message.attribute.size() + 1);
+    socket.send(msg, ZMQ_SNDMORE);
+
+    function<void(const Values&)> sendValues;
+    sendValues = [&](const Values& values) {
+        int size = values.size();
+        msg.rebuild(sizeof(size));
+        memcpy(msg.data(), &size, sizeof(size));
+        socket.send(msg, values.size() == 0 ? 0 : ZMQ_SNDMORE);
+
+        for (uint32_t i = 0; i < values.size(); ++i)
+        {
+            auto v = values[i];
+            Value::Type valueType = v.getType();
+            msg.rebuild(sizeof(valueType));
+            memcpy(msg.data(), &valueType, sizeof(valueType));
+            socket.send(msg, ZMQ_SNDMORE);
+
+            auto valueName = v.getName();
+            msg.rebuild(valueName.size() + 1);
+            memcpy(msg.data(), valueName.c_str(), valueName.size() + 1);
+            socket.send(msg, ZMQ_SNDMORE);
+
+            if (valueType == Value::Type::v)
+            {
+                sendValues(v.as<Values>());
+            }
+            else
+            {
+                int valueSize = (valueType == Value::Type::s) ? v.size() + 1 : v.size();
+                msg.rebuild(valueSize);
+                memcpy(msg.data(), v.data(), valueSize);
+                socket.send(msg, i != values.size() - 1 ? ZMQ_SNDMORE : 0);
+            }
+        }
+    };
+    sendValues(message.values);
+}
+
+/*************/
+void receiveLegacy(zmq::socket_t& socket)
+{
+    zmq::message_t msg;
+    socket.recv(&msg);
+    string target(static_cast<char*>(msg.data()));
+    socket.recv(&msg);
+    string attribute(static_cast<char*>(msg.data()));
+
+    function<Values()> receiveValues;
+    receiveValues = [&]() -> Values {
+        socket.recv(&msg);
+        int size = *static_cast<int*>(msg.data());
+
+        Values values;
+        for (int i = 0; i < size; ++i)
+        {
+            socket.recv(&msg);
+            auto valueType = *static_cast<Value::Type*>(msg.data());
+            socket.recv(&msg);
+            string valueName(static_cast<char*>(msg.data()));
+
+            if (valueType == Value::Type::v)
+            {
+                values.push_back(receiveValues());
+            }
+            else
+            {
+                socket.recv(&msg);
+                if (valueType == Value::Type::i)
+                    values.push_back(*static_cast<int64_t*>(msg.data()));
+                else if (valueType == Value::Type::f)
+                    values.push_back(*static_cast<double*>(msg.data()));
+                else if (valueType == Value::Type::s)
+                    values.push_back(string(static_cast<char*>(msg.data())));
+            }
+
+            if (!valueName.empty())
+                values.back().setName(valueName);
+        }
+        return values;
+    };
+    receiveValues();
+}
+
+/*************/
+void sendFrame(zmq::socket_t& socket, MessageCodec& codec)
+{
+    auto frame = codec.encode();
+    codec.clear();
+    zmq::message_t msg(frame.size());
+    memcpy(msg.data(), frame.data(), frame.size());
+    socket.send(msg);
+}
+
+/*************/
+int receiveFrame(zmq::socket_t& socket)
+{
+    zmq::message_t msg;
+    socket.recv(&msg);
+    vector<MessageCodec::Message> messages;
+    MessageCodec::decode(static_cast<char*>(msg.data()), msg.size(), messages);
+    return messages.size();
+}
+
+/*************/
+double run(const string& name, const function<void(zmq::socket_t&)>& sender, const function<void(zmq::socket_t&)>& receiver)
+{
+    zmq::context_t context(1);
+    zmq::socket_t output(context, ZMQ_PAIR);
+    zmq::socket_t input(context, ZMQ_PAIR);
+    input.bind(("inproc://" + name).c_str());
+    output.connect(("inproc://" + name).c_str());
+
+    auto start = chrono::steady_clock::now();
+    thread receiveThread([&]() { receiver(input); });
+    sender(output);
+    receiveThread.join();
+    auto duration = chrono::duration_cast<chrono::duration<double>>(chrono::steady_clock::now() - start).count();
+
+    auto rate = messageCount / duration;
+    cout << name << ": " << static_cast<uint64_t>(rate) << " messages/s" << endl;
+    return rate;
+}
+
+} // end of anonymous namespace
+
+/*************/
+int main()
+{
+    auto samples = getSampleMessages();
+
+    auto legacyRate = run("legacy",
+        [&](zmq::socket_t& socket) {
+            for (int i = 0; i < messageCount; ++i)
+                sendLegacy(socket, samples[i % samples.size()]);
+        },
+        [&](zmq::socket_t& socket) {
+            for (int i = 0; i < messageCount; ++i)
+                receiveLegacy(socket);
+        });
+
+    auto codecRate = run("codec",
+        [&](zmq::socket_t& socket) {
+            MessageCodec codec;
+            for (int i = 0; i < messageCount; ++i)
+            {
+                const auto& message = samples[i % samples.size()];
+                codec.add(message.target, message.attribute, message.values);
+                sendFrame(socket, codec);
+            }
+        },
+        [&](zmq::socket_t& socket) {
+            for (int i = 0; i < messageCount;)
+                i += receiveFrame(socket);
+        });
+
+    auto batchedRate = run("batched",
+        [&](zmq::socket_t& socket) {
+            MessageCodec codec;
+            for (int i = 0; i < messageCount; ++i)
+            {
+                const auto& message = samples[i % samples.size()];
+                codec.add(message.target, message.attribute, message.values);
+                if (codec.getMessageCount() == batchSize || i == messageCount - 1)
+                    sendFrame(socket, codec);
+            }
+        },
+        [&](zmq::socket_t& socket) {
+            for (int i = 0; i < messageCount;)
+                i += receiveFrame(socket);
+        });
+
+    cout << "codec speedup: " << codecRate / legacyRate << ", batched speedup: " << batchedRate / legacyRate << endl;
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * Measures the pixel format conversions used by the image inputs, at 1080p and 4K:
+ * - legacy: single-threaded scalar loop, as done by Image_Shmdata before the conversion library (I420 only)
+ * - scalar, sse4.1, avx2: conversion library with the given instruction set, run in parallel over rows
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./image/pixel_conversion.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int iterations = 20;
+
+/*************/
+void legacyI420ToUYVY(const uint8_t* Y, const uint8_t* U, const uint8_t* V, uint8_t* pixels, uint32_t width, uint32_t height)
+{
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; x += 2)
+        {
+            pixels[(x + y * width) * 2 + 0] = U[(x / 2) + (y / 2) * (width / 2)];
+            pixels[(x + y * width) * 2 + 1] = Y[x + y * width];
+            pixels[(x + y * width) * 2 + 2] = V[(x / 2) + (y / 2) * (width / 2)];
+            pixels[(x + y * width) * 2 + 3] = Y[x + y * width + 1];
+        }
+    }
+}
+
+/*************/
+template <typename Function>
+void measure(const string& label, uint32_t width, uint32_t height, const Function& function)
+{
+    function(); // Warm up the caches and the thread pool
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        function();
+    auto duration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count() / iterations;
+    cout << "    " << label << duration << " ms, " << static_cast<double>(width) * height / (duration * 1e3) << " Mpixels/s" << endl;
+}
+
+/*************/
+void benchmarkResolution(uint32_t width, uint32_t height)
+{
+    vector<uint8_t> input(width * height * 3, 128);
+    vector<uint16_t> input10Bit(width * height * 3 / 2, 512);
+    vector<uint8_t> output(width * height * 4);
+
+    auto y = input.data();
+    auto u = y + width * height;
+    auto v = u + width * height / 4;
+
+    cout << width << "x" << height << endl;
+    measure("i420 legacy: ", width, height, [&]() { legacyI420ToUYVY(y, u, v, output.data(), width, height); });
+
+    vector<pair<string, PixelConversion::InstructionSet>> instructionSets{
+        {"scalar", PixelConversion::InstructionSet::Scalar}, {"sse4.1", PixelConversion::InstructionSet::SSE41}, {"avx2", PixelConversion::InstructionSet::AVX2}};
+    for (const auto& instructionSet : instructionSets)
+    {
+        if (!PixelConversion::setInstructionSet(instructionSet.second))
+            continue;
+
+        auto name = instructionSet.first + ":" + string(7 - instructionSet.first.size(), ' ');
+        measure("i420 " + name, width, height, [&]() { PixelConversion::i420ToUYVY(y, u, v, output.data(), width, height); });
+        measure("nv12 " + name, width, height, [&]() { PixelConversion::nv12ToUYVY(y, u, output.data(), width, height); });
+        measure("yuy2 " + name, width, height, [&]() { PixelConversion::yuy2ToUYVY(input.data(), output.data(), width, height); });
+        measure("bgr  " + name, width, height, [&]() { PixelConversion::bgrToRGBA(input.data(), output.data(), width, height); });
+        measure("10b  " + name, width, height, [&]() { PixelConversion::unpack10Bit(input10Bit.data(), output.data(), input10Bit.size()); });
+    }
+
+    PixelConversion::setInstructionSet(PixelConversion::getSupportedInstructionSet());
+}
+
+} // end of anonymous namespace
+
+/*************/
+int main()
+{
+    benchmarkResolution(1920, 1080);
+    benchmarkResolution(3840, 2160);
+
+    return 0;
+}
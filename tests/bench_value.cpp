@@ -0,0 +1,183 @@
+/*
+ * Measures the heap allocations and time taken by typical render loop attribute traffic:
+ * uniform updates holding a matrix, copied by the attribute setter then read by the shader,
+ * and named values as sent for media information
+ * - legacy: Value as it was before storing scalars and strings inline, and names as pointers
+ * - compact: current Value
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include "./core/value.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+const int frameCount = 1000;
+const int objectCount = 100;
+
+atomic<uint64_t> allocationCount{0};
+
+/*************/
+// Trimmed down copy of the previous Value implementation, for comparison purpose
+struct LegacyValue;
+typedef deque<LegacyValue> LegacyValues;
+
+struct LegacyValue
+{
+    LegacyValue() {}
+    LegacyValue(int64_t v, string name = "")
+        : _i(v)
+        , _type(Value::Type::i)
+        , _name(name)
+    {
+    }
+    LegacyValue(double v, string name = "")
+        : _f(v)
+        , _type(Value::Type::f)
+        , _name(name)
+    {
+    }
+    LegacyValue(const string& v, string name = "")
+        : _s(v)
+        , _type(Value::Type::s)
+        , _name(name)
+    {
+    }
+    LegacyValue(const LegacyValues& v, string name = "")
+        : _v(unique_ptr<LegacyValues>(new LegacyValues(v)))
+        , _type(Value::Type::v)
+        , _name(name)
+    {
+    }
+
+    LegacyValue(const LegacyValue& v) { operator=(v); }
+    LegacyValue& operator=(const LegacyValue& v)
+    {
+        if (this != &v)
+        {
+            _type = v._type;
+            _i = v._i;
+            _name = v._name;
+            _s = v._s;
+            _v = unique_ptr<LegacyValues>(new LegacyValues());
+            if (v._v)
+                *_v = *(v._v);
+        }
+        return *this;
+    }
+
+    template <class T, typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr>
+    T as() const
+    {
+        return _type == Value::Type::f ? _f : _i;
+    }
+
+    template <class T, typename std::enable_if<std::is_same<T, LegacyValues>::value>::type* = nullptr>
+    T as() const
+    {
+        return _type == Value::Type::v ? *_v : LegacyValues();
+    }
+
+    union {
+        int64_t _i{0};
+        double _f;
+    };
+    string _s{""};
+    unique_ptr<LegacyValues> _v{nullptr};
+    Value::Type _type{Value::Type::i};
+    string _name{""};
+};
+
+/*************/
+template <typename V, typename Vs>
+double runWorkload(uint64_t& allocations)
+{
+    double sum = 0.0;
+    auto allocationsBefore = allocationCount.load();
+    auto start = chrono::steady_clock::now();
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        for (int object = 0; object < objectCount; ++object)
+        {
+            // Uniform update, as sent to a Shader
+            Vs matrix;
+            for (int i = 0; i < 16; ++i)
+                matrix.push_back(V(static_cast<double>(i + frame)));
+            Vs uniform;
+            uniform.push_back(V(string("_modelViewProjectionMatrix")));
+            uniform.push_back(V(matrix));
+
+            // Stored by the attribute setter, then read back when the shader is activated
+            Vs stored = uniform;
+            auto values = stored[1].template as<Vs>();
+            sum += values[15].template as<double>();
+
+            // Named values, as in media information
+            Vs mediaInfo;
+            mediaInfo.push_back(V(12.5, "duration"));
+            mediaInfo.push_back(V(static_cast<int64_t>(frame), "frame"));
+            mediaInfo.push_back(V(string("some_video_file.mov"), "filename"));
+            Vs mediaInfoCopy = mediaInfo;
+            sum += mediaInfoCopy[0].template as<double>();
+        }
+    }
+
+    auto duration = chrono::duration_cast<chrono::duration<double, milli>>(chrono::steady_clock::now() - start).count();
+    allocations = allocationCount.load() - allocationsBefore;
+
+    // Prevents the workload from being optimized out
+    volatile double result = sum;
+    (void)result;
+
+    return duration;
+}
+
+} // end of anonymous namespace
+
+/*************/
+void* operator new(size_t size)
+{
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (auto ptr = malloc(size))
+        return ptr;
+    throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+/*************/
+int main()
+{
+    cout << "Running " << frameCount << " frames of " << objectCount << " objects" << endl;
+    cout << "sizeof(Value): legacy " << sizeof(LegacyValue) << " bytes, compact " << sizeof(Value) << " bytes" << endl;
+
+    uint64_t legacyAllocations = 0;
+    auto legacyDuration = runWorkload<LegacyValue, LegacyValues>(legacyAllocations);
+    cout << "legacy: " << legacyDuration << " ms, " << static_cast<double>(legacyAllocations) / (frameCount * objectCount) << " allocations per object per frame" << endl;
+
+    uint64_t compactAllocations = 0;
+    auto compactDuration = runWorkload<Value, Values>(compactAllocations);
+    cout << "compact: " << compactDuration << " ms, " << static_cast<double>(compactAllocations) / (frameCount * objectCount) << " allocations per object per frame"
+         << endl;
+
+    return 0;
+}
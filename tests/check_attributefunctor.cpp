@@ -28,3 +28,24 @@ TEST_CASE("Testing Attribute")
     CHECK(attr()[0].as<int>() == 42);
     attr.unlock();
 }
+
+/*************/
+TEST_CASE("Testing Attribute version")
+{
+    auto attr = Attribute("attribute", [&](const Values& args) { return args[0].as<int>() >= 0; }, nullptr, {'n'});
+    CHECK(attr.getVersion() == 0);
+
+    CHECK(attr({42}) == true);
+    CHECK(attr.getVersion() == 1);
+    CHECK(attr({42}) == true);
+    CHECK(attr.getVersion() == 2);
+
+    // Failed sets do not change the version
+    CHECK(attr({-1}) == false);
+    CHECK(attr({"Patate"}) == false);
+    CHECK(attr.getVersion() == 2);
+
+    auto defaultAttr = Attribute("default");
+    defaultAttr({"Patate"});
+    CHECK(defaultAttr.getVersion() == 1);
+}
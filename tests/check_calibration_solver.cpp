@@ -0,0 +1,119 @@
+#include <doctest.h>
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/euler_angles.hpp>
+
+#include "./graphics/calibration_solver.h"
+#include "./utils/cgutils.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+vector<CalibrationSolver::Point> createPoints(const CalibrationSolver::Parameters& camera, double width, double height)
+{
+    vector<CalibrationSolver::Point> points;
+    const vector<glm::dvec3> worldPoints{{4.0, -1.0, 0.0}, {4.0, 1.0, 0.5}, {5.0, -2.0, 1.5}, {6.0, 2.0, -1.0}, {5.0, 0.0, 2.0}, {7.0, -1.5, -1.5}, {4.5, 1.5, 1.0},
+        {6.5, 0.5, 0.0}};
+    for (const auto& world : worldPoints)
+    {
+        CalibrationSolver::Point point;
+        point.world = world;
+        point.screen = CalibrationSolver::project(camera, world, width, height);
+        points.push_back(point);
+    }
+    return points;
+}
+} // end of anonymous namespace
+
+/*************/
+TEST_CASE("Testing camera calibration")
+{
+    const double width = 1280.0;
+    const double height = 800.0;
+    const CalibrationSolver::Parameters camera{{40.0, 0.5, 0.45, 0.0, 0.0, 0.5, 0.1, -0.05, 0.02}};
+    auto points = createPoints(camera, width, height);
+
+    CalibrationSolver solver(points, width, height);
+    solver.addRandomStarts(glm::dvec3(0.2, -0.1, 0.4), 42);
+
+    atomic<float> progress{0.f};
+    auto result = solver.solve(&progress);
+    REQUIRE(result.success);
+    CHECK(result.rms < 1.0);
+    CHECK(result.error < SPLASH_CALIBRATION_EARLY_STOP_ERROR);
+    CHECK(progress == 1.f);
+
+    // Reprojections match, whatever the angles found
+    for (const auto& point : points)
+    {
+        auto projected = CalibrationSolver::project(result.parameters, point.world, width, height);
+        CHECK(glm::length(projected - point.screen) < 2.0);
+    }
+
+    // Locked parameters are kept
+    CalibrationSolver lockedSolver(points, width, height);
+    lockedSolver.lockFov(40.0);
+    lockedSolver.addRandomStarts(glm::dvec3(0.0, 0.0, 0.5), 7);
+    result = lockedSolver.solve();
+    REQUIRE(result.success);
+    CHECK(result.parameters[0] == 40.0);
+
+    // A cancelled solver gives no result
+    atomic<bool> cancel{true};
+    CHECK(!solver.solve(nullptr, &cancel).success);
+}
+
+/*************/
+TEST_CASE("Testing camera orientation conversion")
+{
+    glm::dvec3 eye(1.0, 2.0, 3.0);
+
+    // The camera looks along X and has Z as its up vector, before rotation
+    const double ch = cos(0.3), sh = sin(0.3), cp = cos(-0.4), sp = sin(-0.4), cb = cos(1.1), sb = sin(1.1);
+    glm::dvec3 forward(ch * cb + sh * sp * sb, sb * cp, ch * sp * sb - sh * cb);
+    glm::dvec3 up(sh * cp, -sp, ch * cp);
+
+    auto euler = CalibrationSolver::getEulerAngles(eye, eye + forward, up);
+    CHECK(euler[0] == doctest::Approx(0.3));
+    CHECK(euler[1] == doctest::Approx(-0.4));
+    CHECK(euler[2] == doctest::Approx(1.1));
+}
+
+/*************/
+TEST_CASE("Testing calibration projection against the camera rendering path")
+{
+    const double width = 1280.0;
+    const double height = 800.0;
+    const vector<CalibrationSolver::Parameters> cameras{{{40.0, 0.5, 0.45, 0.0, 0.0, 0.5, 0.1, -0.05, 0.02}},
+        {{65.0, 0.4, 0.6, 1.0, -2.0, 0.5, 0.7, 0.3, -0.4}},
+        {{25.0, 0.55, 0.5, -1.0, 1.0, -0.5, 0.1, -0.2, -0.2}}};
+    const vector<glm::dvec3> worldPoints{{4.0, -1.0, 0.0}, {5.0, -2.0, 1.5}, {6.0, 2.0, -1.0}, {7.0, -1.5, -1.5}};
+
+    for (const auto& camera : cameras)
+    {
+        // Same eye, target and up as Camera::applyCalibration, then the same matrices as Camera rendering
+        glm::dvec3 eye(camera[3], camera[4], camera[5]);
+        auto rotateMat = glm::yawPitchRoll(camera[6], camera[7], camera[8]);
+        auto target = eye + glm::dvec3(rotateMat * glm::dvec4(1.0, 0.0, 0.0, 0.0));
+        auto up = glm::normalize(glm::dvec3(rotateMat * glm::dvec4(0.0, 0.0, 1.0, 0.0)));
+
+        auto viewMatrix = glm::lookAt(eye, target, up);
+        auto projectionMatrix = getProjectionMatrix(camera[0], 0.1, 100.0, width, height, camera[1], camera[2]);
+
+        for (const auto& world : worldPoints)
+        {
+            auto expected = glm::project(world, viewMatrix, projectionMatrix, glm::dvec4(0.0, 0.0, width, height));
+            auto projected = CalibrationSolver::project(camera, world, width, height);
+            // getProjectionMatrix takes floats, hence the tolerance
+            CHECK(projected.x == doctest::Approx(expected.x).epsilon(1e-4));
+            CHECK(projected.y == doctest::Approx(expected.y).epsilon(1e-4));
+        }
+    }
+}
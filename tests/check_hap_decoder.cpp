@@ -0,0 +1,114 @@
+#include <doctest.h>
+
+#include <snappy.h>
+
+#include "./utils/hap_decoder.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+
+/*************/
+void writeSectionHeader(vector<char>& frame, size_t size, uint8_t type)
+{
+    for (int i = 0; i < 3; ++i)
+        frame.push_back(static_cast<char>((size >> (8 * i)) & 0xFF));
+    frame.push_back(static_cast<char>(type));
+}
+
+/*************/
+// Builds a chunked Hap frame, with snappy compressed chunks
+vector<char> encodeChunkedFrame(const vector<char>& texture, uint8_t format, size_t chunkCount)
+{
+    vector<string> chunks(chunkCount);
+    auto chunkSize = texture.size() / chunkCount;
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        auto size = (i == chunkCount - 1) ? texture.size() - i * chunkSize : chunkSize;
+        snappy::Compress(texture.data() + i * chunkSize, size, &chunks[i]);
+    }
+
+    vector<char> instructions;
+    writeSectionHeader(instructions, chunkCount, 0x02);
+    for (size_t i = 0; i < chunkCount; ++i)
+        instructions.push_back(0x0B);
+    writeSectionHeader(instructions, chunkCount * 4, 0x03);
+    for (const auto& chunk : chunks)
+        for (int i = 0; i < 4; ++i)
+            instructions.push_back(static_cast<char>((chunk.size() >> (8 * i)) & 0xFF));
+
+    vector<char> payload;
+    writeSectionHeader(payload, instructions.size(), 0x01);
+    payload.insert(payload.end(), instructions.begin(), instructions.end());
+    for (const auto& chunk : chunks)
+        payload.insert(payload.end(), chunk.begin(), chunk.end());
+
+    vector<char> frame;
+    writeSectionHeader(frame, payload.size(), 0xC0 | format);
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return frame;
+}
+
+} // end of anonymous namespace
+
+/*************/
+TEST_CASE("Testing HapDecoder with single and chunked frames")
+{
+    auto spec = HapDecoder::getImageSpec(64, 32, "RGBA_DXT5");
+    REQUIRE(spec.rawSize() == 64 * 32);
+
+    vector<char> texture(spec.rawSize());
+    for (size_t i = 0; i < texture.size(); ++i)
+        texture[i] = static_cast<char>(i * 7);
+
+    // Uncompressed single chunk frame
+    vector<char> frame;
+    writeSectionHeader(frame, texture.size(), 0xAE);
+    frame.insert(frame.end(), texture.begin(), texture.end());
+
+    HapDecoder decoder;
+    REQUIRE(decoder.parse(frame.data(), frame.size()));
+    CHECK(decoder.getFormat() == "RGBA_DXT5");
+    CHECK(decoder.getChunkCount() == 1);
+    CHECK(decoder.getDecodedSize() == texture.size());
+
+    vector<char> output(spec.rawSize());
+    REQUIRE(decoder.decode(output.data(), output.size()));
+    CHECK(output == texture);
+
+    // Snappy compressed chunks, decoded in parallel
+    frame = encodeChunkedFrame(texture, 0x0F, 5);
+    REQUIRE(decoder.parse(frame.data(), frame.size()));
+    CHECK(decoder.getFormat() == "YCoCg_DXT5");
+    CHECK(decoder.getChunkCount() == 5);
+    CHECK(decoder.getDecodedSize() == texture.size());
+
+    fill(output.begin(), output.end(), 0);
+    REQUIRE(decoder.decode(output.data(), output.size()));
+    CHECK(output == texture);
+
+    // Output buffer too small
+    CHECK(!decoder.decode(output.data(), output.size() - 1));
+}
+
+/*************/
+TEST_CASE("Testing HapDecoder with invalid frames")
+{
+    vector<char> texture(HapDecoder::getImageSpec(16, 16, "RGB_DXT1").rawSize(), 'a');
+    auto frame = encodeChunkedFrame(texture, 0x0B, 4);
+
+    HapDecoder decoder;
+    REQUIRE(decoder.parse(frame.data(), frame.size()));
+    CHECK(decoder.getFormat() == "RGB_DXT1");
+
+    for (size_t size = 0; size < frame.size(); ++size)
+        CHECK(!decoder.parse(frame.data(), size));
+
+    // Unsupported texture format
+    frame[3] = static_cast<char>(0xC1);
+    CHECK(!decoder.parse(frame.data(), frame.size()));
+    CHECK(decoder.getDecodedSize() == 0);
+    CHECK(HapDecoder::getImageSpec(16, 16, "BC7").rawSize() == 0);
+}
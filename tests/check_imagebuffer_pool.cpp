@@ -0,0 +1,55 @@
+#include <doctest.h>
+
+#include "./core/imagebuffer_pool.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing ImageBufferPool recycling")
+{
+    auto pool = make_shared<ImageBufferPool>(1 << 20);
+    auto spec = ImageBufferSpec(64, 64, 4, 32, ImageBufferSpec::Type::UINT8);
+
+    char* firstData = nullptr;
+    {
+        auto image = pool->acquire(spec);
+        REQUIRE(image->getSize() == static_cast<size_t>(spec.rawSize()));
+        CHECK(pool->getUsedSize() == spec.rawSize());
+        firstData = image->data();
+    }
+    CHECK(pool->getUsedSize() == 0);
+    CHECK(pool->getMissCount() == 1);
+
+    auto image = pool->acquire(spec);
+    CHECK(image->data() == firstData);
+    CHECK(pool->getHitCount() == 1);
+
+    // Buffers of another size are not reused
+    auto otherImage = pool->acquire(ImageBufferSpec(32, 32, 4, 32, ImageBufferSpec::Type::UINT8));
+    CHECK(pool->getMissCount() == 2);
+    CHECK(pool->getHighWaterMark() == static_cast<int64_t>(spec.rawSize() + otherImage->getSize()));
+}
+
+/*************/
+TEST_CASE("Testing ImageBufferPool limits and lifetime")
+{
+    auto spec = ImageBufferSpec(64, 64, 4, 32, ImageBufferSpec::Type::UINT8);
+    auto pool = make_shared<ImageBufferPool>(spec.rawSize());
+
+    // Released buffers exceeding the maximum size are freed instead of recycled
+    {
+        auto first = pool->acquire(spec);
+        auto second = pool->acquire(spec);
+    }
+    pool->acquire(spec);
+    pool->acquire(spec);
+    CHECK(pool->getHitCount() == 2);
+    CHECK(pool->getMissCount() == 2);
+
+    // Buffers can outlive their pool
+    auto image = pool->acquire(spec);
+    pool.reset();
+    image->zero();
+    image.reset();
+}
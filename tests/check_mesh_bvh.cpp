@@ -0,0 +1,115 @@
+#include <doctest.h>
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "./mesh/mesh_bvh.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+void createWavyGrid(uint32_t size, float amplitude, vector<glm::vec4>& vertices, vector<uint32_t>& indices)
+{
+    vertices.clear();
+    indices.clear();
+    for (uint32_t v = 0; v < size; ++v)
+        for (uint32_t u = 0; u < size; ++u)
+            vertices.push_back(glm::vec4(static_cast<float>(u), static_cast<float>(v), amplitude * sin(u * 0.3f) * cos(v * 0.2f), 1.f));
+
+    for (uint32_t v = 0; v < size - 1; ++v)
+    {
+        for (uint32_t u = 0; u < size - 1; ++u)
+        {
+            uint32_t topLeft = u + v * size;
+            uint32_t bottomLeft = u + (v + 1) * size;
+            indices.insert(indices.end(), {topLeft, topLeft + 1, bottomLeft, topLeft + 1, bottomLeft + 1, bottomLeft});
+        }
+    }
+}
+
+/*************/
+double bruteForceNearest(const vector<glm::vec4>& vertices, const glm::dvec3& point)
+{
+    double distance = numeric_limits<double>::max();
+    for (const auto& vertex : vertices)
+        distance = min(distance, glm::length(glm::dvec3(vertex[0], vertex[1], vertex[2]) - point));
+    return distance;
+}
+} // end of anonymous namespace
+
+/*************/
+TEST_CASE("Testing nearest vertex search")
+{
+    vector<glm::vec4> vertices;
+    vector<uint32_t> indices;
+    createWavyGrid(50, 2.f, vertices, indices);
+
+    MeshBVH bvh(vertices, indices);
+    CHECK(bvh.getTriangleCount() == indices.size() / 3);
+
+    mt19937 generator(42);
+    uniform_real_distribution<double> distribution(-10.0, 60.0);
+    for (int i = 0; i < 200; ++i)
+    {
+        glm::dvec3 point(distribution(generator), distribution(generator), distribution(generator) * 0.1);
+        glm::dvec3 vertex;
+        auto distance = bvh.nearestVertex(point, vertex);
+        CHECK(distance == doctest::Approx(bruteForceNearest(vertices, point)));
+        CHECK(glm::length(vertex - point) == doctest::Approx(distance));
+    }
+
+    // Meshes given as independent triangles
+    vector<glm::vec4> triangles;
+    for (auto index : indices)
+        triangles.push_back(vertices[index]);
+    MeshBVH unindexedBvh(triangles, {});
+    glm::dvec3 vertex;
+    CHECK(unindexedBvh.nearestVertex(glm::dvec3(10.2, 20.1, 0.0), vertex) == doctest::Approx(bruteForceNearest(vertices, glm::dvec3(10.2, 20.1, 0.0))));
+
+    MeshBVH emptyBvh({}, {});
+    CHECK(emptyBvh.nearestVertex(glm::dvec3(0.0, 0.0, 0.0), vertex) == numeric_limits<float>::max());
+}
+
+/*************/
+TEST_CASE("Testing ray intersection")
+{
+    vector<glm::vec4> vertices;
+    vector<uint32_t> indices;
+    createWavyGrid(50, 0.f, vertices, indices);
+    MeshBVH bvh(vertices, indices);
+
+    MeshBVH::RayHit hit;
+    REQUIRE(bvh.intersectRay(glm::dvec3(10.25, 20.5, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit));
+    CHECK(hit.distance == doctest::Approx(5.0));
+    CHECK(hit.position[0] == doctest::Approx(10.25));
+    CHECK(hit.position[1] == doctest::Approx(20.5));
+    CHECK(hit.position[2] == doctest::Approx(0.0));
+    CHECK(hit.triangle < bvh.getTriangleCount());
+
+    // Both sides are hit, rays going away or stopping short are not
+    CHECK(bvh.intersectRay(glm::dvec3(10.25, 20.5, -1.0), glm::dvec3(0.0, 0.0, 1.0), hit));
+    CHECK(!bvh.intersectRay(glm::dvec3(10.25, 20.5, 5.0), glm::dvec3(0.0, 0.0, 1.0), hit));
+    CHECK(!bvh.intersectRay(glm::dvec3(10.25, 20.5, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit, 4.0));
+    CHECK(!bvh.intersectRay(glm::dvec3(-10.0, 20.5, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit));
+
+    // Rays starting on the planes of the boxes, parallel to them
+    REQUIRE(bvh.intersectRay(glm::dvec3(10.0, 20.5, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit));
+    CHECK(hit.distance == doctest::Approx(5.0));
+    REQUIRE(bvh.intersectRay(glm::dvec3(49.0, 0.0, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit));
+    CHECK(hit.distance == doctest::Approx(5.0));
+    CHECK(!bvh.intersectRay(glm::dvec3(10.25, 49.0, 5.0), glm::dvec3(0.0, 1.0, 0.0), hit));
+
+    // Moving the vertices keeps the structure, changing the triangles does not
+    for (auto& vertex : vertices)
+        vertex[2] = 2.f;
+    REQUIRE(bvh.refit(vertices, indices));
+    REQUIRE(bvh.intersectRay(glm::dvec3(10.25, 20.5, 5.0), glm::dvec3(0.0, 0.0, -1.0), hit));
+    CHECK(hit.distance == doctest::Approx(3.0));
+
+    indices.resize(indices.size() - 3);
+    CHECK(!bvh.refit(vertices, indices));
+}
@@ -0,0 +1,240 @@
+#include <doctest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+#include "./mesh/mesh_optimizer.h"
+#include "./mesh/meshloader.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+vector<uint32_t> createGrid(uint32_t size)
+{
+    vector<uint32_t> indices;
+    for (uint32_t v = 0; v < size - 1; ++v)
+    {
+        for (uint32_t u = 0; u < size - 1; ++u)
+        {
+            uint32_t topLeft = u + v * size;
+            uint32_t bottomLeft = u + (v + 1) * size;
+            indices.insert(indices.end(), {topLeft, topLeft + 1, bottomLeft, topLeft + 1, bottomLeft + 1, bottomLeft});
+        }
+    }
+    return indices;
+}
+
+/*************/
+vector<array<uint32_t, 3>> getSortedTriangles(const vector<uint32_t>& indices)
+{
+    vector<array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        // Rotate the triangle so that its smallest index comes first, which keeps its winding
+        array<uint32_t, 3> triangle{{indices[i], indices[i + 1], indices[i + 2]}};
+        rotate(triangle.begin(), min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+} // end of anonymous namespace
+
+/*************/
+TEST_CASE("Testing vertex cache optimization")
+{
+    const uint32_t size = 64;
+    auto grid = createGrid(size);
+
+    // Shuffle the triangles, which is about the worst case for the cache
+    vector<array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < grid.size(); i += 3)
+        triangles.push_back({{grid[i], grid[i + 1], grid[i + 2]}});
+    shuffle(triangles.begin(), triangles.end(), mt19937(42));
+    vector<uint32_t> shuffled;
+    for (auto& triangle : triangles)
+        shuffled.insert(shuffled.end(), triangle.begin(), triangle.end());
+
+    auto optimized = MeshOptimizer::optimizeVertexCache(shuffled, size * size);
+    CHECK(optimized.size() == shuffled.size());
+    CHECK(getSortedTriangles(optimized) == getSortedTriangles(shuffled));
+
+    auto shuffledACMR = MeshOptimizer::computeACMR(shuffled, size * size);
+    auto optimizedACMR = MeshOptimizer::computeACMR(optimized, size * size);
+    CHECK(optimizedACMR < shuffledACMR * 0.5f);
+    CHECK(optimizedACMR < 0.8f);
+
+    // Invalid inputs are returned unchanged
+    vector<uint32_t> invalid{0, 1, 2, 3};
+    CHECK(MeshOptimizer::optimizeVertexCache(invalid, 4) == invalid);
+    invalid = {0, 1, 5};
+    CHECK(MeshOptimizer::optimizeVertexCache(invalid, 4) == invalid);
+}
+
+/*************/
+TEST_CASE("Testing vertex fetch optimization")
+{
+    vector<uint32_t> indices{4, 2, 0, 2, 5, 0};
+    vector<int> vertices{0, 10, 20, 30, 40, 50};
+
+    auto remap = MeshOptimizer::optimizeVertexFetch(indices, vertices.size());
+    MeshOptimizer::remapVertices(vertices, remap);
+
+    CHECK(indices == vector<uint32_t>({0, 1, 2, 1, 3, 2}));
+    CHECK(vertices == vector<int>({40, 20, 0, 50, 10, 30}));
+}
+
+/*************/
+TEST_CASE("Testing indexed OBJ loading")
+{
+    const string filename = "check_mesh_optimizer.obj";
+    {
+        ofstream file(filename);
+        file << "v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\nv 2 1 1\n";
+        file << "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n";
+        file << "vn 0 0 1\n";
+        file << "f 1/1/1 2/2/1 3/3/1 4/4/1\n";
+        // This face has no normal, and gets a flat one differing from the quad
+        file << "f 2/2 5/3 3/3\n";
+    }
+
+    Loader::Obj loader;
+    REQUIRE(loader.load(filename, false));
+    remove(filename.c_str());
+
+    auto vertices = loader.getVertices();
+    auto uvs = loader.getUVs();
+    auto normals = loader.getNormals();
+    auto indices = loader.getIndices();
+
+    // The quad shares two vertices between its triangles, the last face shares none with it
+    CHECK(vertices.size() == 7);
+    CHECK(uvs.size() == vertices.size());
+    CHECK(normals.size() == vertices.size());
+    REQUIRE(indices.size() == 9);
+
+    for (auto index : indices)
+        REQUIRE(index < vertices.size());
+
+    // Vertices are numbered by first use
+    uint32_t nextVertex = 0;
+    for (auto index : indices)
+    {
+        CHECK(index <= nextVertex);
+        if (index == nextVertex)
+            ++nextVertex;
+    }
+
+    // Triangles may have been reordered, but the two from the quad keep the normal read from the file
+    int quadTriangles = 0;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        bool fromQuad = normals[indices[i]] == glm::vec3(0.f, 0.f, 1.f);
+        CHECK((normals[indices[i + 1]] == glm::vec3(0.f, 0.f, 1.f)) == fromQuad);
+        CHECK((normals[indices[i + 2]] == glm::vec3(0.f, 0.f, 1.f)) == fromQuad);
+        if (fromQuad)
+            ++quadTriangles;
+    }
+    CHECK(quadTriangles == 2);
+}
+
+/*************/
+TEST_CASE("Testing OBJ parsing")
+{
+    const string filename = "check_mesh_parsing.obj";
+
+    // Polygons, missing attributes, relative indices and Windows line endings
+    {
+        ofstream file(filename);
+        file << "# comment\r\no object\r\nv 0 0 0\r\nv 1.5e0 0 0\r\nv 1 1 0\r\nv 0 1 0\r\nv 0.5 1.5 0\r\n";
+        file << "vn 0 0 1\r\n";
+        file << "f 1//1 2//1 3//1 5//1 4//1\r\n";
+        file << "f -3 -2 -1\r\n";
+    }
+
+    Loader::Obj loader;
+    REQUIRE(loader.load(filename, false));
+    CHECK(loader.getTriangleCount() == 4);
+    auto vertices = loader.getVertices();
+    CHECK(any_of(vertices.begin(), vertices.end(), [](const glm::vec4& v) { return v[0] == 1.5f && v[3] == 1.f; }));
+    remove(filename.c_str());
+
+    // A vertex with missing coordinates does not shift the indices of the next ones
+    {
+        ofstream file(filename);
+        file << "v 0 0 0\nv 5\nv 1 0 0\nv 1 1 0\nf 1 3 4\n";
+    }
+
+    REQUIRE(loader.load(filename, false));
+    CHECK(loader.getTriangleCount() == 1);
+    vertices = loader.getVertices();
+    CHECK(any_of(vertices.begin(), vertices.end(), [](const glm::vec4& v) { return v[0] == 1.f && v[1] == 0.f; }));
+    CHECK(any_of(vertices.begin(), vertices.end(), [](const glm::vec4& v) { return v[0] == 1.f && v[1] == 1.f; }));
+    CHECK(none_of(vertices.begin(), vertices.end(), [](const glm::vec4& v) { return v[0] == 5.f; }));
+    remove(filename.c_str());
+
+    // A file large enough to be parsed in several chunks, with relative indices crossing chunk boundaries
+    const int size = 400;
+    {
+        ofstream file(filename);
+        for (int v = 0; v < size; ++v)
+        {
+            for (int u = 0; u < size; ++u)
+            {
+                file << "v " << u * 0.01 << " " << v * 0.01 << " 0.123456\n";
+                file << "vt " << u / static_cast<float>(size) << " " << v / static_cast<float>(size) << "\n";
+            }
+        }
+        file << "vn 0 0 1\n";
+        for (int v = 0; v < size - 1; ++v)
+        {
+            for (int u = 0; u < size - 1; ++u)
+            {
+                int topLeft = u + v * size + 1;
+                int bottomLeft = topLeft + size;
+                if ((u + v) % 2)
+                    file << "f " << topLeft << "/" << topLeft << "/1 " << topLeft + 1 << "/" << topLeft + 1 << "/1 " << bottomLeft + 1 << "/" << bottomLeft + 1 << "/1 "
+                         << bottomLeft << "/" << bottomLeft << "/1\n";
+                else
+                    file << "f " << topLeft - size * size - 1 << "/" << topLeft << "/-1 " << topLeft + 1 << "/" << topLeft + 1 << "/1 " << bottomLeft + 1 << "/"
+                         << bottomLeft + 1 << "/1 " << bottomLeft << "/" << bottomLeft << "/1\n";
+            }
+        }
+    }
+
+    REQUIRE(loader.load(filename, false));
+    CHECK(loader.getVertices().size() == size * size);
+    CHECK(loader.getTriangleCount() == 2 * (size - 1) * (size - 1));
+    auto indices = loader.getIndices();
+
+    // The binary cache gives back the same mesh. It is written to a temporary directory instead of the cache of the user
+    const string cacheHome = "check_mesh_cache";
+    auto userCacheHome = getenv("XDG_CACHE_HOME");
+    auto previousCacheHome = userCacheHome ? string(userCacheHome) : string();
+    setenv("XDG_CACHE_HOME", cacheHome.c_str(), 1);
+
+    auto cachePath = Loader::Obj::getCacheFilePath(filename);
+    CHECK(cachePath.find(cacheHome) == 0);
+    CHECK(loader.load(filename));
+    CHECK(loader.load(filename));
+    CHECK(loader.getIndices() == indices);
+    CHECK(loader.getVertices().size() == size * size);
+
+    remove(cachePath.c_str());
+    rmdir((cacheHome + "/splash").c_str());
+    rmdir(cacheHome.c_str());
+    if (userCacheHome)
+        setenv("XDG_CACHE_HOME", previousCacheHome.c_str(), 1);
+    else
+        unsetenv("XDG_CACHE_HOME");
+    remove(filename.c_str());
+}
@@ -0,0 +1,68 @@
+#include <doctest.h>
+
+#include "./core/message_codec.h"
+#include "./splash.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing MessageCodec round trip")
+{
+    MessageCodec codec;
+    codec.add("image", "file", {"/tmp/image.png"});
+    codec.add("camera", "eye", {1.0, 2.5, -3.0});
+    codec.add(SPLASH_ALL_PEERS, "duration", {"loop_world", 16667});
+    codec.add("image", "nested", {Value(Values({1, "two", Value(3.f, "three")}), "list"), Values()});
+    CHECK(codec.getMessageCount() == 4);
+
+    auto frame = codec.encode();
+    vector<MessageCodec::Message> messages;
+    REQUIRE(MessageCodec::decode(frame.data(), frame.size(), messages));
+    REQUIRE(messages.size() == 4);
+
+    CHECK(messages[0].target == "image");
+    CHECK(messages[0].attribute == "file");
+    CHECK(messages[0].values == Values({"/tmp/image.png"}));
+
+    CHECK(messages[1].target == "camera");
+    CHECK(messages[1].values == Values({1.0, 2.5, -3.0}));
+
+    CHECK(messages[2].target == SPLASH_ALL_PEERS);
+    CHECK(messages[2].values == Values({"loop_world", 16667}));
+
+    CHECK(messages[3].attribute == "nested");
+    CHECK(messages[3].values == Values({Value(Values({1, "two", Value(3.f, "three")}), "list"), Values()}));
+}
+
+/*************/
+TEST_CASE("Testing MessageCodec with malformed frames")
+{
+    MessageCodec codec;
+    codec.add("image", "file", {"/tmp/image.png", 42});
+    auto frame = codec.encode();
+
+    vector<MessageCodec::Message> messages;
+    for (size_t size = 0; size < frame.size(); ++size)
+        CHECK(!MessageCodec::decode(frame.data(), size, messages));
+
+    // Frames from another version are rejected
+    frame[4] = SPLASH_MESSAGE_CODEC_VERSION + 1;
+    CHECK(!MessageCodec::decode(frame.data(), frame.size(), messages));
+}
+
+/*************/
+TEST_CASE("Testing MessageCodec clear")
+{
+    MessageCodec codec;
+    codec.add("image", "file", {"/tmp/image.png"});
+    codec.clear();
+    CHECK(codec.getMessageCount() == 0);
+
+    codec.add("mesh", "file", {"/tmp/mesh.obj"});
+    auto frame = codec.encode();
+    vector<MessageCodec::Message> messages;
+    REQUIRE(MessageCodec::decode(frame.data(), frame.size(), messages));
+    REQUIRE(messages.size() == 1);
+    CHECK(messages[0].target == "mesh");
+}
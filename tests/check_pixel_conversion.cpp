@@ -0,0 +1,145 @@
+#include <doctest.h>
+
+#include <random>
+#include <vector>
+
+#include "./image/pixel_conversion.h"
+
+using namespace std;
+using namespace Splash;
+
+namespace
+{
+/*************/
+vector<uint8_t> randomBytes(size_t size)
+{
+    mt19937 generator(42);
+    uniform_int_distribution<int> distribution(0, 255);
+    vector<uint8_t> bytes(size);
+    for (auto& byte : bytes)
+        byte = static_cast<uint8_t>(distribution(generator));
+    return bytes;
+}
+
+/*************/
+vector<PixelConversion::InstructionSet> getInstructionSets()
+{
+    vector<PixelConversion::InstructionSet> instructionSets{PixelConversion::InstructionSet::Scalar};
+    if (PixelConversion::setInstructionSet(PixelConversion::InstructionSet::SSE41))
+        instructionSets.push_back(PixelConversion::InstructionSet::SSE41);
+    if (PixelConversion::setInstructionSet(PixelConversion::InstructionSet::AVX2))
+        instructionSets.push_back(PixelConversion::InstructionSet::AVX2);
+    PixelConversion::setInstructionSet(PixelConversion::getSupportedInstructionSet());
+    return instructionSets;
+}
+} // end of anonymous namespace
+
+/*************/
+TEST_CASE("Testing YUV conversions to UYVY")
+{
+    // The width is not a multiple of the vector sizes, to check the remainders, and the height is large enough to be split among threads
+    const uint32_t width = 1922;
+    const uint32_t height = 270;
+    auto luma = randomBytes(width * height);
+    auto chroma = randomBytes(width * height / 2);
+    auto packed = randomBytes(width * height * 2);
+
+    for (auto instructionSet : getInstructionSets())
+    {
+        PixelConversion::setInstructionSet(instructionSet);
+
+        vector<uint8_t> output(width * height * 2);
+        PixelConversion::i420ToUYVY(luma.data(), chroma.data(), chroma.data() + width * height / 4, output.data(), width, height);
+        bool isValid = true;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; x += 2)
+            {
+                auto pixel = &output[(x + y * width) * 2];
+                auto chromaIndex = x / 2 + (y / 2) * (width / 2);
+                isValid &= pixel[0] == chroma[chromaIndex] && pixel[1] == luma[x + y * width] && pixel[2] == chroma[width * height / 4 + chromaIndex] &&
+                           pixel[3] == luma[x + 1 + y * width];
+            }
+        }
+        CHECK(isValid);
+
+        PixelConversion::nv12ToUYVY(luma.data(), chroma.data(), output.data(), width, height);
+        isValid = true;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; x += 2)
+            {
+                auto pixel = &output[(x + y * width) * 2];
+                auto chromaIndex = x + (y / 2) * width;
+                isValid &= pixel[0] == chroma[chromaIndex] && pixel[1] == luma[x + y * width] && pixel[2] == chroma[chromaIndex + 1] && pixel[3] == luma[x + 1 + y * width];
+            }
+        }
+        CHECK(isValid);
+
+        PixelConversion::yuy2ToUYVY(packed.data(), output.data(), width, height);
+        isValid = true;
+        for (size_t i = 0; i < packed.size(); i += 2)
+            isValid &= output[i] == packed[i + 1] && output[i + 1] == packed[i];
+        CHECK(isValid);
+
+        // Converting on the calling thread only gives the same result
+        vector<uint8_t> serialOutput(width * height * 2);
+        PixelConversion::i420ToUYVY(luma.data(), chroma.data(), chroma.data() + width * height / 4, output.data(), width, height);
+        PixelConversion::i420ToUYVY(luma.data(), chroma.data(), chroma.data() + width * height / 4, serialOutput.data(), width, height, false);
+        CHECK(serialOutput == output);
+    }
+
+    PixelConversion::setInstructionSet(PixelConversion::getSupportedInstructionSet());
+}
+
+/*************/
+TEST_CASE("Testing BGR to RGBA conversion")
+{
+    for (uint32_t width : {1u, 17u, 33u, 1925u})
+    {
+        const uint32_t height = 131;
+        auto input = randomBytes(width * height * 3);
+
+        for (auto instructionSet : getInstructionSets())
+        {
+            PixelConversion::setInstructionSet(instructionSet);
+
+            // The buffers have the exact image size, for out of bounds accesses to be caught by memory checkers
+            vector<uint8_t> output(width * height * 4);
+            PixelConversion::bgrToRGBA(input.data(), output.data(), width, height);
+            bool isValid = true;
+            for (uint32_t i = 0; i < width * height; ++i)
+                isValid &= output[i * 4] == input[i * 3 + 2] && output[i * 4 + 1] == input[i * 3 + 1] && output[i * 4 + 2] == input[i * 3] && output[i * 4 + 3] == 255;
+            CHECK(isValid);
+        }
+    }
+
+    PixelConversion::setInstructionSet(PixelConversion::getSupportedInstructionSet());
+}
+
+/*************/
+TEST_CASE("Testing 10 bits unpacking")
+{
+    const size_t count = 1920 * 1080 + 7;
+    mt19937 generator(42);
+    uniform_int_distribution<int> distribution(0, 1023);
+    vector<uint16_t> input(count);
+    for (auto& sample : input)
+        sample = static_cast<uint16_t>(distribution(generator));
+    input[0] = 0xFFFF; // Out of range samples saturate
+
+    for (auto instructionSet : getInstructionSets())
+    {
+        PixelConversion::setInstructionSet(instructionSet);
+
+        vector<uint8_t> output(count);
+        PixelConversion::unpack10Bit(input.data(), output.data(), count);
+        CHECK(output[0] == 255);
+        bool isValid = true;
+        for (size_t i = 1; i < count; ++i)
+            isValid &= output[i] == input[i] >> 2;
+        CHECK(isValid);
+    }
+
+    PixelConversion::setInstructionSet(PixelConversion::getSupportedInstructionSet());
+}
@@ -0,0 +1,107 @@
+#include <doctest.h>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "./config.h"
+#include "./core/shared_memory_ring.h"
+
+using namespace std;
+using namespace Splash;
+
+#if HAVE_LINUX
+/*************/
+TEST_CASE("Testing SharedMemoryRing acquire, read and release")
+{
+    auto path = "/splash_check_ring_" + to_string(getpid());
+    SharedMemoryRing writer(path, true, 1);
+    SharedMemoryRing reader(path, false);
+
+    string payload = "Splash shared memory";
+    SharedMemoryRing::SlotDescription description;
+    auto slotData = writer.acquireSlot(payload.size(), description);
+    REQUIRE(slotData != nullptr);
+    CHECK(description.index == 0);
+    CHECK(description.size == payload.size());
+    CHECK(description.capacity >= payload.size());
+    memcpy(slotData, payload.data(), payload.size());
+
+    {
+        auto buffer = reader.readSlot(description);
+        REQUIRE(buffer != nullptr);
+        CHECK(buffer->isBorrowed());
+        CHECK(string(buffer->data(), buffer->size()) == payload);
+
+        // The only slot is used as long as the buffer is alive
+        SharedMemoryRing::SlotDescription otherDescription;
+        CHECK(writer.acquireSlot(payload.size(), otherDescription) == nullptr);
+    }
+
+    // Releasing the buffer hands the slot back to the writer
+    CHECK(writer.acquireSlot(payload.size(), description) != nullptr);
+
+    // So does cancelling it
+    writer.cancelSlot(description.index);
+    CHECK(writer.acquireSlot(payload.size(), description) != nullptr);
+
+    // A description larger than the segment is rejected instead of being mapped past its end
+    SharedMemoryRing otherReader(path, false);
+    auto oversizedDescription = description;
+    oversizedDescription.capacity += 1 << 20;
+    CHECK(otherReader.readSlot(oversizedDescription) == nullptr);
+}
+
+/*************/
+TEST_CASE("Testing SharedMemoryRing exhaustion and growth")
+{
+    auto path = "/splash_check_ring_grow_" + to_string(getpid());
+    SharedMemoryRing writer(path, true, 2);
+    SharedMemoryRing reader(path, false, 1);
+
+    SharedMemoryRing::SlotDescription first, second, third;
+    CHECK(writer.acquireSlot(16, first) != nullptr);
+    CHECK(writer.acquireSlot(16, second) != nullptr);
+    CHECK(first.index != second.index);
+    CHECK(writer.acquireSlot(16, third) == nullptr);
+
+    writer.setSlotCount(3);
+    CHECK(writer.getSlotCount() == 3);
+    REQUIRE(writer.acquireSlot(16, third) != nullptr);
+    CHECK(third.index == 2);
+
+    // Rings never shrink
+    writer.setSlotCount(1);
+    CHECK(writer.getSlotCount() == 3);
+
+    // The reader follows the growth of the writer
+    CHECK(reader.readSlot(third) != nullptr);
+    CHECK(reader.getSlotCount() == 3);
+}
+
+/*************/
+TEST_CASE("Testing SharedMemoryRing reclaiming slots which were never read")
+{
+    auto path = "/splash_check_ring_reclaim_" + to_string(getpid());
+    SharedMemoryRing writer(path, true, 1, 10);
+    SharedMemoryRing reader(path, false);
+
+    SharedMemoryRing::SlotDescription lost;
+    REQUIRE(writer.acquireSlot(64, lost) != nullptr);
+
+    SharedMemoryRing::SlotDescription description;
+    CHECK(writer.acquireSlot(64, description) == nullptr);
+
+    // Past the timeout the slot is replaced by a new segment
+    this_thread::sleep_for(chrono::milliseconds(20));
+    REQUIRE(writer.acquireSlot(64, description) != nullptr);
+    CHECK(description.index == lost.index);
+    CHECK(description.generation != lost.generation);
+
+    // The lost announcement does not match the new segment anymore
+    CHECK(reader.readSlot(lost) == nullptr);
+    CHECK(reader.readSlot(description) != nullptr);
+}
+#endif
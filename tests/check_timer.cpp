@@ -0,0 +1,139 @@
+#include <doctest.h>
+
+#include <thread>
+#include <vector>
+
+#include "./utils/histogram.h"
+#include "./utils/timer.h"
+
+using namespace std;
+using namespace Splash;
+
+/*************/
+TEST_CASE("Testing Histogram percentiles")
+{
+    Histogram histogram;
+    CHECK(histogram.getPercentile(50.0) == 0);
+
+    for (uint64_t i = 1; i <= 1000; ++i)
+        histogram.record(i);
+    histogram.record(100000);
+
+    CHECK(histogram.getCount() == 1001);
+    CHECK(histogram.getMax() == 100000);
+
+    // Values are grouped in buckets with a precision of about 3%
+    auto median = histogram.getPercentile(50.0);
+    CHECK(median >= 500);
+    CHECK(median <= 516);
+    auto p99 = histogram.getPercentile(99.0);
+    CHECK(p99 >= 990);
+    CHECK(p99 <= 1023);
+    CHECK(histogram.getPercentile(100.0) == 100000);
+
+    Histogram merged;
+    merged.merge(histogram);
+    merged.merge(histogram);
+    CHECK(merged.getCount() == 2002);
+    CHECK(merged.getPercentile(50.0) == median);
+}
+
+/*************/
+TEST_CASE("Testing Timer identifiers and statistics")
+{
+    auto id = Timer::get().getId("check_timer");
+    CHECK(static_cast<bool>(id));
+    CHECK(Timer::get().getId("check_timer").index == id.index);
+    CHECK(Timer::get().getId("check_timer_other").index != id.index);
+    CHECK(Timer::get().getDuration("check_timer_unknown") == 0);
+
+    // Measures from several threads, some of them ending before reading the statistics, are all accounted for
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([id, t]() {
+            for (int i = 0; i < 100; ++i)
+                Timer::get().record(id, t == 3 ? 10000 : 100);
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    Timer::get().record(id, 42);
+    CHECK(Timer::get().getDuration("check_timer") == 42);
+    CHECK(Timer::get().getDurationMap()["check_timer"] == 42);
+
+    auto statistics = Timer::get().getStatistics("check_timer");
+    CHECK(statistics.count == 401);
+    CHECK(statistics.p50 >= 100);
+    CHECK(statistics.p50 <= 103);
+    CHECK(statistics.max == 10000);
+
+    // Durations set directly are not timings, and have no statistics
+    Timer::get().setDuration("check_timer_value", 12);
+    CHECK(Timer::get().getDuration("check_timer_value") == 12);
+    CHECK(Timer::get().getStatistics("check_timer_value").count == 0);
+
+    // Statistics from a pair are used when there is no local measure
+    Timer::Statistics remote;
+    remote.count = 10;
+    remote.max = 20;
+    Timer::get().setStatistics("check_timer_value", remote);
+    CHECK(Timer::get().getStatistics("check_timer_value").max == 20);
+    CHECK(Timer::get().getStatistics().count("check_timer") == 1);
+}
+
+/*************/
+TEST_CASE("Testing Timer release and reuse")
+{
+    auto id = Timer::get().getId("check_timer_released");
+    Timer::get().record(id, 100);
+    CHECK(Timer::get().getStatistics("check_timer_released").count == 1);
+
+    // Identifiers of a released timer are ignored, even once its slot is reused
+    Timer::get().release("check_timer_released");
+    CHECK(Timer::get().getStatistics().count("check_timer_released") == 0);
+    CHECK(Timer::get().getDurationMap().count("check_timer_released") == 0);
+
+    auto newId = Timer::get().getId("check_timer_reused");
+    CHECK(newId.index == id.index);
+    CHECK(newId.generation != id.generation);
+    Timer::get().record(id, 200);
+    CHECK(Timer::get().getStatistics("check_timer_reused").count == 0);
+    Timer::get().record(newId, 300);
+    CHECK(Timer::get().getStatistics("check_timer_reused").count == 1);
+    CHECK(Timer::get().getDuration(id) == 0);
+
+    // A released name gets a new, valid identifier
+    auto renewedId = Timer::get().getId("check_timer_released");
+    CHECK(Timer::get().getDuration(renewedId) == 0);
+    Timer::get().release("check_timer_released");
+    Timer::get().release("check_timer_reused");
+}
+
+/*************/
+TEST_CASE("Testing Timer slots exhaustion and statistics reset")
+{
+    vector<string> names;
+    Timer::Id id;
+    do
+    {
+        names.push_back("check_timer_exhaustion_" + to_string(names.size()));
+        id = Timer::get().getId(names.back());
+    } while (id);
+    CHECK(!Timer::get().getId("check_timer_exhausted"));
+
+    // Releasing a timer makes room for a new one
+    Timer::get().release(names.front());
+    CHECK(static_cast<bool>(Timer::get().getId("check_timer_exhausted")));
+    Timer::get().release("check_timer_exhausted");
+    for (const auto& name : names)
+        Timer::get().release(name);
+
+    auto statisticsId = Timer::get().getId("check_timer_reset");
+    for (int i = 0; i < 10; ++i)
+        Timer::get().record(statisticsId, 100);
+    CHECK(Timer::get().getStatistics("check_timer_reset").count == 10);
+    Timer::get().resetStatistics();
+    CHECK(Timer::get().getStatistics("check_timer_reset").count == 0);
+    Timer::get().record(statisticsId, 100);
+    CHECK(Timer::get().getStatistics("check_timer_reset").count == 1);
+}
@@ -82,3 +82,33 @@ TEST_CASE("Testing Values comparison")
     CHECK(values != valueInt);
     CHECK(valueString != valueFloat);
 }
+
+/*************/
+TEST_CASE("Testing Value copy and move")
+{
+    auto nested = Value(Values({1, 2.0, "three"}), "nested");
+    auto copy = nested;
+    CHECK(copy == nested);
+    CHECK(copy.getName() == "nested");
+    CHECK(copy.as<Values>()[2].as<string>() == "three");
+
+    auto moved = std::move(copy);
+    CHECK(moved == nested);
+    CHECK(copy.getType() == Value::Type::i);
+    CHECK(!copy.isNamed());
+
+    // Assigning changes the stored type
+    moved = Value("Patate");
+    CHECK(moved.getType() == Value::Type::s);
+    CHECK(moved.as<string>() == "Patate");
+    CHECK(!moved.isNamed());
+    moved = 42;
+    CHECK(moved.as<int>() == 42);
+
+    // Names are compared by value, even if set separately
+    auto named = Value(3.0);
+    named.setName("nested");
+    CHECK(named.getName() == nested.getName());
+    CHECK(named == Value(3.0, "nested"));
+    CHECK(named != Value(3.0, "other"));
+}
@@ -13,7 +13,7 @@ def run():
     sink.open()
     sleep(0.5)
     image = sink.grab()
-    print("Sink linked, grabbed image:", image.hex())
+    print("Sink linked, grabbed image:", memoryview(image).hex(), "sequence:", image.sequence, "timestamp:", image.timestamp)
     sink.close()
     sink.unlink()
 